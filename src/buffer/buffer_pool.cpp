@@ -0,0 +1,417 @@
+#include "buffer/buffer_pool.h"
+
+#include <cstring>
+#include <string>
+
+#include "disk/checksum.h"
+
+namespace spdb {
+
+BufferPool::BufferPool(size_t pool_size, size_t replacer_k)
+    : pool_size_(pool_size) {
+  // we allocate a consecutive memory space for the buffer pool
+  pages_ = new Page[pool_size_];
+  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
+
+  // Initially, every page is in the free list.
+  for (size_t i = 0; i < pool_size_; ++i) {
+    free_list_.emplace_back(static_cast<int>(i));
+  }
+}
+
+BufferPool::~BufferPool() { delete[] pages_; }  // NOLINT
+
+auto BufferPool::RegisterFile(DiskManager *disk_manager, bool has_checksum)
+    -> file_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  file_id_t file_id = next_file_id_++;
+  files_[file_id] = disk_manager;
+  if (has_checksum) {
+    checksum_files_.insert(file_id);
+  }
+  return file_id;
+}
+
+void BufferPool::UnregisterFile(file_id_t file_id) {
+  std::unique_lock<std::shared_mutex> files_lock(files_latch_);
+  std::lock_guard<std::mutex> lock(latch_);
+  for (size_t fid = 0; fid < pool_size_; ++fid) {
+    auto &page = pages_[fid];
+    if (page.page_id_ == INVALID_PAGE_ID || page.file_id_ != file_id) {
+      continue;
+    }
+    replacer_->SetEvictable(fid, true);
+    replacer_->Remove(fid);
+    ResetFrame(fid);
+    free_list_.push_back(fid);
+  }
+  files_.erase(file_id);
+  checksum_files_.erase(file_id);
+}
+
+void BufferPool::WritePage(DiskManager *disk_manager, Page *page,
+                           bool has_checksum) {
+  if (!has_checksum) {
+    disk_manager->WritePage(page->page_id_, page->GetData());
+    return;
+  }
+  char data[PAGE_SIZE];
+  memcpy(data, page->GetData(), PAGE_SIZE);
+  SetPageChecksum(data);
+  disk_manager->WritePage(page->page_id_, data);
+}
+
+auto BufferPool::FindPage(uint64_t key, std::unique_lock<std::mutex> *lock)
+    -> std::unordered_map<uint64_t, frame_id_t>::iterator {
+  auto it = page_table_.find(key);
+  // the read may fail, then the page is gone from the page table
+  while (it != page_table_.end() && loading_frames_.count(it->second) > 0) {
+    loaded_cv_.wait(*lock);
+    it = page_table_.find(key);
+  }
+  return it;
+}
+
+auto BufferPool::WriteBack(frame_id_t frame_id,
+                           std::unique_lock<std::mutex> *lock, LatchMode mode)
+    -> bool {
+  auto &page = pages_[frame_id];
+  DiskManager *disk_manager = files_[page.file_id_];
+  bool has_checksum = checksum_files_.count(page.file_id_) > 0;
+  // cleared before the copy, so an unpin dirtying the page meanwhile keeps
+  // it dirty
+  bool is_dirty = page.is_dirty_;
+  page.is_dirty_ = false;
+  lock->unlock();
+  // the page is pinned, so it stays in the frame, and the read latch keeps
+  // writers off until the copy is written
+  if (mode == LatchMode::TRY && !page.TryRLatch()) {
+    lock->lock();
+    page.is_dirty_ = page.is_dirty_ || is_dirty;
+    return false;
+  }
+  if (mode == LatchMode::WAIT) {
+    page.RLatch();
+  }
+  try {
+    if (log_manager_ != nullptr) {
+      log_manager_->Flush(page.GetLSN());
+    }
+    WritePage(disk_manager, &page, has_checksum);
+  } catch (...) {
+    if (mode != LatchMode::HELD) {
+      page.RUnlatch();
+    }
+    lock->lock();
+    page.is_dirty_ = page.is_dirty_ || is_dirty;
+    throw;
+  }
+
+  lock->lock();
+  if (!page.is_dirty_) {
+    page.rec_lsn_ = INVALID_LSN;
+  }
+  if (mode != LatchMode::HELD) {
+    page.RUnlatch();
+  }
+  return true;
+}
+
+void BufferPool::Pin(frame_id_t frame_id) {
+  pages_[frame_id].pin_count_++;
+  replacer_->SetEvictable(frame_id, false);
+}
+
+void BufferPool::Unpin(frame_id_t frame_id) {
+  if (--pages_[frame_id].pin_count_ == 0) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+}
+
+void BufferPool::ResetFrame(frame_id_t frame_id) {
+  auto &page = pages_[frame_id];
+  page_table_.erase(MakeKey(page.file_id_, page.page_id_));
+  page.ResetMemory();
+  page.file_id_ = -1;
+  page.page_id_ = INVALID_PAGE_ID;
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  page.rec_lsn_ = INVALID_LSN;
+}
+
+auto BufferPool::GetFreeFrame(frame_id_t *frame_id,
+                              std::unique_lock<std::mutex> *lock) -> bool {
+  // if there is no empty frames
+  // evict an evictable page and free the frame.
+  while (free_list_.empty()) {
+    frame_id_t frame_tmp_id;
+    if (!replacer_->Evict(&frame_tmp_id)) {
+      return false;
+    }
+    auto &page = pages_[frame_tmp_id];
+    if (page.IsDirty()) {
+      // the page stays cached while it is written back without the latch,
+      // if it is fetched or dirtied again meanwhile it is kept
+      replacer_->RecordAccess(frame_tmp_id);
+      Pin(frame_tmp_id);
+      bool is_written = WriteBack(frame_tmp_id, lock, LatchMode::TRY);
+      Unpin(frame_tmp_id);
+      if (!is_written || page.GetPinCount() > 0 || page.IsDirty()) {
+        continue;
+      }
+      replacer_->Remove(frame_tmp_id);
+    }
+    ResetFrame(frame_tmp_id);
+    free_list_.push_back(frame_tmp_id);
+  }
+  *frame_id = free_list_.front();
+  free_list_.pop_front();
+  return true;
+}
+
+auto BufferPool::NewPage(file_id_t file_id, page_id_t page_id) -> Page * {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t fid;
+  if (!GetFreeFrame(&fid, &lock)) {
+    return nullptr;
+  }
+  page_table_[MakeKey(file_id, page_id)] = fid;
+  replacer_->RecordAccess(fid);
+  replacer_->SetEvictable(fid, false);
+
+  Page *new_page = &pages_[fid];
+  new_page->pin_count_++;
+  new_page->file_id_ = file_id;
+  new_page->page_id_ = page_id;
+  new_page->is_dirty_ = false;
+  // the page is pinned and nobody else has its id yet
+  DiskManager *disk_manager = files_[file_id];
+  bool has_checksum = checksum_files_.count(file_id) > 0;
+  lock.unlock();
+  WritePage(disk_manager, new_page, has_checksum);
+  return new_page;
+}
+
+auto BufferPool::FetchPage(file_id_t file_id, page_id_t page_id) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  // the latch is released while an evicted page is written back, so the
+  // page is looked up again once a frame is taken
+  auto key = MakeKey(file_id, page_id);
+  auto it = FindPage(key, &lock);
+  frame_id_t fid;
+  bool has_frame = false;
+  if (it == page_table_.end()) {
+    has_frame = GetFreeFrame(&fid, &lock);
+    it = FindPage(key, &lock);
+  }
+  // if the page is already in the buffer pool
+  if (it != page_table_.end()) {
+    if (has_frame) {
+      free_list_.push_back(fid);
+    }
+    Page *page_ret = &pages_[it->second];
+    page_ret->pin_count_++;
+    replacer_->RecordAccess(it->second);
+    replacer_->SetEvictable(it->second, false);
+    ++hit_count_;
+    return page_ret;
+  }
+  if (!has_frame) {
+    return nullptr;
+  }
+
+  // the frame is pinned and taken by the page, but its id is only set once
+  // the page is read, so the flushes leave it alone meanwhile
+  page_table_[key] = fid;
+  loading_frames_.insert(fid);
+  replacer_->RecordAccess(fid);
+  replacer_->SetEvictable(fid, false);
+  Page *new_page = &pages_[fid];
+  new_page->pin_count_++;
+  DiskManager *disk_manager = files_[file_id];
+  bool has_checksum = checksum_files_.count(file_id) > 0;
+  lock.unlock();
+
+  std::string error;
+  try {
+    disk_manager->ReadPage(page_id, new_page->GetData());
+    // a torn write or a flipped bit is caught before anyone follows the page
+    if (has_checksum && !IsPageChecksumValid(new_page->GetData())) {
+      error = "page " + std::to_string(page_id) + " of " +
+              disk_manager->GetFileName() + " is damaged.";
+    } else if (has_checksum) {
+      ClearPageChecksumFlag(new_page->GetData());
+    }
+  } catch (std::runtime_error &e) {
+    error = e.what();
+  }
+
+  lock.lock();
+  loading_frames_.erase(fid);
+  loaded_cv_.notify_all();
+  if (!error.empty()) {
+    page_table_.erase(key);
+    replacer_->SetEvictable(fid, true);
+    replacer_->Remove(fid);
+    new_page->ResetMemory();
+    new_page->pin_count_ = 0;
+    free_list_.push_back(fid);
+    throw std::runtime_error(error);
+  }
+  new_page->file_id_ = file_id;
+  new_page->page_id_ = page_id;
+  new_page->is_dirty_ = false;
+  ++miss_count_;
+  return new_page;
+}
+
+auto BufferPool::UnpinPage(file_id_t file_id, page_id_t page_id,
+                           bool is_dirty) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = page_table_.find(MakeKey(file_id, page_id));
+  if (it == page_table_.end() || pages_[it->second].GetPinCount() <= 0) {
+    return false;
+  }
+
+  frame_id_t fid = it->second;
+  pages_[fid].pin_count_--;
+  if (pages_[fid].GetPinCount() == 0) {
+    replacer_->SetEvictable(fid, true);
+  }
+  pages_[fid].is_dirty_ = is_dirty ? true : pages_[fid].is_dirty_;
+  return true;
+}
+
+auto BufferPool::FlushPage(file_id_t file_id, page_id_t page_id,
+                           bool is_latched) -> bool {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  auto it = FindPage(MakeKey(file_id, page_id), &lock);
+  if (it == page_table_.end()) {
+    return false;
+  }
+  frame_id_t fid = it->second;
+  Pin(fid);
+  WriteBack(fid, &lock, is_latched ? LatchMode::HELD : LatchMode::WAIT);
+  Unpin(fid);
+  return true;
+}
+
+void BufferPool::FlushFile(file_id_t file_id) {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  for (size_t fid = 0; fid < pool_size_; ++fid) {
+    auto &page = pages_[fid];
+    if (page.page_id_ != INVALID_PAGE_ID && page.file_id_ == file_id) {
+      Pin(fid);
+      WriteBack(fid, &lock, LatchMode::WAIT);
+      Unpin(fid);
+    }
+  }
+}
+
+void BufferPool::FlushAllPages() {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  for (size_t fid = 0; fid < pool_size_; ++fid) {
+    auto &page = pages_[fid];
+    if (page.page_id_ != INVALID_PAGE_ID) {
+      Pin(fid);
+      WriteBack(fid, &lock, LatchMode::WAIT);
+      Unpin(fid);
+    }
+  }
+}
+
+auto BufferPool::PinOldPage(lsn_t lsn, frame_id_t *frame_id) -> bool {
+  for (; *frame_id < static_cast<frame_id_t>(pool_size_); ++*frame_id) {
+    auto &page = pages_[*frame_id];
+    lsn_t rec_lsn = page.rec_lsn_;
+    if (page.page_id_ != INVALID_PAGE_ID && rec_lsn != INVALID_LSN &&
+        rec_lsn < lsn) {
+      Pin(*frame_id);
+      return true;
+    }
+  }
+  return false;
+}
+
+auto BufferPool::FlushOldPages(lsn_t lsn) -> size_t {
+  size_t count = 0;
+  frame_id_t fid = 0;
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  for (; PinOldPage(lsn, &fid); ++fid) {
+    if (WriteBack(fid, &lock, LatchMode::TRY)) {
+      ++count;
+    }
+    Unpin(fid);
+  }
+  return count;
+}
+
+auto BufferPool::GetDirtyPages() -> std::vector<DirtyPage> {
+  // a page moving to another frame meanwhile is written back first, so the
+  // frames don't need to be visited at once
+  static const size_t chunk_size = 256;
+  std::vector<DirtyPage> dirty_pages;
+  for (size_t begin = 0; begin < pool_size_; begin += chunk_size) {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (size_t fid = begin; fid < pool_size_ && fid < begin + chunk_size;
+         ++fid) {
+      auto &page = pages_[fid];
+      lsn_t rec_lsn = page.rec_lsn_;
+      if (page.page_id_ != INVALID_PAGE_ID && rec_lsn != INVALID_LSN) {
+        dirty_pages.push_back(DirtyPage{files_[page.file_id_]->GetFileName(),
+                                        page.page_id_, rec_lsn});
+      }
+    }
+  }
+  return dirty_pages;
+}
+
+void BufferPool::SyncFiles() {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::vector<DiskManager *> files;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto &[file_id, disk_manager] : files_) {
+      files.push_back(disk_manager);
+    }
+  }
+  for (auto disk_manager : files) {
+    disk_manager->Sync();
+  }
+}
+
+auto BufferPool::DeletePage(file_id_t file_id, page_id_t page_id) -> bool {
+  std::shared_lock<std::shared_mutex> files_lock(files_latch_);
+  std::unique_lock<std::mutex> lock(latch_);
+  auto it = page_table_.find(MakeKey(file_id, page_id));
+  if (it == page_table_.end()) {
+    return true;
+  }
+  frame_id_t fid = it->second;
+  auto &page = pages_[fid];
+  if (page.GetPinCount() > 0) {
+    return false;
+  }
+  if (page.IsDirty()) {
+    Pin(fid);
+    bool is_written = WriteBack(fid, &lock, LatchMode::TRY);
+    Unpin(fid);
+    if (!is_written || page.GetPinCount() > 0 || page.IsDirty()) {
+      return false;
+    }
+  }
+  replacer_->Remove(fid);
+  ResetFrame(fid);
+  free_list_.push_back(fid);
+  return true;
+}
+}  // namespace spdb
@@ -4,214 +4,166 @@ namespace spdb {
 
 BufferPoolManager::BufferPoolManager(size_t pool_size,
                                      DiskManager *disk_manager,
-                                     size_t replacer_k)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
-
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
-  }
+                                     size_t replacer_k, bool has_checksum)
+    : BufferPoolManager(new BufferPool(pool_size, replacer_k), disk_manager,
+                        has_checksum) {
+  own_pool_.reset(pool_);
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }  // NOLINT
+BufferPoolManager::BufferPoolManager(BufferPool *buffer_pool,
+                                     DiskManager *disk_manager,
+                                     bool has_checksum)
+    : pool_(buffer_pool),
+      disk_manager_(disk_manager),
+      free_page_map_(disk_manager->GetFileName()) {
+  file_id_ = pool_->RegisterFile(disk_manager_, has_checksum);
+  // pages already in the file are in use, but the free ones saved
+  next_page_id_ = disk_manager_->GetFileSize() / PAGE_SIZE;
+  free_page_map_.Load(next_page_id_, &free_pages_);
+  saved_page_count_ = next_page_id_;
+}
+
+BufferPoolManager::~BufferPoolManager() {
+  pool_->UnregisterFile(file_id_);
+  // a map is only started once a page is freed
+  if (is_free_pages_changed_ ||
+      (free_page_map_.IsClean() && saved_page_count_ != next_page_id_)) {
+    free_page_map_.Save(next_page_id_, free_pages_);
+  }
+}
 
 auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
   std::lock_guard<std::mutex> lock(latch_);
-
-  // if there is no empty frames
-  // evict an evictable page and free the frame.
-  if (free_list_.empty()) {
-    frame_id_t frame_tmp_id;
-    if (replacer_->Evict(&frame_tmp_id)) {
-      free_list_.push_back(frame_tmp_id);
-      replacer_->Remove(frame_tmp_id);
-
-      if (pages_[frame_tmp_id].IsDirty()) {
-        disk_manager_->WritePage(pages_[frame_tmp_id].page_id_,
-                                 pages_[frame_tmp_id].GetData());
-      }
-
-      pages_[frame_tmp_id].ResetMemory();
-      page_table_.erase(pages_[frame_tmp_id].page_id_);
-      pages_[frame_tmp_id].page_id_ = INVALID_PAGE_ID;
-      pages_[frame_tmp_id].pin_count_ = 0;
-      pages_[frame_tmp_id].is_dirty_ = false;
-
-    } else {
-      return nullptr;
-    }
+  // only take the page id once there is a frame for it, so that pages are
+  // still written in order
+  page_id_t pid =
+      free_pages_.empty() ? next_page_id_.load() : *free_pages_.begin();
+  Page *new_page = pool_->NewPage(file_id_, pid);
+  if (new_page == nullptr) {
+    return nullptr;
   }
-
-  // put the page in the empty frame
-  frame_id_t fid = free_list_.front();
-  free_list_.pop_front();
   *page_id = AllocatePage();
-  page_table_[*page_id] = fid;
-
-  replacer_->RecordAccess(fid);
-  replacer_->SetEvictable(fid, false);
-
-  Page *new_page = &pages_[fid];
-  new_page->pin_count_++;
-  new_page->page_id_ = *page_id;
-  disk_manager_->WritePage(new_page->GetPageId(), new_page->GetData());
-  new_page->is_dirty_ = false;
-
-  // auto log = std::stringstream();
-  // log << "thread " << std::this_thread::get_id() << " page "<< *page_id<<"
-  // frame "<<fid; LOG_DEBUG("%s", log.str().c_str());
   return new_page;
 }
 
 auto BufferPoolManager::FetchPage(page_id_t page_id,
                                   [[maybe_unused]] AccessType access_type)
     -> Page * {
-  if (page_id == INVALID_PAGE_ID) {
-    return nullptr;
-  }
-  std::lock_guard<std::mutex> lock(latch_);
-  // auto log = std::stringstream();
-  // log << "thread " << std::this_thread::get_id() << " page "<< page_id;
-  // if the page is already in the buffer pool
-  if (page_table_.find(page_id) != page_table_.end()) {
-    Page *page_ret = &pages_[page_table_[page_id]];
-    page_ret->pin_count_++;
-    replacer_->SetEvictable(page_table_[page_id], false);
-
-    // log<<" frame "<<page_table_[page_id];
-    // LOG_DEBUG("%s", log.str().c_str());
-    return page_ret;
-  }
-
-  // to put the page in the frame
-  if (free_list_.empty()) {
-    frame_id_t frame_tmp_id;
-    if (replacer_->Evict(&frame_tmp_id)) {
-      free_list_.push_back(frame_tmp_id);
-      replacer_->Remove(frame_tmp_id);
-
-      if (pages_[frame_tmp_id].IsDirty()) {
-        disk_manager_->WritePage(pages_[frame_tmp_id].page_id_,
-                                 pages_[frame_tmp_id].GetData());
-      }
-
-      pages_[frame_tmp_id].ResetMemory();
-      page_table_.erase(pages_[frame_tmp_id].page_id_);
-      pages_[frame_tmp_id].page_id_ = INVALID_PAGE_ID;
-      pages_[frame_tmp_id].pin_count_ = 0;
-      pages_[frame_tmp_id].is_dirty_ = false;
-
-    } else {
-      return nullptr;
-    }
-  }
-
-  frame_id_t fid = free_list_.front();
-  free_list_.pop_front();
-  page_table_[page_id] = fid;
-  replacer_->RecordAccess(fid);
-  replacer_->SetEvictable(fid, false);
-
-  Page *new_page = &pages_[fid];
-  new_page->pin_count_++;
-  new_page->page_id_ = page_id;
-  disk_manager_->ReadPage(page_id, new_page->GetData());
-  new_page->is_dirty_ = false;
-
-  // log<<" fetch from disk, fid "<<fid;
-  // LOG_DEBUG("%s", log.str().c_str());
-  return new_page;
+  return pool_->FetchPage(file_id_, page_id);
 }
 
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty,
                                   [[maybe_unused]] AccessType access_type)
     -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
+  return pool_->UnpinPage(file_id_, page_id, is_dirty);
+}
 
-  if (page_table_.find(page_id) == page_table_.end() ||
-      pages_[page_table_[page_id]].GetPinCount() <= 0) {
+auto BufferPoolManager::FlushPage(page_id_t page_id, bool is_latched)
+    -> bool {
+  return pool_->FlushPage(file_id_, page_id, is_latched);
+}
+
+auto BufferPoolManager::LogPageUpdate(Page *page, const char *before_image)
+    -> bool {
+  auto log_manager = pool_->GetLogManager();
+  if (log_manager == nullptr || before_image == nullptr) {
     return false;
   }
-
-  frame_id_t fid = page_table_[page_id];
-  pages_[fid].pin_count_--;
-  if (pages_[fid].GetPinCount() == 0) {
-    replacer_->SetEvictable(fid, true);
+  // the first record dirtying the page is never after the next lsn, which is
+  // noted before appending so a checkpoint can't miss the page
+  lsn_t rec_lsn = INVALID_LSN;
+  page->rec_lsn_.compare_exchange_strong(rec_lsn, log_manager->GetNextLSN());
+  lsn_t lsn =
+      log_manager->AppendPageUpdate(disk_manager_->GetFileName(),
+                                    page->GetPageId(), before_image,
+                                    page->GetData());
+  if (lsn != INVALID_LSN) {
+    page->SetLSN(lsn);
   }
-  pages_[fid].is_dirty_ = is_dirty ? true : pages_[fid].is_dirty_;
-
   return true;
 }
 
-auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
+void BufferPoolManager::FlushAllPages() { pool_->FlushFile(file_id_); }
 
-  if (page_table_.find(page_id) == page_table_.end()) {
+auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
+  if (!pool_->DeletePage(file_id_, page_id)) {
     return false;
   }
-
-  frame_id_t fid = page_table_[page_id];
-  disk_manager_->WritePage(page_id, pages_[fid].GetData());
-  pages_[fid].is_dirty_ = false;
-
-  // auto log = std::stringstream();
-  // log << "thread " << std::this_thread::get_id() << " flush page "<< page_id;
-  // LOG_DEBUG("%s", log.str().c_str());
+  std::lock_guard<std::mutex> lock(latch_);
+  DeallocatePage(page_id);
   return true;
 }
 
-void BufferPoolManager::FlushAllPages() {
-  std::lock_guard<std::mutex> lock(latch_);
-  for (auto [pid, fid] : page_table_) {
-    disk_manager_->WritePage(pid, pages_[fid].GetData());
-    pages_[fid].is_dirty_ = false;
+auto BufferPoolManager::AllocatePage() -> page_id_t {
+  page_id_t page_tmp_id;
+  if (free_pages_.empty()) {
+    page_tmp_id = next_page_id_++;
+  } else {
+    ChangeFreePages();
+    page_tmp_id = *free_pages_.begin();
+    free_pages_.erase(free_pages_.begin());
   }
+  return page_tmp_id;
 }
 
-auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
-  // auto log = std::stringstream();
-  // log << "thread " << std::this_thread::get_id() << " delete page "<<
-  // page_id; LOG_DEBUG("%s", log.str().c_str());
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
-    return true;
-  }
+void BufferPoolManager::DeallocatePage(page_id_t page_id) {
+  ChangeFreePages();
+  free_pages_.insert(page_id);
+}
 
-  frame_id_t fid = page_table_[page_id];
+void BufferPoolManager::ChangeFreePages() {
+  // a crash from now on leaves a map the pages in use may be free in, so it
+  // is marked stale first
+  free_page_map_.Invalidate();
+  is_free_pages_changed_ = true;
+}
 
-  if (pages_[fid].GetPinCount() > 0) {
-    return false;
+auto BufferPoolManager::Vacuum(const std::vector<page_id_t> &used_pages)
+    -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  std::vector<bool> is_used(next_page_id_, false);
+  for (auto page_id : used_pages) {
+    if (page_id >= 0 && page_id < next_page_id_) {
+      is_used[page_id] = true;
+    }
   }
-
-  if (pages_[fid].IsDirty()) {
-    disk_manager_->WritePage(page_id, pages_[fid].GetData());
+  // a free page leaves the pool, to be cached afresh once it is reused
+  std::set<page_id_t> free_pages;
+  for (page_id_t page_id = 0; page_id < next_page_id_; ++page_id) {
+    if (!is_used[page_id] && pool_->DeletePage(file_id_, page_id)) {
+      free_pages.insert(page_id);
+    }
   }
-  DeallocatePage(page_id);
-  replacer_->Remove(fid);
-  free_list_.push_back(fid);
-  pages_[fid].ResetMemory();
-  pages_[fid].page_id_ = INVALID_PAGE_ID;
-  page_table_.erase(page_id);
 
-  return true;
+  // the free pages at the end are cut off the file
+  page_id_t page_count = next_page_id_;
+  while (page_count > 0 && free_pages.count(page_count - 1) > 0) {
+    free_pages.erase(--page_count);
+  }
+  if (free_pages == free_pages_ && page_count == next_page_id_) {
+    return 0;
+  }
+  ChangeFreePages();
+  free_pages_ = std::move(free_pages);
+  if (page_count < next_page_id_) {
+    disk_manager_->Truncate(page_count);
+  }
+  size_t truncated = next_page_id_ - page_count;
+  next_page_id_ = page_count;
+  return truncated;
 }
 
-auto BufferPoolManager::AllocatePage() -> page_id_t {
-  page_id_t page_tmp_id;
-  if (page_id_bin_.empty()) {
-    page_tmp_id = next_page_id_++;
-  } else {
-    page_tmp_id = page_id_bin_.back();
-    page_id_bin_.pop_back();
+void BufferPoolManager::ExtendTo(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  std::vector<char> zeros(PAGE_SIZE, 0);
+  while (next_page_id_ <= page_id) {
+    disk_manager_->WritePage(next_page_id_++, zeros.data());
   }
-  return page_tmp_id;
 }
 
-void BufferPoolManager::DeallocatePage(page_id_t page_id) {
-  page_id_bin_.push_back(page_id);
+auto BufferPoolManager::GetFreePageCount() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return free_pages_.size();
 }
 
 auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
@@ -9,7 +9,7 @@ auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::lock_guard<std::mutex> lock(latch_);
 
   bool ret = false;
-  for (auto [fid, lrunode] : node_store_) {
+  for (auto &[fid, lrunode] : node_store_) {
     if (lrunode.IsEvictable()) {
       if (!ret) {
         *frame_id = fid;
@@ -0,0 +1,268 @@
+#include "concurrency/lock_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <map>
+#include <set>
+
+namespace spdb {
+LockManager::LockManager(size_t interval_ms) : interval_ms_(interval_ms) {}
+
+LockManager::~LockManager() { Stop(); }
+
+void LockManager::Start() {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (is_running_) {
+    return;
+  }
+  is_running_ = true;
+  thread_ = std::thread([this] { DetectionThread(); });
+}
+
+void LockManager::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    is_running_ = false;
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto LockManager::GetPartition(const std::string &row_key) -> Partition & {
+  return partitions_[std::hash<std::string>()(row_key) %
+                     LOCK_TABLE_PARTITION_NUMS];
+}
+
+auto LockManager::IsGrantable(const LockRequestQueue &queue,
+                              std::list<LockRequest>::iterator request)
+    -> bool {
+  // first come first served: every request ahead is granted, and none of
+  // them conflicts
+  for (auto it = queue.requests_.begin(); it != request; ++it) {
+    if (!it->granted_ || it->mode_ == LockMode::EXCLUSIVE ||
+        request->mode_ == LockMode::EXCLUSIVE) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LockManager::Wait(Transaction *txn, std::unique_lock<std::mutex> *lock,
+                       LockRequestQueue *queue,
+                       std::list<LockRequest>::iterator request) {
+  bool is_victim = false;
+  queue->cv_.wait(*lock, [&] {
+    std::lock_guard<std::mutex> victims_lock(victims_latch_);
+    is_victim = victims_.erase(txn->txn_id_) > 0;
+    return is_victim || IsGrantable(*queue, request);
+  });
+  if (!is_victim) {
+    request->granted_ = true;
+    return;
+  }
+  // the requests behind may be grantable without it
+  if (queue->upgrading_ == txn->txn_id_) {
+    queue->upgrading_ = INVALID_TXN_ID;
+  }
+  queue->requests_.erase(request);
+  queue->cv_.notify_all();
+  txn->state_ = TransactionState::ABORTED;
+  throw TransactionAbortException("the transaction is deadlocked.");
+}
+
+void LockManager::LockShared(Transaction *txn, const std::string &row_key) {
+  if (txn->lock_set_.count(row_key) > 0) {
+    return;
+  }
+  auto &partition = GetPartition(row_key);
+  std::unique_lock<std::mutex> lock(partition.latch_);
+  auto &queue = partition.queues_[row_key];
+  auto request = queue.requests_.insert(
+      queue.requests_.end(),
+      LockRequest{txn->txn_id_, LockMode::SHARED, false});
+  Wait(txn, &lock, &queue, request);
+  txn->lock_set_[row_key] = LockMode::SHARED;
+}
+
+void LockManager::LockExclusive(Transaction *txn, const std::string &row_key) {
+  auto held = txn->lock_set_.find(row_key);
+  if (held != txn->lock_set_.end() && held->second == LockMode::EXCLUSIVE) {
+    return;
+  }
+  auto &partition = GetPartition(row_key);
+  std::unique_lock<std::mutex> lock(partition.latch_);
+  auto &queue = partition.queues_[row_key];
+  auto request = queue.requests_.end();
+  if (held != txn->lock_set_.end()) {
+    // two upgrades would wait for each other
+    if (queue.upgrading_ != INVALID_TXN_ID) {
+      txn->state_ = TransactionState::ABORTED;
+      throw TransactionAbortException("the lock is being upgraded.");
+    }
+    queue.upgrading_ = txn->txn_id_;
+    // the shared lock is traded for an exclusive request ahead of the
+    // waiting ones
+    for (auto it = queue.requests_.begin(); it != queue.requests_.end();) {
+      if (it->txn_id_ == txn->txn_id_) {
+        it = queue.requests_.erase(it);
+      } else if (it->granted_) {
+        ++it;
+      } else {
+        break;
+      }
+    }
+    request = queue.requests_.begin();
+    while (request != queue.requests_.end() && request->granted_) {
+      ++request;
+    }
+    txn->lock_set_.erase(held);
+  }
+  request = queue.requests_.insert(
+      request, LockRequest{txn->txn_id_, LockMode::EXCLUSIVE, false});
+  Wait(txn, &lock, &queue, request);
+  if (queue.upgrading_ == txn->txn_id_) {
+    queue.upgrading_ = INVALID_TXN_ID;
+  }
+  txn->lock_set_[row_key] = LockMode::EXCLUSIVE;
+}
+
+void LockManager::Release(Partition *partition, const std::string &row_key,
+                          txn_id_t txn_id) {
+  auto it = partition->queues_.find(row_key);
+  if (it == partition->queues_.end()) {
+    return;
+  }
+  auto &queue = it->second;
+  queue.requests_.remove_if(
+      [&](const LockRequest &request) { return request.txn_id_ == txn_id; });
+  if (queue.requests_.empty()) {
+    partition->queues_.erase(it);
+  } else {
+    queue.cv_.notify_all();
+  }
+}
+
+void LockManager::Unlock(Transaction *txn, const std::string &row_key) {
+  if (txn->lock_set_.erase(row_key) == 0) {
+    return;
+  }
+  auto &partition = GetPartition(row_key);
+  std::lock_guard<std::mutex> lock(partition.latch_);
+  Release(&partition, row_key, txn->txn_id_);
+}
+
+void LockManager::UnlockAll(Transaction *txn) {
+  for (auto &[row_key, mode] : txn->lock_set_) {
+    auto &partition = GetPartition(row_key);
+    std::lock_guard<std::mutex> lock(partition.latch_);
+    Release(&partition, row_key, txn->txn_id_);
+  }
+  txn->lock_set_.clear();
+}
+
+void LockManager::DetectDeadlocks() {
+  // a waiting request waits for every request ahead of it, each
+  // transaction waits for a single row at a time
+  std::map<txn_id_t, std::set<txn_id_t>> waits_for;
+  std::unordered_map<txn_id_t, std::string> waiting_row;
+  for (auto &partition : partitions_) {
+    std::lock_guard<std::mutex> lock(partition.latch_);
+    for (auto &[row_key, queue] : partition.queues_) {
+      for (auto waiter = queue.requests_.begin();
+           waiter != queue.requests_.end(); ++waiter) {
+        if (waiter->granted_) {
+          continue;
+        }
+        waiting_row[waiter->txn_id_] = row_key;
+        for (auto ahead = queue.requests_.begin(); ahead != waiter; ++ahead) {
+          waits_for[waiter->txn_id_].insert(ahead->txn_id_);
+        }
+      }
+    }
+  }
+
+  // the partitions are collected one at a time, so a cycle found here may
+  // have been broken meanwhile; aborting a transaction then is harmless
+  std::vector<txn_id_t> victims;
+  while (true) {
+    // depth first from the oldest transaction, in txn id order, so the same
+    // graph always gives the same victims
+    std::unordered_map<txn_id_t, int> state;  // 1: on the path, 2: done
+    std::vector<txn_id_t> path;
+    txn_id_t victim = INVALID_TXN_ID;
+    std::function<bool(txn_id_t)> visit = [&](txn_id_t txn_id) {
+      state[txn_id] = 1;
+      path.push_back(txn_id);
+      for (auto next : waits_for[txn_id]) {
+        if (state[next] == 1) {
+          // the youngest transaction on the cycle is aborted
+          auto begin = std::find(path.begin(), path.end(), next);
+          victim = *std::max_element(begin, path.end());
+          return true;
+        }
+        if (state[next] == 0 && visit(next)) {
+          return true;
+        }
+      }
+      state[txn_id] = 2;
+      path.pop_back();
+      return false;
+    };
+    std::vector<txn_id_t> txn_ids;
+    for (auto &[txn_id, holders] : waits_for) {
+      txn_ids.push_back(txn_id);
+    }
+    bool found = false;
+    for (auto txn_id : txn_ids) {
+      if (state[txn_id] == 0 && visit(txn_id)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      break;
+    }
+    victims.push_back(victim);
+    waits_for.erase(victim);
+  }
+
+  for (auto victim : victims) {
+    // wake the victim up in the queue it waits in, unless it is granted
+    // meanwhile and the deadlock is gone
+    auto &row_key = waiting_row[victim];
+    auto &partition = GetPartition(row_key);
+    std::lock_guard<std::mutex> lock(partition.latch_);
+    auto it = partition.queues_.find(row_key);
+    bool is_waiting =
+        it != partition.queues_.end() &&
+        std::any_of(it->second.requests_.begin(), it->second.requests_.end(),
+                    [&](const LockRequest &request) {
+                      return request.txn_id_ == victim && !request.granted_;
+                    });
+    if (is_waiting) {
+      {
+        std::lock_guard<std::mutex> victims_lock(victims_latch_);
+        victims_.insert(victim);
+      }
+      ++deadlock_count_;
+      it->second.cv_.notify_all();
+    }
+  }
+}
+
+void LockManager::DetectionThread() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (is_running_) {
+    cv_.wait_for(lock, std::chrono::milliseconds(interval_ms_));
+    if (!is_running_) {
+      break;
+    }
+    lock.unlock();
+    DetectDeadlocks();
+    lock.lock();
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,815 @@
+#include "concurrency/transaction_manager.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace spdb {
+// the transaction the calling thread is running
+static thread_local Transaction *current_txn = nullptr;
+
+TransactionManager::TransactionManager(Catalog *catalog,
+                                       LogManager *log_manager,
+                                       LockManager *lock_manager)
+    : catalog_(catalog),
+      log_manager_(log_manager),
+      lock_manager_(lock_manager) {}
+
+TransactionManager::~TransactionManager() {
+  // no snapshot outlives the manager
+  for (auto &retired : retired_) {
+    FreePages(retired);
+  }
+}
+
+auto TransactionManager::RowKey(const std::string &table_name,
+                                const Tuple &key) -> std::string {
+  size_t key_size = 0;
+  for (auto &col : key.GetCloums()) {
+    key_size += col.GetSize();
+  }
+  std::string version_key = table_name;
+  version_key.push_back('\0');
+  version_key.append(key.GetData(), key_size);
+  return version_key;
+}
+
+auto TransactionManager::GetShard(const std::string &version_key) -> Shard & {
+  return shards_[std::hash<std::string>()(version_key) %
+                 VERSION_STORE_SHARD_NUMS];
+}
+
+auto TransactionManager::GetTableLatch(const std::string &table_name)
+    -> std::mutex & {
+  std::lock_guard<std::mutex> lock(table_latches_latch_);
+  auto &latch = table_latches_[table_name];
+  if (latch == nullptr) {
+    latch = std::make_unique<std::mutex>();
+  }
+  return *latch;
+}
+
+auto TransactionManager::Register(std::unique_ptr<Transaction> txn)
+    -> Transaction * {
+  auto ptr = txn.get();
+  txns_[ptr] = std::move(txn);
+  return ptr;
+}
+
+auto TransactionManager::Begin() -> Transaction * {
+  txn_id_t txn_id = INVALID_TXN_ID;
+  if (log_manager_ != nullptr) {
+    txn_id = log_manager_->Begin();
+  }
+  std::lock_guard<std::mutex> lock(latch_);
+  if (log_manager_ == nullptr) {
+    txn_id = next_txn_id_++;
+  }
+  current_txn =
+      Register(std::make_unique<Transaction>(txn_id, last_commit_ts_));
+  return current_txn;
+}
+
+auto TransactionManager::BeginSnapshot() -> Transaction * {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto txn = std::make_unique<Transaction>(INVALID_TXN_ID, last_commit_ts_);
+  txn->is_snapshot_ = true;
+  return Register(std::move(txn));
+}
+
+void TransactionManager::Resume(Transaction *txn) {
+  current_txn = txn;
+  if (log_manager_ != nullptr && !txn->is_snapshot_) {
+    log_manager_->Resume(txn->txn_id_);
+  }
+}
+
+void TransactionManager::Suspend() {
+  current_txn = nullptr;
+  if (log_manager_ != nullptr) {
+    log_manager_->Resume(INVALID_TXN_ID);
+  }
+}
+
+auto TransactionManager::Current() -> Transaction * { return current_txn; }
+
+void TransactionManager::Commit(Transaction *txn) {
+  // durable before it is visible
+  if (log_manager_ != nullptr && !txn->is_snapshot_) {
+    log_manager_->Commit(txn->txn_id_);
+  }
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (!txn->write_set_.empty()) {
+      // the versions are stamped before the commit is published, so no
+      // snapshot sees a part of them
+      timestamp_t commit_ts = last_commit_ts_ + 1;
+      std::vector<std::string> version_keys;
+      for (auto &write : txn->write_set_) {
+        auto version_key = write.table_name_;
+        version_key.push_back('\0');
+        version_key.append(write.key_);
+        auto &shard = GetShard(version_key);
+        std::lock_guard<std::mutex> shard_lock(shard.latch_);
+        shard.chains_[version_key].ts_ = commit_ts;
+        version_keys.push_back(std::move(version_key));
+      }
+      last_commit_ts_ = commit_ts;
+      txn->commit_ts_ = commit_ts;
+      commits_.emplace_back(commit_ts, std::move(version_keys));
+    }
+    txn->state_ = TransactionState::COMMITTED;
+  }
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  Finish(txn);
+}
+
+void TransactionManager::Abort(Transaction *txn) {
+  if (!txn->is_snapshot_) {
+    Resume(txn);
+  }
+  for (auto it = txn->write_set_.rbegin(); it != txn->write_set_.rend();
+       ++it) {
+    Rollback(*it);
+  }
+  if (log_manager_ != nullptr && !txn->is_snapshot_) {
+    log_manager_->Abort(txn->txn_id_);
+  }
+  txn->state_ = TransactionState::ABORTED;
+  if (lock_manager_ != nullptr) {
+    lock_manager_->UnlockAll(txn);
+  }
+  Finish(txn);
+}
+
+void TransactionManager::Finish(Transaction *txn) {
+  if (current_txn == txn) {
+    current_txn = nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    txns_.erase(txn);
+  }
+  CollectGarbage();
+}
+
+void TransactionManager::CollectGarbage() {
+  // the versions at or before the watermark are seen by every snapshot
+  std::vector<std::string> version_keys;
+  std::vector<RetiredPages> retired;
+  timestamp_t watermark = 0;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (commits_.empty() && retired_.empty()) {
+      return;
+    }
+    watermark = last_commit_ts_;
+    for (auto &[ptr, running] : txns_) {
+      watermark = std::min(watermark, running->read_ts_);
+    }
+    while (!commits_.empty() && commits_.front().first <= watermark) {
+      auto &keys = commits_.front().second;
+      version_keys.insert(version_keys.end(), keys.begin(), keys.end());
+      commits_.pop_front();
+    }
+    while (!retired_.empty() && retired_.front().ts_ <= watermark) {
+      retired.push_back(std::move(retired_.front()));
+      retired_.pop_front();
+    }
+  }
+
+  for (auto &pages : retired) {
+    FreePages(pages);
+  }
+  for (auto &version_key : version_keys) {
+    auto &shard = GetShard(version_key);
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    auto it = shard.chains_.find(version_key);
+    if (it == shard.chains_.end()) {
+      continue;
+    }
+    auto &chain = it->second;
+    if (chain.ts_ <= watermark) {
+      shard.chains_.erase(it);
+      Undisplace(version_key);
+      continue;
+    }
+    // keep the newest version the oldest snapshot sees
+    auto visible = std::find_if(
+        chain.undo_.begin(), chain.undo_.end(),
+        [&](const UndoVersion &undo) { return undo.ts_ <= watermark; });
+    if (visible != chain.undo_.end()) {
+      chain.undo_.erase(visible + 1, chain.undo_.end());
+    }
+  }
+}
+
+void TransactionManager::FreePages(const RetiredPages &retired) {
+  // the file may be dropped meanwhile
+  if (!catalog_->IsFileExisted(retired.disk_name_)) {
+    return;
+  }
+  auto bpm = catalog_->GetBufferPoolManager(retired.disk_name_);
+  for (auto page_id : retired.page_ids_) {
+    bpm->DeletePage(page_id);
+  }
+}
+
+auto TransactionManager::HasUncommittedWrites(const std::string &table_name)
+    -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  for (auto &[ptr, running] : txns_) {
+    for (auto &write : running->write_set_) {
+      if (write.table_name_ == table_name) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto TransactionManager::CompactTable(const std::string &table_name)
+    -> size_t {
+  if (current_txn != nullptr) {
+    throw std::runtime_error("cannot compact inside a transaction.");
+  }
+  if (!catalog_->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  std::lock_guard<std::mutex> table_lock(GetTableLatch(table_name));
+  if (HasUncommittedWrites(table_name)) {
+    throw std::runtime_error("the table has uncommitted writes.");
+  }
+
+  auto table = catalog_->GetTable(table_name);
+  std::vector<RetiredPages> retired;
+  size_t shrunk = 0;
+  auto compact = [&](const std::string &disk_name,
+                     const std::vector<Cloum> &key_type,
+                     const std::vector<Cloum> &value_type, page_id_t root_id,
+                     int leaf_max_size, int internal_max_size,
+                     LeafLayout layout) {
+    BPlusTree tree(catalog_->GetBufferPoolManager(disk_name), key_type,
+                   value_type, leaf_max_size, internal_max_size, root_id,
+                   layout);
+    RetiredPages pages{0, disk_name, {}};
+    size_t page_nums = tree.Compact(&pages.page_ids_);
+    if (page_nums == 0) {
+      return;
+    }
+    catalog_->ModifyRoot(disk_name, tree.GetRootPageId());
+    if (pages.page_ids_.size() > page_nums) {
+      shrunk += pages.page_ids_.size() - page_nums;
+    }
+    retired.push_back(std::move(pages));
+  };
+  compact(table.disk_name_, table.key_type_, table.value_type_,
+          table.root_id_, table.leaf_max_size_, table.internal_max_size_,
+          table.layout_);
+  for (auto &index : table.indexes_) {
+    compact(index.disk_name_, index.key_type_, table.key_type_,
+            index.root_id_, index.leaf_max_size_, index.internal_max_size_,
+            LeafLayout::Row);
+  }
+  if (retired.empty()) {
+    return 0;
+  }
+
+  {
+    // published like a commit, the snapshots taken from now on start from
+    // the new roots, and the old pages wait for the older ones
+    std::lock_guard<std::mutex> lock(latch_);
+    timestamp_t ts = ++last_commit_ts_;
+    for (auto &pages : retired) {
+      pages.ts_ = ts;
+      retired_.push_back(std::move(pages));
+    }
+  }
+  CollectGarbage();
+  return shrunk;
+}
+
+auto TransactionManager::VacuumTable(const std::string &table_name)
+    -> size_t {
+  std::unordered_map<std::string, std::vector<page_id_t>> retired;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto &pages : retired_) {
+      auto &page_ids = retired[pages.disk_name_];
+      page_ids.insert(page_ids.end(), pages.page_ids_.begin(),
+                      pages.page_ids_.end());
+    }
+  }
+  return catalog_->Vacuum(table_name, retired);
+}
+
+auto TransactionManager::GetRetiredPageCount() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  size_t count = 0;
+  for (auto &retired : retired_) {
+    count += retired.page_ids_.size();
+  }
+  return count;
+}
+
+auto TransactionManager::InsertRow(Transaction *txn,
+                                   const std::string &table_name,
+                                   const Tuple &row) -> bool {
+  return InsertRows(txn, table_name, {row}) == 1;
+}
+
+auto TransactionManager::InsertRows(Transaction *txn,
+                                    const std::string &table_name,
+                                    const std::vector<Tuple> &rows)
+    -> size_t {
+  if (txn->is_snapshot_) {
+    throw std::runtime_error("a snapshot only reads.");
+  }
+  Resume(txn);
+  if (!catalog_->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  auto table = catalog_->GetTable(table_name);
+  std::vector<std::pair<Tuple, Tuple>> pairs;
+  pairs.reserve(rows.size());
+  for (auto &row : rows) {
+    pairs.emplace_back(row.Project(table.key_type_), row);
+  }
+  // the first row of a key wins, as if they were inserted in order
+  std::stable_sort(
+      pairs.begin(), pairs.end(),
+      [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<Tuple> keys;
+  keys.reserve(pairs.size());
+  for (auto &pair : pairs) {
+    keys.push_back(pair.first);
+  }
+  LockRows(txn, table_name, keys);
+  std::lock_guard<std::mutex> table_lock(GetTableLatch(table_name));
+  // the root changes until the table is latched
+  table = catalog_->GetTable(table_name);
+  CheckConflicts(txn, table_name, keys);
+
+  BPlusTree tree(catalog_->GetBufferPoolManager(table_name), table.key_type_,
+                 table.value_type_, table.leaf_max_size_,
+                 table.internal_max_size_, table.root_id_, table.layout_);
+  size_t inserted = WriteInserts(txn, table_name, &tree, pairs);
+  catalog_->ModifyTableRoot(table_name, tree.GetRootPageId());
+  EndStatement();
+  return inserted;
+}
+
+auto TransactionManager::DeleteRows(Transaction *txn,
+                                    const std::string &table_name,
+                                    const std::vector<Tuple> &keys)
+    -> size_t {
+  if (txn->is_snapshot_) {
+    throw std::runtime_error("a snapshot only reads.");
+  }
+  Resume(txn);
+  if (!catalog_->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  auto sorted = keys;
+  std::sort(sorted.begin(), sorted.end());
+  LockRows(txn, table_name, sorted);
+  std::lock_guard<std::mutex> table_lock(GetTableLatch(table_name));
+  auto table = catalog_->GetTable(table_name);
+  CheckConflicts(txn, table_name, sorted);
+
+  BPlusTree tree(catalog_->GetBufferPoolManager(table_name), table.key_type_,
+                 table.value_type_, table.leaf_max_size_,
+                 table.internal_max_size_, table.root_id_, table.layout_);
+  size_t deleted = WriteDeletes(txn, table_name, &tree, sorted);
+  catalog_->ModifyTableRoot(table_name, tree.GetRootPageId());
+  EndStatement();
+  return deleted;
+}
+
+auto TransactionManager::UpdateRows(
+    Transaction *txn, const std::string &table_name,
+    const std::vector<std::pair<Tuple, Tuple>> &rows) -> size_t {
+  if (txn->is_snapshot_) {
+    throw std::runtime_error("a snapshot only reads.");
+  }
+  Resume(txn);
+  if (!catalog_->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  auto table = catalog_->GetTable(table_name);
+  // the rows keeping their key are written in place, the others move
+  std::vector<std::pair<Tuple, Tuple>> in_place;
+  std::vector<Tuple> moved_keys;
+  std::vector<std::pair<Tuple, Tuple>> moved;
+  std::vector<Tuple> keys;
+  for (auto &[old_row, new_row] : rows) {
+    auto old_key = old_row.Project(table.key_type_);
+    auto new_key = new_row.Project(table.key_type_);
+    keys.push_back(old_key);
+    if (old_key == new_key) {
+      in_place.emplace_back(old_key, new_row);
+    } else {
+      keys.push_back(new_key);
+      moved_keys.push_back(old_key);
+      moved.emplace_back(new_key, new_row);
+    }
+  }
+  auto by_key = [](const auto &a, const auto &b) { return a.first < b.first; };
+  std::sort(in_place.begin(), in_place.end(), by_key);
+  std::sort(moved.begin(), moved.end(), by_key);
+  std::sort(moved_keys.begin(), moved_keys.end());
+  std::sort(keys.begin(), keys.end());
+  LockRows(txn, table_name, keys);
+  std::lock_guard<std::mutex> table_lock(GetTableLatch(table_name));
+  table = catalog_->GetTable(table_name);
+  CheckConflicts(txn, table_name, keys);
+
+  BPlusTree tree(catalog_->GetBufferPoolManager(table_name), table.key_type_,
+                 table.value_type_, table.leaf_max_size_,
+                 table.internal_max_size_, table.root_id_, table.layout_);
+  // a row moves to a key no row takes after the update
+  Tuple row{table.value_type_};
+  for (size_t i = 0; i < moved.size(); ++i) {
+    auto &key = moved[i].first;
+    if ((i > 0 && moved[i - 1].first == key) ||
+        (tree.GetValue(key, row) &&
+         !std::binary_search(moved_keys.begin(), moved_keys.end(), key))) {
+      throw std::runtime_error("the key is already existed.");
+    }
+  }
+
+  std::vector<Tuple> old_rows;
+  std::vector<size_t> reindexed;
+  size_t updated = tree.UpdateBatch(in_place, [&](size_t i,
+                                                  const Tuple &old_row) {
+    auto &[key, new_row] = in_place[i];
+    bool is_reindexed = false;
+    for (auto &index : table.indexes_) {
+      is_reindexed = is_reindexed || !(old_row.Project(index.key_type_) ==
+                                       new_row.Project(index.key_type_));
+    }
+    // the older snapshots no longer find the row in the indexes
+    if (is_reindexed) {
+      Displace(table_name, key);
+      old_rows.push_back(old_row);
+      reindexed.push_back(i);
+    }
+    AddVersion(txn, table_name, key, &old_row);
+  });
+  std::vector<std::pair<Tuple, Tuple>> entries;
+  for (size_t j = 0; j < reindexed.size(); ++j) {
+    catalog_->RemoveIndexEntries(table_name, old_rows[j]);
+    entries.push_back(in_place[reindexed[j]]);
+  }
+  catalog_->InsertIndexEntries(table_name, entries);
+
+  updated += WriteDeletes(txn, table_name, &tree, moved_keys);
+  WriteInserts(txn, table_name, &tree, moved);
+  catalog_->ModifyTableRoot(table_name, tree.GetRootPageId());
+  EndStatement();
+  return updated;
+}
+
+void TransactionManager::LockRows(Transaction *txn,
+                                  const std::string &table_name,
+                                  const std::vector<Tuple> &keys) {
+  if (lock_manager_ == nullptr) {
+    return;
+  }
+  std::string last;
+  for (auto &key : keys) {
+    auto version_key = RowKey(table_name, key);
+    if (version_key != last) {
+      lock_manager_->LockExclusive(txn, version_key);
+    }
+    last = std::move(version_key);
+  }
+}
+
+void TransactionManager::CheckConflicts(Transaction *txn,
+                                        const std::string &table_name,
+                                        const std::vector<Tuple> &keys) {
+  for (auto &key : keys) {
+    auto version_key = RowKey(table_name, key);
+    auto &shard = GetShard(version_key);
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    auto it = shard.chains_.find(version_key);
+    if (it != shard.chains_.end() && it->second.ts_ != txn->GetTempTs() &&
+        it->second.ts_ > txn->read_ts_) {
+      throw TransactionAbortException(
+          "the row is written by another transaction.");
+    }
+  }
+}
+
+void TransactionManager::AddVersion(Transaction *txn,
+                                    const std::string &table_name,
+                                    const Tuple &key, const Tuple *row) {
+  auto version_key = RowKey(table_name, key);
+  std::string value;
+  if (row != nullptr) {
+    size_t value_size = 0;
+    for (auto &col : row->GetCloums()) {
+      value_size += col.GetSize();
+    }
+    value.assign(row->GetData(), value_size);
+  }
+  {
+    auto &shard = GetShard(version_key);
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    auto &chain = shard.chains_[version_key];
+    if (chain.ts_ == txn->GetTempTs()) {
+      return;
+    }
+    chain.undo_.insert(chain.undo_.begin(),
+                       UndoVersion{chain.ts_, row == nullptr, value});
+    chain.ts_ = txn->GetTempTs();
+  }
+  WriteRecord write{table_name, version_key.substr(table_name.size() + 1)};
+  // logged before the pages, for the recovery to undo the write by the row
+  if (log_manager_ != nullptr) {
+    log_manager_->AppendRowUpdate(table_name, write.key_, value,
+                                  &write.undo_next_lsn_);
+  }
+  txn->write_set_.push_back(std::move(write));
+}
+
+auto TransactionManager::WriteInserts(
+    Transaction *txn, const std::string &table_name, BPlusTree *tree,
+    const std::vector<std::pair<Tuple, Tuple>> &pairs) -> size_t {
+  std::vector<std::pair<Tuple, Tuple>> entries;
+  tree->InsertBatch(pairs, [&](size_t i) {
+    // the version goes first, so a reader never takes the row for a
+    // committed one
+    AddVersion(txn, table_name, pairs[i].first, nullptr);
+    entries.push_back(pairs[i]);
+  });
+  catalog_->InsertIndexEntries(table_name, entries);
+  return entries.size();
+}
+
+auto TransactionManager::WriteDeletes(Transaction *txn,
+                                      const std::string &table_name,
+                                      BPlusTree *tree,
+                                      const std::vector<Tuple> &keys)
+    -> size_t {
+  auto table = catalog_->GetTable(table_name);
+  Tuple row{table.value_type_};
+  size_t deleted = 0;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if ((i > 0 && keys[i - 1] == keys[i]) || !tree->GetValue(keys[i], row)) {
+      continue;
+    }
+    // noted before the row leaves the tree, for the readers passing by
+    Displace(table_name, keys[i]);
+    AddVersion(txn, table_name, keys[i], &row);
+    tree->Remove(keys[i]);
+    catalog_->RemoveIndexEntries(table_name, row);
+    ++deleted;
+  }
+  return deleted;
+}
+
+void TransactionManager::EndStatement() {
+  if (log_manager_ != nullptr) {
+    log_manager_->AppendStatementEnd();
+  }
+}
+
+void TransactionManager::Displace(const std::string &table_name,
+                                  const Tuple &key) {
+  std::lock_guard<std::mutex> lock(displaced_latch_);
+  if (displaced_[table_name].insert(key).second) {
+    ++displaced_count_;
+  }
+}
+
+void TransactionManager::Undisplace(const std::string &version_key) {
+  if (displaced_count_ == 0) {
+    return;
+  }
+  auto table_name = version_key.substr(0, version_key.find('\0'));
+  std::lock_guard<std::mutex> lock(displaced_latch_);
+  auto it = displaced_.find(table_name);
+  if (it == displaced_.end()) {
+    return;
+  }
+  auto &keys = it->second;
+  // the keys of a table are alike
+  Tuple key = *keys.begin();
+  std::string key_data = version_key.substr(table_name.size() + 1);
+  key.SetValues(key_data.data());
+  if (keys.erase(key) != 0) {
+    --displaced_count_;
+  }
+  if (keys.empty()) {
+    displaced_.erase(it);
+  }
+}
+
+void TransactionManager::Rollback(const WriteRecord &write) {
+  std::lock_guard<std::mutex> table_lock(GetTableLatch(write.table_name_));
+  if (!catalog_->IsExisted(write.table_name_)) {
+    return;
+  }
+  auto table = catalog_->GetTable(write.table_name_);
+  std::string key_data = write.key_;
+  Tuple key{table.key_type_};
+  key.SetValues(key_data.data());
+  auto version_key = RowKey(write.table_name_, key);
+  auto &shard = GetShard(version_key);
+  UndoVersion undo;
+  {
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    undo = shard.chains_.at(version_key).undo_.front();
+  }
+
+  // put the older version back in the tree, then drop the newer one from
+  // the versions
+  Tuple row{table.value_type_};
+  if (!undo.is_deleted_) {
+    row.SetValues(undo.value_.data());
+  }
+  catalog_->RestoreRow(write.table_name_, key,
+                       undo.is_deleted_ ? nullptr : &row);
+  // the row is back, the recovery doesn't undo the write again
+  if (log_manager_ != nullptr) {
+    log_manager_->AppendRowClr(write.undo_next_lsn_);
+  }
+
+  bool is_kept = false;
+  {
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    auto it = shard.chains_.find(version_key);
+    auto &chain = it->second;
+    chain.ts_ = undo.ts_;
+    chain.undo_.erase(chain.undo_.begin());
+    if (chain.undo_.empty()) {
+      // a displaced row is dropped with its chain, once the readers which
+      // may have passed by have finished
+      std::lock_guard<std::mutex> lock(displaced_latch_);
+      auto displaced = displaced_.find(write.table_name_);
+      is_kept = displaced != displaced_.end() && displaced->second.count(key);
+      if (!is_kept) {
+        shard.chains_.erase(it);
+      }
+    }
+  }
+  if (is_kept) {
+    std::lock_guard<std::mutex> lock(latch_);
+    commits_.emplace_back(last_commit_ts_ + 1,
+                          std::vector<std::string>{version_key});
+  }
+}
+
+auto TransactionManager::FindOlderVersion(const Transaction *txn,
+                                          const VersionChain &chain,
+                                          bool *is_newest)
+    -> const UndoVersion * {
+  timestamp_t read_ts = txn == nullptr ? last_commit_ts_.load() : txn->read_ts_;
+  *is_newest = (txn != nullptr && chain.ts_ == txn->GetTempTs()) ||
+               chain.ts_ <= read_ts;
+  if (*is_newest) {
+    return nullptr;
+  }
+  for (auto &undo : chain.undo_) {
+    if (undo.ts_ <= read_ts) {
+      return &undo;
+    }
+  }
+  return nullptr;
+}
+
+auto TransactionManager::ReadRow(const Transaction *txn,
+                                 const std::string &table_name,
+                                 const Tuple &key, Tuple *row) -> bool {
+  auto version_key = RowKey(table_name, key);
+  auto &shard = GetShard(version_key);
+  std::lock_guard<std::mutex> shard_lock(shard.latch_);
+  auto it = shard.chains_.find(version_key);
+  if (it == shard.chains_.end()) {
+    return true;
+  }
+  bool is_newest;
+  auto undo = FindOlderVersion(txn, it->second, &is_newest);
+  if (is_newest) {
+    return true;
+  }
+  if (undo == nullptr || undo->is_deleted_) {
+    return false;
+  }
+  row->SetValues(const_cast<char *>(undo->value_.data()));
+  return true;
+}
+
+auto TransactionManager::ReadOlderVersion(const Transaction *txn,
+                                          const std::string &table_name,
+                                          const Tuple &key, Tuple *row)
+    -> bool {
+  auto version_key = RowKey(table_name, key);
+  auto &shard = GetShard(version_key);
+  std::lock_guard<std::mutex> shard_lock(shard.latch_);
+  auto it = shard.chains_.find(version_key);
+  if (it == shard.chains_.end()) {
+    return false;
+  }
+  bool is_newest;
+  auto undo = FindOlderVersion(txn, it->second, &is_newest);
+  if (undo == nullptr || undo->is_deleted_) {
+    return false;
+  }
+  row->SetValues(const_cast<char *>(undo->value_.data()));
+  return true;
+}
+
+auto TransactionManager::NextDisplacedRow(const Transaction *txn,
+                                          const std::string &table_name,
+                                          const Tuple *low,
+                                          bool is_low_inclusive,
+                                          const Tuple *high, Tuple *key,
+                                          Tuple *row) -> bool {
+  if (displaced_count_ == 0) {
+    return false;
+  }
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(displaced_latch_);
+      auto it = displaced_.find(table_name);
+      if (it == displaced_.end()) {
+        return false;
+      }
+      auto &keys = it->second;
+      auto next = low == nullptr      ? keys.begin()
+                  : is_low_inclusive ? keys.lower_bound(*low)
+                                     : keys.upper_bound(*low);
+      if (next == keys.end() || (high != nullptr && !(*next < *high))) {
+        return false;
+      }
+      *key = *next;
+    }
+    // the versions are read without the latch, the keys skipped are the
+    // ones txn sees in the tree or not at all
+    if (ReadOlderVersion(txn, table_name, *key, row)) {
+      return true;
+    }
+    low = key;
+    is_low_inclusive = false;
+  }
+}
+
+auto TransactionManager::GetVersionCount() -> size_t {
+  size_t count = 0;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> shard_lock(shard.latch_);
+    count += shard.chains_.size();
+  }
+  return count;
+}
+
+StatementSnapshot::StatementSnapshot(TransactionManager *txn_manager)
+    : txn_manager_(txn_manager) {
+  if (txn_manager_ == nullptr) {
+    return;
+  }
+  txn_ = TransactionManager::Current();
+  if (txn_ == nullptr) {
+    txn_ = txn_manager_->BeginSnapshot();
+    is_own_ = true;
+  }
+}
+
+StatementSnapshot::~StatementSnapshot() {
+  if (is_own_) {
+    txn_manager_->Commit(txn_);
+  }
+}
+
+auto StatementSnapshot::ReadRow(const std::string &table_name,
+                                const Tuple &key, Tuple *row) -> bool {
+  return txn_manager_ == nullptr ||
+         txn_manager_->ReadRow(txn_, table_name, key, row);
+}
+
+auto StatementSnapshot::ReadOlderVersion(const std::string &table_name,
+                                         const Tuple &key, Tuple *row)
+    -> bool {
+  return txn_manager_ != nullptr &&
+         txn_manager_->ReadOlderVersion(txn_, table_name, key, row);
+}
+
+auto StatementSnapshot::NextDisplacedRow(const std::string &table_name,
+                                         const Tuple *low,
+                                         bool is_low_inclusive,
+                                         const Tuple *high, Tuple *key,
+                                         Tuple *row) -> bool {
+  return txn_manager_ != nullptr &&
+         txn_manager_->NextDisplacedRow(txn_, table_name, low,
+                                        is_low_inclusive, high, key, row);
+}
+
+auto StatementSnapshot::SeesNewest() -> bool {
+  // a write keeps the older version before it reaches the tree
+  return txn_manager_ == nullptr || txn_manager_->GetVersionCount() == 0;
+}
+}  // namespace spdb
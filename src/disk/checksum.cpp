@@ -0,0 +1,142 @@
+#include "disk/checksum.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "disk/disk_manager.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace spdb {
+// the reflected Castagnoli polynomial
+static const uint32_t CRC32C_POLY = 0x82F63B78;
+
+static auto MakeTable() -> std::vector<uint32_t> {
+  std::vector<uint32_t> table(256);
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+static auto Crc32cSoftware(uint32_t crc, const char *data, size_t size)
+    -> uint32_t {
+  static const std::vector<uint32_t> table = MakeTable();
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) static auto Crc32cHardware(
+    uint32_t crc, const char *data, size_t size) -> uint32_t {
+  uint64_t crc64 = crc;
+  for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(uint64_t));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += sizeof(uint64_t);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; size > 0; --size) {
+    crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data++));
+  }
+  return crc;
+}
+#endif
+
+auto Crc32c(const char *data, size_t size, uint32_t crc) -> uint32_t {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  if (has_sse42) {
+    return ~Crc32cHardware(~crc, data, size);
+  }
+#endif
+  return ~Crc32cSoftware(~crc, data, size);
+}
+
+auto PageChecksum(const char *data) -> uint32_t {
+  size_t end = PAGE_CHECKSUM_OFFSET + sizeof(uint32_t);
+  uint32_t crc = Crc32c(data, PAGE_CHECKSUM_OFFSET);
+  return Crc32c(data + end, PAGE_SIZE - end, crc);
+}
+
+void SetPageChecksum(char *data) {
+  uint32_t flags;
+  memcpy(&flags, data + PAGE_FLAGS_OFFSET, sizeof(uint32_t));
+  flags |= PAGE_CHECKSUM_FLAG;
+  memcpy(data + PAGE_FLAGS_OFFSET, &flags, sizeof(uint32_t));
+  uint32_t checksum = PageChecksum(data);
+  memcpy(data + PAGE_CHECKSUM_OFFSET, &checksum, sizeof(uint32_t));
+}
+
+auto HasPageChecksum(const char *data) -> bool {
+  uint32_t flags;
+  memcpy(&flags, data + PAGE_FLAGS_OFFSET, sizeof(uint32_t));
+  return (flags & PAGE_CHECKSUM_FLAG) != 0;
+}
+
+void ClearPageChecksumFlag(char *data) {
+  uint32_t flags;
+  memcpy(&flags, data + PAGE_FLAGS_OFFSET, sizeof(uint32_t));
+  flags &= ~PAGE_CHECKSUM_FLAG;
+  memcpy(data + PAGE_FLAGS_OFFSET, &flags, sizeof(uint32_t));
+}
+
+auto IsPageChecksumValid(const char *data) -> bool {
+  if (!HasPageChecksum(data)) {
+    return true;
+  }
+  uint32_t checksum;
+  memcpy(&checksum, data + PAGE_CHECKSUM_OFFSET, sizeof(uint32_t));
+  return checksum == PageChecksum(data);
+}
+
+auto VerifyFile(const std::string &file_name) -> std::vector<page_id_t> {
+  std::ifstream file(file_name, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("can't open db file");
+  }
+  std::vector<page_id_t> damaged_pages;
+  std::vector<char> data(PAGE_SIZE);
+  if (DiskManager::IsCompressedFile(file_name)) {
+    // the pages are checked as they are decompressed
+    DiskManager disk(file_name);
+    page_id_t page_count = disk.GetFileSize() / PAGE_SIZE;
+    for (page_id_t page_id = 0; page_id < page_count; ++page_id) {
+      try {
+        disk.ReadPage(page_id, data.data());
+      } catch (std::runtime_error &e) {
+        damaged_pages.push_back(page_id);
+        continue;
+      }
+      if (!IsPageChecksumValid(data.data())) {
+        damaged_pages.push_back(page_id);
+      }
+    }
+    return damaged_pages;
+  }
+  for (page_id_t page_id = 0;; ++page_id) {
+    file.read(data.data(), PAGE_SIZE);
+    if (file.gcount() == 0) {
+      break;
+    }
+    // a page cut short counts as damaged as well
+    if (file.gcount() < PAGE_SIZE || !IsPageChecksumValid(data.data())) {
+      damaged_pages.push_back(page_id);
+    }
+    if (file.gcount() < PAGE_SIZE) {
+      break;
+    }
+  }
+  return damaged_pages;
+}
+}  // namespace spdb
@@ -0,0 +1,259 @@
+#include "disk/column_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "disk/checksum.h"
+#include "disk/lz4.h"
+
+namespace spdb {
+static const char COLUMN_MAGIC[8] = {'S', 'P', 'D', 'B', 'C', 'O', 'L', '\0'};
+
+// compare two values of a cloum, as the tuples do
+static auto CompareValue(const Cloum &col, const char *a, const char *b)
+    -> int {
+  switch (col.GetType()) {
+    case CloumType::INT: {
+      int x;
+      int y;
+      memcpy(&x, a, sizeof(int));
+      memcpy(&y, b, sizeof(int));
+      return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    case CloumType::CHAR:
+      return strncmp(a, b, col.GetSize());
+    default:
+      return memcmp(a, b, col.GetSize());
+  }
+}
+
+template <class T>
+static void WriteValue(std::ofstream *file, T value) {
+  file->write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+ColumnFileWriter::ColumnFileWriter(const std::string &file_name,
+                                   const std::vector<Cloum> &cols,
+                                   const std::vector<std::string> &key_names)
+    : file_(file_name, std::ios::binary | std::ios::trunc), cols_(cols) {
+  if (!file_.is_open()) {
+    throw std::runtime_error("can't create " + file_name + ".");
+  }
+  file_.write(COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+  WriteValue<uint32_t>(&file_, cols_.size());
+  size_t row_size = 0;
+  for (auto &col : cols_) {
+    WriteValue<uint8_t>(&file_, static_cast<uint8_t>(col.GetType()));
+    WriteValue<uint32_t>(&file_, col.GetSize());
+    WriteValue<uint16_t>(&file_, col.cloum_name_.size());
+    file_.write(col.cloum_name_.data(), col.cloum_name_.size());
+    row_size += col.GetSize();
+  }
+  WriteValue<uint32_t>(&file_, key_names.size());
+  for (auto &name : key_names) {
+    WriteValue<uint16_t>(&file_, name.size());
+    file_.write(name.data(), name.size());
+  }
+
+  block_capacity_ =
+      std::max<size_t>(COLUMN_BLOCK_SIZE / std::max<size_t>(row_size, 1), 1);
+  chunks_.resize(cols_.size());
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    chunks_[i].reserve(block_capacity_ * cols_[i].GetSize());
+  }
+}
+
+void ColumnFileWriter::Append(const Tuple &row) {
+  const char *data = row.GetData();
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    chunks_[i].append(data, cols_[i].GetSize());
+    data += cols_[i].GetSize();
+  }
+  if (++block_rows_ == block_capacity_) {
+    WriteBlock();
+  }
+}
+
+void ColumnFileWriter::WriteBlock() {
+  if (block_rows_ == 0) {
+    return;
+  }
+  WriteValue<uint32_t>(&file_, block_rows_);
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    auto &col = cols_[i];
+    const char *values = chunks_[i].data();
+    const char *min = values;
+    const char *max = values;
+    for (size_t j = 1; j < block_rows_; ++j) {
+      const char *value = values + j * col.GetSize();
+      if (CompareValue(col, value, min) < 0) {
+        min = value;
+      }
+      if (CompareValue(col, value, max) > 0) {
+        max = value;
+      }
+    }
+    file_.write(min, col.GetSize());
+    file_.write(max, col.GetSize());
+
+    // kept as they are if compressing doesn't make them smaller
+    size_t size = chunks_[i].size();
+    compressed_.resize(size);
+    size_t stored_size =
+        size > 1 ? Lz4Compress(values, size, compressed_.data(), size - 1) : 0;
+    const char *stored = compressed_.data();
+    if (stored_size == 0) {
+      stored = values;
+      stored_size = size;
+    }
+    WriteValue<uint32_t>(&file_, stored_size);
+    WriteValue<uint32_t>(&file_, Crc32c(stored, stored_size));
+    file_.write(stored, stored_size);
+    chunks_[i].clear();
+  }
+  rows_ += block_rows_;
+  block_rows_ = 0;
+}
+
+auto ColumnFileWriter::Finish() -> size_t {
+  WriteBlock();
+  WriteValue<uint32_t>(&file_, 0);
+  WriteValue<uint64_t>(&file_, rows_);
+  file_.flush();
+  if (!file_.good()) {
+    throw std::runtime_error("write error.");
+  }
+  file_.close();
+  return rows_;
+}
+
+template <class T>
+static auto ReadValue(std::ifstream *file) -> T {
+  T value;
+  if (!file->read(reinterpret_cast<char *>(&value), sizeof(T))) {
+    throw std::runtime_error("the column file is damaged.");
+  }
+  return value;
+}
+
+static auto ReadString(std::ifstream *file, size_t size) -> std::string {
+  std::string text(size, '\0');
+  if (!file->read(text.data(), size)) {
+    throw std::runtime_error("the column file is damaged.");
+  }
+  return text;
+}
+
+ColumnFileReader::ColumnFileReader(const std::string &file_name)
+    : file_(file_name, std::ios::binary) {
+  if (!file_.is_open()) {
+    throw std::runtime_error("can't open " + file_name + ".");
+  }
+  char magic[sizeof(COLUMN_MAGIC)];
+  if (!file_.read(magic, sizeof(magic)) ||
+      memcmp(magic, COLUMN_MAGIC, sizeof(magic)) != 0) {
+    throw std::runtime_error(file_name + " is not a column file.");
+  }
+  auto col_nums = ReadValue<uint32_t>(&file_);
+  for (size_t i = 0; i < col_nums; ++i) {
+    auto type = static_cast<CloumType>(ReadValue<uint8_t>(&file_));
+    auto size = ReadValue<uint32_t>(&file_);
+    auto name = ReadString(&file_, ReadValue<uint16_t>(&file_));
+    if ((type != CloumType::INT && type != CloumType::BOOL &&
+         type != CloumType::CHAR) ||
+        size == 0 || (type == CloumType::INT && size != sizeof(int))) {
+      throw std::runtime_error("the column file is damaged.");
+    }
+    cols_.emplace_back(name, CloumAtr{type, size});
+    row_size_ += size;
+  }
+  auto key_nums = ReadValue<uint32_t>(&file_);
+  for (size_t i = 0; i < key_nums; ++i) {
+    key_names_.push_back(ReadString(&file_, ReadValue<uint16_t>(&file_)));
+  }
+  if (cols_.empty()) {
+    throw std::runtime_error("the column file is damaged.");
+  }
+  chunks_.resize(cols_.size());
+  row_.resize(row_size_);
+}
+
+auto ColumnFileReader::NextBlock() -> bool {
+  if (is_end_) {
+    return false;
+  }
+  block_rows_ = ReadValue<uint32_t>(&file_);
+  block_index_ = 0;
+  if (block_rows_ == 0) {
+    ReadValue<uint64_t>(&file_);
+    is_end_ = true;
+    is_loaded_ = true;
+    return false;
+  }
+  // the values are passed over, LoadBlock comes back for them
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    auto &chunk = chunks_[i];
+    size_t size = cols_[i].GetSize();
+    chunk.min_ = ReadString(&file_, size);
+    chunk.max_ = ReadString(&file_, size);
+    chunk.stored_size_ = ReadValue<uint32_t>(&file_);
+    chunk.checksum_ = ReadValue<uint32_t>(&file_);
+    chunk.offset_ = file_.tellg();
+    if (chunk.stored_size_ > block_rows_ * size ||
+        !file_.seekg(chunk.stored_size_, std::ios::cur)) {
+      throw std::runtime_error("the column file is damaged.");
+    }
+  }
+  is_loaded_ = false;
+  return true;
+}
+
+void ColumnFileReader::LoadBlock() {
+  auto next_block = file_.tellg();
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    auto &chunk = chunks_[i];
+    size_t size = block_rows_ * cols_[i].GetSize();
+    file_.seekg(chunk.offset_);
+    stored_ = ReadString(&file_, chunk.stored_size_);
+    if (Crc32c(stored_.data(), stored_.size()) != chunk.checksum_) {
+      throw std::runtime_error("the column file is damaged.");
+    }
+    if (chunk.stored_size_ == size) {
+      chunk.values_.swap(stored_);
+    } else {
+      chunk.values_.resize(size);
+      if (!Lz4Decompress(stored_.data(), stored_.size(),
+                         chunk.values_.data(), size)) {
+        throw std::runtime_error("the column file is damaged.");
+      }
+    }
+  }
+  file_.seekg(next_block);
+  is_loaded_ = true;
+}
+
+auto ColumnFileReader::Next(Tuple *row) -> bool {
+  while (true) {
+    if (!is_loaded_) {
+      LoadBlock();
+    }
+    if (block_index_ < block_rows_) {
+      break;
+    }
+    if (!NextBlock()) {
+      return false;
+    }
+  }
+  size_t offset = 0;
+  for (size_t i = 0; i < cols_.size(); ++i) {
+    size_t size = cols_[i].GetSize();
+    memcpy(&row_[offset], chunks_[i].values_.data() + block_index_ * size,
+           size);
+    offset += size;
+  }
+  ++block_index_;
+  row->SetValues(row_.data());
+  return true;
+}
+}  // namespace spdb
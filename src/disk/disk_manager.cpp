@@ -1,7 +1,44 @@
 #include "disk/disk_manager.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include "disk/checksum.h"
+#include "disk/lz4.h"
+
 namespace spdb {
-DiskManager::DiskManager(const std::string& name) {
+static_assert(PAGE_SIZE % COMPRESSED_EXTENT_SIZE == 0,
+              "a page should take whole units");
+
+static const uint32_t PAGE_UNITS = PAGE_SIZE / COMPRESSED_EXTENT_SIZE;
+static const char FILE_MAGIC[8] = {'S', 'P', 'D', 'B', 'L', 'Z', '4', '\0'};
+static const char MAP_MAGIC[8] = {'S', 'P', 'D', 'B', 'M', 'A', 'P', '\0'};
+
+// Force a file, or a directory, to the disk.
+static void SyncFile(const std::string& name) {
+  int fd = open(name.data(), O_RDONLY);
+  if (fd == -1) {
+    throw std::runtime_error("can't open db file");
+  }
+  int result = fsync(fd);
+  close(fd);
+  if (result != 0) {
+    throw std::runtime_error("sync error.");
+  }
+}
+
+static auto DirectoryOf(const std::string& name) -> std::string {
+  auto directory = std::filesystem::path(name).parent_path();
+  return directory.empty() ? "." : directory.string();
+}
+
+DiskManager::DiskManager(const std::string& name, bool is_compressed) {
   db_name_ = name;
   db_file_.open(db_name_, std::ios::binary | std::ios::in | std::ios::out);
   if (!db_file_.is_open()) {
@@ -12,18 +49,60 @@ DiskManager::DiskManager(const std::string& name) {
       throw std::runtime_error("can't open db file");
     }
   }
+  size_t file_size = GetRawFileSize();
+  if (file_size == 0 && is_compressed) {
+    // the header unit, and an empty map, so the file is known as compressed
+    // from now on
+    char header[COMPRESSED_EXTENT_SIZE] = {};
+    memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    db_file_.write(header, COMPRESSED_EXTENT_SIZE);
+    is_compressed_ = true;
+    is_map_changed_ = true;
+    SyncCompressed();
+  } else if (file_size >= sizeof(FILE_MAGIC)) {
+    char magic[sizeof(FILE_MAGIC)];
+    db_file_.read(magic, sizeof(FILE_MAGIC));
+    if (memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0) {
+      is_compressed_ = true;
+      LoadMap();
+    }
+  }
 }
 
-auto DiskManager::GetFileSize() -> size_t {
+DiskManager::~DiskManager() {
+  if (!db_file_.is_open()) {
+    return;
+  }
+  try {
+    ShutDown();
+  } catch (std::runtime_error& e) {
+    // the pages written since the map was last saved are redone from the
+    // log, as after a crash
+  }
+}
+
+auto DiskManager::GetRawFileSize() -> size_t {
   db_file_.seekg(0, std::ios::end);
   auto size = db_file_.tellg();
   db_file_.seekg(0, std::ios::beg);
   return size;
 }
 
+auto DiskManager::GetFileSize() -> size_t {
+  if (!is_compressed_) {
+    return GetRawFileSize();
+  }
+  std::lock_guard<std::mutex> lock(latch_);
+  return extents_.size() * PAGE_SIZE;
+}
+
 void DiskManager::ReadPage(page_id_t id, char* data) {
+  if (is_compressed_) {
+    ReadCompressedPage(id, data);
+    return;
+  }
   std::lock_guard<std::mutex> lock(latch_);
-  size_t file_size = GetFileSize();
+  size_t file_size = GetRawFileSize();
   size_t page_offset = id * PAGE_SIZE;
   if (page_offset >= file_size) {
     throw std::runtime_error("try reading out of the range of this file.");
@@ -36,8 +115,12 @@ void DiskManager::ReadPage(page_id_t id, char* data) {
   }
 }
 void DiskManager::WritePage(page_id_t id, char* data) {
+  if (is_compressed_) {
+    WriteCompressedPage(id, data);
+    return;
+  }
   std::lock_guard<std::mutex> lock(latch_);
-  size_t file_size = GetFileSize();
+  size_t file_size = GetRawFileSize();
   size_t page_offset = id * PAGE_SIZE;
   if (page_offset > file_size) {
     throw std::runtime_error("the page id should on order");
@@ -51,5 +134,310 @@ void DiskManager::WritePage(page_id_t id, char* data) {
   }
 }
 
-void DiskManager::ShutDown() { db_file_.close(); }
-}  // namespace spdb
\ No newline at end of file
+void DiskManager::ReadCompressedPage(page_id_t id, char* data) {
+  char buffer[PAGE_SIZE];
+  Extent extent;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (id < 0 || static_cast<size_t>(id) >= extents_.size()) {
+      throw std::runtime_error("try reading out of the range of this file.");
+    }
+    extent = extents_[id];
+    size_t size = extent.units_ * COMPRESSED_EXTENT_SIZE;
+    db_file_.seekg(static_cast<size_t>(extent.unit_) * COMPRESSED_EXTENT_SIZE);
+    db_file_.read(extent.units_ == PAGE_UNITS ? data : buffer, size);
+    if (db_file_.gcount() != static_cast<std::streamsize>(size)) {
+      db_file_.clear();
+      throw std::runtime_error("read error.");
+    }
+  }
+  // decompressed out of the latch, so other pages are read meanwhile
+  if (extent.units_ < PAGE_UNITS &&
+      !Lz4Decompress(buffer, extent.units_ * COMPRESSED_EXTENT_SIZE, data,
+                     PAGE_SIZE)) {
+    throw std::runtime_error("page " + std::to_string(id) + " of " +
+                             db_name_ + " is damaged.");
+  }
+}
+
+void DiskManager::WriteCompressedPage(page_id_t id, char* data) {
+  // a page is only compressed if it saves a unit at least
+  char buffer[PAGE_SIZE];
+  size_t size = Lz4Compress(data, PAGE_SIZE, buffer,
+                            PAGE_SIZE - COMPRESSED_EXTENT_SIZE);
+  const char* image = buffer;
+  uint32_t units = PAGE_UNITS;
+  if (size == 0) {
+    image = data;
+  } else {
+    units = (size + COMPRESSED_EXTENT_SIZE - 1) / COMPRESSED_EXTENT_SIZE;
+    memset(buffer + size, 0, units * COMPRESSED_EXTENT_SIZE - size);
+  }
+
+  std::lock_guard<std::mutex> lock(latch_);
+  if (id < 0 || static_cast<size_t>(id) > extents_.size()) {
+    throw std::runtime_error("the page id should on order");
+  }
+  if (static_cast<size_t>(id) < extents_.size()) {
+    // a compressed page fits in a larger extent, the decompression stops at
+    // its end
+    auto& extent = extents_[id];
+    if (units == extent.units_ ||
+        (units < extent.units_ && extent.units_ < PAGE_UNITS)) {
+      WriteExtent(extent.unit_, image, units * COMPRESSED_EXTENT_SIZE);
+      return;
+    }
+    pending_free_.push_back(extent);
+  }
+  is_map_changed_ = true;
+  Extent extent{Allocate(units), units};
+  WriteExtent(extent.unit_, image, units * COMPRESSED_EXTENT_SIZE);
+  if (static_cast<size_t>(id) == extents_.size()) {
+    extents_.push_back(extent);
+  } else {
+    extents_[id] = extent;
+  }
+}
+
+void DiskManager::WriteExtent(uint32_t unit, const char* data, size_t size) {
+  db_file_.seekp(static_cast<size_t>(unit) * COMPRESSED_EXTENT_SIZE);
+  db_file_.write(data, size);
+  if (db_file_.bad()) {
+    throw std::runtime_error("write error.");
+  }
+  db_file_.flush();
+}
+
+auto DiskManager::Allocate(uint32_t units) -> uint32_t {
+  // the smallest free extent large enough, the rest of it stays free
+  auto it = free_by_size_.lower_bound({units, 0});
+  if (it == free_by_size_.end()) {
+    uint32_t unit = end_unit_;
+    end_unit_ += units;
+    return unit;
+  }
+  auto [size, unit] = *it;
+  free_by_size_.erase(it);
+  free_by_unit_.erase(unit);
+  if (size > units) {
+    free_by_unit_[unit + units] = size - units;
+    free_by_size_.emplace(size - units, unit + units);
+  }
+  return unit;
+}
+
+void DiskManager::Free(Extent extent) {
+  // merged with the free extents around it
+  uint32_t unit = extent.unit_;
+  uint32_t units = extent.units_;
+  auto next = free_by_unit_.find(unit + units);
+  if (next != free_by_unit_.end()) {
+    units += next->second;
+    free_by_size_.erase({next->second, next->first});
+    free_by_unit_.erase(next);
+  }
+  auto prev = free_by_unit_.lower_bound(unit);
+  if (prev != free_by_unit_.begin()) {
+    --prev;
+    if (prev->first + prev->second == unit) {
+      unit = prev->first;
+      units += prev->second;
+      free_by_size_.erase({prev->second, prev->first});
+      free_by_unit_.erase(prev);
+    }
+  }
+  if (unit + units == end_unit_) {
+    end_unit_ = unit;
+    return;
+  }
+  free_by_unit_[unit] = units;
+  free_by_size_.emplace(units, unit);
+}
+
+void DiskManager::LoadMap() {
+  std::ifstream map(MapFileName(db_name_), std::ios::binary);
+  if (!map.is_open()) {
+    throw std::runtime_error("the page map of " + db_name_ + " is missing.");
+  }
+  map.seekg(0, std::ios::end);
+  std::streamoff map_end = map.tellg();
+  map.seekg(0, std::ios::beg);
+  char magic[sizeof(MAP_MAGIC)];
+  uint32_t page_count = 0;
+  uint32_t checksum = 0;
+  map.read(magic, sizeof(MAP_MAGIC));
+  map.read(reinterpret_cast<char*>(&page_count), sizeof(uint32_t));
+  map.read(reinterpret_cast<char*>(&checksum), sizeof(uint32_t));
+  size_t extents_size = static_cast<size_t>(page_count) * sizeof(Extent);
+  // tellg() is -1 once a read failed
+  std::streamoff header_end = map.tellg();
+  bool is_valid = map.good() && map_end != -1 && header_end != -1 &&
+                  memcmp(magic, MAP_MAGIC, sizeof(MAP_MAGIC)) == 0 &&
+                  static_cast<size_t>(map_end) ==
+                      static_cast<size_t>(header_end) + extents_size;
+  if (is_valid) {
+    extents_.resize(page_count);
+    map.read(reinterpret_cast<char*>(extents_.data()), extents_size);
+    is_valid = map.good() &&
+               Crc32c(reinterpret_cast<char*>(extents_.data()),
+                      extents_size) == checksum;
+  }
+
+  // the units between the extents are free
+  std::vector<Extent> used(extents_);
+  std::sort(used.begin(), used.end(), [](const Extent& a, const Extent& b) {
+    return a.unit_ < b.unit_;
+  });
+  end_unit_ = 1;
+  for (auto& extent : used) {
+    if (!is_valid || extent.unit_ < end_unit_ || extent.units_ == 0 ||
+        extent.units_ > PAGE_UNITS) {
+      is_valid = false;
+      break;
+    }
+    if (extent.unit_ > end_unit_) {
+      free_by_unit_[end_unit_] = extent.unit_ - end_unit_;
+      free_by_size_.emplace(extent.unit_ - end_unit_, end_unit_);
+    }
+    end_unit_ = extent.unit_ + extent.units_;
+  }
+  if (!is_valid) {
+    throw std::runtime_error("the page map of " + db_name_ + " is damaged.");
+  }
+}
+
+void DiskManager::SaveMap() {
+  std::string map_name = MapFileName(db_name_);
+  std::string temp_name = map_name + ".tmp";
+  {
+    std::ofstream map(temp_name, std::ios::binary | std::ios::trunc);
+    uint32_t page_count = extents_.size();
+    uint32_t checksum = Crc32c(reinterpret_cast<char*>(extents_.data()),
+                               page_count * sizeof(Extent));
+    map.write(MAP_MAGIC, sizeof(MAP_MAGIC));
+    map.write(reinterpret_cast<char*>(&page_count), sizeof(uint32_t));
+    map.write(reinterpret_cast<char*>(&checksum), sizeof(uint32_t));
+    map.write(reinterpret_cast<char*>(extents_.data()),
+              page_count * sizeof(Extent));
+    if (!map.good()) {
+      throw std::runtime_error("write error.");
+    }
+  }
+  SyncFile(temp_name);
+  if (std::rename(temp_name.data(), map_name.data()) != 0) {
+    throw std::runtime_error("can't save the page map of " + db_name_);
+  }
+  SyncFile(DirectoryOf(db_name_));
+}
+
+void DiskManager::SyncCompressed() {
+  // the extents are on disk before the map pointing to them
+  db_file_.flush();
+  SyncFile(db_name_);
+  if (!is_map_changed_) {
+    return;
+  }
+  SaveMap();
+  is_map_changed_ = false;
+  for (auto& extent : pending_free_) {
+    Free(extent);
+  }
+  pending_free_.clear();
+  size_t end = static_cast<size_t>(end_unit_) * COMPRESSED_EXTENT_SIZE;
+  if (GetRawFileSize() > end &&
+      truncate(db_name_.data(), static_cast<off_t>(end)) != 0) {
+    throw std::runtime_error("truncate error.");
+  }
+}
+
+void DiskManager::Sync() {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (is_compressed_) {
+    SyncCompressed();
+    return;
+  }
+  db_file_.flush();
+  // the stream doesn't expose its descriptor, syncing another one of the same
+  // file forces its pages all the same
+  SyncFile(db_name_);
+}
+
+void DiskManager::Truncate(page_id_t page_count) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (is_compressed_) {
+    // the extents are freed, and cut off, once the map is saved
+    for (size_t id = page_count; id < extents_.size(); ++id) {
+      pending_free_.push_back(extents_[id]);
+    }
+    extents_.resize(std::min<size_t>(page_count, extents_.size()));
+    is_map_changed_ = true;
+    return;
+  }
+  db_file_.flush();
+  if (truncate(db_name_.data(), static_cast<off_t>(page_count) * PAGE_SIZE) !=
+      0) {
+    throw std::runtime_error("truncate error.");
+  }
+}
+
+void DiskManager::ShutDown() {
+  // a file only read, as by the verify tool, is left alone
+  if (is_compressed_ && is_map_changed_ && db_file_.is_open()) {
+    Sync();
+  }
+  db_file_.close();
+}
+
+auto DiskManager::MapFileName(const std::string& name) -> std::string {
+  return name + ".map";
+}
+
+auto DiskManager::IsCompressedFile(const std::string& name) -> bool {
+  std::ifstream file(name, std::ios::binary);
+  char magic[sizeof(FILE_MAGIC)];
+  file.read(magic, sizeof(FILE_MAGIC));
+  return file.good() && memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0;
+}
+
+auto DiskManager::GetDiskSize(const std::string& name) -> size_t {
+  size_t size = 0;
+  for (auto& file_name : {name, MapFileName(name)}) {
+    std::error_code ec;
+    auto file_size = std::filesystem::file_size(file_name, ec);
+    size += ec ? 0 : file_size;
+  }
+  return size;
+}
+
+void DiskManager::Convert(const std::string& name, bool is_compressed) {
+  if (IsCompressedFile(name) == is_compressed) {
+    return;
+  }
+  std::string temp_name = name + ".tmp";
+  std::remove(temp_name.data());
+  std::remove(MapFileName(temp_name).data());
+  {
+    DiskManager from(name);
+    DiskManager to(temp_name, is_compressed);
+    char data[PAGE_SIZE];
+    page_id_t page_count = from.GetFileSize() / PAGE_SIZE;
+    for (page_id_t id = 0; id < page_count; ++id) {
+      from.ReadPage(id, data);
+      to.WritePage(id, data);
+    }
+    to.Sync();
+  }
+  // a map next to a plain file is left alone, so it goes first
+  if (is_compressed && std::rename(MapFileName(temp_name).data(),
+                                   MapFileName(name).data()) != 0) {
+    throw std::runtime_error("can't convert " + name);
+  }
+  if (std::rename(temp_name.data(), name.data()) != 0) {
+    throw std::runtime_error("can't convert " + name);
+  }
+  SyncFile(DirectoryOf(name));
+  if (!is_compressed) {
+    std::remove(MapFileName(name).data());
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,117 @@
+#include "disk/free_page_map.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace spdb {
+FreePageMap::FreePageMap(const std::string &file_name)
+    : file_name_(FileName(file_name)) {}
+
+FreePageMap::~FreePageMap() {
+  if (disk_ != nullptr) {
+    disk_->ShutDown();
+  }
+}
+
+auto FreePageMap::FileName(const std::string &file_name) -> std::string {
+  return file_name + ".fsm";
+}
+
+auto FreePageMap::GetDisk() -> DiskManager * {
+  if (disk_ == nullptr) {
+    disk_ = std::make_unique<DiskManager>(file_name_);
+  }
+  return disk_.get();
+}
+
+auto FreePageMap::Load(page_id_t page_count, std::set<page_id_t> *free_pages)
+    -> bool {
+  free_pages->clear();
+  is_clean_ = false;
+  if (!std::ifstream(file_name_).is_open()) {
+    return false;
+  }
+  auto disk = GetDisk();
+  page_id_t map_pages = disk->GetFileSize() / PAGE_SIZE;
+  if (map_pages == 0) {
+    return false;
+  }
+  std::vector<char> data(PAGE_SIZE);
+  disk->ReadPage(0, data.data());
+  Header header;
+  memcpy(&header, data.data(), sizeof(Header));
+  if (header.is_clean_ != 1 || header.page_count_ != page_count) {
+    return false;
+  }
+
+  page_id_t map_page_id = 0;
+  for (page_id_t first = 0; first < page_count; first += FREE_PAGE_MAP_BITS) {
+    if (map_page_id == INVALID_PAGE_ID || map_page_id >= map_pages) {
+      free_pages->clear();
+      return false;
+    }
+    disk->ReadPage(map_page_id, data.data());
+    memcpy(&header, data.data(), sizeof(Header));
+    auto bits = reinterpret_cast<uint8_t *>(data.data() + sizeof(Header));
+    for (page_id_t bit = 0;
+         bit < FREE_PAGE_MAP_BITS && first + bit < page_count; ++bit) {
+      if ((bits[bit / 8] >> (bit % 8)) & 1) {
+        free_pages->insert(first + bit);
+      }
+    }
+    map_page_id = header.next_page_id_;
+  }
+  is_clean_ = true;
+  return true;
+}
+
+void FreePageMap::Invalidate() {
+  if (!is_clean_) {
+    return;
+  }
+  auto disk = GetDisk();
+  std::vector<char> data(PAGE_SIZE);
+  disk->ReadPage(0, data.data());
+  reinterpret_cast<Header *>(data.data())->is_clean_ = 0;
+  disk->WritePage(0, data.data());
+  disk->Sync();
+  is_clean_ = false;
+}
+
+void FreePageMap::Save(page_id_t page_count,
+                       const std::set<page_id_t> &free_pages) {
+  auto disk = GetDisk();
+  page_id_t map_pages =
+      page_count == 0 ? 1
+                      : (page_count + FREE_PAGE_MAP_BITS - 1) /
+                            FREE_PAGE_MAP_BITS;
+  std::vector<std::vector<char>> pages(map_pages,
+                                       std::vector<char>(PAGE_SIZE, 0));
+  for (auto page_id : free_pages) {
+    auto &data = pages[page_id / FREE_PAGE_MAP_BITS];
+    page_id_t bit = page_id % FREE_PAGE_MAP_BITS;
+    data[sizeof(Header) + bit / 8] |= 1 << (bit % 8);
+  }
+  for (page_id_t i = 0; i < map_pages; ++i) {
+    Header header{i + 1 < map_pages ? i + 1 : INVALID_PAGE_ID, page_count,
+                  0, 0};
+    memcpy(pages[i].data(), &header, sizeof(Header));
+  }
+
+  // the first page goes last, marking the map clean once the rest of it is
+  // on the disk
+  Invalidate();
+  if (disk->GetFileSize() < PAGE_SIZE) {
+    disk->WritePage(0, pages[0].data());
+  }
+  for (page_id_t i = 1; i < map_pages; ++i) {
+    disk->WritePage(i, pages[i].data());
+  }
+  disk->Sync();
+  reinterpret_cast<Header *>(pages[0].data())->is_clean_ = 1;
+  disk->WritePage(0, pages[0].data());
+  disk->Sync();
+  is_clean_ = true;
+}
+}  // namespace spdb
@@ -0,0 +1,183 @@
+#include "disk/lz4.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace spdb {
+// a match is 4 bytes at least, and the last 5 bytes of a block are
+// literals, with the last match starting 12 bytes before the end at least
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5;
+static const size_t MF_LIMIT = 12;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_LOG = 12;
+
+static auto Read32(const char *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(uint32_t));
+  return value;
+}
+
+static auto Hash(uint32_t value) -> uint32_t {
+  return (value * 2654435761U) >> (32 - HASH_LOG);
+}
+
+// Append a length beyond what the token holds, as bytes of 255 and the rest.
+static auto PutLength(size_t length, char *dst, size_t *op, size_t capacity)
+    -> bool {
+  for (; length >= 255; length -= 255) {
+    if (*op >= capacity) {
+      return false;
+    }
+    dst[(*op)++] = static_cast<char>(255);
+  }
+  if (*op >= capacity) {
+    return false;
+  }
+  dst[(*op)++] = static_cast<char>(length);
+  return true;
+}
+
+// Append a sequence: the literals, then a match unless it is the last one.
+static auto PutSequence(const char *literals, size_t literal_length,
+                        size_t offset, size_t match_length, char *dst,
+                        size_t *op, size_t capacity) -> bool {
+  if (*op >= capacity) {
+    return false;
+  }
+  size_t token_at = (*op)++;
+  uint8_t token = literal_length >= 15 ? 15 << 4 : literal_length << 4;
+  if (literal_length >= 15 &&
+      !PutLength(literal_length - 15, dst, op, capacity)) {
+    return false;
+  }
+  if (*op + literal_length > capacity) {
+    return false;
+  }
+  memcpy(dst + *op, literals, literal_length);
+  *op += literal_length;
+  if (match_length > 0) {
+    if (*op + 2 > capacity) {
+      return false;
+    }
+    dst[(*op)++] = static_cast<char>(offset & 0xFF);
+    dst[(*op)++] = static_cast<char>(offset >> 8);
+    size_t length = match_length - MIN_MATCH;
+    token |= length >= 15 ? 15 : length;
+    if (length >= 15 && !PutLength(length - 15, dst, op, capacity)) {
+      return false;
+    }
+  }
+  dst[token_at] = static_cast<char>(token);
+  return true;
+}
+
+auto Lz4Compress(const char *src, size_t size, char *dst, size_t capacity)
+    -> size_t {
+  size_t op = 0;
+  size_t anchor = 0;
+  if (size >= MF_LIMIT + 1) {
+    // the last position seen of each hash of 4 bytes, plus one
+    uint32_t table[1 << HASH_LOG] = {};
+    size_t match_limit = size - LAST_LITERALS;
+    size_t ip = 0;
+    // the step grows along a run without matches, skipping incompressible
+    // data faster
+    size_t misses = 0;
+    while (ip + MF_LIMIT <= size) {
+      uint32_t value = Read32(src + ip);
+      uint32_t h = Hash(value);
+      size_t ref = table[h];
+      table[h] = ip + 1;
+      if (ref == 0 || ip - (ref - 1) > MAX_OFFSET ||
+          Read32(src + ref - 1) != value) {
+        ip += 1 + (misses++ >> 6);
+        continue;
+      }
+      --ref;
+      misses = 0;
+      size_t length = MIN_MATCH;
+      while (ip + length < match_limit &&
+             src[ref + length] == src[ip + length]) {
+        ++length;
+      }
+      if (!PutSequence(src + anchor, ip - anchor, ip - ref, length, dst, &op,
+                       capacity)) {
+        return 0;
+      }
+      ip += length;
+      anchor = ip;
+      // the position just behind the match helps the next one
+      if (ip + MF_LIMIT <= size) {
+        table[Hash(Read32(src + ip - 2))] = ip - 1;
+      }
+    }
+  }
+  if (!PutSequence(src + anchor, size - anchor, 0, 0, dst, &op, capacity)) {
+    return 0;
+  }
+  return op;
+}
+
+auto Lz4Decompress(const char *src, size_t capacity, char *dst, size_t size)
+    -> bool {
+  size_t ip = 0;
+  size_t op = 0;
+  // reads a length beyond the 15 of the token
+  auto get_length = [&](size_t *length) {
+    uint8_t byte;
+    do {
+      if (ip >= capacity) {
+        return false;
+      }
+      byte = static_cast<uint8_t>(src[ip++]);
+      *length += byte;
+    } while (byte == 255);
+    return true;
+  };
+  while (true) {
+    if (ip >= capacity) {
+      return false;
+    }
+    uint8_t token = static_cast<uint8_t>(src[ip++]);
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !get_length(&literal_length)) {
+      return false;
+    }
+    if (literal_length > size - op || literal_length > capacity - ip) {
+      return false;
+    }
+    memcpy(dst + op, src + ip, literal_length);
+    op += literal_length;
+    ip += literal_length;
+    // only the last sequence ends the block, without a match
+    if (op == size) {
+      return true;
+    }
+
+    if (ip + 2 > capacity) {
+      return false;
+    }
+    size_t offset = static_cast<uint8_t>(src[ip]) |
+                    static_cast<uint8_t>(src[ip + 1]) << 8;
+    ip += 2;
+    size_t match_length = token & 15;
+    if (match_length == 15 && !get_length(&match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (offset == 0 || offset > op || match_length > size - op) {
+      return false;
+    }
+    // the match may overlap the bytes it writes, repeating them
+    if (offset >= match_length) {
+      memcpy(dst + op, dst + op - offset, match_length);
+    } else {
+      for (size_t i = 0; i < match_length; ++i) {
+        dst[op + i] = dst[op + i - offset];
+      }
+    }
+    op += match_length;
+  }
+}
+}  // namespace spdb
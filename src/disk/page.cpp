@@ -11,6 +11,14 @@ auto Page::GetPinCount() const -> int { return pin_count_; }
 
 auto Page::GetPageId() -> page_id_t { return page_id_; }
 
+auto Page::GetLSN() -> lsn_t {
+  lsn_t lsn = INVALID_LSN;
+  memcpy(&lsn, data_, sizeof(lsn_t));
+  return lsn;
+}
+
+void Page::SetLSN(lsn_t lsn) { memcpy(data_, &lsn, sizeof(lsn_t)); }
+
 void Page::ResetMemory() { memset(data_, 0, PAGE_SIZE); }
 
 bool Page::IsDirty() { return is_dirty_; }
@@ -21,5 +29,7 @@ void Page::WUnlatch() { latch_.unlock(); }
 
 void Page::RLatch() { latch_.lock_shared(); }
 
+auto Page::TryRLatch() -> bool { return latch_.try_lock_shared(); }
+
 void Page::WLatch() { latch_.lock(); }
 }  // namespace spdb
\ No newline at end of file
@@ -9,23 +9,40 @@ BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept {
   bpm_ = that.bpm_;
   page_ = that.page_;
   is_dirty_ = that.is_dirty_;
+  before_image_ = std::move(that.before_image_);
   that.bpm_ = nullptr;
   that.page_ = nullptr;
+  that.is_dirty_ = false;
 }
 
-void BasicPageGuard::Drop() {
+auto BasicPageGuard::GetDataMut() -> char * {
+  if (!is_dirty_ && bpm_->IsLogging()) {
+    before_image_ = std::make_unique<char[]>(PAGE_SIZE);
+    memcpy(before_image_.get(), page_->GetData(), PAGE_SIZE);
+  }
+  is_dirty_ = true;
+  return page_->GetData();
+}
+
+void BasicPageGuard::Drop() { Drop(false); }
+
+void BasicPageGuard::Drop(bool is_latched) {
   if (bpm_ != nullptr && page_ != nullptr) {
+    // a logged page is written back by the buffer pool later, otherwise it
+    // is written back right now
+    bool is_logged = false;
     if (is_dirty_) {
-      if (bpm_->FlushPage(page_->GetPageId())) {
-        is_dirty_ = false;
-      } else {
+      is_logged = bpm_->LogPageUpdate(page_, before_image_.get());
+      if (!is_logged && !bpm_->FlushPage(page_->GetPageId(), is_latched)) {
         std::cout << "flush fail\n";
       }
     }
-    bpm_->UnpinPage(page_->GetPageId(), false);
+    bpm_->UnpinPage(page_->GetPageId(), is_logged);
   }
   bpm_ = nullptr;
   page_ = nullptr;
+  is_dirty_ = false;
+  before_image_.reset();
 }
 
 auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept
@@ -34,25 +51,14 @@ auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept
   bpm_ = that.bpm_;
   page_ = that.page_;
   is_dirty_ = that.is_dirty_;
+  before_image_ = std::move(that.before_image_);
   that.bpm_ = nullptr;
   that.page_ = nullptr;
+  that.is_dirty_ = false;
   return *this;
 }
 
-BasicPageGuard::~BasicPageGuard() {
-  if (bpm_ != nullptr && page_ != nullptr) {
-    if (is_dirty_) {
-      if (bpm_->FlushPage(page_->GetPageId())) {
-        is_dirty_ = false;
-      } else {
-        std::cout << "flush fail\n";
-      }
-    }
-    bpm_->UnpinPage(page_->GetPageId(), false);
-  }
-  bpm_ = nullptr;
-  page_ = nullptr;
-};  // NOLINT
+BasicPageGuard::~BasicPageGuard() { Drop(); }  // NOLINT
 
 ReadPageGuard::ReadPageGuard(ReadPageGuard &&that) noexcept = default;
 
@@ -92,36 +98,13 @@ auto WritePageGuard::operator=(WritePageGuard &&that) noexcept
 }
 
 void WritePageGuard::Drop() {
-  if (guard_.bpm_ != nullptr && guard_.page_ != nullptr) {
-    if (guard_.is_dirty_) {
-      if (guard_.bpm_->FlushPage(guard_.page_->GetPageId())) {
-        guard_.is_dirty_ = false;
-      } else {
-        std::cout << "flush fail\n";
-      }
-    }
-    guard_.bpm_->UnpinPage(guard_.page_->GetPageId(), false);
-    guard_.page_->WUnlatch();
+  // the modification is logged before other writers may see the page
+  Page *page = guard_.page_;
+  guard_.Drop(true);
+  if (page != nullptr) {
+    page->WUnlatch();
   }
-  guard_.bpm_ = nullptr;
-  guard_.page_ = nullptr;
-  guard_.is_dirty_ = false;
 }
 
-WritePageGuard::~WritePageGuard() {
-  if (guard_.bpm_ != nullptr && guard_.page_ != nullptr) {
-    if (guard_.is_dirty_) {
-      if (guard_.bpm_->FlushPage(guard_.page_->GetPageId())) {
-        guard_.is_dirty_ = false;
-      } else {
-        std::cout << "flush fail\n";
-      }
-    }
-    guard_.bpm_->UnpinPage(guard_.page_->GetPageId(), false);
-    guard_.page_->WUnlatch();
-  }
-  guard_.bpm_ = nullptr;
-  guard_.page_ = nullptr;
-  guard_.is_dirty_ = false;
-}  // NOLINT
-}  // namespace spdb
\ No newline at end of file
+WritePageGuard::~WritePageGuard() { Drop(); }  // NOLINT
+}  // namespace spdb
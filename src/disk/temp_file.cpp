@@ -0,0 +1,90 @@
+#include "disk/temp_file.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace spdb {
+static std::atomic<size_t> temp_file_nums{0};
+
+TempFile::TempFile(const std::vector<Cloum> &cols) : cols_(cols) {
+  for (auto &col : cols_) {
+    tuple_size_ += col.GetSize();
+  }
+  if (tuple_size_ == 0 || tuple_size_ > PAGE_SIZE - sizeof(int)) {
+    throw std::runtime_error("TempFile: tuple doesn't fit in a page.");
+  }
+  tuples_per_page_ = (PAGE_SIZE - sizeof(int)) / tuple_size_;
+
+  name_ = (std::filesystem::temp_directory_path() /
+           ("spdb_" + std::to_string(getpid()) + "_" +
+            std::to_string(temp_file_nums++) + ".tmp"))
+              .string();
+  std::remove(name_.data());
+  disk_ = new DiskManager(name_);
+  page_ = new char[PAGE_SIZE];
+  memset(page_, 0, PAGE_SIZE);
+}
+
+TempFile::~TempFile() {
+  disk_->ShutDown();
+  delete disk_;
+  delete[] page_;
+  std::remove(name_.data());
+}
+
+void TempFile::Append(const Tuple &tuple) {
+  if (is_reading_) {
+    throw std::runtime_error("TempFile: can't append after rewind.");
+  }
+  int count = 0;
+  memcpy(&count, page_, sizeof(int));
+  if (count == tuples_per_page_) {
+    disk_->WritePage(write_pid_++, page_);
+    count = 0;
+  }
+  memcpy(page_ + sizeof(int) + count * tuple_size_, tuple.GetData(),
+         tuple_size_);
+  ++count;
+  memcpy(page_, &count, sizeof(int));
+  ++size_;
+}
+
+void TempFile::Rewind() {
+  if (!is_reading_) {
+    int count = 0;
+    memcpy(&count, page_, sizeof(int));
+    if (count > 0) {
+      disk_->WritePage(write_pid_++, page_);
+    }
+    is_reading_ = true;
+  }
+  read_pid_ = 0;
+  read_index_ = 0;
+  memset(page_, 0, PAGE_SIZE);
+  if (write_pid_ > 0) {
+    disk_->ReadPage(read_pid_, page_);
+  }
+}
+
+auto TempFile::Next(Tuple *tuple) -> bool {
+  if (!is_reading_) {
+    throw std::runtime_error("TempFile: should rewind before reading.");
+  }
+  int count = 0;
+  memcpy(&count, page_, sizeof(int));
+  if (read_index_ >= count) {
+    if (read_pid_ + 1 >= write_pid_) {
+      return false;
+    }
+    disk_->ReadPage(++read_pid_, page_);
+    read_index_ = 0;
+  }
+  tuple->SetValues(page_ + sizeof(int) + read_index_ * tuple_size_);
+  ++read_index_;
+  return true;
+}
+}  // namespace spdb
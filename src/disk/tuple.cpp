@@ -52,8 +52,42 @@ auto Tuple::GetValueAt(int index) const -> char* {
   return ret;
 }
 
+auto Tuple::GetValuePtrAt(int index) const -> const char* {
+  size_t offset = 0;
+  for (int i = 0; i < index; ++i) {
+    offset += cloums_[i].GetSize();
+  }
+  return data_ + offset;
+}
+
+auto Tuple::GetCloums() const -> const std::vector<Cloum>& { return cloums_; }
+
 auto Tuple::GetData() const -> const char* { return data_; }
 
+auto Tuple::Project(const std::vector<Cloum>& cols) const -> Tuple {
+  std::vector<Cloum> out_cols(cols);
+  Tuple ret(out_cols);
+  size_t offset = 0;
+  for (auto& col : cols) {
+    size_t src_offset = 0;
+    size_t i = 0;
+    for (; i < cloums_.size(); ++i) {
+      if (cloums_[i].cloum_name_ == col.cloum_name_) {
+        break;
+      }
+      src_offset += cloums_[i].GetSize();
+    }
+    if (i == cloums_.size()) {
+      throw std::runtime_error("Project: cloum " + col.cloum_name_ +
+                               " is not existed.");
+    }
+    memcpy(ret.data_ + offset, data_ + src_offset, col.GetSize());
+    offset += col.GetSize();
+  }
+  ret.rid_ = rid_;
+  return ret;
+}
+
 Tuple& Tuple::operator=(const Tuple& other) {
   size_t data_size = 0;
   for (auto& col : cloums_) {
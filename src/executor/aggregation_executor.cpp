@@ -0,0 +1,419 @@
+#include "executor/aggregation_executor.h"
+
+#include <functional>
+
+#include "executor/expression.h"
+
+namespace spdb {
+// tuples handed to the accumulators at once
+static constexpr size_t AGGREGATION_BATCH_SIZE = 1024;
+// rough cost of a group besides its key and accumulators
+static constexpr size_t GROUP_OVERHEAD = 64;
+
+// partition with the high bits of the hash, the low bits pick the slot
+static auto PartitionOf(size_t hash) -> size_t {
+  return (hash >> (sizeof(size_t) * 8 - 8)) % SPILL_PARTITION_NUMS;
+}
+
+AggregationExecutor::AggregationExecutor(
+    Catalog *catalog, std::unique_ptr<AbstractExecutor> child,
+    std::vector<int> group_by, std::vector<AggregateSpec> aggregates,
+    size_t memory_budget)
+    : AbstractExecutor(catalog),
+      child_executor_(std::move(child)),
+      group_by_(std::move(group_by)),
+      aggregates_(std::move(aggregates)),
+      memory_budget_(memory_budget) {
+  child_cols_ = child_executor_->GetOutputCols();
+  for (auto &col : child_cols_) {
+    child_offsets_.push_back(tuple_size_);
+    tuple_size_ += col.GetSize();
+  }
+  for (auto index : group_by_) {
+    output_cols_.push_back(child_cols_[index]);
+    group_size_ += child_cols_[index].GetSize();
+  }
+  CloumAtr int_atr{CloumType::INT, sizeof(int)};
+  for (auto &agg : aggregates_) {
+    if (agg.col_ == -1 && agg.type_ != AggregationType::COUNT) {
+      throw std::runtime_error(agg.name_ + " should apply to a cloum.");
+    }
+    switch (agg.type_) {
+      case AggregationType::SUM:
+      case AggregationType::AVG:
+        if (child_cols_[agg.col_].GetType() != CloumType::INT) {
+          throw std::runtime_error(agg.name_ + " only supports int cloums.");
+        }
+        output_cols_.emplace_back(agg.name_, int_atr);
+        break;
+      case AggregationType::MIN:
+      case AggregationType::MAX:
+        output_cols_.emplace_back(agg.name_, child_cols_[agg.col_].atr_);
+        break;
+      default:
+        output_cols_.emplace_back(agg.name_, int_atr);
+        break;
+    }
+  }
+  sums_.resize(aggregates_.size());
+  values_.resize(aggregates_.size());
+  batch_.resize(AGGREGATION_BATCH_SIZE * tuple_size_);
+  batch_groups_.resize(AGGREGATION_BATCH_SIZE);
+  parallel_child_ =
+      dynamic_cast<ParallelSeqScanExecutor *>(child_executor_.get());
+  bool is_one_cloum = group_by_.empty();
+  int cloum = -1;
+  for (auto &agg : aggregates_) {
+    if (agg.col_ != -1) {
+      is_one_cloum = is_one_cloum && (cloum == -1 || cloum == agg.col_);
+      cloum = agg.col_;
+    }
+  }
+  if (is_one_cloum) {
+    cloum_child_ = dynamic_cast<SeqScanExecutor *>(child_executor_.get());
+    cloum_ = cloum == -1 ? 0 : cloum;
+  }
+}
+
+AggregationExecutor::AggregationExecutor(const AggregationExecutor &parent,
+                                         size_t memory_budget)
+    : AbstractExecutor(nullptr),
+      child_cols_(parent.child_cols_),
+      child_offsets_(parent.child_offsets_),
+      tuple_size_(parent.tuple_size_),
+      group_by_(parent.group_by_),
+      aggregates_(parent.aggregates_),
+      output_cols_(parent.output_cols_),
+      memory_budget_(memory_budget),
+      group_size_(parent.group_size_) {
+  sums_.resize(aggregates_.size());
+  values_.resize(aggregates_.size());
+  batch_.resize(AGGREGATION_BATCH_SIZE * tuple_size_);
+  batch_groups_.resize(AGGREGATION_BATCH_SIZE);
+}
+
+auto AggregationExecutor::GetOutputCols() -> std::vector<Cloum> {
+  return output_cols_;
+}
+
+void AggregationExecutor::Clear() {
+  slots_.clear();
+  keys_.clear();
+  hashes_.clear();
+  group_values_.clear();
+  counts_.clear();
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    sums_[i].clear();
+    values_[i].clear();
+  }
+  used_ = 0;
+  emit_index_ = 0;
+}
+
+auto AggregationExecutor::FindOrInsert(const std::string &key, size_t hash,
+                                       const char *tuple, bool can_spill)
+    -> int {
+  if (slots_.empty()) {
+    slots_.assign(1024, -1);
+  }
+  size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  for (; slots_[slot] != -1; slot = (slot + 1) & mask) {
+    int group = slots_[slot];
+    if (hashes_[group] == hash && keys_[group] == key) {
+      return group;
+    }
+  }
+
+  size_t cost = key.size() + sizeof(std::string) + group_size_ +
+                aggregates_.size() * sizeof(int64_t) + GROUP_OVERHEAD;
+  for (auto &agg : aggregates_) {
+    cost += agg.col_ == -1 ? 0 : child_cols_[agg.col_].GetSize();
+  }
+  if (can_spill && !keys_.empty() && used_ + cost > memory_budget_) {
+    return -1;
+  }
+  used_ += cost;
+
+  int group = keys_.size();
+  keys_.push_back(key);
+  hashes_.push_back(hash);
+  slots_[slot] = group;
+  counts_.push_back(0);
+  group_values_.resize(group_values_.size() + group_size_);
+  char *dst = group_values_.data() + group * group_size_;
+  for (auto index : group_by_) {
+    if (tuple == nullptr) {
+      break;
+    }
+    memcpy(dst, tuple + child_offsets_[index], child_cols_[index].GetSize());
+    dst += child_cols_[index].GetSize();
+  }
+  // MIN and MAX are set by the first row of the group
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    sums_[i].push_back(0);
+    auto col = aggregates_[i].col_;
+    if (col == -1) {
+      continue;
+    }
+    values_[i].resize(values_[i].size() + child_cols_[col].GetSize(), '\0');
+  }
+
+  if (keys_.size() * 2 > slots_.size()) {
+    slots_.assign(slots_.size() * 2, -1);
+    mask = slots_.size() - 1;
+    for (size_t g = 0; g < hashes_.size(); ++g) {
+      size_t s = hashes_[g] & mask;
+      while (slots_[s] != -1) {
+        s = (s + 1) & mask;
+      }
+      slots_[s] = g;
+    }
+  }
+  return group;
+}
+
+void AggregationExecutor::UpdateBatch(const char *batch, size_t rows,
+                                      size_t stride,
+                                      const std::vector<size_t> &offsets) {
+  const int *groups = batch_groups_.data();
+  for (size_t i = 0; i < rows; ++i) {
+    // MIN and MAX start from the first value of the group
+    if (counts_[groups[i]]++ == 0) {
+      for (size_t a = 0; a < aggregates_.size(); ++a) {
+        auto &agg = aggregates_[a];
+        if (agg.type_ != AggregationType::MIN &&
+            agg.type_ != AggregationType::MAX) {
+          continue;
+        }
+        size_t size = child_cols_[agg.col_].GetSize();
+        memcpy(values_[a].data() + groups[i] * size,
+               batch + i * stride + offsets[agg.col_], size);
+      }
+    }
+  }
+  for (size_t a = 0; a < aggregates_.size(); ++a) {
+    auto &agg = aggregates_[a];
+    if (agg.type_ == AggregationType::COUNT) {
+      // no NULL values, COUNT(cloum) is the number of tuples as well
+      continue;
+    }
+    size_t offset = offsets[agg.col_];
+    if (agg.type_ == AggregationType::SUM ||
+        agg.type_ == AggregationType::AVG) {
+      int64_t *sums = sums_[a].data();
+      for (size_t i = 0; i < rows; ++i) {
+        int v = 0;
+        memcpy(&v, batch + i * stride + offset, sizeof(int));
+        sums[groups[i]] += v;
+      }
+      continue;
+    }
+    auto &col = child_cols_[agg.col_];
+    size_t size = col.GetSize();
+    int sign = agg.type_ == AggregationType::MIN ? -1 : 1;
+    char *values = values_[a].data();
+    for (size_t i = 0; i < rows; ++i) {
+      const char *src = batch + i * stride + offset;
+      char *dst = values + groups[i] * size;
+      if (CompareValue(src, dst, col) * sign > 0) {
+        memcpy(dst, src, size);
+      }
+    }
+  }
+}
+
+template <class NextFunc>
+void AggregationExecutor::Aggregate(NextFunc &&next, bool spill) {
+  Tuple tuple{child_cols_};
+  size_t rows = 0;
+  while (next(&tuple)) {
+    int group = 0;
+    if (group_by_.empty()) {
+      // a partial of a worker has the group once it has a row
+      if (keys_.empty()) {
+        FindOrInsert("", 0, nullptr, false);
+      }
+    } else {
+      auto key = EncodeKey(tuple, group_by_);
+      auto hash = std::hash<std::string>{}(key);
+      group = FindOrInsert(key, hash, tuple.GetData(), spill);
+      if (group == -1) {
+        if (partitions_.empty()) {
+          for (size_t i = 0; i < SPILL_PARTITION_NUMS; ++i) {
+            partitions_.push_back(std::make_unique<TempFile>(child_cols_));
+          }
+        }
+        partitions_[PartitionOf(hash)]->Append(tuple);
+        continue;
+      }
+    }
+    memcpy(batch_.data() + rows * tuple_size_, tuple.GetData(), tuple_size_);
+    batch_groups_[rows] = group;
+    if (++rows == AGGREGATION_BATCH_SIZE) {
+      UpdateBatch(batch_.data(), rows, tuple_size_, child_offsets_);
+      rows = 0;
+    }
+  }
+  UpdateBatch(batch_.data(), rows, tuple_size_, child_offsets_);
+}
+
+void AggregationExecutor::AggregateCloum(SeqScanExecutor *scan) {
+  std::vector<char> values;
+  // every cloum is at the start of its value
+  std::vector<size_t> offsets(child_cols_.size(), 0);
+  size_t size = child_cols_[cloum_].GetSize();
+  Tuple tuple{child_cols_};
+  RID rid{};
+  size_t rows = 0;
+  while (true) {
+    size_t n = scan->ReadCloum(cloum_, &values);
+    if (n > 0) {
+      // there is a single group
+      if (batch_groups_.size() < n) {
+        batch_groups_.resize(n, 0);
+      }
+      UpdateBatch(values.data(), n, size, offsets);
+      continue;
+    }
+    // the rest of the leaf is read by rows
+    if (!scan->Next(&tuple, &rid)) {
+      break;
+    }
+    memcpy(batch_.data() + rows * tuple_size_, tuple.GetData(), tuple_size_);
+    batch_groups_[rows] = 0;
+    if (++rows == AGGREGATION_BATCH_SIZE) {
+      UpdateBatch(batch_.data(), rows, tuple_size_, child_offsets_);
+      rows = 0;
+    }
+  }
+  UpdateBatch(batch_.data(), rows, tuple_size_, child_offsets_);
+}
+
+void AggregationExecutor::AggregateMorsels(ParallelSeqScanExecutor *scan) {
+  auto scheduler = scan->GetScheduler();
+  size_t worker_nums = scheduler->GetWorkerCount();
+  std::vector<std::unique_ptr<AggregationExecutor>> partials(worker_nums);
+  scan->ForEachMorsel([&](AbstractExecutor *morsel) {
+    // the morsels of a worker run one after another
+    auto &partial = partials[scheduler->GetWorkerIndex()];
+    if (partial == nullptr) {
+      partial = std::unique_ptr<AggregationExecutor>(
+          new AggregationExecutor(*this, memory_budget_ / worker_nums));
+    }
+    RID rid{};
+    partial->Aggregate([&](Tuple *t) { return morsel->Next(t, &rid); },
+                       true);
+  });
+  // a worker whose morsels had no rows has no group
+  for (auto &partial : partials) {
+    if (partial != nullptr && !partial->keys_.empty()) {
+      Merge(partial.get());
+    }
+  }
+  // only once all the groups are in, so no group is both in memory and in a
+  // partition
+  for (auto &partial : partials) {
+    if (partial == nullptr) {
+      continue;
+    }
+    for (auto &file : partial->partitions_) {
+      file->Rewind();
+      Aggregate([&](Tuple *t) { return file->Next(t); }, true);
+    }
+    partial.reset();
+  }
+}
+
+void AggregationExecutor::Merge(AggregationExecutor *partial) {
+  for (size_t g = 0; g < partial->keys_.size(); ++g) {
+    // a group without rows has no MIN or MAX to merge
+    if (partial->counts_[g] == 0) {
+      continue;
+    }
+    int group =
+        FindOrInsert(partial->keys_[g], partial->hashes_[g], nullptr, false);
+    bool is_new = counts_[group] == 0;
+    counts_[group] += partial->counts_[g];
+    if (is_new) {
+      memcpy(group_values_.data() + group * group_size_,
+             partial->group_values_.data() + g * group_size_, group_size_);
+    }
+    for (size_t a = 0; a < aggregates_.size(); ++a) {
+      auto &agg = aggregates_[a];
+      sums_[a][group] += partial->sums_[a][g];
+      if (agg.type_ != AggregationType::MIN &&
+          agg.type_ != AggregationType::MAX) {
+        continue;
+      }
+      auto &col = child_cols_[agg.col_];
+      size_t size = col.GetSize();
+      const char *src = partial->values_[a].data() + g * size;
+      char *dst = values_[a].data() + group * size;
+      int sign = agg.type_ == AggregationType::MIN ? -1 : 1;
+      if (is_new || CompareValue(src, dst, col) * sign > 0) {
+        memcpy(dst, src, size);
+      }
+    }
+  }
+}
+
+auto AggregationExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!is_built_) {
+    if (group_by_.empty()) {
+      FindOrInsert("", 0, nullptr, false);
+    }
+    if (parallel_child_ != nullptr) {
+      AggregateMorsels(parallel_child_);
+    } else if (cloum_child_ != nullptr) {
+      AggregateCloum(cloum_child_);
+    } else {
+      RID child_rid{};
+      Aggregate(
+          [&](Tuple *t) { return child_executor_->Next(t, &child_rid); },
+          true);
+    }
+    is_built_ = true;
+  }
+  while (emit_index_ >= keys_.size()) {
+    if (partition_ >= partitions_.size()) {
+      return false;
+    }
+    // a single partition is expected to fit in memory
+    Clear();
+    auto &file = partitions_[partition_];
+    file->Rewind();
+    Aggregate([&](Tuple *t) { return file->Next(t); }, false);
+    partitions_[partition_++].reset();
+  }
+
+  size_t group = emit_index_++;
+  std::vector<char> src(group_size_);
+  memcpy(src.data(), group_values_.data() + group * group_size_, group_size_);
+  for (size_t a = 0; a < aggregates_.size(); ++a) {
+    int v = 0;
+    switch (aggregates_[a].type_) {
+      case AggregationType::COUNT:
+        v = counts_[group];
+        break;
+      case AggregationType::SUM:
+        v = sums_[a][group];
+        break;
+      case AggregationType::AVG:
+        v = counts_[group] == 0 ? 0 : sums_[a][group] / counts_[group];
+        break;
+      default: {
+        auto size = child_cols_[aggregates_[a].col_].GetSize();
+        auto value = values_[a].data() + group * size;
+        src.insert(src.end(), value, value + size);
+        continue;
+      }
+    }
+    auto bytes = reinterpret_cast<const char *>(&v);
+    src.insert(src.end(), bytes, bytes + sizeof(int));
+  }
+  tuple->SetValues(src.data());
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
@@ -0,0 +1,41 @@
+#include "executor/delete_executor.h"
+
+namespace spdb {
+DeleteExecutor::DeleteExecutor(Catalog *catalog, const std::string &table_name,
+                               std::unique_ptr<AbstractExecutor> child)
+    : AbstractExecutor(catalog),
+      txn_manager_(catalog->GetTransactionManager()),
+      child_executor_(std::move(child)) {
+  if (!catalog->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  if (txn_manager_ == nullptr || TransactionManager::Current() == nullptr) {
+    throw std::runtime_error("DeleteExecutor should run in a transaction.");
+  }
+  table_info_ = catalog->GetTable(table_name);
+}
+
+auto DeleteExecutor::GetOutputCols() -> std::vector<Cloum> {
+  CloumAtr int_atr{CloumType::INT, sizeof(int)};
+  return {Cloum{"deleted", int_atr}};
+}
+
+auto DeleteExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (is_done_) {
+    return false;
+  }
+  is_done_ = true;
+  auto cols = child_executor_->GetOutputCols();
+  Tuple row{cols};
+  RID row_rid{};
+  std::vector<Tuple> keys;
+  while (child_executor_->Next(&row, &row_rid)) {
+    keys.push_back(row.Project(table_info_.key_type_));
+  }
+  int count = static_cast<int>(txn_manager_->DeleteRows(
+      TransactionManager::Current(), table_info_.disk_name_, keys));
+  tuple->SetValues(reinterpret_cast<char *>(&count));
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
@@ -0,0 +1,264 @@
+#include "executor/expression.h"
+
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+namespace spdb {
+auto GetIndexByName(std::string name, std::vector<Cloum> cols) -> int {
+  for (size_t i = 0; i < cols.size(); ++i) {
+    if (name == cols[i].cloum_name_) {
+      return i;
+    }
+  }
+  // fall back to the cloum part of qualified names
+  for (size_t i = 0; i < cols.size(); ++i) {
+    auto &col_name = cols[i].cloum_name_;
+    auto dot = col_name.find('.');
+    if (dot != std::string::npos && col_name.substr(dot + 1) == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+auto ExprName(const hsql::Expr *expr) -> std::string {
+  switch (expr->type) {
+    case hsql::ExprType::kExprStar:
+      return "*";
+    case hsql::ExprType::kExprColumnRef:
+      return expr->table == nullptr
+                 ? std::string(expr->name)
+                 : std::string(expr->table) + "." + expr->name;
+    case hsql::ExprType::kExprFunctionRef: {
+      std::string name(expr->name);
+      for (auto &c : name) {
+        c = toupper(c);
+      }
+      name += expr->distinct ? "(DISTINCT " : "(";
+      if (expr->exprList != nullptr) {
+        for (size_t i = 0; i < expr->exprList->size(); ++i) {
+          name += (i == 0 ? "" : ", ") + ExprName(expr->exprList->at(i));
+        }
+      }
+      return name + ")";
+    }
+    case hsql::ExprType::kExprLiteralInt:
+      return std::to_string(expr->ival);
+    default:
+      throw std::runtime_error("unsupported expression in select list.");
+  }
+}
+
+auto ResolveColumn(const hsql::Expr *expr, const std::vector<Cloum> &cols)
+    -> int {
+  if (expr != nullptr && expr->type == hsql::ExprType::kExprFunctionRef) {
+    auto name = ExprName(expr);
+    for (size_t i = 0; i < cols.size(); ++i) {
+      if (cols[i].cloum_name_ == name) {
+        return i;
+      }
+    }
+    return -1;
+  }
+  if (expr == nullptr || expr->type != hsql::ExprType::kExprColumnRef) {
+    return -1;
+  }
+  if (expr->table != nullptr) {
+    std::string qualified = std::string(expr->table) + "." + expr->name;
+    for (size_t i = 0; i < cols.size(); ++i) {
+      if (cols[i].cloum_name_ == qualified) {
+        return i;
+      }
+    }
+  }
+  return GetIndexByName(expr->name, cols);
+}
+
+auto QualifyCols(const std::vector<Cloum> &cols, const std::string &table_name)
+    -> std::vector<Cloum> {
+  std::vector<Cloum> ret;
+  ret.reserve(cols.size());
+  for (auto &col : cols) {
+    if (col.cloum_name_.find('.') != std::string::npos) {
+      ret.push_back(col);
+    } else {
+      ret.emplace_back(table_name + "." + col.cloum_name_, col.atr_);
+    }
+  }
+  return ret;
+}
+
+static auto CompareChar(const char *a, size_t a_size, const char *b,
+                        size_t b_size) -> int {
+  size_t la = strnlen(a, a_size);
+  size_t lb = strnlen(b, b_size);
+  int ret = memcmp(a, b, la < lb ? la : lb);
+  if (ret != 0) {
+    return ret;
+  }
+  return la < lb ? -1 : (la > lb ? 1 : 0);
+}
+
+auto CompareLiteral(const char *src, const Cloum &col,
+                    const hsql::Expr *literal) -> int {
+  switch (col.GetType()) {
+    case CloumType::INT: {
+      int a = 0;
+      memcpy(&a, src, sizeof(int));
+      int64_t b = literal->ival;
+      return a < b ? -1 : (a > b ? 1 : 0);
+    }
+    case CloumType::CHAR:
+      return CompareChar(src, col.GetSize(), literal->name,
+                         strlen(literal->name));
+    default:
+      throw std::runtime_error("only support int&char now.");
+  }
+}
+
+auto CompareValue(const char *a, const char *b, const Cloum &col) -> int {
+  switch (col.GetType()) {
+    case CloumType::INT: {
+      int x = 0, y = 0;
+      memcpy(&x, a, sizeof(int));
+      memcpy(&y, b, sizeof(int));
+      return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    case CloumType::CHAR:
+      return CompareChar(a, col.GetSize(), b, col.GetSize());
+    default:
+      throw std::runtime_error("only support int&char now.");
+  }
+}
+
+auto CompareCloums(const char *a, const Cloum &col_a, const char *b,
+                   const Cloum &col_b) -> int {
+  if (col_a.GetType() != col_b.GetType()) {
+    throw std::runtime_error("can't compare cloums of different types.");
+  }
+  if (col_a.GetType() == CloumType::CHAR) {
+    return CompareChar(a, col_a.GetSize(), b, col_b.GetSize());
+  }
+  return CompareValue(a, b, col_a);
+}
+
+auto EncodeKey(const Tuple &tuple, const std::vector<int> &indexes)
+    -> std::string {
+  auto &cols = tuple.GetCloums();
+  std::string key;
+  for (auto index : indexes) {
+    auto src = tuple.GetValuePtrAt(index);
+    if (cols[index].GetType() == CloumType::CHAR) {
+      key.append(src, strnlen(src, cols[index].GetSize()));
+      key.push_back('\0');
+    } else {
+      key.append(src, cols[index].GetSize());
+    }
+  }
+  return key;
+}
+
+void WriteLiteral(char *dst, const Cloum &col, const hsql::Expr *literal) {
+  switch (col.GetType()) {
+    case CloumType::INT: {
+      int v = literal->ival;
+      memcpy(dst, &v, sizeof(int));
+      break;
+    }
+    case CloumType::CHAR:
+      memset(dst, '\0', col.GetSize());
+      strncpy(dst, literal->name, col.GetSize());
+      break;
+    default:
+      throw std::runtime_error("only support int&char now.");
+  }
+}
+
+auto IsLiteralOf(const hsql::Expr *literal, const Cloum &col) -> bool {
+  if (literal == nullptr) {
+    return false;
+  }
+  switch (col.GetType()) {
+    case CloumType::INT:
+      return literal->type == hsql::ExprType::kExprLiteralInt;
+    case CloumType::CHAR:
+      return literal->type == hsql::ExprType::kExprLiteralString;
+    default:
+      return false;
+  }
+}
+
+static auto IsSatisfied(hsql::OperatorType op, int cmp) -> bool {
+  switch (op) {
+    case hsql::OperatorType::kOpEquals:
+      return cmp == 0;
+    case hsql::OperatorType::kOpNotEquals:
+      return cmp != 0;
+    case hsql::OperatorType::kOpLess:
+      return cmp < 0;
+    case hsql::OperatorType::kOpLessEq:
+      return cmp <= 0;
+    case hsql::OperatorType::kOpGreater:
+      return cmp > 0;
+    case hsql::OperatorType::kOpGreaterEq:
+      return cmp >= 0;
+    default:
+      throw std::runtime_error("unsupported operator in where clause.");
+  }
+}
+
+// compare two operands of a binary predicate, at least one of them should be
+// a cloum of the tuple
+static auto CompareOperands(const hsql::Expr *lhs, const hsql::Expr *rhs,
+                            const Tuple &tuple, const std::vector<Cloum> &cols)
+    -> int {
+  int l = ResolveColumn(lhs, cols);
+  int r = ResolveColumn(rhs, cols);
+  if (l != -1 && r != -1) {
+    return CompareCloums(tuple.GetValuePtrAt(l), cols[l],
+                         tuple.GetValuePtrAt(r), cols[r]);
+  }
+  if (l != -1 && IsLiteralOf(rhs, cols[l])) {
+    return CompareLiteral(tuple.GetValuePtrAt(l), cols[l], rhs);
+  }
+  if (r != -1 && IsLiteralOf(lhs, cols[r])) {
+    return -CompareLiteral(tuple.GetValuePtrAt(r), cols[r], lhs);
+  }
+  throw std::runtime_error("unsupported operands in where clause.");
+}
+
+auto EvaluatePredicate(const hsql::Expr *expr, const Tuple &tuple,
+                       const std::vector<Cloum> &cols) -> bool {
+  if (expr == nullptr) {
+    return true;
+  }
+  switch (expr->type) {
+    case hsql::ExprType::kExprLiteralInt:
+      return expr->ival != 0;
+    case hsql::ExprType::kExprOperator:
+      break;
+    default:
+      throw std::runtime_error("unsupported expression in where clause.");
+  }
+
+  switch (expr->opType) {
+    case hsql::OperatorType::kOpAnd:
+      return EvaluatePredicate(expr->expr, tuple, cols) &&
+             EvaluatePredicate(expr->expr2, tuple, cols);
+    case hsql::OperatorType::kOpOr:
+      return EvaluatePredicate(expr->expr, tuple, cols) ||
+             EvaluatePredicate(expr->expr2, tuple, cols);
+    case hsql::OperatorType::kOpNot:
+      return !EvaluatePredicate(expr->expr, tuple, cols);
+    case hsql::OperatorType::kOpBetween:
+      return CompareOperands(expr->expr, expr->exprList->at(0), tuple, cols) >=
+                 0 &&
+             CompareOperands(expr->expr, expr->exprList->at(1), tuple, cols) <=
+                 0;
+    default:
+      return IsSatisfied(expr->opType,
+                         CompareOperands(expr->expr, expr->expr2, tuple, cols));
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,25 @@
+#include "executor/filter_executor.h"
+
+#include "executor/expression.h"
+
+namespace spdb {
+FilterExecutor::FilterExecutor(Catalog *catalog,
+                               std::unique_ptr<AbstractExecutor> child,
+                               const hsql::Expr *predicate)
+    : AbstractExecutor(catalog),
+      child_executor_(std::move(child)),
+      predicate_(predicate) {
+  cols_ = child_executor_->GetOutputCols();
+}
+
+auto FilterExecutor::GetOutputCols() -> std::vector<Cloum> { return cols_; }
+
+auto FilterExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (child_executor_->Next(tuple, rid)) {
+    if (EvaluatePredicate(predicate_, *tuple, cols_)) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace spdb
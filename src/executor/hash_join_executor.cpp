@@ -0,0 +1,169 @@
+#include "executor/hash_join_executor.h"
+
+#include <functional>
+
+#include "executor/expression.h"
+
+namespace spdb {
+// rough cost of a hash table entry besides the tuple and the key
+static constexpr size_t HASH_ENTRY_OVERHEAD = 64;
+
+HashJoinExecutor::HashJoinExecutor(
+    Catalog *catalog, std::unique_ptr<AbstractExecutor> left,
+    const std::string &left_name, std::unique_ptr<AbstractExecutor> right,
+    const std::string &right_name, std::vector<int> left_keys,
+    std::vector<int> right_keys, const hsql::Expr *predicate, bool build_left,
+    size_t memory_budget)
+    : AbstractExecutor(catalog),
+      left_executor_(std::move(left)),
+      right_executor_(std::move(right)),
+      left_keys_(std::move(left_keys)),
+      right_keys_(std::move(right_keys)),
+      predicate_(predicate),
+      build_left_(build_left),
+      memory_budget_(memory_budget) {
+  if (left_keys_.empty() || left_keys_.size() != right_keys_.size()) {
+    throw std::runtime_error("HashJoinExecutor: invalid join keys.");
+  }
+  left_cols_ = QualifyCols(left_executor_->GetOutputCols(), left_name);
+  right_cols_ = QualifyCols(right_executor_->GetOutputCols(), right_name);
+  output_cols_ = left_cols_;
+  output_cols_.insert(output_cols_.end(), right_cols_.begin(),
+                      right_cols_.end());
+}
+
+auto HashJoinExecutor::GetOutputCols() -> std::vector<Cloum> {
+  return output_cols_;
+}
+
+void HashJoinExecutor::Build() {
+  auto &build_executor = build_left_ ? left_executor_ : right_executor_;
+  auto &probe_executor = build_left_ ? right_executor_ : left_executor_;
+  auto &build_cols = build_left_ ? left_cols_ : right_cols_;
+  auto &probe_cols = build_left_ ? right_cols_ : left_cols_;
+  auto &build_keys = build_left_ ? left_keys_ : right_keys_;
+  auto &probe_keys = build_left_ ? right_keys_ : left_keys_;
+  auto partition_of = [](const std::string &key) {
+    return std::hash<std::string>{}(key) % SPILL_PARTITION_NUMS;
+  };
+
+  Tuple tuple{build_cols};
+  RID rid{};
+  size_t used = 0;
+  while (build_executor->Next(&tuple, &rid)) {
+    auto key = EncodeKey(tuple, build_keys);
+    if (!build_partitions_.empty()) {
+      build_partitions_[partition_of(key)]->Append(tuple);
+      continue;
+    }
+    used += key.size() + tuple.GetCloums().size() * sizeof(Cloum) +
+            HASH_ENTRY_OVERHEAD;
+    for (auto &col : build_cols) {
+      used += col.GetSize();
+    }
+    hash_table_.emplace(std::move(key), tuple);
+    if (used <= memory_budget_) {
+      continue;
+    }
+
+    // over budget, move the build side into partitions
+    for (size_t i = 0; i < SPILL_PARTITION_NUMS; ++i) {
+      build_partitions_.push_back(std::make_unique<TempFile>(build_cols));
+      probe_partitions_.push_back(std::make_unique<TempFile>(probe_cols));
+    }
+    for (auto &[k, v] : hash_table_) {
+      build_partitions_[partition_of(k)]->Append(v);
+    }
+    hash_table_.clear();
+  }
+  is_built_ = true;
+  if (build_partitions_.empty()) {
+    return;
+  }
+
+  Tuple probe_tuple{probe_cols};
+  while (probe_executor->Next(&probe_tuple, &rid)) {
+    auto key = EncodeKey(probe_tuple, probe_keys);
+    probe_partitions_[partition_of(key)]->Append(probe_tuple);
+  }
+  LoadPartition(0);
+}
+
+void HashJoinExecutor::LoadPartition(size_t partition) {
+  // a single partition is expected to fit in memory
+  hash_table_.clear();
+  auto &build_cols = build_left_ ? left_cols_ : right_cols_;
+  auto &build_keys = build_left_ ? left_keys_ : right_keys_;
+  auto &build_file = build_partitions_[partition];
+  build_file->Rewind();
+  Tuple tuple{build_cols};
+  while (build_file->Next(&tuple)) {
+    hash_table_.emplace(EncodeKey(tuple, build_keys), tuple);
+  }
+  build_file.reset();
+  probe_partitions_[partition]->Rewind();
+}
+
+auto HashJoinExecutor::NextProbe(Tuple *tuple) -> bool {
+  if (probe_partitions_.empty()) {
+    RID rid{};
+    auto &probe_executor = build_left_ ? right_executor_ : left_executor_;
+    return probe_executor->Next(tuple, &rid);
+  }
+  while (partition_ < probe_partitions_.size()) {
+    if (probe_partitions_[partition_]->Next(tuple)) {
+      return true;
+    }
+    probe_partitions_[partition_].reset();
+    if (++partition_ < probe_partitions_.size()) {
+      LoadPartition(partition_);
+    }
+  }
+  return false;
+}
+
+auto HashJoinExecutor::Combine(const Tuple &left, const Tuple &right)
+    -> Tuple {
+  size_t left_size = 0, right_size = 0;
+  for (auto &col : left_cols_) {
+    left_size += col.GetSize();
+  }
+  for (auto &col : right_cols_) {
+    right_size += col.GetSize();
+  }
+  auto src = (char *)malloc(left_size + right_size);
+  memcpy(src, left.GetData(), left_size);
+  memcpy(src + left_size, right.GetData(), right_size);
+  Tuple ret{output_cols_};
+  ret.SetValues(src);
+  free(src);
+  return ret;
+}
+
+auto HashJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!is_built_) {
+    Build();
+  }
+  auto &probe_cols = build_left_ ? right_cols_ : left_cols_;
+  auto &probe_keys = build_left_ ? right_keys_ : left_keys_;
+  Tuple probe_tuple{probe_cols};
+  while (results_.empty()) {
+    if (!NextProbe(&probe_tuple)) {
+      return false;
+    }
+    auto [begin, end] = hash_table_.equal_range(EncodeKey(probe_tuple,
+                                                          probe_keys));
+    for (auto it = begin; it != end; ++it) {
+      auto joined = build_left_ ? Combine(it->second, probe_tuple)
+                                : Combine(probe_tuple, it->second);
+      if (EvaluatePredicate(predicate_, joined, output_cols_)) {
+        results_.push_back(joined);
+      }
+    }
+  }
+  *tuple = results_.front();
+  results_.pop_front();
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
@@ -0,0 +1,228 @@
+#include "executor/index_scan_executor.h"
+
+#include <climits>
+
+#include "executor/expression.h"
+
+namespace spdb {
+static auto AsSelect(const hsql::SQLStatement *state)
+    -> const hsql::SelectStatement * {
+  if (!state->isType(hsql::StatementType::kStmtSelect)) {
+    throw std::runtime_error(
+        "IndexScanExecutor should construct with a selectstatement.");
+  }
+  return static_cast<const hsql::SelectStatement *>(state);
+}
+
+IndexScanExecutor::IndexScanExecutor(Catalog *catalog,
+                                     const hsql::SQLStatement *state,
+                                     KeyRange range, const IndexInfo *index)
+    : IndexScanExecutor(catalog, AsSelect(state)->fromTable->name,
+                        AsSelect(state)->whereClause, range, index) {}
+
+IndexScanExecutor::IndexScanExecutor(Catalog *catalog,
+                                     const std::string &table_name,
+                                     const hsql::Expr *predicate,
+                                     KeyRange range, const IndexInfo *index)
+    : AbstractExecutor(catalog),
+      range_(range),
+      snapshot_(catalog->GetTransactionManager()) {
+  if (!catalog->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  table_info_ = catalog->GetTable(table_name);
+  predicate_ = predicate;
+  table_ = std::make_unique<BPlusTree>(
+      catalog->GetBufferPoolManager(table_info_.disk_name_),
+      table_info_.key_type_, table_info_.value_type_,
+      table_info_.leaf_max_size_, table_info_.internal_max_size_,
+      table_info_.root_id_);
+  key_type_ = index == nullptr ? table_info_.key_type_ : index->key_type_;
+
+  // the smallest key inside the range, unbounded cloums take their minimum
+  auto &key_type = key_type_;
+  size_t key_size = 0;
+  for (auto &col : key_type) {
+    key_size += col.GetSize();
+  }
+  auto src = (char *)malloc(key_size);
+  memset(src, '\0', key_size);
+  size_t offset = 0;
+  for (size_t i = 0; i < key_type.size(); ++i) {
+    if (i < range_.eq_.size()) {
+      WriteLiteral(src + offset, key_type[i], range_.eq_[i]);
+    } else if (i == range_.eq_.size() && range_.lower_ != nullptr) {
+      WriteLiteral(src + offset, key_type[i], range_.lower_);
+    } else if (key_type[i].GetType() == CloumType::INT) {
+      int min = INT_MIN;
+      memcpy(src + offset, &min, sizeof(int));
+    }
+    offset += key_type[i].GetSize();
+  }
+  Tuple low_key{key_type};
+  low_key.SetValues(src);
+  free(src);
+  low_key_ = std::make_unique<Tuple>(low_key);
+  displaced_key_ = std::make_unique<Tuple>(table_info_.key_type_);
+
+  if (index != nullptr) {
+    is_index_scan_ = true;
+    last_key_ = std::make_unique<Tuple>(table_info_.key_type_);
+    // the root is read after the snapshot is taken, as a compaction since
+    // the plan only keeps the old pages for the older snapshots
+    page_id_t index_root_id = index->root_id_;
+    for (auto &info : table_info_.indexes_) {
+      if (info.index_name_ == index->index_name_) {
+        index_root_id = info.root_id_;
+      }
+    }
+    BPlusTree index_tree(catalog->GetBufferPoolManager(index->disk_name_),
+                         index->key_type_, table_info_.key_type_,
+                         index->leaf_max_size_, index->internal_max_size_,
+                         index_root_id);
+    table_iterator_ = index_tree.Begin(low_key);
+  } else if (range_.IsPoint(key_type.size())) {
+    point_result_ = std::make_unique<Tuple>(table_info_.value_type_);
+    // a row deleted since the snapshot is read from the versions
+    bool is_found =
+        table_->GetValue(low_key, *point_result_)
+            ? snapshot_.ReadRow(table_info_.disk_name_, low_key,
+                                point_result_.get())
+            : snapshot_.ReadOlderVersion(table_info_.disk_name_, low_key,
+                                         point_result_.get());
+    if (!is_found) {
+      point_result_.reset();
+    }
+    is_end_ = true;
+  } else {
+    table_iterator_ = table_->Begin(low_key);
+    last_key_ = std::make_unique<Tuple>(low_key);
+  }
+}
+
+IndexScanExecutor::~IndexScanExecutor() {}
+
+auto IndexScanExecutor::GetOutputCols() -> std::vector<Cloum> {
+  return table_info_.value_type_;
+}
+
+auto IndexScanExecutor::InRange(const Tuple &key) -> bool {
+  auto &key_type = key_type_;
+  for (size_t i = 0; i < range_.eq_.size(); ++i) {
+    if (CompareLiteral(key.GetValuePtrAt(i), key_type[i], range_.eq_[i]) != 0) {
+      is_end_ = true;
+      return false;
+    }
+  }
+  size_t col = range_.eq_.size();
+  if (range_.upper_ != nullptr) {
+    int cmp = CompareLiteral(key.GetValuePtrAt(col), key_type[col],
+                             range_.upper_);
+    if (cmp > 0 || (cmp == 0 && !range_.upper_inclusive_)) {
+      is_end_ = true;
+      return false;
+    }
+  }
+  if (range_.lower_ != nullptr && !range_.lower_inclusive_) {
+    return CompareLiteral(key.GetValuePtrAt(col), key_type[col],
+                          range_.lower_) != 0;
+  }
+  return true;
+}
+
+auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (point_result_ != nullptr) {
+    auto result = std::move(point_result_);
+    if (!EvaluatePredicate(predicate_, *result, table_info_.value_type_)) {
+      return false;
+    }
+    *tuple = *result;
+    *rid = result->GetRid();
+    return true;
+  }
+
+  return is_index_scan_ ? NextInIndex(tuple, rid) : NextInTable(tuple, rid);
+}
+
+auto IndexScanExecutor::NextInTable(Tuple *tuple, RID *rid) -> bool {
+  while (!is_end_) {
+    // a row deleted since the snapshot comes before the next one of the tree,
+    // the range starts at low_key_ itself
+    const Tuple *next_key =
+        table_iterator_.IsEnd() ? nullptr : &(*table_iterator_).first;
+    if (snapshot_.NextDisplacedRow(table_info_.disk_name_, last_key_.get(),
+                                   !has_last_key_, next_key,
+                                   displaced_key_.get(), tuple)) {
+      *last_key_ = *displaced_key_;
+      has_last_key_ = true;
+      if (!InRange(*displaced_key_) ||
+          !EvaluatePredicate(predicate_, *tuple, table_info_.value_type_)) {
+        continue;
+      }
+      *rid = RID{};
+      return true;
+    }
+    if (table_iterator_.IsEnd()) {
+      return false;
+    }
+
+    auto [key, value] = *table_iterator_;
+    ++table_iterator_;
+    *last_key_ = key;
+    has_last_key_ = true;
+    if (!InRange(key) ||
+        !snapshot_.ReadRow(table_info_.disk_name_, key, &value) ||
+        !EvaluatePredicate(predicate_, value, table_info_.value_type_)) {
+      continue;
+    }
+    *tuple = value;
+    *rid = value.GetRid();
+    return true;
+  }
+  return false;
+}
+
+auto IndexScanExecutor::NextInIndex(Tuple *tuple, RID *rid) -> bool {
+  while (!is_end_ && !table_iterator_.IsEnd()) {
+    auto [key, value] = *table_iterator_;
+    ++table_iterator_;
+    if (!InRange(key)) {
+      continue;
+    }
+    // value is the table key of an index entry, a row being updated may be
+    // met at its old and its new entry
+    Tuple row{table_info_.value_type_};
+    if (!table_->GetValue(value, row) ||
+        !snapshot_.ReadRow(table_info_.disk_name_, value, &row) ||
+        !EvaluatePredicate(predicate_, row, table_info_.value_type_) ||
+        !returned_
+             .insert(TransactionManager::RowKey(table_info_.disk_name_, value))
+             .second) {
+      continue;
+    }
+    *tuple = row;
+    *rid = row.GetRid();
+    return true;
+  }
+
+  // then the rows which left the range of the index since the snapshot
+  while (snapshot_.NextDisplacedRow(
+      table_info_.disk_name_, has_last_key_ ? last_key_.get() : nullptr,
+      false, nullptr, displaced_key_.get(), tuple)) {
+    *last_key_ = *displaced_key_;
+    has_last_key_ = true;
+    auto index_key = tuple->Project(key_type_);
+    if (index_key < *low_key_ || !InRange(index_key) ||
+        !EvaluatePredicate(predicate_, *tuple, table_info_.value_type_) ||
+        !returned_
+             .insert(TransactionManager::RowKey(table_info_.disk_name_,
+                                                *displaced_key_))
+             .second) {
+      continue;
+    }
+    *rid = RID{};
+    return true;
+  }
+  return false;
+}
+}  // namespace spdb
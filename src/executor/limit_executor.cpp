@@ -0,0 +1,32 @@
+#include "executor/limit_executor.h"
+
+namespace spdb {
+LimitExecutor::LimitExecutor(Catalog *catalog,
+                             std::unique_ptr<AbstractExecutor> child,
+                             size_t limit, size_t offset)
+    : AbstractExecutor(catalog),
+      child_executor_(std::move(child)),
+      limit_(limit),
+      offset_(offset) {
+  cols_ = child_executor_->GetOutputCols();
+}
+
+auto LimitExecutor::GetOutputCols() -> std::vector<Cloum> { return cols_; }
+
+auto LimitExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (count_ >= limit_) {
+    return false;
+  }
+  if (offset_ > 0) {
+    child_executor_->Skip(offset_);
+    offset_ = 0;
+  }
+  if (!child_executor_->Next(tuple, rid)) {
+    // the child is done, it isn't asked again
+    limit_ = count_;
+    return false;
+  }
+  ++count_;
+  return true;
+}
+}  // namespace spdb
@@ -0,0 +1,112 @@
+#include "executor/merge_join_executor.h"
+
+#include "executor/expression.h"
+
+namespace spdb {
+MergeJoinExecutor::MergeJoinExecutor(
+    Catalog *catalog, std::unique_ptr<AbstractExecutor> left,
+    const std::string &left_name, std::unique_ptr<AbstractExecutor> right,
+    const std::string &right_name, std::vector<int> left_keys,
+    std::vector<int> right_keys, const hsql::Expr *predicate)
+    : AbstractExecutor(catalog),
+      left_executor_(std::move(left)),
+      right_executor_(std::move(right)),
+      left_keys_(std::move(left_keys)),
+      right_keys_(std::move(right_keys)),
+      predicate_(predicate) {
+  if (left_keys_.empty() || left_keys_.size() != right_keys_.size()) {
+    throw std::runtime_error("MergeJoinExecutor: invalid join keys.");
+  }
+  left_cols_ = QualifyCols(left_executor_->GetOutputCols(), left_name);
+  right_cols_ = QualifyCols(right_executor_->GetOutputCols(), right_name);
+  output_cols_ = left_cols_;
+  output_cols_.insert(output_cols_.end(), right_cols_.begin(),
+                      right_cols_.end());
+  left_tuple_ = std::make_unique<Tuple>(left_cols_);
+  right_tuple_ = std::make_unique<Tuple>(right_cols_);
+}
+
+auto MergeJoinExecutor::GetOutputCols() -> std::vector<Cloum> {
+  return output_cols_;
+}
+
+auto MergeJoinExecutor::CompareKeys(const Tuple &left, const Tuple &right)
+    -> int {
+  for (size_t i = 0; i < left_keys_.size(); ++i) {
+    int l = left_keys_[i], r = right_keys_[i];
+    int cmp = CompareCloums(left.GetValuePtrAt(l), left_cols_[l],
+                            right.GetValuePtrAt(r), right_cols_[r]);
+    if (cmp != 0) {
+      return cmp;
+    }
+  }
+  return 0;
+}
+
+void MergeJoinExecutor::AdvanceLeft() {
+  RID rid{};
+  has_left_ = left_executor_->Next(left_tuple_.get(), &rid);
+}
+
+void MergeJoinExecutor::AdvanceRight() {
+  RID rid{};
+  has_right_ = right_executor_->Next(right_tuple_.get(), &rid);
+}
+
+auto MergeJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!is_started_) {
+    AdvanceLeft();
+    AdvanceRight();
+    is_started_ = true;
+  }
+  size_t left_size = 0;
+  for (auto &col : left_cols_) {
+    left_size += col.GetSize();
+  }
+  size_t right_size = 0;
+  for (auto &col : right_cols_) {
+    right_size += col.GetSize();
+  }
+
+  while (results_.empty()) {
+    if (!has_left_) {
+      return false;
+    }
+    if (!group_.empty() && CompareKeys(*left_tuple_, group_.front()) == 0) {
+      auto src = (char *)malloc(left_size + right_size);
+      memcpy(src, left_tuple_->GetData(), left_size);
+      for (auto &right : group_) {
+        memcpy(src + left_size, right.GetData(), right_size);
+        Tuple joined{output_cols_};
+        joined.SetValues(src);
+        if (EvaluatePredicate(predicate_, joined, output_cols_)) {
+          results_.push_back(joined);
+        }
+      }
+      free(src);
+      AdvanceLeft();
+      continue;
+    }
+
+    group_.clear();
+    while (has_right_ && CompareKeys(*left_tuple_, *right_tuple_) > 0) {
+      AdvanceRight();
+    }
+    if (!has_right_) {
+      return false;
+    }
+    if (CompareKeys(*left_tuple_, *right_tuple_) < 0) {
+      AdvanceLeft();
+      continue;
+    }
+    while (has_right_ && CompareKeys(*left_tuple_, *right_tuple_) == 0) {
+      group_.push_back(*right_tuple_);
+      AdvanceRight();
+    }
+  }
+  *tuple = results_.front();
+  results_.pop_front();
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
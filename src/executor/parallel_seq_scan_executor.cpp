@@ -0,0 +1,136 @@
+#include "executor/parallel_seq_scan_executor.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace spdb {
+ParallelSeqScanExecutor::ParallelSeqScanExecutor(
+    Catalog *catalog, const std::string &table_name,
+    const hsql::Expr *predicate, size_t worker_nums, TaskScheduler *scheduler)
+    : AbstractExecutor(catalog),
+      scheduler_(scheduler),
+      snapshot_(catalog->GetTransactionManager()),
+      tasks_(scheduler) {
+  if (!catalog->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  table_info_ = catalog->GetTable(table_name);
+  for (auto &col : table_info_.value_type_) {
+    tuple_size_ += col.GetSize();
+  }
+  worker_nums = std::max<size_t>(worker_nums, 1);
+  BPlusTree table(catalog->GetBufferPoolManager(table_info_.disk_name_),
+                  table_info_.key_type_, table_info_.value_type_,
+                  table_info_.leaf_max_size_, table_info_.internal_max_size_,
+                  table_info_.root_id_);
+  auto split_keys =
+      table.SplitKeys(worker_nums * PARALLEL_SCAN_MORSELS_PER_WORKER);
+  for (size_t i = 0; i <= split_keys.size(); ++i) {
+    morsels_.push_back(std::make_unique<SeqScanExecutor>(
+        catalog, table_name, predicate, &snapshot_,
+        i == 0 ? nullptr : &split_keys[i - 1],
+        i == split_keys.size() ? nullptr : &split_keys[i]));
+  }
+}
+
+ParallelSeqScanExecutor::~ParallelSeqScanExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    is_stopped_ = true;
+  }
+  not_full_.notify_all();
+  tasks_.Wait();
+}
+
+auto ParallelSeqScanExecutor::GetOutputCols() -> std::vector<Cloum> {
+  return table_info_.value_type_;
+}
+
+void ParallelSeqScanExecutor::ForEachMorsel(
+    const std::function<void(AbstractExecutor *)> &task) {
+  for (auto &morsel : morsels_) {
+    auto scan = morsel.get();
+    tasks_.Run([&task, scan] { task(scan); });
+  }
+  tasks_.Wait();
+}
+
+void ParallelSeqScanExecutor::Scan(size_t morsel) {
+  Tuple tuple{table_info_.value_type_};
+  RID rid{};
+  std::vector<char> batch;
+  try {
+    while (!is_stopped_ && morsels_[morsel]->Next(&tuple, &rid)) {
+      batch.insert(batch.end(), tuple.GetData(),
+                   tuple.GetData() + tuple_size_);
+      if (batch.size() < tuple_size_ * EXCHANGE_BATCH_SIZE) {
+        continue;
+      }
+      if (!Push(std::move(batch))) {
+        break;
+      }
+      batch.clear();
+    }
+    if (!batch.empty()) {
+      Push(std::move(batch));
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(latch_);
+    if (error_ == nullptr) {
+      error_ = std::current_exception();
+    }
+    is_stopped_ = true;
+  }
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    --running_;
+  }
+  not_empty_.notify_all();
+  not_full_.notify_all();
+}
+
+auto ParallelSeqScanExecutor::Push(std::vector<char> batch) -> bool {
+  std::unique_lock<std::mutex> lock(latch_);
+  not_full_.wait(lock, [&] {
+    return is_stopped_ || batches_.size() < EXCHANGE_QUEUE_SIZE;
+  });
+  if (is_stopped_) {
+    return false;
+  }
+  batches_.push_back(std::move(batch));
+  lock.unlock();
+  not_empty_.notify_one();
+  return true;
+}
+
+auto ParallelSeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!is_started_) {
+    is_started_ = true;
+    running_ = morsels_.size();
+    for (size_t i = 0; i < morsels_.size(); ++i) {
+      tasks_.Run([this, i] { Scan(i); });
+    }
+  }
+  while (batch_offset_ == batch_.size()) {
+    std::unique_lock<std::mutex> lock(latch_);
+    not_empty_.wait(lock, [&] {
+      return !batches_.empty() || running_ == 0 || error_ != nullptr;
+    });
+    if (error_ != nullptr) {
+      std::rethrow_exception(error_);
+    }
+    if (batches_.empty()) {
+      return false;
+    }
+    batch_ = std::move(batches_.front());
+    batches_.pop_front();
+    batch_offset_ = 0;
+    lock.unlock();
+    not_full_.notify_one();
+  }
+  tuple->SetValues(batch_.data() + batch_offset_);
+  batch_offset_ += tuple_size_;
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
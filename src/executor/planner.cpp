@@ -0,0 +1,529 @@
+#include "executor/planner.h"
+
+#include "executor/aggregation_executor.h"
+#include "executor/expression.h"
+#include "executor/filter_executor.h"
+#include "executor/hash_join_executor.h"
+#include "executor/limit_executor.h"
+#include "executor/merge_join_executor.h"
+#include "executor/parallel_seq_scan_executor.h"
+#include "executor/seq_scan_executor.h"
+#include "executor/sort_executor.h"
+#include "executor/task_scheduler.h"
+
+namespace spdb {
+static void CollectConjuncts(const hsql::Expr *expr,
+                             std::vector<const hsql::Expr *> &conjuncts) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (expr->type == hsql::ExprType::kExprOperator &&
+      expr->opType == hsql::OperatorType::kOpAnd) {
+    CollectConjuncts(expr->expr, conjuncts);
+    CollectConjuncts(expr->expr2, conjuncts);
+    return;
+  }
+  conjuncts.push_back(expr);
+}
+
+// mirror a comparison so that the cloum can be read as the left operand
+static auto FlipOperator(hsql::OperatorType op) -> hsql::OperatorType {
+  switch (op) {
+    case hsql::OperatorType::kOpLess:
+      return hsql::OperatorType::kOpGreater;
+    case hsql::OperatorType::kOpLessEq:
+      return hsql::OperatorType::kOpGreaterEq;
+    case hsql::OperatorType::kOpGreater:
+      return hsql::OperatorType::kOpLess;
+    case hsql::OperatorType::kOpGreaterEq:
+      return hsql::OperatorType::kOpLessEq;
+    default:
+      return op;
+  }
+}
+
+static auto RefersTo(const hsql::Expr *expr, const Cloum &col) -> bool {
+  return expr != nullptr && expr->type == hsql::ExprType::kExprColumnRef &&
+         GetIndexByName(expr->name, {col}) == 0;
+}
+
+auto ExtractKeyRange(const hsql::Expr *where,
+                     const std::vector<Cloum> &key_type)
+    -> std::optional<KeyRange> {
+  std::vector<const hsql::Expr *> conjuncts;
+  CollectConjuncts(where, conjuncts);
+
+  KeyRange range;
+  for (auto &col : key_type) {
+    const hsql::Expr *eq = nullptr;
+    for (auto conjunct : conjuncts) {
+      if (conjunct->type != hsql::ExprType::kExprOperator) {
+        continue;
+      }
+      auto op = conjunct->opType;
+      const hsql::Expr *literal = nullptr;
+      if (op == hsql::OperatorType::kOpBetween) {
+        auto low = conjunct->exprList->at(0);
+        auto high = conjunct->exprList->at(1);
+        if (RefersTo(conjunct->expr, col) && IsLiteralOf(low, col) &&
+            IsLiteralOf(high, col)) {
+          range.lower_ = range.lower_ == nullptr ? low : range.lower_;
+          range.upper_ = range.upper_ == nullptr ? high : range.upper_;
+        }
+        continue;
+      }
+      if (RefersTo(conjunct->expr, col) && IsLiteralOf(conjunct->expr2, col)) {
+        literal = conjunct->expr2;
+      } else if (RefersTo(conjunct->expr2, col) &&
+                 IsLiteralOf(conjunct->expr, col)) {
+        literal = conjunct->expr;
+        op = FlipOperator(op);
+      } else {
+        continue;
+      }
+
+      switch (op) {
+        case hsql::OperatorType::kOpEquals:
+          eq = literal;
+          break;
+        case hsql::OperatorType::kOpGreater:
+        case hsql::OperatorType::kOpGreaterEq:
+          if (range.lower_ == nullptr) {
+            range.lower_ = literal;
+            range.lower_inclusive_ = op == hsql::OperatorType::kOpGreaterEq;
+          }
+          break;
+        case hsql::OperatorType::kOpLess:
+        case hsql::OperatorType::kOpLessEq:
+          if (range.upper_ == nullptr) {
+            range.upper_ = literal;
+            range.upper_inclusive_ = op == hsql::OperatorType::kOpLessEq;
+          }
+          break;
+        default:
+          break;
+      }
+    }
+
+    if (eq == nullptr) {
+      break;
+    }
+    // an equality makes any range on the same cloum redundant
+    range.eq_.push_back(eq);
+    range.lower_ = nullptr;
+    range.upper_ = nullptr;
+    range.lower_inclusive_ = true;
+    range.upper_inclusive_ = true;
+  }
+
+  if (range.eq_.empty() && range.lower_ == nullptr &&
+      range.upper_ == nullptr) {
+    return std::nullopt;
+  }
+  return range;
+}
+
+// an index scan if the where clause bounds the key of the table or of one
+// of its indexes, nullptr otherwise
+static auto PlanIndexScan(Catalog *catalog, const std::string &table_name,
+                          const hsql::Expr *where)
+    -> std::unique_ptr<AbstractExecutor> {
+  if (where == nullptr) {
+    return nullptr;
+  }
+
+  // an index is only worth it if it fixes more cloums than the table key
+  auto table_info = catalog->GetTable(table_name);
+  auto best_range = ExtractKeyRange(where, table_info.key_type_);
+  const IndexInfo *best_index = nullptr;
+  for (auto &index : table_info.indexes_) {
+    auto range = ExtractKeyRange(where, index.key_type_);
+    if (!range.has_value()) {
+      continue;
+    }
+    if (!best_range.has_value() || range->eq_.size() > best_range->eq_.size()) {
+      best_index = &index;
+      best_range = range;
+    }
+  }
+  if (!best_range.has_value()) {
+    return nullptr;
+  }
+  return std::make_unique<IndexScanExecutor>(catalog, table_name, where,
+                                             *best_range, best_index);
+}
+
+// the rows of a select are grouped or sorted before they are returned, so
+// the scan may return them in any order
+static auto IsReordered(const hsql::SelectStatement *select) -> bool {
+  if (select->groupBy != nullptr ||
+      (select->order != nullptr && !select->order->empty())) {
+    return true;
+  }
+  for (auto expr : *select->selectList) {
+    if (expr->type == hsql::ExprType::kExprFunctionRef) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// a table large enough to be scanned by every worker of the scheduler
+static auto IsParallelScanWorth(Catalog *catalog,
+                                const std::string &table_name) -> bool {
+  if (TaskScheduler::Global()->GetWorkerCount() < 2 ||
+      !catalog->IsExisted(table_name)) {
+    return false;
+  }
+  auto bpm = catalog->GetBufferPoolManager(table_name);
+  return static_cast<size_t>(bpm->GetPageCount()) >= PARALLEL_SCAN_MIN_PAGES;
+}
+
+auto PlanScan(Catalog *catalog, const hsql::SelectStatement *select)
+    -> std::unique_ptr<AbstractExecutor> {
+  std::string table_name = select->fromTable->name;
+  auto where = select->whereClause;
+  auto executor = PlanIndexScan(catalog, table_name, where);
+  if (executor != nullptr) {
+    return executor;
+  }
+  if (IsReordered(select) && IsParallelScanWorth(catalog, table_name)) {
+    return std::make_unique<ParallelSeqScanExecutor>(
+        catalog, table_name, where,
+        TaskScheduler::Global()->GetWorkerCount());
+  }
+  return std::make_unique<SeqScanExecutor>(catalog, table_name, where);
+}
+
+auto PlanScan(Catalog *catalog, const std::string &table_name,
+              const hsql::Expr *where) -> std::unique_ptr<AbstractExecutor> {
+  auto executor = PlanIndexScan(catalog, table_name, where);
+  if (executor != nullptr) {
+    return executor;
+  }
+  return std::make_unique<SeqScanExecutor>(catalog, table_name, where);
+}
+
+namespace {
+struct JoinInput {
+  std::unique_ptr<AbstractExecutor> executor_;
+  // the name cloums of this input are qualified with
+  std::string name_;
+  // the table a plain sequential scan reads, nullptr for joins
+  std::optional<TableInfo> table_;
+  // estimated size in bytes
+  size_t size_{0};
+};
+}  // namespace
+
+static auto PlanTableRef(Catalog *catalog, const hsql::TableRef *ref)
+    -> JoinInput;
+
+// split the join condition into pairs of cloums compared for equality, one
+// from each side
+static void ExtractJoinKeys(const hsql::Expr *condition,
+                            const std::vector<Cloum> &left_cols,
+                            const std::vector<Cloum> &right_cols,
+                            std::vector<int> &left_keys,
+                            std::vector<int> &right_keys) {
+  std::vector<const hsql::Expr *> conjuncts;
+  CollectConjuncts(condition, conjuncts);
+  for (auto conjunct : conjuncts) {
+    if (conjunct->type != hsql::ExprType::kExprOperator ||
+        conjunct->opType != hsql::OperatorType::kOpEquals) {
+      continue;
+    }
+    int l1 = ResolveColumn(conjunct->expr, left_cols);
+    int r1 = ResolveColumn(conjunct->expr, right_cols);
+    int l2 = ResolveColumn(conjunct->expr2, left_cols);
+    int r2 = ResolveColumn(conjunct->expr2, right_cols);
+    int l = -1, r = -1;
+    if (l1 != -1 && r1 == -1 && r2 != -1 && l2 == -1) {
+      l = l1;
+      r = r2;
+    } else if (l2 != -1 && r2 == -1 && r1 != -1 && l1 == -1) {
+      l = l2;
+      r = r1;
+    } else {
+      continue;
+    }
+    if (left_cols[l].GetType() != right_cols[r].GetType()) {
+      continue;
+    }
+    left_keys.push_back(l);
+    right_keys.push_back(r);
+  }
+}
+
+// check whether a sequential scan of the table is ordered on cloum col
+static auto IsOrderedOn(const std::optional<TableInfo> &table, int col)
+    -> bool {
+  return table.has_value() && !table->key_type_.empty() &&
+         table->key_type_[0].cloum_name_ == table->value_type_[col].cloum_name_;
+}
+
+static auto PlanJoin(Catalog *catalog, const hsql::JoinDefinition *join)
+    -> JoinInput {
+  if (join->type != hsql::JoinType::kJoinInner) {
+    throw std::runtime_error("only support inner join now.");
+  }
+  auto left = PlanTableRef(catalog, join->left);
+  auto right = PlanTableRef(catalog, join->right);
+  auto left_cols = QualifyCols(left.executor_->GetOutputCols(), left.name_);
+  auto right_cols = QualifyCols(right.executor_->GetOutputCols(), right.name_);
+
+  std::vector<int> left_keys, right_keys;
+  ExtractJoinKeys(join->condition, left_cols, right_cols, left_keys,
+                  right_keys);
+  if (left_keys.empty()) {
+    throw std::runtime_error("only support equi-join now.");
+  }
+
+  JoinInput ret;
+  ret.size_ = left.size_ + right.size_;
+  // the other key pairs are still checked as part of the join condition
+  for (size_t i = 0; i < left_keys.size(); ++i) {
+    if (IsOrderedOn(left.table_, left_keys[i]) &&
+        IsOrderedOn(right.table_, right_keys[i])) {
+      ret.executor_ = std::make_unique<MergeJoinExecutor>(
+          catalog, std::move(left.executor_), left.name_,
+          std::move(right.executor_), right.name_,
+          std::vector<int>{left_keys[i]}, std::vector<int>{right_keys[i]},
+          join->condition);
+      return ret;
+    }
+  }
+  bool build_left = left.size_ <= right.size_;
+  // the build side goes into a hash table, in whatever order it comes
+  auto &build = build_left ? left : right;
+  if (build.table_.has_value() &&
+      IsParallelScanWorth(catalog, build.table_->disk_name_)) {
+    build.executor_ = std::make_unique<ParallelSeqScanExecutor>(
+        catalog, build.table_->disk_name_, nullptr,
+        TaskScheduler::Global()->GetWorkerCount());
+  }
+  ret.executor_ = std::make_unique<HashJoinExecutor>(
+      catalog, std::move(left.executor_), left.name_,
+      std::move(right.executor_), right.name_, left_keys, right_keys,
+      join->condition, build_left);
+  return ret;
+}
+
+static auto PlanTableRef(Catalog *catalog, const hsql::TableRef *ref)
+    -> JoinInput {
+  switch (ref->type) {
+    case hsql::TableRefType::kTableName: {
+      JoinInput ret;
+      ret.table_ = catalog->GetTable(ref->name);
+      ret.name_ = ref->getName();
+      ret.executor_ = std::make_unique<SeqScanExecutor>(catalog, ref->name);
+      // the pages as they are in memory, a compressed file is smaller
+      auto bpm = catalog->GetBufferPoolManager(ret.table_->disk_name_);
+      ret.size_ = static_cast<size_t>(bpm->GetPageCount()) * PAGE_SIZE;
+      return ret;
+    }
+    case hsql::TableRefType::kTableJoin:
+      return PlanJoin(catalog, ref->join);
+    default:
+      throw std::runtime_error("only support table&join in from clause now.");
+  }
+}
+
+auto PlanFrom(Catalog *catalog, const hsql::SelectStatement *select)
+    -> std::unique_ptr<AbstractExecutor> {
+  if (select->fromTable->type != hsql::TableRefType::kTableJoin) {
+    return PlanScan(catalog, select);
+  }
+  auto input = PlanJoin(catalog, select->fromTable->join);
+  if (select->whereClause == nullptr) {
+    return std::move(input.executor_);
+  }
+  return std::make_unique<FilterExecutor>(catalog, std::move(input.executor_),
+                                          select->whereClause);
+}
+
+static auto IsAggregate(const hsql::Expr *expr) -> bool {
+  return expr != nullptr && expr->type == hsql::ExprType::kExprFunctionRef;
+}
+
+static auto ParseAggregate(const hsql::Expr *expr,
+                           const std::vector<Cloum> &cols) -> AggregateSpec {
+  auto name = ExprName(expr);
+  AggregateSpec spec{AggregationType::COUNT, -1, name};
+  std::string func = name.substr(0, name.find('('));
+  if (func == "COUNT") {
+    spec.type_ = AggregationType::COUNT;
+  } else if (func == "SUM") {
+    spec.type_ = AggregationType::SUM;
+  } else if (func == "MIN") {
+    spec.type_ = AggregationType::MIN;
+  } else if (func == "MAX") {
+    spec.type_ = AggregationType::MAX;
+  } else if (func == "AVG") {
+    spec.type_ = AggregationType::AVG;
+  } else {
+    throw std::runtime_error("unsupported function " + func + ".");
+  }
+  if (expr->distinct) {
+    throw std::runtime_error("unsupported distinct aggregate " + name + ".");
+  }
+  if (expr->exprList == nullptr || expr->exprList->size() != 1) {
+    throw std::runtime_error(name + " should have one argument.");
+  }
+  auto arg = expr->exprList->at(0);
+  if (arg->type == hsql::ExprType::kExprStar) {
+    return spec;
+  }
+  spec.col_ = ResolveColumn(arg, cols);
+  if (spec.col_ == -1) {
+    throw std::runtime_error("cloum " + ExprName(arg) + " is not existed.");
+  }
+  return spec;
+}
+
+// collect the aggregates an expression uses, skipping duplicates
+static void CollectAggregates(const hsql::Expr *expr,
+                              const std::vector<Cloum> &cols,
+                              std::vector<AggregateSpec> &aggregates) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (IsAggregate(expr)) {
+    auto spec = ParseAggregate(expr, cols);
+    for (auto &agg : aggregates) {
+      if (agg.name_ == spec.name_) {
+        return;
+      }
+    }
+    aggregates.push_back(spec);
+    return;
+  }
+  CollectAggregates(expr->expr, cols, aggregates);
+  CollectAggregates(expr->expr2, cols, aggregates);
+  if (expr->exprList != nullptr) {
+    for (auto e : *expr->exprList) {
+      CollectAggregates(e, cols, aggregates);
+    }
+  }
+}
+
+auto PlanAggregation(Catalog *catalog, const hsql::SelectStatement *select,
+                     std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor> {
+  bool has_aggregate = false;
+  for (auto expr : *select->selectList) {
+    has_aggregate = has_aggregate || IsAggregate(expr);
+  }
+  if (!has_aggregate && select->groupBy == nullptr) {
+    return child;
+  }
+
+  auto cols = child->GetOutputCols();
+  std::vector<int> group_by;
+  if (select->groupBy != nullptr && select->groupBy->columns != nullptr) {
+    for (auto expr : *select->groupBy->columns) {
+      int index = ResolveColumn(expr, cols);
+      if (index == -1) {
+        throw std::runtime_error("cloum " + ExprName(expr) +
+                                 " is not existed.");
+      }
+      group_by.push_back(index);
+    }
+  }
+
+  std::vector<AggregateSpec> aggregates;
+  for (auto expr : *select->selectList) {
+    switch (expr->type) {
+      case hsql::ExprType::kExprFunctionRef:
+        CollectAggregates(expr, cols, aggregates);
+        break;
+      case hsql::ExprType::kExprColumnRef: {
+        int index = ResolveColumn(expr, cols);
+        bool is_grouped = false;
+        for (auto g : group_by) {
+          is_grouped = is_grouped || g == index;
+        }
+        if (!is_grouped) {
+          throw std::runtime_error("cloum " + ExprName(expr) +
+                                   " should appear in the group by clause.");
+        }
+        break;
+      }
+      case hsql::ExprType::kExprLiteralInt:
+        break;
+      default:
+        throw std::runtime_error("unsupported expression with group by.");
+    }
+  }
+  const hsql::Expr *having =
+      select->groupBy == nullptr ? nullptr : select->groupBy->having;
+  CollectAggregates(having, cols, aggregates);
+
+  std::unique_ptr<AbstractExecutor> ret = std::make_unique<AggregationExecutor>(
+      catalog, std::move(child), group_by, aggregates);
+  if (having != nullptr) {
+    ret = std::make_unique<FilterExecutor>(catalog, std::move(ret), having);
+  }
+  return ret;
+}
+
+// The limit and offset of the limit clause, the limit is the max of size_t
+// without one.
+static void ReadLimit(const hsql::SelectStatement *select, size_t *limit,
+                      size_t *offset) {
+  *limit = std::numeric_limits<size_t>::max();
+  *offset = 0;
+  auto limit_desc = select->limit;
+  if (limit_desc == nullptr) {
+    return;
+  }
+  if (limit_desc->limit != nullptr &&
+      limit_desc->limit->type == hsql::ExprType::kExprLiteralInt) {
+    *limit = std::max<int64_t>(limit_desc->limit->ival, 0);
+  }
+  if (limit_desc->offset != nullptr &&
+      limit_desc->offset->type == hsql::ExprType::kExprLiteralInt) {
+    *offset = std::max<int64_t>(limit_desc->offset->ival, 0);
+  }
+}
+
+auto PlanSort(Catalog *catalog, const hsql::SelectStatement *select,
+              std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor> {
+  if (select->order == nullptr || select->order->empty()) {
+    return child;
+  }
+  auto cols = child->GetOutputCols();
+  std::vector<SortKey> keys;
+  for (auto order : *select->order) {
+    int index = ResolveColumn(order->expr, cols);
+    if (index == -1) {
+      throw std::runtime_error("cloum " + ExprName(order->expr) +
+                               " is not existed.");
+    }
+    keys.push_back({index, order->type == hsql::OrderType::kOrderDesc});
+  }
+
+  size_t limit;
+  size_t offset;
+  ReadLimit(select, &limit, &offset);
+  if (limit != std::numeric_limits<size_t>::max()) {
+    limit += offset;
+  }
+  return std::make_unique<SortExecutor>(catalog, std::move(child), keys,
+                                        limit);
+}
+
+auto PlanLimit(Catalog *catalog, const hsql::SelectStatement *select,
+               std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor> {
+  size_t limit;
+  size_t offset;
+  ReadLimit(select, &limit, &offset);
+  if (limit == std::numeric_limits<size_t>::max() && offset == 0) {
+    return child;
+  }
+  return std::make_unique<LimitExecutor>(catalog, std::move(child), limit,
+                                         offset);
+}
+}  // namespace spdb
@@ -1,15 +1,9 @@
 #include "executor/projection_executor.h"
 
-namespace spdb {
-int GetIndexByName(std::string name, std::vector<Cloum> cols) {
-  for (size_t i = 0; i < cols.size(); ++i) {
-    if (name == cols[i].cloum_name_) {
-      return i;
-    }
-  }
-  return -1;
-}
+#include "executor/expression.h"
+#include "executor/planner.h"
 
+namespace spdb {
 ProjectionExecutor::ProjectionExecutor(Catalog *catalog,
                                        const hsql::SQLStatement *state)
     : AbstractExecutor(catalog) {
@@ -17,28 +11,29 @@ ProjectionExecutor::ProjectionExecutor(Catalog *catalog,
     throw std::runtime_error(
         "ProjectionExecutor should construct with a select statement.");
   }
-  child_executor_ = std::make_unique<SeqScanExecutor>(catalog, state);
-
   auto select = static_cast<const hsql::SelectStatement *>(state);
-  table_info_ = catalog->GetTable(select->fromTable->getName());
+  child_executor_ = PlanLimit(
+      catalog, select,
+      PlanSort(catalog, select,
+               PlanAggregation(catalog, select, PlanFrom(catalog, select))));
+  child_cols_ = child_executor_->GetOutputCols();
 
   tuple_size_ = 0;
   for (auto &c : *select->selectList) {
     switch (c->type) {
       case hsql::ExprType::kExprStar: {
-        for (auto col : table_info_.value_type_) {
+        for (auto col : child_cols_) {
           tuple_cloums_.push_back(col);
           tuple_size_ += col.GetSize();
         }
         break;
       }
-      case hsql::ExprType::kExprColumnRef: {
-        for (auto col : table_info_.value_type_) {
-          if (col.cloum_name_ == c->getName()) {
-            tuple_cloums_.push_back(col);
-            tuple_size_ += col.GetSize();
-            break;
-          }
+      case hsql::ExprType::kExprColumnRef:
+      case hsql::ExprType::kExprFunctionRef: {
+        int index = ResolveColumn(c, child_cols_);
+        if (index != -1) {
+          tuple_cloums_.push_back(child_cols_[index]);
+          tuple_size_ += child_cols_[index].GetSize();
         }
         break;
       }
@@ -65,8 +60,8 @@ auto ProjectionExecutor::GetOutputCols() -> std::vector<Cloum> {
 ProjectionExecutor::~ProjectionExecutor() {}
 
 auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  auto child_output = child_executor_->GetOutputCols();
-  Tuple tuple_from_table{table_info_.value_type_};
+  auto &child_output = child_cols_;
+  Tuple tuple_from_table{child_cols_};
   RID rid_from_table{};
   if (child_executor_->Next(&tuple_from_table, &rid_from_table)) {
     std::deque<int> unname_var(unname_var_);
@@ -89,12 +84,12 @@ auto ProjectionExecutor::Next(Tuple *tuple, RID *rid) -> bool {
         int index = GetIndexByName(col.cloum_name_, child_output);
         switch (col.GetType()) {
           case CloumType::INT:
-            memcpy(src + offset, tuple_from_table.GetValueAt(index),
+            memcpy(src + offset, tuple_from_table.GetValuePtrAt(index),
                    sizeof(int));
             offset += sizeof(int);
             break;
           case CloumType::CHAR:
-            memcpy(src + offset, tuple_from_table.GetValueAt(index),
+            memcpy(src + offset, tuple_from_table.GetValuePtrAt(index),
                    child_output[index].GetSize());
             offset += child_output[index].GetSize();
             break;
@@ -1,45 +1,143 @@
 #include "executor/seq_scan_executor.h"
 
+#include "executor/expression.h"
+
 namespace spdb {
-SeqScanExecutor::SeqScanExecutor(Catalog *catalog,
-                                 const hsql::SQLStatement *state)
-    : AbstractExecutor(catalog) {
+static auto AsSelect(const hsql::SQLStatement *state)
+    -> const hsql::SelectStatement * {
   if (!state->isType(hsql::StatementType::kStmtSelect)) {
     throw std::runtime_error(
         "SeqScanExecutor should construct with a selectstatement.");
   }
-  auto select = static_cast<const hsql::SelectStatement *>(state);
-  if (!catalog->IsExisted(select->fromTable->getName())) {
+  return static_cast<const hsql::SelectStatement *>(state);
+}
+
+SeqScanExecutor::SeqScanExecutor(Catalog *catalog,
+                                 const hsql::SQLStatement *state)
+    : SeqScanExecutor(catalog, AsSelect(state)->fromTable->name,
+                      AsSelect(state)->whereClause) {}
+
+SeqScanExecutor::SeqScanExecutor(Catalog *catalog,
+                                 const std::string &table_name,
+                                 const hsql::Expr *predicate)
+    : AbstractExecutor(catalog),
+      snapshot_(catalog->GetTransactionManager()) {
+  if (!catalog->IsExisted(table_name)) {
     throw std::runtime_error("table is not existed.");
   }
-  table_info_ = catalog->GetTable(select->fromTable->getName());
-  disk_ = new DiskManager(table_info_.disk_name_);
-  bpm_ = new BufferPoolManager(BUFFER_POOL_SIZE, disk_);
-  BPlusTree table(bpm_, table_info_.key_type_, table_info_.value_type_,
+  table_info_ = catalog->GetTable(table_name);
+  predicate_ = predicate;
+  BPlusTree table(catalog->GetBufferPoolManager(table_info_.disk_name_),
+                  table_info_.key_type_, table_info_.value_type_,
                   table_info_.leaf_max_size_, table_info_.internal_max_size_,
                   table_info_.root_id_);
   table_iterator_ = table.Begin();
+  last_key_ = std::make_unique<Tuple>(table_info_.key_type_);
+  displaced_key_ = std::make_unique<Tuple>(table_info_.key_type_);
 }
 
-SeqScanExecutor::~SeqScanExecutor() {
-  delete disk_;
-  delete bpm_;
+SeqScanExecutor::SeqScanExecutor(Catalog *catalog,
+                                 const std::string &table_name,
+                                 const hsql::Expr *predicate,
+                                 const StatementSnapshot *outer,
+                                 const Tuple *low, const Tuple *high)
+    : AbstractExecutor(catalog), snapshot_(outer) {
+  if (!catalog->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  table_info_ = catalog->GetTable(table_name);
+  predicate_ = predicate;
+  BPlusTree table(catalog->GetBufferPoolManager(table_info_.disk_name_),
+                  table_info_.key_type_, table_info_.value_type_,
+                  table_info_.leaf_max_size_, table_info_.internal_max_size_,
+                  table_info_.root_id_);
+  table_iterator_ = low == nullptr ? table.Begin() : table.Begin(*low);
+  if (low != nullptr) {
+    low_ = std::make_unique<Tuple>(*low);
+  }
+  if (high != nullptr) {
+    high_ = std::make_unique<Tuple>(*high);
+  }
+  last_key_ = std::make_unique<Tuple>(table_info_.key_type_);
+  displaced_key_ = std::make_unique<Tuple>(table_info_.key_type_);
 }
 
+SeqScanExecutor::~SeqScanExecutor() {}
+
 auto SeqScanExecutor::GetOutputCols() -> std::vector<Cloum> {
   return table_info_.value_type_;
 }
 
-auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (table_iterator_.IsEnd()) {
-    return false;
+auto SeqScanExecutor::Skip(size_t n) -> size_t {
+  size_t skipped = 0;
+  while (predicate_ == nullptr && high_ == nullptr && skipped < n) {
+    // displaced_key_ is free until the next row is read
+    size_t rest = table_iterator_.CountLeafRest(displaced_key_.get());
+    // checked once the leaf is counted, a write after that is invisible
+    if (rest == 0 || rest > n - skipped || !snapshot_.SeesNewest()) {
+      break;
+    }
+    table_iterator_.SkipPast(*displaced_key_);
+    *last_key_ = *displaced_key_;
+    has_last_key_ = true;
+    skipped += rest;
   }
-  auto [key, value] = *table_iterator_;
+  return skipped + AbstractExecutor::Skip(n - skipped);
+}
 
-  *tuple = value;
-  *rid = tuple->GetRid();
-  ++table_iterator_;
+auto SeqScanExecutor::ReadCloum(size_t index, std::vector<char> *values)
+    -> size_t {
+  if (predicate_ != nullptr || high_ != nullptr) {
+    return 0;
+  }
+  size_t rest =
+      table_iterator_.ReadLeafCloum(index, values, displaced_key_.get());
+  if (rest == 0 || !snapshot_.SeesNewest()) {
+    return 0;
+  }
+  table_iterator_.SkipPast(*displaced_key_);
+  *last_key_ = *displaced_key_;
+  has_last_key_ = true;
+  return rest;
+}
+
+auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  while (true) {
+    // the tree is read up to the end of the range
+    bool is_tree_end =
+        table_iterator_.IsEnd() ||
+        (high_ != nullptr && !((*table_iterator_).first < *high_));
+    // a row deleted since the snapshot comes before the next one of the tree
+    const Tuple *next_key =
+        is_tree_end ? high_.get() : &(*table_iterator_).first;
+    if (snapshot_.NextDisplacedRow(
+            table_info_.disk_name_,
+            has_last_key_ ? last_key_.get() : low_.get(), !has_last_key_,
+            next_key, displaced_key_.get(), tuple)) {
+      *last_key_ = *displaced_key_;
+      has_last_key_ = true;
+      if (!EvaluatePredicate(predicate_, *tuple, table_info_.value_type_)) {
+        continue;
+      }
+      *rid = RID{};
+      return true;
+    }
+    if (is_tree_end) {
+      return false;
+    }
+
+    auto [key, value] = *table_iterator_;
+    ++table_iterator_;
+    *last_key_ = key;
+    has_last_key_ = true;
+    if (!snapshot_.ReadRow(table_info_.disk_name_, key, &value) ||
+        !EvaluatePredicate(predicate_, value, table_info_.value_type_)) {
+      continue;
+    }
 
-  return true;
+    *tuple = value;
+    *rid = value.GetRid();
+    return true;
+  }
 }
 }  // namespace spdb
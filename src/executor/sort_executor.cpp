@@ -0,0 +1,233 @@
+#include "executor/sort_executor.h"
+
+#include <algorithm>
+
+#include "executor/expression.h"
+
+namespace spdb {
+LoserTree::LoserTree(size_t k, std::function<bool(size_t, size_t)> less)
+    : k_(k), less_(std::move(less)), is_exhausted_(k, false) {
+  // k is a virtual source beating everyone, it is pushed out of the tree
+  // while the real sources are added
+  tree_.assign(k_, k_);
+  for (size_t i = k_; i > 0; --i) {
+    Adjust(i - 1);
+  }
+}
+
+auto LoserTree::Beats(size_t a, size_t b) const -> bool {
+  if (a == k_ || b == k_) {
+    return a == k_;
+  }
+  if (is_exhausted_[a] || is_exhausted_[b]) {
+    return !is_exhausted_[a];
+  }
+  return less_(a, b);
+}
+
+void LoserTree::Adjust(size_t source) {
+  size_t winner = source;
+  for (size_t node = (source + k_) / 2; node > 0; node /= 2) {
+    if (Beats(tree_[node], winner)) {
+      std::swap(tree_[node], winner);
+    }
+  }
+  tree_[0] = winner;
+}
+
+auto LoserTree::Winner() const -> int {
+  if (k_ == 0 || is_exhausted_[tree_[0]]) {
+    return -1;
+  }
+  return tree_[0];
+}
+
+void LoserTree::Replay(bool is_exhausted) {
+  size_t winner = tree_[0];
+  is_exhausted_[winner] = is_exhausted;
+  Adjust(winner);
+}
+
+SortExecutor::SortExecutor(Catalog *catalog,
+                           std::unique_ptr<AbstractExecutor> child,
+                           std::vector<SortKey> keys, size_t limit,
+                           size_t memory_budget)
+    : AbstractExecutor(catalog),
+      child_executor_(std::move(child)),
+      keys_(std::move(keys)),
+      limit_(limit),
+      memory_budget_(memory_budget) {
+  cols_ = child_executor_->GetOutputCols();
+  for (auto &col : cols_) {
+    offsets_.push_back(tuple_size_);
+    tuple_size_ += col.GetSize();
+  }
+  if (keys_.empty()) {
+    throw std::runtime_error("SortExecutor: no sort key.");
+  }
+}
+
+auto SortExecutor::GetOutputCols() -> std::vector<Cloum> { return cols_; }
+
+auto SortExecutor::Prefix(const char *tuple) const -> uint64_t {
+  auto &key = keys_[0];
+  auto &col = cols_[key.col_];
+  const char *src = tuple + offsets_[key.col_];
+  uint64_t prefix = 0;
+  switch (col.GetType()) {
+    case CloumType::INT: {
+      int v = 0;
+      memcpy(&v, src, sizeof(int));
+      prefix = static_cast<uint64_t>(static_cast<uint32_t>(v) ^ 0x80000000U)
+               << 32;
+      break;
+    }
+    case CloumType::CHAR: {
+      size_t len = strnlen(src, col.GetSize());
+      for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        uint8_t c = i < len ? static_cast<uint8_t>(src[i]) : 0;
+        prefix = (prefix << 8) | c;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return key.is_desc_ ? ~prefix : prefix;
+}
+
+auto SortExecutor::CompareTuples(const char *a, const char *b) const -> int {
+  for (auto &key : keys_) {
+    size_t offset = offsets_[key.col_];
+    int cmp = CompareValue(a + offset, b + offset, cols_[key.col_]);
+    if (cmp != 0) {
+      return key.is_desc_ ? -cmp : cmp;
+    }
+  }
+  return 0;
+}
+
+auto SortExecutor::EntryLess(const std::pair<uint64_t, size_t> &a,
+                             const std::pair<uint64_t, size_t> &b) const
+    -> bool {
+  if (a.first != b.first) {
+    return a.first < b.first;
+  }
+  return CompareTuples(tuples_.data() + a.second * tuple_size_,
+                       tuples_.data() + b.second * tuple_size_) < 0;
+}
+
+void SortExecutor::SpillRun() {
+  std::sort(entries_.begin(), entries_.end(),
+            [this](auto &a, auto &b) { return EntryLess(a, b); });
+  auto run = std::make_unique<TempFile>(cols_);
+  Tuple tuple{cols_};
+  for (auto &entry : entries_) {
+    tuple.SetValues(tuples_.data() + entry.second * tuple_size_);
+    run->Append(tuple);
+  }
+  runs_.push_back(std::move(run));
+  tuples_.clear();
+  entries_.clear();
+}
+
+void SortExecutor::SortTopN() {
+  auto less = [this](auto &a, auto &b) { return EntryLess(a, b); };
+  tuples_.reserve(limit_ * tuple_size_);
+  Tuple tuple{cols_};
+  RID rid{};
+  while (limit_ > 0 && child_executor_->Next(&tuple, &rid)) {
+    auto data = tuple.GetData();
+    auto prefix = Prefix(data);
+    if (entries_.size() < limit_) {
+      entries_.emplace_back(prefix, entries_.size());
+      tuples_.insert(tuples_.end(), data, data + tuple_size_);
+      std::push_heap(entries_.begin(), entries_.end(), less);
+      continue;
+    }
+    // the top of the heap is the largest tuple kept so far
+    auto &top = entries_.front();
+    if (prefix > top.first ||
+        (prefix == top.first &&
+         CompareTuples(data, tuples_.data() + top.second * tuple_size_) >=
+             0)) {
+      continue;
+    }
+    std::pop_heap(entries_.begin(), entries_.end(), less);
+    auto &entry = entries_.back();
+    memcpy(tuples_.data() + entry.second * tuple_size_, data, tuple_size_);
+    entry.first = prefix;
+    std::push_heap(entries_.begin(), entries_.end(), less);
+  }
+  std::sort_heap(entries_.begin(), entries_.end(), less);
+}
+
+void SortExecutor::Sort() {
+  if (limit_ != std::numeric_limits<size_t>::max() &&
+      limit_ * (tuple_size_ + sizeof(entries_[0])) <= memory_budget_) {
+    SortTopN();
+    return;
+  }
+
+  Tuple tuple{cols_};
+  RID rid{};
+  while (child_executor_->Next(&tuple, &rid)) {
+    size_t used = tuples_.size() + entries_.size() * sizeof(entries_[0]);
+    if (!entries_.empty() &&
+        used + tuple_size_ + sizeof(entries_[0]) > memory_budget_) {
+      SpillRun();
+    }
+    auto data = tuple.GetData();
+    entries_.emplace_back(Prefix(data), entries_.size());
+    tuples_.insert(tuples_.end(), data, data + tuple_size_);
+  }
+  if (runs_.empty()) {
+    std::sort(entries_.begin(), entries_.end(),
+              [this](auto &a, auto &b) { return EntryLess(a, b); });
+    return;
+  }
+
+  if (!entries_.empty()) {
+    SpillRun();
+  }
+  tuples_.shrink_to_fit();
+  entries_.shrink_to_fit();
+  for (auto &run : runs_) {
+    run->Rewind();
+    heads_.push_back(std::make_unique<Tuple>(cols_));
+    run->Next(heads_.back().get());
+  }
+  // ties go to the earlier run to keep the merge stable
+  loser_tree_ = std::make_unique<LoserTree>(runs_.size(), [this](auto a,
+                                                                 auto b) {
+    int cmp = CompareTuples(heads_[a]->GetData(), heads_[b]->GetData());
+    return cmp < 0 || (cmp == 0 && a < b);
+  });
+}
+
+auto SortExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!is_sorted_) {
+    Sort();
+    is_sorted_ = true;
+  }
+  if (emitted_ >= limit_) {
+    return false;
+  }
+  if (loser_tree_ != nullptr) {
+    int winner = loser_tree_->Winner();
+    if (winner == -1) {
+      return false;
+    }
+    *tuple = *heads_[winner];
+    loser_tree_->Replay(!runs_[winner]->Next(heads_[winner].get()));
+  } else {
+    if (cursor_ >= entries_.size()) {
+      return false;
+    }
+    tuple->SetValues(tuples_.data() + entries_[cursor_++].second * tuple_size_);
+  }
+  ++emitted_;
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
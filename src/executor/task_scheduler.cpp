@@ -0,0 +1,228 @@
+#include "executor/task_scheduler.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <string>
+#include <utility>
+
+namespace spdb {
+// the scheduler and the index of the worker the calling thread is
+static thread_local const TaskScheduler *current_scheduler = nullptr;
+static thread_local int current_worker = -1;
+
+// the cpus of every NUMA node, empty if they can't be read
+static auto ReadNodes() -> std::vector<std::vector<int>> {
+  std::vector<std::vector<int>> nodes;
+  for (int node = 0;; ++node) {
+    std::ifstream file("/sys/devices/system/node/node" +
+                       std::to_string(node) + "/cpulist");
+    if (!file) {
+      break;
+    }
+    // ranges like 0-3,8-11
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(file, range, ',')) {
+      size_t dash = range.find('-');
+      try {
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos
+                       ? first
+                       : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+      } catch (std::exception &) {
+        return {};
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.push_back(std::move(cpus));
+    }
+  }
+  return nodes;
+}
+
+TaskScheduler::TaskScheduler(size_t worker_nums) {
+  if (worker_nums == 0) {
+    worker_nums = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  }
+  auto nodes = ReadNodes();
+  node_nums_ = std::max<size_t>(nodes.size(), 1);
+  for (size_t i = 0; i < worker_nums; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+    workers_.back()->node_ = i % node_nums_;
+  }
+  for (size_t i = 0; i < worker_nums; ++i) {
+    auto &victims = workers_[i]->victims_;
+    for (size_t step = 1; step < worker_nums; ++step) {
+      size_t victim = (i + step) % worker_nums;
+      if (workers_[victim]->node_ == workers_[i]->node_) {
+        victims.push_back(victim);
+      }
+    }
+    for (size_t step = 1; step < worker_nums; ++step) {
+      size_t victim = (i + step) % worker_nums;
+      if (workers_[victim]->node_ != workers_[i]->node_) {
+        victims.push_back(victim);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < worker_nums; ++i) {
+    auto &worker = workers_[i];
+    worker->thread_ = std::thread([this, i] { Work(i); });
+    if (node_nums_ > 1) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      for (int cpu : nodes[worker->node_]) {
+        CPU_SET(cpu, &cpus);
+      }
+      pthread_setaffinity_np(worker->thread_.native_handle(), sizeof(cpus),
+                             &cpus);
+    }
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_latch_);
+    is_stopped_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker->thread_.join();
+  }
+}
+
+auto TaskScheduler::Global() -> TaskScheduler * {
+  static TaskScheduler scheduler(0);
+  return &scheduler;
+}
+
+auto TaskScheduler::GetWorkerIndex() const -> int {
+  return current_scheduler == this ? current_worker : -1;
+}
+
+void TaskScheduler::Submit(Task task) {
+  int index = GetWorkerIndex();
+  size_t target = index != -1 ? index : next_worker_++ % workers_.size();
+  // counted first, so the count never falls below the tasks queued
+  ++queued_;
+  {
+    std::lock_guard<std::mutex> lock(workers_[target]->latch_);
+    workers_[target]->tasks_.push_back(std::move(task));
+  }
+  // the lock orders the wake up after the check of a worker going to sleep
+  { std::lock_guard<std::mutex> lock(sleep_latch_); }
+  sleep_cv_.notify_one();
+}
+
+auto TaskScheduler::Take(size_t index, Task *task) -> bool {
+  {
+    auto &worker = workers_[index];
+    std::lock_guard<std::mutex> lock(worker->latch_);
+    if (!worker->tasks_.empty()) {
+      *task = std::move(worker->tasks_.back());
+      worker->tasks_.pop_back();
+      --queued_;
+      return true;
+    }
+  }
+  for (auto victim : workers_[index]->victims_) {
+    auto &worker = workers_[victim];
+    std::lock_guard<std::mutex> lock(worker->latch_);
+    if (!worker->tasks_.empty()) {
+      *task = std::move(worker->tasks_.front());
+      worker->tasks_.pop_front();
+      --queued_;
+      ++steals_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::Run(Task *task) {
+  std::exception_ptr error;
+  try {
+    task->function_();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  task->group_->Finish(error);
+}
+
+void TaskScheduler::Work(size_t index) {
+  current_scheduler = this;
+  current_worker = index;
+  Task task;
+  while (true) {
+    if (Take(index, &task)) {
+      Run(&task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_latch_);
+    sleep_cv_.wait(lock, [&] { return is_stopped_ || queued_ > 0; });
+    if (is_stopped_ && queued_ == 0) {
+      return;
+    }
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  try {
+    Wait();
+  } catch (...) {
+  }
+}
+
+void TaskGroup::Run(std::function<void()> function) {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    ++pending_;
+  }
+  scheduler_->Submit({std::move(function), this});
+}
+
+void TaskGroup::Wait() {
+  int index = scheduler_->GetWorkerIndex();
+  std::unique_lock<std::mutex> lock(latch_);
+  while (pending_ > 0) {
+    if (index == -1) {
+      cv_.wait(lock, [&] { return pending_ == 0; });
+      break;
+    }
+    // a worker doesn't sit idle, the tasks it runs may be of any group
+    lock.unlock();
+    TaskScheduler::Task task;
+    if (scheduler_->Take(index, &task)) {
+      scheduler_->Run(&task);
+      lock.lock();
+      continue;
+    }
+    lock.lock();
+    cv_.wait_for(lock, std::chrono::milliseconds(1),
+                 [&] { return pending_ == 0; });
+  }
+  if (error_ != nullptr) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void TaskGroup::Finish(std::exception_ptr error) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (error != nullptr && error_ == nullptr) {
+    error_ = error;
+  }
+  if (--pending_ == 0) {
+    cv_.notify_all();
+  }
+}
+}  // namespace spdb
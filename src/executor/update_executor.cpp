@@ -0,0 +1,76 @@
+#include "executor/update_executor.h"
+
+#include "executor/expression.h"
+
+namespace spdb {
+UpdateExecutor::UpdateExecutor(
+    Catalog *catalog, const std::string &table_name,
+    std::unique_ptr<AbstractExecutor> child,
+    const std::vector<hsql::UpdateClause *> &updates)
+    : AbstractExecutor(catalog),
+      txn_manager_(catalog->GetTransactionManager()),
+      child_executor_(std::move(child)) {
+  if (!catalog->IsExisted(table_name)) {
+    throw std::runtime_error("table is not existed.");
+  }
+  if (txn_manager_ == nullptr || TransactionManager::Current() == nullptr) {
+    throw std::runtime_error("UpdateExecutor should run in a transaction.");
+  }
+  table_info_ = catalog->GetTable(table_name);
+  auto &value_type = table_info_.value_type_;
+  for (auto update : updates) {
+    int col = GetIndexByName(update->column, value_type);
+    if (col == -1) {
+      throw std::runtime_error("cloum " + std::string(update->column) +
+                               " is not existed.");
+    }
+    if (!IsLiteralOf(update->value, value_type[col])) {
+      throw std::runtime_error("only support literals of the cloum type in "
+                               "set clause now.");
+    }
+    size_t offset = 0;
+    for (int i = 0; i < col; ++i) {
+      offset += value_type[i].GetSize();
+    }
+    cols_.push_back(col);
+    offsets_.push_back(offset);
+    values_.push_back(update->value);
+  }
+}
+
+auto UpdateExecutor::GetOutputCols() -> std::vector<Cloum> {
+  CloumAtr int_atr{CloumType::INT, sizeof(int)};
+  return {Cloum{"updated", int_atr}};
+}
+
+auto UpdateExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (is_done_) {
+    return false;
+  }
+  is_done_ = true;
+  auto cols = child_executor_->GetOutputCols();
+  size_t row_size = 0;
+  for (auto &col : cols) {
+    row_size += col.GetSize();
+  }
+  Tuple row{cols};
+  RID row_rid{};
+  std::vector<std::pair<Tuple, Tuple>> rows;
+  std::string data;
+  while (child_executor_->Next(&row, &row_rid)) {
+    data.assign(row.GetData(), row_size);
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      WriteLiteral(&data[offsets_[i]], table_info_.value_type_[cols_[i]],
+                   values_[i]);
+    }
+    Tuple new_row{cols};
+    new_row.SetValues(data.data());
+    rows.emplace_back(row, new_row);
+  }
+  int count = static_cast<int>(txn_manager_->UpdateRows(
+      TransactionManager::Current(), table_info_.disk_name_, rows));
+  tuple->SetValues(reinterpret_cast<char *>(&count));
+  *rid = RID{};
+  return true;
+}
+}  // namespace spdb
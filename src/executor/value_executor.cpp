@@ -14,6 +14,11 @@ ValueExecutor::ValueExecutor(Catalog *catalog, const hsql::SQLStatement *state)
   }
 
   table_info_ = catalog->GetTable(insert->tableName);
+  AddRow(state);
+}
+
+void ValueExecutor::AddRow(const hsql::SQLStatement *state) {
+  auto insert = static_cast<const hsql::InsertStatement *>(state);
   size_t value_size{0};
   for (auto &c : table_info_.value_type_) {
     value_size += c.GetSize();
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/lru_k_replacer.h"
+#include "config/config.h"
+#include "disk/disk_manager.h"
+#include "disk/page.h"
+#include "recovery/log_manager.h"
+
+namespace spdb {
+
+/**
+ * BufferPool caches the pages of many files in one set of frames. A page is
+ * identified by (file id, page id), files get their id when registered.
+ *
+ * It is meant to live as long as the process, so pages stay cached across
+ * statements. Each file is accessed through a BufferPoolManager, which also
+ * hands out the page ids of the file.
+ *
+ * The pages of a file registered with checksums are written back with a
+ * CRC32C checksum at PAGE_CHECKSUM_OFFSET, which is checked when the page is
+ * read again, so a torn write or a damaged page fails the fetch instead of
+ * being followed. Such pages are marked with PAGE_CHECKSUM_FLAG, the pages
+ * written before the checksums were kept are read unchecked until they are
+ * written back. The layout of such a file should leave those bytes to the
+ * pool, as the B+ tree pages do; the pages of other files are written as
+ * they are.
+ *
+ * With a log manager the pool follows the write-ahead rule: a dirty page is
+ * only written back after the log is flushed up to the LSN of the page. Every
+ * cached page also keeps the first record which dirtied it, the dirty page
+ * table of a checkpoint.
+ */
+class BufferPool {
+ public:
+  /**
+   * @param pool_size the number of frames
+   * @param replacer_k the LookBack constant k for the LRU-K replacer
+   */
+  explicit BufferPool(size_t pool_size, size_t replacer_k = LRUK_REPLACER_K);
+
+  ~BufferPool();
+
+  auto GetPoolSize() -> size_t { return pool_size_; }
+
+  auto GetPages() -> Page * { return pages_; }
+
+  /**
+   * Log the modifications of the pages with log_manager, nullptr disables
+   * logging. Should be set before any page is fetched.
+   */
+  void SetLogManager(LogManager *log_manager) { log_manager_ = log_manager; }
+
+  auto GetLogManager() -> LogManager * { return log_manager_; }
+
+  /**
+   * @param has_checksum true to checksum the pages of the file
+   * @return the id the pages of the file are cached under
+   */
+  auto RegisterFile(DiskManager *disk_manager, bool has_checksum = false)
+      -> file_id_t;
+
+  /** Drop all the pages of a file, dirty pages are not written back. */
+  void UnregisterFile(file_id_t file_id);
+
+  /**
+   * Put a new, zeroed page in a frame and write it to disk.
+   * @return nullptr if all frames are pinned
+   */
+  auto NewPage(file_id_t file_id, page_id_t page_id) -> Page *;
+
+  /**
+   * A page missing from the pool is read and checked without the latch of
+   * the pool, other fetches of the page wait for it meanwhile.
+   * @return nullptr if the page isn't cached and all frames are pinned
+   * @throws std::runtime_error if the page read from the disk is damaged
+   */
+  auto FetchPage(file_id_t file_id, page_id_t page_id) -> Page *;
+
+  auto UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty) -> bool;
+
+  /**
+   * Write back a page, with its read latch held while it is copied and
+   * written, so the copy carries no change newer than the log flushed for
+   * it. The latch of the pool is released meanwhile.
+   * @param is_latched true if the caller holds the write latch of the page
+   */
+  auto FlushPage(file_id_t file_id, page_id_t page_id, bool is_latched = false)
+      -> bool;
+
+  /** Write back the pages of a file, as FlushPage. */
+  void FlushFile(file_id_t file_id);
+
+  void FlushAllPages();
+
+  /**
+   * Write back the pages dirtied by a record before lsn, for a checkpoint.
+   * The latch of the pool is only held to pick each page, so fetching and
+   * unpinning go on meanwhile, and a page latched by a writer is skipped.
+   * @return the number of pages written back
+   */
+  auto FlushOldPages(lsn_t lsn) -> size_t;
+
+  /**
+   * The dirty page table: the dirty pages and the first record dirtying each
+   * of them. The frames are visited a chunk at a time.
+   */
+  auto GetDirtyPages() -> std::vector<DirtyPage>;
+
+  /** Force the pages written back so far to the disk, in every file. */
+  void SyncFiles();
+
+  /**
+   * Drop a page from the pool.
+   * @return false if the page is pinned
+   */
+  auto DeletePage(file_id_t file_id, page_id_t page_id) -> bool;
+
+  /** The number of fetches served from memory and from disk. */
+  auto GetHitCount() const -> size_t { return hit_count_; }
+  auto GetMissCount() const -> size_t { return miss_count_; }
+
+ private:
+  /** How the latch of a page is taken to write it back. */
+  enum class LatchMode {
+    // the caller latches the page already
+    HELD,
+    WAIT,
+    // give up if a writer latches the page
+    TRY
+  };
+
+  static auto MakeKey(file_id_t file_id, page_id_t page_id) -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(file_id)) << 32) |
+           static_cast<uint32_t>(page_id);
+  }
+
+  /**
+   * Take a frame from the free list, or evict one and write its page back if
+   * it is dirty. Caller should acquire the latch with lock, which is
+   * released while a page is written back.
+   * @return false if all frames are pinned
+   */
+  auto GetFreeFrame(frame_id_t *frame_id, std::unique_lock<std::mutex> *lock)
+      -> bool;
+
+  // Write a page to its file, with its checksum if the file has them, which
+  // is set on a copy, so the readers of the frame go on meanwhile.
+  static void WritePage(DiskManager *disk_manager, Page *page,
+                        bool has_checksum);
+
+  // Find a cached page, waiting while it is read from the disk, caller
+  // should acquire the latch with lock.
+  auto FindPage(uint64_t key, std::unique_lock<std::mutex> *lock)
+      -> std::unordered_map<uint64_t, frame_id_t>::iterator;
+
+  // Write the page in a frame pinned by the caller to its file, the log goes
+  // first. The latch of the pool, held by lock, is released while the page
+  // is written under its read latch, and held again on return.
+  // @return false if mode is TRY and a writer latches the page
+  auto WriteBack(frame_id_t frame_id, std::unique_lock<std::mutex> *lock,
+                 LatchMode mode) -> bool;
+
+  // Pin the page in a frame, or unpin it, caller should acquire the latch.
+  void Pin(frame_id_t frame_id);
+  void Unpin(frame_id_t frame_id);
+
+  // Pin the next page from frame *frame_id on dirtied before lsn, caller
+  // should acquire the latch.
+  auto PinOldPage(lsn_t lsn, frame_id_t *frame_id) -> bool;
+
+  // Drop the page in a frame, caller should acquire the latch.
+  void ResetFrame(frame_id_t frame_id);
+
+  const size_t pool_size_;
+  Page *pages_;
+  std::unique_ptr<LRUKReplacer> replacer_;
+  std::list<frame_id_t> free_list_;
+  /** (file id, page id) to the frame holding the page */
+  std::unordered_map<uint64_t, frame_id_t> page_table_;
+  std::unordered_map<file_id_t, DiskManager *> files_;
+  std::unordered_set<file_id_t> checksum_files_;
+  /**
+   * The frames whose page is being read by a fetch, the page is in the page
+   * table but its id is only set in the frame once it is read.
+   */
+  std::unordered_set<frame_id_t> loading_frames_;
+  std::condition_variable loaded_cv_;
+  file_id_t next_file_id_{0};
+  LogManager *log_manager_{nullptr};
+  std::atomic<size_t> hit_count_{0};
+  std::atomic<size_t> miss_count_{0};
+  /** Protects all the members above. */
+  std::mutex latch_;
+  /**
+   * Keeps the files open while their pages are written back or synced
+   * without holding latch_, acquired before it.
+   */
+  std::shared_mutex files_latch_;
+};
+}  // namespace spdb
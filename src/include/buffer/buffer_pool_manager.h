@@ -1,22 +1,29 @@
 #pragma once
 
 #include <atomic>
-#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_pool.h"
 #include "buffer/lru_k_replacer.h"
 #include "config/config.h"
 #include "disk/disk_manager.h"
+#include "disk/free_page_map.h"
 #include "disk/page.h"
 #include "disk/page_guard.h"
 
 namespace spdb {
 
 /**
- * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ * BufferPoolManager reads the pages of one file to and from a buffer pool.
+ * The pool is either shared with the managers of other files or owned by this
+ * manager alone. Page ids are handed out by the manager: the lowest free
+ * page of the file first, then the pages after its end. The free pages are
+ * kept in a FreePageMap across restarts.
  */
 class BufferPoolManager {
  public:
@@ -27,20 +34,49 @@ class BufferPoolManager {
    * @param replacer_k the LookBack constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable
    * logging). Please ignore this for P1.
+   * @param has_checksum true to checksum the pages, see BufferPool
    */
   explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                             size_t replacer_k = LRUK_REPLACER_K);
+                             size_t replacer_k = LRUK_REPLACER_K,
+                             bool has_checksum = false);
 
   /**
-   * @brief Destroy an existing BufferPoolManager.
+   * @brief Creates a BufferPoolManager caching the file in a shared pool.
+   * @param buffer_pool the pool, which should outlive this manager
+   * @param disk_manager the disk manager
+   * @param has_checksum true to checksum the pages, see BufferPool
+   */
+  BufferPoolManager(BufferPool *buffer_pool, DiskManager *disk_manager,
+                    bool has_checksum = false);
+
+  /**
+   * @brief Destroy an existing BufferPoolManager, the cached pages of the file
+   * are dropped without being written back. The free pages are saved.
    */
   ~BufferPoolManager();
 
   /** @brief Return the size (number of frames) of the buffer pool. */
-  auto GetPoolSize() -> size_t { return pool_size_; }
+  auto GetPoolSize() -> size_t { return pool_->GetPoolSize(); }
 
   /** @brief Return the pointer to all the pages in the buffer pool. */
-  auto GetPages() -> Page * { return pages_; }
+  auto GetPages() -> Page * { return pool_->GetPages(); }
+
+  auto GetBufferPool() -> BufferPool * { return pool_; }
+
+  /** @return true if the modifications of the pages are logged */
+  auto IsLogging() -> bool { return pool_->GetLogManager() != nullptr; }
+
+  /**
+   * @brief Log the modification of a page, called by the guard which
+   * modified the page before releasing it. The page LSN is set to the lsn of
+   * the record, the page is written back later by the buffer pool.
+   *
+   * @param page the modified page, still latched by the guard
+   * @param before_image the page before the modification
+   * @return false if the modifications aren't logged, then the page should
+   * be flushed right away
+   */
+  auto LogPageUpdate(Page *page, const char *before_image) -> bool;
 
   /**
    * TODO(P1): Add implementation
@@ -152,10 +188,12 @@ class BufferPoolManager {
    * of the dirty flag. Unset the dirty flag of the page after flushing.
    *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @param is_latched true if the caller holds the write latch of the page,
+   * otherwise its read latch is taken while it is written
    * @return false if the page could not be found in the page table, true
    * otherwise
    */
-  auto FlushPage(page_id_t page_id) -> bool;
+  auto FlushPage(page_id_t page_id, bool is_latched = false) -> bool;
 
   /**
    * TODO(P1): Add implementation
@@ -182,24 +220,44 @@ class BufferPoolManager {
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Free every page but the ones in use, and cut the free pages at
+   * the end off the file. Nobody else should use the file meanwhile.
+   *
+   * @param used_pages the pages still in use
+   * @return the number of pages cut off
+   */
+  auto Vacuum(const std::vector<page_id_t> &used_pages) -> size_t;
+
+  /**
+   * @brief Make sure a page is in the file, the recovery redoes the records
+   * of pages which a vacuum may have cut off.
+   */
+  void ExtendTo(page_id_t page_id);
+
+  /** @return the number of pages in the file */
+  auto GetPageCount() -> page_id_t { return next_page_id_; }
+
+  auto GetFreePageCount() -> size_t;
+
  private:
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** The pool owned by this manager, if it isn't shared. */
+  std::unique_ptr<BufferPool> own_pool_;
+  BufferPool *pool_;
+  /** The id of the file in the pool. */
+  file_id_t file_id_;
   /** The next page id to be allocated  */
   std::atomic<page_id_t> next_page_id_ = 0;
-  std::deque<page_id_t> page_id_bin_;
-  /** Array of buffer pool pages. */
-  Page *pages_;
+  /** The free pages in the file, the lowest one is reused first so the file
+   * may shrink at its end. */
+  std::set<page_id_t> free_pages_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_;
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUKReplacer> replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this
-   * comment to describe what it protects. */
+  FreePageMap free_page_map_;
+  /** The page count the free page map was loaded or saved with. */
+  page_id_t saved_page_count_{0};
+  bool is_free_pages_changed_{false};
+  /** This latch protects the page id allocation. */
   std::mutex latch_;
 
   /**
@@ -216,6 +274,9 @@ class BufferPoolManager {
    */
   void DeallocatePage(page_id_t page_id);
 
+  // Called before the free pages change, the saved map goes stale.
+  void ChangeFreePages();
+
   // TODO(student): You may add additional private members and helper functions
 };
 }  // namespace spdb
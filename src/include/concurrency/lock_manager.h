@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "concurrency/transaction.h"
+#include "config/config.h"
+
+namespace spdb {
+
+/**
+ * LockManager locks rows for transactions, in shared or exclusive mode. A
+ * row is named by its row key, the table name and the key of the row (see
+ * TransactionManager::RowKey). Locks are held until the transaction
+ * finishes and are granted first come first served, a shared lock is
+ * upgraded ahead of the waiting requests.
+ *
+ * The lock table is partitioned by row key, each partition behind its own
+ * latch, so locking different rows rarely contends.
+ *
+ * Transactions wait for their locks without a timeout. A background thread
+ * searches the waits-for graph for cycles every interval and breaks each of
+ * them by aborting its youngest transaction, whose lock call throws.
+ */
+class LockManager {
+ public:
+  explicit LockManager(size_t interval_ms = DEADLOCK_DETECTION_INTERVAL_MS);
+
+  ~LockManager();
+
+  /** Start detecting deadlocks in the background. */
+  void Start();
+
+  void Stop();
+
+  /**
+   * Lock a row in shared mode, waiting for the exclusive holders. Holding
+   * any lock on the row is enough.
+   * @throws TransactionAbortException if txn is aborted to break a deadlock
+   */
+  void LockShared(Transaction *txn, const std::string &row_key);
+
+  /**
+   * Lock a row in exclusive mode, waiting for the other holders. A shared
+   * lock of txn is upgraded.
+   * @throws TransactionAbortException if txn is aborted to break a deadlock,
+   * or another transaction is already upgrading its lock on the row
+   */
+  void LockExclusive(Transaction *txn, const std::string &row_key);
+
+  /** Release the lock of txn on a row. */
+  void Unlock(Transaction *txn, const std::string &row_key);
+
+  /** Release every lock of txn, once it commits or aborts. */
+  void UnlockAll(Transaction *txn);
+
+  /** Search the waits-for graph once and abort a transaction per cycle. */
+  void DetectDeadlocks();
+
+  /** The number of transactions aborted to break deadlocks. */
+  auto GetDeadlockCount() const -> size_t { return deadlock_count_; }
+
+ private:
+  struct LockRequest {
+    txn_id_t txn_id_;
+    LockMode mode_;
+    bool granted_;
+  };
+
+  /** The requests on a row: the granted ones, then the waiting ones. */
+  struct LockRequestQueue {
+    std::list<LockRequest> requests_;
+    std::condition_variable cv_;
+    /** The transaction upgrading its lock, or INVALID_TXN_ID. */
+    txn_id_t upgrading_{INVALID_TXN_ID};
+  };
+
+  struct Partition {
+    std::mutex latch_;
+    std::unordered_map<std::string, LockRequestQueue> queues_;
+  };
+
+  auto GetPartition(const std::string &row_key) -> Partition &;
+
+  // Wait in the queue until the request of txn is granted.
+  void Wait(Transaction *txn, std::unique_lock<std::mutex> *lock,
+            LockRequestQueue *queue, std::list<LockRequest>::iterator request);
+
+  static auto IsGrantable(const LockRequestQueue &queue,
+                          std::list<LockRequest>::iterator request) -> bool;
+
+  // Drop the request of a transaction, the queue too once it is empty.
+  void Release(Partition *partition, const std::string &row_key,
+               txn_id_t txn_id);
+
+  void DetectionThread();
+
+  size_t interval_ms_;
+  Partition partitions_[LOCK_TABLE_PARTITION_NUMS];
+
+  /** The transactions chosen to break deadlocks, until they give up. */
+  std::unordered_set<txn_id_t> victims_;
+  std::mutex victims_latch_;
+  std::atomic<size_t> deadlock_count_{0};
+
+  bool is_running_{false};
+  /** Protects is_running_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+}  // namespace spdb
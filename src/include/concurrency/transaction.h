@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "config/config.h"
+
+namespace spdb {
+
+enum class TransactionState { RUNNING, COMMITTED, ABORTED };
+
+enum class LockMode { SHARED, EXCLUSIVE };
+
+/**
+ * Thrown when a transaction writes a row which another transaction wrote
+ * after its snapshot, or is chosen to break a deadlock. The transaction
+ * should be rolled back.
+ */
+class TransactionAbortException : public std::runtime_error {
+ public:
+  explicit TransactionAbortException(const std::string &message)
+      : std::runtime_error(message) {}
+};
+
+/** A row written by a transaction, to commit or roll back its version. */
+struct WriteRecord {
+  std::string table_name_;
+  /** The key of the row, as stored in the table. */
+  std::string key_;
+  /** The record of the transaction before the row update logged for the
+   * write, the undo goes on from there. */
+  lsn_t undo_next_lsn_{INVALID_LSN};
+};
+
+/**
+ * Transaction reads the snapshot of the database as of its start: the
+ * versions committed until then and its own writes.
+ */
+class Transaction {
+  friend class TransactionManager;
+  friend class LockManager;
+
+ public:
+  Transaction(txn_id_t txn_id, timestamp_t read_ts)
+      : txn_id_(txn_id), read_ts_(read_ts) {}
+
+  auto GetTransactionId() const -> txn_id_t { return txn_id_; }
+
+  /** The timestamp of the last commit the snapshot includes. */
+  auto GetReadTs() const -> timestamp_t { return read_ts_; }
+
+  auto GetCommitTs() const -> timestamp_t { return commit_ts_; }
+
+  /** The timestamp the versions written by the transaction carry until it
+   * commits. */
+  auto GetTempTs() const -> timestamp_t { return TXN_START_TS + txn_id_; }
+
+  auto GetState() const -> TransactionState { return state_; }
+
+  auto GetWriteSet() const -> const std::vector<WriteRecord> & {
+    return write_set_;
+  }
+
+  auto GetLockSet() const -> const std::unordered_map<std::string, LockMode> & {
+    return lock_set_;
+  }
+
+ private:
+  txn_id_t txn_id_;
+  timestamp_t read_ts_;
+  timestamp_t commit_ts_{0};
+  TransactionState state_{TransactionState::RUNNING};
+  /** Only reads, started for a statement outside of transactions. */
+  bool is_snapshot_{false};
+  std::vector<WriteRecord> write_set_;
+  /** The row locks held, by row key. */
+  std::unordered_map<std::string, LockMode> lock_set_;
+};
+}  // namespace spdb
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction.h"
+#include "config/catalog.h"
+#include "config/config.h"
+#include "recovery/log_manager.h"
+
+namespace spdb {
+
+/** A version of a row older than the one in the table. */
+struct UndoVersion {
+  /** The commit timestamp of the version. */
+  timestamp_t ts_;
+  /** The row didn't exist in the version. */
+  bool is_deleted_;
+  /** The row in the version, unless it is deleted. */
+  std::string value_;
+};
+
+/**
+ * The versions of a row which some snapshot may still read. The newest
+ * version is the one in the table, the older ones hang off it newest first.
+ */
+struct VersionChain {
+  /** The commit timestamp of the newest version, or the temporary timestamp
+   * of the transaction writing it. */
+  timestamp_t ts_{0};
+  std::vector<UndoVersion> undo_;
+};
+
+/**
+ * TransactionManager runs transactions over the tables with multi-version
+ * concurrency control. The B+ tree of a table holds the newest version of
+ * every row, written in place; the versions some running snapshot may still
+ * need are kept in memory in a version store keyed by (table, row key).
+ *
+ * A transaction reads the snapshot as of its start, readers never wait for
+ * writers. Writes are snapshot isolated: writing a row which another
+ * transaction wrote after the snapshot aborts the transaction, the first
+ * writer wins. Rolling back restores the older versions in the trees.
+ *
+ * Versions are dropped once no running snapshot is older than the newest
+ * version of the row, then a row without versions is read from the tree.
+ * A deleted row leaves the tree at once, as a row updated leaves its place
+ * in the indexes, the scans of the older snapshots pick them up from the
+ * versions.
+ *
+ * Writes to a table are serialized by the manager, so they share the root
+ * of the tree, readers run alongside them. They are serialized per
+ * statement only, so the rows written are logged for the recovery to undo
+ * them row by row. With a lock manager a writer locks the row first and
+ * waits for the transaction writing it instead of aborting at once, it
+ * aborts only if that transaction commits.
+ */
+class TransactionManager {
+ public:
+  /**
+   * @param catalog the tables the transactions run over
+   * @param log_manager logs the transactions, nullptr disables logging
+   * @param lock_manager locks the rows written, nullptr disables locking
+   */
+  explicit TransactionManager(Catalog *catalog,
+                              LogManager *log_manager = nullptr,
+                              LockManager *lock_manager = nullptr);
+
+  ~TransactionManager();
+
+  /**
+   * Begin a transaction on the calling thread.
+   * @return the transaction, valid until it commits or aborts
+   */
+  auto Begin() -> Transaction *;
+
+  /**
+   * Take a snapshot for a statement outside of transactions, it only reads
+   * and is released by Commit.
+   */
+  auto BeginSnapshot() -> Transaction *;
+
+  /** Make the writes of the transaction visible to later snapshots. */
+  void Commit(Transaction *txn);
+
+  /** Roll back the writes of the transaction. */
+  void Abort(Transaction *txn);
+
+  /** Go on with a transaction on the calling thread. */
+  void Resume(Transaction *txn);
+
+  /** Leave the transaction of the calling thread, for any thread to resume. */
+  void Suspend();
+
+  /** @return the transaction of the calling thread, or nullptr */
+  static auto Current() -> Transaction *;
+
+  /**
+   * Insert a row, and its index entries, as txn.
+   * @return false if txn already sees a row with the key
+   * @throws TransactionAbortException if another transaction wrote the key
+   * after the snapshot of txn, or txn is deadlocked
+   */
+  auto InsertRow(Transaction *txn, const std::string &table_name,
+                 const Tuple &row) -> bool;
+
+  /**
+   * Insert rows, and their index entries, as txn. The rows are sorted by
+   * key, locked in that order and go into the tree a leaf at a time, under
+   * one latch of the table.
+   * @return the number of rows inserted, a row with a key txn already sees
+   * or repeating one of the batch is left out
+   * @throws TransactionAbortException as InsertRow, before any row is
+   * inserted
+   */
+  auto InsertRows(Transaction *txn, const std::string &table_name,
+                  const std::vector<Tuple> &rows) -> size_t;
+
+  /**
+   * Delete rows, and their index entries, as txn. The rows are locked in key
+   * order and removed from the tree under one latch of the table, the
+   * snapshots older than the delete go on reading them from the versions.
+   * @param keys the keys of the rows
+   * @return the number of rows deleted, a key txn doesn't see is left out
+   * @throws TransactionAbortException as InsertRow, before any row is
+   * deleted
+   */
+  auto DeleteRows(Transaction *txn, const std::string &table_name,
+                  const std::vector<Tuple> &keys) -> size_t;
+
+  /**
+   * Update rows, and their index entries, as txn. A row keeping its key is
+   * overwritten in place in its leaf, the leaves a batch at a time as
+   * InsertRows writes them; a row getting another key is deleted and
+   * inserted again.
+   * @param rows the rows as txn sees them, each with the row replacing it
+   * @return the number of rows updated
+   * @throws TransactionAbortException as InsertRow, before any row is
+   * updated
+   * @throws std::runtime_error if a row would get the key of a row txn sees,
+   * before any row is updated
+   */
+  auto UpdateRows(Transaction *txn, const std::string &table_name,
+                  const std::vector<std::pair<Tuple, Tuple>> &rows) -> size_t;
+
+  /**
+   * Turn the row read from a table into the version txn sees.
+   * @param key the key of the row in the table
+   * @param[in,out] row the row in the table, replaced by the visible version
+   * @return false if txn sees no row with the key
+   */
+  auto ReadRow(const Transaction *txn, const std::string &table_name,
+               const Tuple &key, Tuple *row) -> bool;
+
+  /**
+   * Read the version txn sees of a row, if it is older than the one in the
+   * table, as for a row deleted since the snapshot of txn.
+   * @return false if txn sees the row in the table, or no row with the key
+   */
+  auto ReadOlderVersion(const Transaction *txn, const std::string &table_name,
+                        const Tuple &key, Tuple *row) -> bool;
+
+  /**
+   * Find the first row of a key range txn sees, which was deleted, moved to
+   * another key or moved in an index since the snapshot of txn, so a scan
+   * of the tree or an index doesn't come across it. Scanning a table in key
+   * order, a reader takes the rows between the last key read and the next
+   * one from here; the write is noted before the row leaves the tree, so
+   * the reader doesn't miss it.
+   * @param low the key the range starts at, nullptr from the first one
+   * @param high the key the range ends before, nullptr until the last one
+   * @param[out] key the key of the row
+   * @param[out] row the version txn sees
+   * @return false if there is no such row
+   */
+  auto NextDisplacedRow(const Transaction *txn, const std::string &table_name,
+                        const Tuple *low, bool is_low_inclusive,
+                        const Tuple *high, Tuple *key, Tuple *row) -> bool;
+
+  /**
+   * Rebuild the B+ trees of a table and its indexes with dense leaves laid
+   * out in key order, see BPlusTree::Compact. Writers to the table wait
+   * meanwhile, readers go on: the old pages are freed once every snapshot
+   * taken before the new roots were published has finished.
+   * @return the number of pages the trees shrank by
+   * @throws std::runtime_error if the calling thread runs a transaction, or
+   * a running transaction wrote the table, as the recovery would undo its
+   * writes on the old pages
+   */
+  auto CompactTable(const std::string &table_name) -> size_t;
+
+  /**
+   * Vacuum a table, see Catalog::Vacuum. The pages compactions left for the
+   * running snapshots are kept, they are freed once these finish.
+   * @return the number of pages cut off
+   */
+  auto VacuumTable(const std::string &table_name) -> size_t;
+
+  /** @return true if a running transaction wrote the table */
+  auto HasUncommittedWrites(const std::string &table_name) -> bool;
+
+  /** The number of pages compactions left for the running snapshots. */
+  auto GetRetiredPageCount() -> size_t;
+
+  /** @return the timestamp of the last commit */
+  auto GetLastCommitTs() const -> timestamp_t { return last_commit_ts_; }
+
+  /** The number of rows with older versions kept. */
+  auto GetVersionCount() -> size_t;
+
+  /** Name a row of a table, in the version store and the lock table. */
+  static auto RowKey(const std::string &table_name, const Tuple &key)
+      -> std::string;
+
+ private:
+  struct Shard {
+    std::mutex latch_;
+    std::unordered_map<std::string, VersionChain> chains_;
+  };
+
+  auto GetShard(const std::string &version_key) -> Shard &;
+
+  auto GetTableLatch(const std::string &table_name) -> std::mutex &;
+
+  auto Register(std::unique_ptr<Transaction> txn) -> Transaction *;
+
+  /** The pages of a file a compaction replaced, as of a timestamp. */
+  struct RetiredPages {
+    timestamp_t ts_;
+    std::string disk_name_;
+    std::vector<page_id_t> page_ids_;
+  };
+
+  // Release a finished transaction and drop the versions no snapshot needs
+  // anymore.
+  void Finish(Transaction *txn);
+
+  // Drop the versions and free the pages no running snapshot needs anymore.
+  void CollectGarbage();
+
+  void FreePages(const RetiredPages &retired);
+
+  // Undo a write in the table and the version store.
+  void Rollback(const WriteRecord &write);
+
+  // The older version of a chain txn sees, nullptr if there is none.
+  // is_newest tells txn sees the newest one, in the table, instead.
+  auto FindOlderVersion(const Transaction *txn, const VersionChain &chain,
+                        bool *is_newest) -> const UndoVersion *;
+
+  // Lock the rows of the keys exclusively, the keys sorted. The rows are
+  // locked before the table, so a writer waiting for a row doesn't hold up
+  // the others; in key order, so two batches don't wait for each other the
+  // other way round.
+  void LockRows(Transaction *txn, const std::string &table_name,
+                const std::vector<Tuple> &keys);
+
+  // Abort txn if another transaction wrote a row after its snapshot, under
+  // the latch of the table.
+  void CheckConflicts(Transaction *txn, const std::string &table_name,
+                      const std::vector<Tuple> &keys);
+
+  // Keep the version of a row before txn writes it, and note the write, unless
+  // txn wrote the row already. row is nullptr if the row didn't exist.
+  void AddVersion(Transaction *txn, const std::string &table_name,
+                  const Tuple &key, const Tuple *row);
+
+  // Insert key-row pairs sorted by key into the tree as txn, under the latch
+  // of the table. @return the number of rows inserted
+  auto WriteInserts(Transaction *txn, const std::string &table_name,
+                    BPlusTree *tree,
+                    const std::vector<std::pair<Tuple, Tuple>> &pairs)
+      -> size_t;
+
+  // Remove the rows of keys from the tree as txn, under the latch of the
+  // table. @return the number of rows removed
+  auto WriteDeletes(Transaction *txn, const std::string &table_name,
+                    BPlusTree *tree, const std::vector<Tuple> &keys) -> size_t;
+
+  // Log the end of a write statement, still under the latch of the table.
+  // Until then no other transaction wrote the pages of the table, so the
+  // recovery may undo the statement by its page updates, after it only by
+  // its row updates.
+  void EndStatement();
+
+  // Note a row the older snapshots no longer find where they look for it,
+  // until its versions are dropped.
+  void Displace(const std::string &table_name, const Tuple &key);
+
+  void Undisplace(const std::string &version_key);
+
+  Catalog *catalog_;
+  LogManager *log_manager_;
+  LockManager *lock_manager_;
+  txn_id_t next_txn_id_{0};
+  std::atomic<timestamp_t> last_commit_ts_{0};
+
+  /** The transactions running, snapshots included. */
+  std::unordered_map<Transaction *, std::unique_ptr<Transaction>> txns_;
+  /** The rows written by every commit, until no snapshot is older. */
+  std::deque<std::pair<timestamp_t, std::vector<std::string>>> commits_;
+  /** The pages replaced by every compaction, until no snapshot is older. */
+  std::deque<RetiredPages> retired_;
+  /** Protects the members above, a commit is published under it. */
+  std::mutex latch_;
+
+  Shard shards_[VERSION_STORE_SHARD_NUMS];
+
+  /**
+   * The keys of the rows displaced by deletes and updates, by table, in key
+   * order. A row stays until its versions are dropped.
+   */
+  std::unordered_map<std::string, std::set<Tuple>> displaced_;
+  std::atomic<size_t> displaced_count_{0};
+  std::mutex displaced_latch_;
+
+  /** One writer per table at a time. */
+  std::unordered_map<std::string, std::unique_ptr<std::mutex>> table_latches_;
+  std::mutex table_latches_latch_;
+};
+
+/**
+ * The snapshot a statement reads: the transaction of the calling thread, or
+ * a snapshot of its own for a statement outside of transactions, released
+ * with the statement. Without a transaction manager every row is visible.
+ */
+class StatementSnapshot {
+ public:
+  explicit StatementSnapshot(TransactionManager *txn_manager);
+
+  /**
+   * Read as of the snapshot of another statement, as the threads of a
+   * parallel scan do. It is left to the statement to release it.
+   */
+  explicit StatementSnapshot(const StatementSnapshot *outer)
+      : txn_manager_(outer->txn_manager_), txn_(outer->txn_) {}
+
+  ~StatementSnapshot();
+
+  StatementSnapshot(const StatementSnapshot &) = delete;
+  auto operator=(const StatementSnapshot &) -> StatementSnapshot & = delete;
+
+  /** @see TransactionManager::ReadRow */
+  auto ReadRow(const std::string &table_name, const Tuple &key, Tuple *row)
+      -> bool;
+
+  /** @see TransactionManager::ReadOlderVersion */
+  auto ReadOlderVersion(const std::string &table_name, const Tuple &key,
+                        Tuple *row) -> bool;
+
+  /** @see TransactionManager::NextDisplacedRow */
+  auto NextDisplacedRow(const std::string &table_name, const Tuple *low,
+                        bool is_low_inclusive, const Tuple *high, Tuple *key,
+                        Tuple *row) -> bool;
+
+  /**
+   * Whether the snapshot sees the tables as their trees hold them, no older
+   * version of a row being kept, so every entry read since is a visible row.
+   */
+  auto SeesNewest() -> bool;
+
+ private:
+  TransactionManager *txn_manager_;
+  Transaction *txn_{nullptr};
+  bool is_own_{false};
+};
+}  // namespace spdb
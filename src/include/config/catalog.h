@@ -1,11 +1,34 @@
 #pragma once
+#include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 
+#include "buffer/buffer_pool.h"
 #include "buffer/buffer_pool_manager.h"
 #include "config.h"
 #include "table/b_plus_tree.h"
 namespace spdb {
+class TransactionManager;
+
+/**
+ * A secondary index is a B+ tree in its own file, it maps the indexed cloums
+ * followed by the table key to the table key.
+ */
+class IndexInfo {
+ public:
+  std::string index_name_;
+  std::string disk_name_;
+  std::vector<Cloum> key_type_;
+  page_id_t root_id_;
+  int leaf_max_size_;
+  int internal_max_size_;
+};
+
 class TableInfo {
  public:
   std::string disk_name_;
@@ -14,6 +37,8 @@ class TableInfo {
   page_id_t root_id_;
   int leaf_max_size_;
   int internal_max_size_;
+  std::vector<IndexInfo> indexes_;
+  LeafLayout layout_{LeafLayout::Row};
 };
 
 class Catalog {
@@ -22,6 +47,10 @@ class Catalog {
    *  ------------------------------------------------------------
    * | TableSize (8) | TableInfo(1) | ... | TableInfo(n) |
    *  ------------------------------------------------------------
+   * | Layout(1) (4) | ... | Layout(n) (4) |
+   *  ------------------------------------------------------------
+   * | Indexes(1) | ... | Indexes(n) |
+   *  ------------------------------------------------------------
    *  TableInfo:
    *  ------------------------------------------------------------
    * |  DiskNameLength (8) | DiskName (DiskNameLength) | KeyNums (8) |
@@ -30,12 +59,36 @@ class Catalog {
    *  ------------------------------------------------------------
    * |  Value1Size (8) | Value1 (Value1Size) | ... | HeaderId (4) |
    *  ------------------------------------------------------------
+   * |  LeafMaxSize (4) | InternalMaxSize (4) |
+   *  ------------------------------------------------------------
+   *  Indexes:
+   *  ------------------------------------------------------------
+   * |  IndexNums (8) | IndexInfo(1) | ... | IndexInfo(n) |
+   *  ------------------------------------------------------------
+   *  IndexInfo:
+   *  ------------------------------------------------------------
+   * |  IndexNameLength (8) | IndexName (IndexNameLength) | KeyNums (8) |
+   *  ------------------------------------------------------------
+   * |  Key1Size (8) | Key1 (Key1Size) | ... | RootId (4) |
+   *  ------------------------------------------------------------
    * |  LeafMaxSize (4) | InternalMaxSize (4)
    *  ------------------------------------------------------------
+   * The leaf layouts and the indexes of the tables come after them, a
+   * catalog written before they were kept ends with the tables, which are
+   * all Row ones without indexes.
    */
  public:
-  explicit Catalog(std::string name) {
+  /**
+   * @param buffer_pool the pool caching the pages of all tables and indexes,
+   * a pool of DEFAULT_BUFFER_POOL_SIZE frames is created if it is nullptr
+   */
+  explicit Catalog(std::string name, BufferPool *buffer_pool = nullptr) {
     catal_name_ = name;
+    if (buffer_pool == nullptr) {
+      own_pool_ = std::make_unique<BufferPool>(DEFAULT_BUFFER_POOL_SIZE);
+      buffer_pool = own_pool_.get();
+    }
+    buffer_pool_ = buffer_pool;
     std::fstream catal_file(name, std::ios::in | std::ios::binary);
 
     size_t tsize = 0;
@@ -90,16 +143,63 @@ class Catalog {
       catal_file.read((char *)&header_id, sizeof(page_id_t));
       catal_file.read((char *)&leaf_max_size, sizeof(int));
       catal_file.read((char *)&internal_max_size, sizeof(int));
-      TableInfo table_info{disk_name, key_type,      value_type,
-                           header_id, leaf_max_size, internal_max_size};
+      TableInfo table_info{disk_name,         key_type,  value_type,
+                           header_id,         leaf_max_size,
+                           internal_max_size, {},        LeafLayout::Row};
       tables_.push_back(table_info);
     }
+    for (auto &table : tables_) {
+      LeafLayout layout = LeafLayout::Row;
+      if (!catal_file.read((char *)&layout, sizeof(LeafLayout))) {
+        break;
+      }
+      table.layout_ = layout;
+    }
+    for (auto &table : tables_) {
+      size_t index_nums = 0;
+      if (!catal_file.read((char *)&index_nums, sizeof(size_t))) {
+        break;
+      }
+      for (size_t j = 0; j < index_nums; ++j) {
+        IndexInfo index_info{};
+        index_info.index_name_ = ReadString(catal_file);
+        index_info.disk_name_ =
+            IndexDiskName(table.disk_name_, index_info.index_name_);
+        index_info.key_type_ = ReadCloums(catal_file);
+        catal_file.read((char *)&index_info.root_id_, sizeof(page_id_t));
+        catal_file.read((char *)&index_info.leaf_max_size_, sizeof(int));
+        catal_file.read((char *)&index_info.internal_max_size_, sizeof(int));
+        table.indexes_.push_back(index_info);
+      }
+    }
 
     catal_file.close();
   }
 
   ~Catalog() {
-    std::fstream catal_file(catal_name_,
+    try {
+      for (auto &[disk_name, file] : files_) {
+        file.bpm_->FlushAllPages();
+      }
+      Save();
+    } catch (std::runtime_error &e) {
+      // the log can't be written, so neither can the pages, the recovery
+      // goes on from the files as they are
+    }
+  }
+
+  /**
+   * Write the catalog file. It is written aside and renamed over the old
+   * one, so a crash leaves either of them. With logging, the log is flushed
+   * first, so every root saved can be rolled back by the recovery.
+   */
+  void Save() {
+    auto log_manager = buffer_pool_->GetLogManager();
+    if (log_manager != nullptr) {
+      log_manager->FlushAll();
+    }
+    std::string tmp_name = catal_name_ + ".tmp";
+    std::fstream catal_file(tmp_name,
                             std::ios::out | std::ios::binary | std::ios::trunc);
     size_t tsize = tables_.size();
     catal_file.write((char *)&tsize, sizeof(size_t));
@@ -136,18 +236,35 @@ class Catalog {
       catal_file.write((char *)&tables_[i].leaf_max_size_, sizeof(int));
       catal_file.write((char *)&tables_[i].internal_max_size_, sizeof(int));
     }
+    for (auto &table : tables_) {
+      catal_file.write((char *)&table.layout_, sizeof(LeafLayout));
+    }
+    for (auto &table : tables_) {
+      size_t index_nums = table.indexes_.size();
+      catal_file.write((char *)&index_nums, sizeof(size_t));
+      for (auto &index : table.indexes_) {
+        WriteString(catal_file, index.index_name_);
+        WriteCloums(catal_file, index.key_type_);
+        catal_file.write((char *)&index.root_id_, sizeof(page_id_t));
+        catal_file.write((char *)&index.leaf_max_size_, sizeof(int));
+        catal_file.write((char *)&index.internal_max_size_, sizeof(int));
+      }
+    }
+    catal_file.close();
+    std::rename(tmp_name.data(), catal_name_.data());
   }
 
+  /** @param layout how the leaves of the table store the rows */
   bool CreateTable(std::string name, std::vector<Cloum> key_type,
-                   std::vector<Cloum> value_type) {
+                   std::vector<Cloum> value_type,
+                   LeafLayout layout = LeafLayout::Row) {
     for (auto &table : tables_) {
       if (name == table.disk_name_) {
         return false;
       }
     }
-    auto disk = DiskManager(name);
-    // create and fetch header_page
-    BufferPoolManager bpm(5, &disk);
+    // create the table file
+    auto bpm = GetBufferPoolManager(name);
     // create b+ tree
     size_t kv_size = 0;
     for (auto &col : key_type) {
@@ -161,9 +278,11 @@ class Catalog {
     int internal_max_size = (PAGE_SIZE - INTERNAL_HEADER_SIZE) / kv_size;
     TableInfo table{name,          key_type,
                     value_type,    INVALID_PAGE_ID,
-                    leaf_max_size, internal_max_size};
+                    leaf_max_size, internal_max_size,
+                    {},            layout};
     tables_.push_back(table);
-    BPlusTree(&bpm, key_type, value_type, leaf_max_size, internal_max_size);
+    BPlusTree(bpm, key_type, value_type, leaf_max_size, internal_max_size);
+    Save();
     return true;
   }
   TableInfo GetTable(std::string name) {
@@ -178,27 +297,387 @@ class Catalog {
   void ModifyTableRoot(std::string name, page_id_t root_id) {
     for (auto &table : tables_) {
       if (table.disk_name_ == name) {
+        LogRootUpdate(name, table.root_id_, root_id);
         table.root_id_ = root_id;
         break;
       }
     }
   }
 
+  /** Move the root of a table or index file. */
+  void ModifyRoot(const std::string &disk_name, page_id_t root_id) {
+    for (auto &table : tables_) {
+      if (table.disk_name_ == disk_name) {
+        LogRootUpdate(disk_name, table.root_id_, root_id);
+        table.root_id_ = root_id;
+      }
+      for (auto &index : table.indexes_) {
+        if (index.disk_name_ == disk_name) {
+          LogRootUpdate(disk_name, index.root_id_, root_id);
+          index.root_id_ = root_id;
+        }
+      }
+    }
+  }
+
+  /**
+   * Set the root of a table or index file without logging it, used by the
+   * recovery.
+   */
+  void SetRoot(const std::string &disk_name, page_id_t root_id) {
+    for (auto &table : tables_) {
+      if (table.disk_name_ == disk_name) {
+        table.root_id_ = root_id;
+      }
+      for (auto &index : table.indexes_) {
+        if (index.disk_name_ == disk_name) {
+          index.root_id_ = root_id;
+        }
+      }
+    }
+  }
+
+  /** @return true if a table or an index is stored in the file */
+  bool IsFileExisted(const std::string &disk_name) {
+    for (auto &table : tables_) {
+      if (table.disk_name_ == disk_name) {
+        return true;
+      }
+      for (auto &index : table.indexes_) {
+        if (index.disk_name_ == disk_name) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
   bool DropTable(std::string name) {
     for (auto it = tables_.begin(); it != tables_.end(); ++it) {
       if (it->disk_name_ == name) {
-        if (!std::remove(name.data()) == 0) {
+        // a table created again under the name starts from no root
+        LogRootUpdate(name, it->root_id_, INVALID_PAGE_ID);
+        CloseFile(name);
+        for (auto &index : it->indexes_) {
+          LogRootUpdate(index.disk_name_, index.root_id_, INVALID_PAGE_ID);
+          CloseFile(index.disk_name_);
+        }
+        if (!RemoveFile(name)) {
           return false;
         } else {
+          for (auto &index : it->indexes_) {
+            RemoveFile(index.disk_name_);
+          }
           tables_.erase(it);
+          Save();
         }
         break;
       }
     }
     return true;
   }
+
+  /**
+   * Create a secondary index on cols of a table. The existing rows are
+   * collected, sorted and bulk loaded into the new B+ tree.
+   */
+  bool CreateIndex(std::string table_name, std::string index_name,
+                   std::vector<std::string> cols) {
+    auto table = FindTable(table_name);
+    if (table == nullptr || cols.empty() || IsIndexExisted(index_name)) {
+      return false;
+    }
+
+    std::vector<Cloum> key_type;
+    for (auto &name : cols) {
+      auto col = std::find_if(
+          table->value_type_.begin(), table->value_type_.end(),
+          [&](const Cloum &c) { return c.cloum_name_ == name; });
+      if (col == table->value_type_.end()) {
+        return false;
+      }
+      key_type.push_back(*col);
+    }
+    for (auto &col : table->key_type_) {
+      key_type.push_back(col);
+    }
+
+    size_t key_size = 0;
+    size_t table_key_size = 0;
+    for (auto &col : key_type) {
+      key_size += col.GetSize();
+    }
+    for (auto &col : table->key_type_) {
+      table_key_size += col.GetSize();
+    }
+    IndexInfo index{index_name,
+                    IndexDiskName(table_name, index_name),
+                    key_type,
+                    INVALID_PAGE_ID,
+                    static_cast<int>((PAGE_SIZE - LEAF_HEADER_SIZE) /
+                                     (key_size + table_key_size)),
+                    static_cast<int>((PAGE_SIZE - INTERNAL_HEADER_SIZE) /
+                                     (key_size + sizeof(page_id_t)))};
+
+    std::vector<std::pair<Tuple, Tuple>> entries;
+    {
+      BPlusTree tree(GetBufferPoolManager(table->disk_name_), table->key_type_,
+                     table->value_type_, table->leaf_max_size_,
+                     table->internal_max_size_, table->root_id_);
+      for (auto it = tree.Begin(); it != tree.End(); ++it) {
+        auto &[key, value] = *it;
+        entries.emplace_back(value.Project(key_type), key);
+      }
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    CloseFile(index.disk_name_);
+    RemoveFile(index.disk_name_);
+    auto bpm = GetBufferPoolManager(index.disk_name_);
+    BPlusTree tree(bpm, index.key_type_, table->key_type_,
+                   index.leaf_max_size_, index.internal_max_size_);
+    tree.BulkLoad(entries);
+    bpm->FlushAllPages();
+    LogRootUpdate(index.disk_name_, INVALID_PAGE_ID, tree.GetRootPageId());
+    index.root_id_ = tree.GetRootPageId();
+    table->indexes_.push_back(index);
+    Save();
+    return true;
+  }
+
+  bool DropIndex(std::string index_name) {
+    for (auto &table : tables_) {
+      for (auto it = table.indexes_.begin(); it != table.indexes_.end();
+           ++it) {
+        if (it->index_name_ == index_name) {
+          LogRootUpdate(it->disk_name_, it->root_id_, INVALID_PAGE_ID);
+          CloseFile(it->disk_name_);
+          RemoveFile(it->disk_name_);
+          table.indexes_.erase(it);
+          Save();
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  bool IsIndexExisted(std::string index_name) {
+    for (auto &table : tables_) {
+      for (auto &index : table.indexes_) {
+        if (index.index_name_ == index_name) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Keep the secondary indexes of a table up to date after a row is
+   * inserted with key.
+   */
+  void InsertIndexEntries(std::string table_name, const Tuple &key,
+                          const Tuple &row) {
+    InsertIndexEntries(std::move(table_name), {{key, row}});
+  }
+
+  /**
+   * Keep the secondary indexes of a table up to date after rows are
+   * inserted, given with their keys. The entries of an index go into it
+   * sorted, a leaf at a time.
+   */
+  void InsertIndexEntries(
+      std::string table_name,
+      const std::vector<std::pair<Tuple, Tuple>> &keys_and_rows) {
+    auto table = FindTable(table_name);
+    if (table == nullptr || keys_and_rows.empty()) {
+      return;
+    }
+    for (auto &index : table->indexes_) {
+      std::vector<std::pair<Tuple, Tuple>> entries;
+      entries.reserve(keys_and_rows.size());
+      for (auto &[key, row] : keys_and_rows) {
+        entries.emplace_back(row.Project(index.key_type_), key);
+      }
+      std::sort(entries.begin(), entries.end(),
+                [](const auto &a, const auto &b) { return a.first < b.first; });
+      BPlusTree tree(GetBufferPoolManager(index.disk_name_), index.key_type_,
+                     table->key_type_, index.leaf_max_size_,
+                     index.internal_max_size_, index.root_id_);
+      tree.InsertBatch(entries, [](size_t) {});
+      LogRootUpdate(index.disk_name_, index.root_id_, tree.GetRootPageId());
+      index.root_id_ = tree.GetRootPageId();
+    }
+  }
+
+  /**
+   * Keep the secondary indexes of a table up to date after a row is removed.
+   */
+  void RemoveIndexEntries(std::string table_name, const Tuple &row) {
+    auto table = FindTable(table_name);
+    if (table == nullptr) {
+      return;
+    }
+    for (auto &index : table->indexes_) {
+      BPlusTree tree(GetBufferPoolManager(index.disk_name_), index.key_type_,
+                     table->key_type_, index.leaf_max_size_,
+                     index.internal_max_size_, index.root_id_);
+      tree.Remove(row.Project(index.key_type_));
+      LogRootUpdate(index.disk_name_, index.root_id_, tree.GetRootPageId());
+      index.root_id_ = tree.GetRootPageId();
+    }
+  }
+
+  /**
+   * Put the row of a key back in a table as it was before a write, with its
+   * index entries, to undo the write.
+   * @param row the row, nullptr if there was none
+   */
+  void RestoreRow(std::string table_name, const Tuple &key, const Tuple *row) {
+    auto table = FindTable(table_name);
+    if (table == nullptr) {
+      return;
+    }
+    BPlusTree tree(GetBufferPoolManager(table_name), table->key_type_,
+                   table->value_type_, table->leaf_max_size_,
+                   table->internal_max_size_, table->root_id_, table->layout_);
+    Tuple current{table->value_type_};
+    bool is_present = tree.GetValue(key, current);
+    if (is_present) {
+      RemoveIndexEntries(table_name, current);
+    }
+    if (row == nullptr) {
+      if (is_present) {
+        tree.Remove(key);
+      }
+    } else {
+      // an update is undone in place as well
+      if (is_present) {
+        tree.UpdateBatch({{key, *row}}, [](size_t, const Tuple &) {});
+      } else {
+        tree.Insert(key, *row);
+      }
+      InsertIndexEntries(table_name, key, *row);
+    }
+    ModifyTableRoot(table_name, tree.GetRootPageId());
+  }
   auto GetTables() -> std::vector<TableInfo> { return tables_; }
 
+  auto GetBufferPool() -> BufferPool * { return buffer_pool_; }
+
+  /**
+   * Read the tables through the snapshots of txn_manager, nullptr lets the
+   * statements see every row.
+   */
+  void SetTransactionManager(TransactionManager *txn_manager) {
+    txn_manager_ = txn_manager;
+  }
+
+  auto GetTransactionManager() -> TransactionManager * { return txn_manager_; }
+
+  /**
+   * The buffer pool manager of a table or index file, the file is opened on
+   * first use and stays open until it is dropped, so its pages stay cached
+   * in the shared pool across statements. The files only hold B+ tree
+   * pages, so their pages are checksummed.
+   */
+  auto GetBufferPoolManager(const std::string &disk_name)
+      -> BufferPoolManager * {
+    std::lock_guard<std::mutex> lock(files_latch_);
+    auto &file = files_[disk_name];
+    if (file.bpm_ == nullptr) {
+      file.disk_ = std::make_unique<DiskManager>(disk_name);
+      file.bpm_ = std::make_unique<BufferPoolManager>(
+          buffer_pool_, file.disk_.get(), true);
+    }
+    return file.bpm_.get();
+  }
+
+  /**
+   * Write back and drop the cached pages of a file and close it.
+   */
+  void CloseFile(const std::string &disk_name) {
+    std::lock_guard<std::mutex> lock(files_latch_);
+    auto it = files_.find(disk_name);
+    if (it == files_.end()) {
+      return;
+    }
+    it->second.bpm_->FlushAllPages();
+    it->second.bpm_.reset();
+    it->second.disk_->ShutDown();
+    files_.erase(it);
+  }
+
+  /**
+   * Free the pages of a table and its indexes which their B+ trees don't
+   * reach anymore, and cut the free pages at the end off the files. Nobody
+   * should use the table meanwhile.
+   * @param kept_pages the pages of each file to keep though the trees don't
+   * reach them, as the ones a compaction left for the running snapshots
+   * @return the number of pages cut off
+   */
+  auto Vacuum(const std::string &table_name,
+              const std::unordered_map<std::string, std::vector<page_id_t>>
+                  &kept_pages = {}) -> size_t {
+    auto table = FindTable(table_name);
+    if (table == nullptr) {
+      return 0;
+    }
+    auto vacuum = [&](const std::string &disk_name,
+                      const std::vector<Cloum> &key_type,
+                      const std::vector<Cloum> &value_type, page_id_t root_id,
+                      int leaf_max_size, int internal_max_size) {
+      auto bpm = GetBufferPoolManager(disk_name);
+      BPlusTree tree(bpm, key_type, value_type, leaf_max_size,
+                     internal_max_size, root_id);
+      std::vector<page_id_t> used_pages;
+      tree.CollectPageIds(&used_pages);
+      auto it = kept_pages.find(disk_name);
+      if (it != kept_pages.end()) {
+        used_pages.insert(used_pages.end(), it->second.begin(),
+                          it->second.end());
+      }
+      return bpm->Vacuum(used_pages);
+    };
+    size_t truncated =
+        vacuum(table->disk_name_, table->key_type_, table->value_type_,
+               table->root_id_, table->leaf_max_size_,
+               table->internal_max_size_);
+    for (auto &index : table->indexes_) {
+      truncated += vacuum(index.disk_name_, index.key_type_, table->key_type_,
+                          index.root_id_, index.leaf_max_size_,
+                          index.internal_max_size_);
+    }
+    return truncated;
+  }
+
+  /**
+   * Store a table and its indexes compressed, or back in plain files (see
+   * DiskManager). The files are written back, closed and rewritten, so
+   * nobody should use the table meanwhile.
+   * @return the bytes the files take on the disk now
+   */
+  auto SetCompressed(const std::string &table_name, bool is_compressed)
+      -> size_t {
+    auto table = FindTable(table_name);
+    if (table == nullptr) {
+      return 0;
+    }
+    std::vector<std::string> disk_names{table->disk_name_};
+    for (auto &index : table->indexes_) {
+      disk_names.push_back(index.disk_name_);
+    }
+    size_t disk_size = 0;
+    for (auto &disk_name : disk_names) {
+      CloseFile(disk_name);
+      DiskManager::Convert(disk_name, is_compressed);
+      disk_size += DiskManager::GetDiskSize(disk_name);
+    }
+    return disk_size;
+  }
+
   bool IsExisted(std::string name) {
     for (auto &table : tables_) {
       if (table.disk_name_ == name) {
@@ -209,7 +688,86 @@ class Catalog {
   }
 
  private:
+  // the root of a B+ tree is kept here instead of a page, so its moves are
+  // logged apart
+  void LogRootUpdate(const std::string &disk_name, page_id_t old_root,
+                     page_id_t new_root) {
+    auto log_manager = buffer_pool_->GetLogManager();
+    if (log_manager != nullptr && old_root != new_root) {
+      log_manager->AppendRootUpdate(disk_name, old_root, new_root);
+    }
+  }
+
+  auto FindTable(const std::string &name) -> TableInfo * {
+    for (auto &table : tables_) {
+      if (table.disk_name_ == name) {
+        return &table;
+      }
+    }
+    return nullptr;
+  }
+
+  // Remove a table or index file and its free page map.
+  static auto RemoveFile(const std::string &disk_name) -> bool {
+    std::remove(FreePageMap::FileName(disk_name).data());
+    std::remove(DiskManager::MapFileName(disk_name).data());
+    return std::remove(disk_name.data()) == 0;
+  }
+
+  static auto IndexDiskName(const std::string &table_name,
+                            const std::string &index_name) -> std::string {
+    return table_name + "." + index_name + ".idx";
+  }
+
+  static auto ReadString(std::fstream &file) -> std::string {
+    size_t length = 0;
+    file.read((char *)&length, sizeof(size_t));
+    std::string str(length, '\0');
+    file.read(str.data(), length);
+    return str.c_str();
+  }
+
+  static void WriteString(std::fstream &file, const std::string &str) {
+    size_t length = str.length() + 1;
+    file.write((char *)&length, sizeof(size_t));
+    file.write(str.data(), length);
+  }
+
+  static auto ReadCloums(std::fstream &file) -> std::vector<Cloum> {
+    size_t nums = 0;
+    file.read((char *)&nums, sizeof(size_t));
+    std::vector<Cloum> cols;
+    cols.reserve(nums);
+    for (size_t i = 0; i < nums; ++i) {
+      CloumAtr atr{};
+      auto name = ReadString(file);
+      file.read((char *)&atr, sizeof(CloumAtr));
+      cols.emplace_back(name, atr);
+    }
+    return cols;
+  }
+
+  static void WriteCloums(std::fstream &file, const std::vector<Cloum> &cols) {
+    size_t nums = cols.size();
+    file.write((char *)&nums, sizeof(size_t));
+    for (auto &col : cols) {
+      WriteString(file, col.cloum_name_);
+      file.write((char *)&col.atr_, sizeof(CloumAtr));
+    }
+  }
+
+  struct FileHandle {
+    std::unique_ptr<DiskManager> disk_;
+    std::unique_ptr<BufferPoolManager> bpm_;
+  };
+
   std::string catal_name_;
   std::vector<TableInfo> tables_;
+  // declared before files_, so the pool outlives the managers using it
+  std::unique_ptr<BufferPool> own_pool_;
+  BufferPool *buffer_pool_;
+  TransactionManager *txn_manager_{nullptr};
+  std::unordered_map<std::string, FileHandle> files_;
+  std::mutex files_latch_;
 };
 }  // namespace spdb
@@ -5,14 +5,84 @@
 
 namespace spdb {
 #define page_id_t int32_t
+#define file_id_t int32_t
 #define slot_id_t int32_t
+#define lsn_t int64_t
+#define txn_id_t int32_t
+#define timestamp_t int64_t
 #define INVALID_PAGE_ID -1
+#define INVALID_LSN 0
+#define INVALID_TXN_ID -1
 #define PAGE_SIZE 4096
+// the CRC32C of a page written back by the buffer pool is kept at this
+// offset, in the header of the B+ tree pages
+#define PAGE_CHECKSUM_OFFSET 20
+// a page written with its checksum has this bit set in the 4 bytes at
+// PAGE_FLAGS_OFFSET, the page type of the B+ tree pages, which the pages
+// written before the checksums were kept don't have
+#define PAGE_FLAGS_OFFSET 8
+#define PAGE_CHECKSUM_FLAG 0x80000000U
+// a compressed file is allocated in units of this many bytes, a page takes
+// PAGE_SIZE / COMPRESSED_EXTENT_SIZE of them at most
+#define COMPRESSED_EXTENT_SIZE 256
 
 #define BUFFER_POOL_SIZE 50
+// frames of the buffer pool shared by all tables, unless set at startup
+#define DEFAULT_BUFFER_POOL_SIZE 4096
 #define LRUK_REPLACER_K 5
+// pages of a data file tracked by one page of its free page map
+#define FREE_PAGE_MAP_BITS ((PAGE_SIZE - 16) * 8)
 #define CATALOG_NAME "catalog.db"
 
+// memory an executor may hold before it spills to temp files
+#define EXECUTOR_MEMORY_BUDGET (64 * 1024 * 1024)
+#define SPILL_PARTITION_NUMS 16
+// a table smaller than this is scanned by one thread
+#define PARALLEL_SCAN_MIN_PAGES 1024
+// morsels of a parallel scan per worker, so the workers done early help
+#define PARALLEL_SCAN_MORSELS_PER_WORKER 16
+// tuples a thread of a parallel scan hands over at once
+#define EXCHANGE_BATCH_SIZE 1024
+// batches waiting to be taken before the threads of a parallel scan wait
+#define EXCHANGE_QUEUE_SIZE 16
+// bytes of rows in a block of a column file, before compression
+#define COLUMN_BLOCK_SIZE (1024 * 1024)
+
+#define LOG_FILE_NAME "spdb.log"
+// bytes of log records buffered before the log flusher is woken up
+#define LOG_BUFFER_SIZE (1024 * 1024)
+// the log is flushed at least this often even if nobody commits
+#define LOG_TIMEOUT_MS 100
+// threads redoing the log at startup, each of them redoes a share of the pages
+#define REDO_THREAD_NUMS 4
+// a fuzzy checkpoint is taken at least this often
+#define CHECKPOINT_INTERVAL_MS 60000
+// the recovery time aimed at, a checkpoint is taken earlier once redoing the
+// log appended since the last one would take longer
+#define RECOVERY_TIME_OBJECTIVE_MS 5000
+// the estimated speed of redo, turning the recovery time into log bytes
+#define REDO_BYTES_PER_SECOND (64 * 1024 * 1024)
+
+// versions written by running transactions are stamped after every commit
+#define TXN_START_TS (1LL << 62)
+// the version store is split by row key, each part behind its own latch
+#define VERSION_STORE_SHARD_NUMS 16
+// the lock table is split by row, each part behind its own latch
+#define LOCK_TABLE_PARTITION_NUMS 16
+// how often the waits-for graph is searched for deadlocks
+#define DEADLOCK_DETECTION_INTERVAL_MS 50
+
+// the server listens here unless told otherwise
+#define SERVER_PORT 5433
+// threads of the server running statements, shared by all connections
+#define SERVER_WORKER_NUMS 8
+// a connection sending a longer statement is closed
+#define SERVER_MAX_STATEMENT_SIZE (1024 * 1024)
+// statements a session keeps parsed, by their text without the literals
+#define PLAN_CACHE_SIZE 256
+// bytes of a result buffered before they are written to the output
+#define RESULT_BUFFER_SIZE (1024 * 1024)
+
 class RID {
  private:
   page_id_t pid_{-1};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+
+namespace spdb {
+/**
+ * The CRC32C (Castagnoli) of size bytes, computed with the SSE4.2
+ * instruction when the CPU has it.
+ * @param crc the CRC32C of the bytes before, to checksum a buffer in parts
+ */
+auto Crc32c(const char *data, size_t size, uint32_t crc = 0) -> uint32_t;
+
+/**
+ * The checksum of a page, over every byte but the checksum itself at
+ * PAGE_CHECKSUM_OFFSET.
+ */
+auto PageChecksum(const char *data) -> uint32_t;
+
+/**
+ * Mark a page with PAGE_CHECKSUM_FLAG and store its checksum in it, before
+ * it is written.
+ */
+void SetPageChecksum(char *data);
+
+/** @return true if a page read from the disk was written with a checksum */
+auto HasPageChecksum(const char *data) -> bool;
+
+/**
+ * Drop the mark of the checksum from a page read from the disk, so it reads
+ * as the page written back.
+ */
+void ClearPageChecksumFlag(char *data);
+
+/**
+ * @return true if the checksum stored in a page read from the disk matches
+ * the page, or the page has none, as it was written before the checksums
+ * were kept or allocated but never written
+ */
+auto IsPageChecksumValid(const char *data) -> bool;
+
+/**
+ * Read every page of a file and check its checksum, the file should be
+ * closed meanwhile. A page of a compressed file which doesn't decompress is
+ * damaged as well.
+ * @return the ids of the damaged pages
+ */
+auto VerifyFile(const std::string &file_name) -> std::vector<page_id_t>;
+}  // namespace spdb
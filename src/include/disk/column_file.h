@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/tuple.h"
+
+namespace spdb {
+/**
+ * A column file holds the rows of a table for export and import, with the
+ * cloums it needs to read them. The rows are cut into blocks of about
+ * COLUMN_BLOCK_SIZE bytes, a block stores the values of every cloum apart,
+ * each compressed with LZ4 unless that doesn't make them smaller, together
+ * with their min and max, so a reader may pass over a block without
+ * decompressing it.
+ *
+ * File format:
+ *  ---------------------------------------------------------------------
+ * | MAGIC (8) | CloumNums (4) | CLOUM(1) | ... | CLOUM(n) | KeyNums (4) |
+ *  ---------------------------------------------------------------------
+ * | KeyNameLength (2) | KeyName | ... | BLOCK(1) | ... | BLOCK(m) |
+ *  ---------------------------------------------------------------------
+ * | 0 (4) | RowNums (8) |
+ *  ---------------------------------------------------------------------
+ *  CLOUM:
+ *  ---------------------------------------------------------------------
+ * | Type (1) | Size (4) | NameLength (2) | Name |
+ *  ---------------------------------------------------------------------
+ *  BLOCK:
+ *  ---------------------------------------------------------------------
+ * | BlockRowNums (4) | CHUNK(1) | ... | CHUNK(n) |
+ *  ---------------------------------------------------------------------
+ *  CHUNK, the values of a cloum in the block:
+ *  ---------------------------------------------------------------------
+ * | Min (Size) | Max (Size) | StoredSize (4) | Checksum (4) | Data |
+ *  ---------------------------------------------------------------------
+ * Data is stored as it is if StoredSize is BlockRowNums * Size, the
+ * checksum is the CRC32C of Data.
+ */
+class ColumnFileWriter {
+ public:
+  /**
+   * @param cols the cloums of the rows
+   * @param key_names the cloums of the key of the table
+   * @throws std::runtime_error if the file can't be created
+   */
+  ColumnFileWriter(const std::string &file_name,
+                   const std::vector<Cloum> &cols,
+                   const std::vector<std::string> &key_names);
+
+  ColumnFileWriter(const ColumnFileWriter &) = delete;
+  auto operator=(const ColumnFileWriter &) -> ColumnFileWriter & = delete;
+
+  void Append(const Tuple &row);
+
+  /**
+   * Write the last block and the end of the file.
+   * @return the number of rows written
+   * @throws std::runtime_error if the file can't be written
+   */
+  auto Finish() -> size_t;
+
+ private:
+  void WriteBlock();
+
+  std::ofstream file_;
+  std::vector<Cloum> cols_;
+  size_t block_capacity_;
+  // the values of every cloum in the block being filled
+  std::vector<std::string> chunks_;
+  size_t block_rows_{0};
+  size_t rows_{0};
+  std::string compressed_;
+};
+
+class ColumnFileReader {
+ public:
+  /** @throws std::runtime_error if the file can't be read or isn't one */
+  explicit ColumnFileReader(const std::string &file_name);
+
+  ColumnFileReader(const ColumnFileReader &) = delete;
+  auto operator=(const ColumnFileReader &) -> ColumnFileReader & = delete;
+
+  auto GetCloums() const -> const std::vector<Cloum> & { return cols_; }
+
+  auto GetKeyNames() const -> const std::vector<std::string> & {
+    return key_names_;
+  }
+
+  /**
+   * Move to the next block, reading its min and max only; its values are
+   * read by the first Next for a row of it.
+   * @return false at the end of the file
+   * @throws std::runtime_error if the file is damaged
+   */
+  auto NextBlock() -> bool;
+
+  auto GetBlockRowCount() const -> size_t { return block_rows_; }
+
+  /** The min of a cloum in the block, a value of the cloum. */
+  auto GetBlockMin(size_t index) const -> const char * {
+    return chunks_[index].min_.data();
+  }
+
+  auto GetBlockMax(size_t index) const -> const char * {
+    return chunks_[index].max_.data();
+  }
+
+  /**
+   * Read the next row, from the next block once the rows of one are read.
+   * @return false at the end of the file
+   * @throws std::runtime_error if the file is damaged
+   */
+  auto Next(Tuple *row) -> bool;
+
+ private:
+  struct Chunk {
+    std::string min_;
+    std::string max_;
+    uint32_t stored_size_;
+    uint32_t checksum_;
+    std::streamoff offset_;
+    std::string values_;
+  };
+
+  // Decompress the values of the block.
+  void LoadBlock();
+
+  std::ifstream file_;
+  std::vector<Cloum> cols_;
+  std::vector<std::string> key_names_;
+  size_t row_size_{0};
+  std::vector<Chunk> chunks_;
+  size_t block_rows_{0};
+  // the next row of the block, valid once the block is loaded
+  size_t block_index_{0};
+  bool is_loaded_{true};
+  bool is_end_{false};
+  std::string stored_;
+  std::string row_;
+};
+}  // namespace spdb
@@ -1,26 +1,115 @@
 #pragma once
 
 #include <fstream>
+#include <map>
 #include <mutex>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "config/config.h"
 namespace spdb {
+/**
+ * DiskManager reads and writes the pages of a file, in one of two storage
+ * modes. A plain file holds page i at offset i * PAGE_SIZE.
+ *
+ * A compressed file holds each page LZ4-compressed in an extent of
+ * COMPRESSED_EXTENT_SIZE units, a page which doesn't compress is kept in
+ * an extent of PAGE_SIZE. A page rewritten in place when it still fits,
+ * elsewhere otherwise. The file starts with a header unit telling the mode,
+ * and the extent of every page is kept in a map file next to it.
+ *
+ * The map is saved by Sync, written aside and renamed over the old one. An
+ * extent left by its page is only reused once the map not pointing to it
+ * anymore is saved, so after a crash every page is as of the last Sync or
+ * later, as in a plain file.
+ *
+ * Map format:
+ *  -------------------------------------------------
+ * | Magic (8) | PageCount (4) | Checksum (4) | EXTENTS |
+ *  -------------------------------------------------
+ * the checksum is the CRC32C of the extents, the first unit and the unit
+ * count of each page.
+ */
 class DiskManager {
  private:
+  struct Extent {
+    uint32_t unit_;
+    uint32_t units_;
+  };
+
   std::fstream db_file_;
   std::string db_name_;
   std::mutex latch_;
 
+  bool is_compressed_{false};
+  /** The extent of every page of a compressed file. */
+  std::vector<Extent> extents_;
+  /** The free extents by first unit, and by size then first unit. */
+  std::map<uint32_t, uint32_t> free_by_unit_;
+  std::set<std::pair<uint32_t, uint32_t>> free_by_size_;
+  /** The extents left since the map was last saved. */
+  std::vector<Extent> pending_free_;
+  /** The units in use, up to the last extent. */
+  uint32_t end_unit_{1};
+  /** True if the map changed since it was saved. */
+  bool is_map_changed_{false};
+
+  auto GetRawFileSize() -> size_t;
+
+  void LoadMap();
+  void SaveMap();
+  auto Allocate(uint32_t units) -> uint32_t;
+  void Free(Extent extent);
+  void WriteExtent(uint32_t unit, const char* data, size_t size);
+  void ReadCompressedPage(page_id_t id, char* data);
+  void WriteCompressedPage(page_id_t id, char* data);
+  void SyncCompressed();
+
  public:
-  DiskManager(const std::string& name);
+  /**
+   * Open a file, or create it empty.
+   * @param is_compressed the mode of a new file, an existing one keeps the
+   * mode it is written in
+   */
+  DiskManager(const std::string& name, bool is_compressed = false);
+
+  ~DiskManager();
 
   void ReadPage(page_id_t id, char* data);
 
   void WritePage(page_id_t id, char* data);
 
+  /** The size of the pages, as they are uncompressed. */
   auto GetFileSize() -> size_t;
 
+  auto GetFileName() -> const std::string& { return db_name_; }
+
+  auto IsCompressed() const -> bool { return is_compressed_; }
+
+  /** Force the pages written so far to the disk. */
+  void Sync();
+
+  /** Cut the file down to its first page_count pages. */
+  void Truncate(page_id_t page_count);
+
   void ShutDown();
+
+  /** @return the map file of a compressed file */
+  static auto MapFileName(const std::string& name) -> std::string;
+
+  /** @return true if a file is stored compressed */
+  static auto IsCompressedFile(const std::string& name) -> bool;
+
+  /** @return the bytes a file takes on the disk, with its map */
+  static auto GetDiskSize(const std::string& name) -> size_t;
+
+  /**
+   * Rewrite a closed file in the compressed mode or back. The new file is
+   * written aside and renamed over the old one, so a crash leaves either
+   * of them.
+   */
+  static void Convert(const std::string& name, bool is_compressed);
 };
-}  // namespace spdb
\ No newline at end of file
+}  // namespace spdb
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include "config/config.h"
+#include "disk/disk_manager.h"
+
+namespace spdb {
+/**
+ * FreePageMap keeps the free pages of a data file across restarts, in a
+ * bitmap of one bit per page of the data file. The bitmap is a chain of
+ * pages in a file next to the data file, so the page ids and the frames of
+ * the data file are left alone.
+ *
+ * The map is saved when the data file is closed. Before the free pages
+ * change afterwards, the saved map is marked stale on the disk, so after a
+ * crash it isn't trusted and the free pages are only leaked until a vacuum
+ * finds them again.
+ *
+ * Page format:
+ *  ------------------------------------------------------------------
+ * | NextPageId (4) | PageCount (4) | IsClean (4) | Reserved (4) | BITS |
+ *  ------------------------------------------------------------------
+ * PageCount and IsClean are only read from the first page of the chain,
+ * the bit of page i of the data file is in the (i / FREE_PAGE_MAP_BITS)th
+ * page of the chain.
+ */
+class FreePageMap {
+ public:
+  /** @param file_name the data file */
+  explicit FreePageMap(const std::string &file_name);
+
+  ~FreePageMap();
+
+  FreePageMap(const FreePageMap &) = delete;
+  auto operator=(const FreePageMap &) -> FreePageMap & = delete;
+
+  /** @return the file of the map of a data file */
+  static auto FileName(const std::string &file_name) -> std::string;
+
+  /**
+   * Read the free pages saved.
+   * @param page_count the pages of the data file now
+   * @return false if the map is missing, stale or of another data file
+   */
+  auto Load(page_id_t page_count, std::set<page_id_t> *free_pages) -> bool;
+
+  /** Mark the saved map stale, durably, before the free pages change. */
+  void Invalidate();
+
+  /** Save the free pages of a data file of page_count pages. */
+  void Save(page_id_t page_count, const std::set<page_id_t> &free_pages);
+
+  /** @return true if a map is saved and not stale */
+  auto IsClean() const -> bool { return is_clean_; }
+
+ private:
+  struct Header {
+    page_id_t next_page_id_;
+    page_id_t page_count_;
+    uint32_t is_clean_;
+    uint32_t reserved_;
+  };
+
+  // The map file, opened on first use so a data file without free pages
+  // gets none.
+  auto GetDisk() -> DiskManager *;
+
+  std::string file_name_;
+  std::unique_ptr<DiskManager> disk_;
+  bool is_clean_{false};
+};
+}  // namespace spdb
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+namespace spdb {
+/**
+ * Compress size bytes into an LZ4 block, in the block format of the LZ4
+ * library, so the blocks are readable by its LZ4_decompress_safe as well.
+ * @return the size of the block, or 0 if it would take more than capacity
+ */
+auto Lz4Compress(const char *src, size_t size, char *dst, size_t capacity)
+    -> size_t;
+
+/**
+ * Decompress an LZ4 block of size bytes uncompressed. The block is read up
+ * to the byte completing them, so it may be followed by anything.
+ * @param capacity the bytes of src which may be read
+ * @return false if the block is damaged
+ */
+auto Lz4Decompress(const char *src, size_t capacity, char *dst, size_t size)
+    -> bool;
+}  // namespace spdb
@@ -2,6 +2,7 @@
 
 #include <memory.h>
 
+#include <atomic>
 #include <shared_mutex>
 
 #include "config/config.h"
@@ -9,13 +10,17 @@
 namespace spdb {
 
 class Page {
+  friend class BufferPool;
   friend class BufferPoolManager;
 
  private:
+  file_id_t file_id_{-1};
   page_id_t page_id_{INVALID_PAGE_ID};
   int pin_count_{0};
   char *data_;
   bool is_dirty_{false};
+  /** The first log record which dirtied the page since it was read. */
+  std::atomic<lsn_t> rec_lsn_{INVALID_LSN};
   std::shared_mutex latch_;
 
  public:
@@ -35,6 +40,14 @@ class Page {
 
   auto GetPageId() -> page_id_t;
 
+  /**
+   * The LSN of the last log record that modified the page, stored in the
+   * first bytes of the page data.
+   */
+  auto GetLSN() -> lsn_t;
+
+  void SetLSN(lsn_t lsn);
+
   void ResetMemory();
 
   bool IsDirty();
@@ -45,6 +58,8 @@ class Page {
 
   void RLatch();
 
+  auto TryRLatch() -> bool;
+
   void WLatch();
 };
 
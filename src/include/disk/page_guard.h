@@ -1,4 +1,6 @@
 #pragma once
+#include <memory>
+
 #include "config/config.h"
 #include "disk/page.h"
 namespace spdb {
@@ -66,10 +68,12 @@ class BasicPageGuard {
     return reinterpret_cast<const T *>(GetData());
   }
 
-  auto GetDataMut() -> char * {
-    is_dirty_ = true;
-    return page_->GetData();
-  }
+  /**
+   * @brief Get the page to modify it. When the buffer pool is logging, the
+   * page is copied on the first call, and the modification is logged against
+   * the copy when the guard is dropped.
+   */
+  auto GetDataMut() -> char *;
 
   template <class T>
   auto AsMut() -> T * {
@@ -80,9 +84,15 @@ class BasicPageGuard {
   friend class ReadPageGuard;
   friend class WritePageGuard;
 
+  // Drop the guard, is_latched tells the page is write latched by the
+  // caller, so it is written back as it is.
+  void Drop(bool is_latched);
+
   BufferPoolManager *bpm_{nullptr};
   Page *page_{nullptr};
   bool is_dirty_{false};
+  /** The page before the modification, only kept when logging. */
+  std::unique_ptr<char[]> before_image_;
 };
 
 class ReadPageGuard {
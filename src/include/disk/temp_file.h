@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/disk_manager.h"
+#include "disk/tuple.h"
+
+namespace spdb {
+/**
+ * TempFile keeps a sequence of fixed-size tuples in the pages of a scratch
+ * file, which is removed when the TempFile is destroyed. Executors use it to
+ * spill data that doesn't fit in their memory budget.
+ *
+ * Tuples are appended first, then read back in the same order after Rewind().
+ *
+ * Page format:
+ *  ----------------------------------------------------------------
+ * | TupleNums (4) | TUPLE(1) | TUPLE(2) | ... | TUPLE(n) |
+ *  ----------------------------------------------------------------
+ */
+class TempFile {
+ public:
+  explicit TempFile(const std::vector<Cloum> &cols);
+
+  ~TempFile();
+
+  TempFile(const TempFile &) = delete;
+  auto operator=(const TempFile &) -> TempFile & = delete;
+
+  void Append(const Tuple &tuple);
+
+  // Write out the last page and start reading from the first tuple.
+  void Rewind();
+
+  auto Next(Tuple *tuple) -> bool;
+
+  auto Size() const -> size_t { return size_; }
+
+ private:
+  std::string name_;
+  DiskManager *disk_;
+  std::vector<Cloum> cols_;
+  size_t tuple_size_{0};
+  int tuples_per_page_;
+  char *page_;
+  page_id_t write_pid_{0};
+  page_id_t read_pid_{0};
+  int read_index_{0};
+  size_t size_{0};
+  bool is_reading_{false};
+};
+}  // namespace spdb
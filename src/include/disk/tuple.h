@@ -23,9 +23,14 @@ class Tuple {
   void SetRid(RID&);
   auto GetRid() const -> RID;
   auto GetValueAt(int) const -> char*;
+  auto GetValuePtrAt(int) const -> const char*;
+  auto GetCloums() const -> const std::vector<Cloum>&;
 
   auto GetData() const -> const char*;
 
+  // Build a tuple of cols, each cloum is taken from the one with the same name
+  auto Project(const std::vector<Cloum>& cols) const -> Tuple;
+
   template <class T>
   auto GetValueAtAs(int index) const -> T* {
     auto src = GetValueAt(index);
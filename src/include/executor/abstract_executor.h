@@ -14,6 +14,22 @@ class AbstractExecutor {
 
   virtual auto GetOutputCols() -> std::vector<Cloum> = 0;
 
+  /**
+   * Pass over the next n tuples, as for an offset. A scan may skip them
+   * without reading them one by one.
+   * @return the number of tuples passed over, less than n at the end
+   */
+  virtual auto Skip(size_t n) -> size_t {
+    auto cols = GetOutputCols();
+    Tuple tuple(cols);
+    RID rid{};
+    size_t count = 0;
+    while (count < n && Next(&tuple, &rid)) {
+      ++count;
+    }
+    return count;
+  }
+
  private:
   Catalog *catalog_;
 };
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "disk/temp_file.h"
+#include "executor/parallel_seq_scan_executor.h"
+#include "executor/seq_scan_executor.h"
+namespace spdb {
+
+enum class AggregationType { COUNT, SUM, MIN, MAX, AVG };
+
+struct AggregateSpec {
+  AggregationType type_;
+  // the input cloum, -1 for COUNT(*)
+  int col_;
+  // the name of the output cloum
+  std::string name_;
+};
+
+/**
+ * The AggregationExecutor groups the tuples of its child on the group by
+ * cloums and computes the aggregates of every group. The output tuple is the
+ * group by cloums followed by one cloum per aggregate.
+ *
+ * Groups live in an open-addressing hash table. Input is processed in
+ * batches: the group of every tuple in the batch is looked up first, then each
+ * accumulator is updated in a tight loop over the batch.
+ *
+ * Once the groups grow over the memory budget no new group is added, tuples
+ * of unknown groups are spilled into temp files partitioned by the hash of
+ * their group, and each partition is aggregated after the groups in memory
+ * are returned.
+ *
+ * If the child is a parallel scan, every worker of the scheduler aggregates
+ * the morsels it runs into groups of its own, each with a share of the
+ * budget, and the groups of the workers are merged once the scan finishes.
+ * The tuples a worker spilled are aggregated again while merging.
+ *
+ * Without group by cloums, if the child is a sequential scan and the
+ * aggregates read one cloum, only the values of that cloum are read from
+ * each leaf, straight from the cloum of a Pax leaf.
+ *
+ * SUM and AVG only apply to int cloums, AVG is truncated like an integer
+ * division. Without group by cloums there is always one output tuple.
+ */
+class AggregationExecutor : public AbstractExecutor {
+ public:
+  AggregationExecutor(Catalog *catalog,
+                      std::unique_ptr<AbstractExecutor> child,
+                      std::vector<int> group_by,
+                      std::vector<AggregateSpec> aggregates,
+                      size_t memory_budget = EXECUTOR_MEMORY_BUDGET);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  // the groups of a worker aggregating the morsels of a parallel scan
+  AggregationExecutor(const AggregationExecutor &parent, size_t memory_budget);
+
+  void AggregateMorsels(ParallelSeqScanExecutor *scan);
+
+  // add the groups of a worker
+  void Merge(AggregationExecutor *partial);
+
+  // aggregate the tuples returned by next, spilling the ones of new groups
+  // if spill is true and the table is full
+  template <class NextFunc>
+  void Aggregate(NextFunc &&next, bool spill);
+
+  // aggregate the values of the cloum the aggregates read, leaf by leaf
+  void AggregateCloum(SeqScanExecutor *scan);
+
+  // update the accumulators with rows at batch, stride bytes apart, with
+  // the cloums at offsets in each
+  void UpdateBatch(const char *batch, size_t rows, size_t stride,
+                   const std::vector<size_t> &offsets);
+
+  // @return the group of the key, or -1 if it is new and there is no room
+  auto FindOrInsert(const std::string &key, size_t hash, const char *tuple,
+                    bool can_grow) -> int;
+
+  void Clear();
+
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  // the child if it is a parallel scan
+  ParallelSeqScanExecutor *parallel_child_{nullptr};
+  // the child if it is a sequential scan read a cloum at a time
+  SeqScanExecutor *cloum_child_{nullptr};
+  // the cloum the aggregates read
+  int cloum_{0};
+  std::vector<Cloum> child_cols_;
+  std::vector<size_t> child_offsets_;
+  size_t tuple_size_{0};
+  std::vector<int> group_by_;
+  std::vector<AggregateSpec> aggregates_;
+  std::vector<Cloum> output_cols_;
+  size_t memory_budget_;
+
+  // open-addressing hash table, slots hold a group index or -1
+  std::vector<int> slots_;
+  std::vector<std::string> keys_;
+  std::vector<size_t> hashes_;
+  // the group by values of each group
+  std::vector<char> group_values_;
+  size_t group_size_{0};
+  std::vector<int64_t> counts_;
+  // one accumulator per aggregate, ints for SUM/AVG, raw values for MIN/MAX
+  std::vector<std::vector<int64_t>> sums_;
+  std::vector<std::vector<char>> values_;
+  size_t used_{0};
+
+  // the current batch of input tuples and their groups
+  std::vector<char> batch_;
+  std::vector<int> batch_groups_;
+
+  std::vector<std::unique_ptr<TempFile>> partitions_;
+  size_t partition_{0};
+  bool is_built_{false};
+  size_t emit_index_{0};
+};
+}  // namespace spdb
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "concurrency/transaction_manager.h"
+namespace spdb {
+
+/**
+ * The DeleteExecutor deletes the rows its child returns from a table, in the
+ * transaction of the calling thread. The child is drained before the first
+ * row is deleted, so a scan of the same table doesn't come across the
+ * writes. It returns one tuple, the number of rows deleted.
+ */
+class DeleteExecutor : public AbstractExecutor {
+ public:
+  DeleteExecutor(Catalog *catalog, const std::string &table_name,
+                 std::unique_ptr<AbstractExecutor> child);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  TransactionManager *txn_manager_;
+  TableInfo table_info_;
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  bool is_done_{false};
+};
+}  // namespace spdb
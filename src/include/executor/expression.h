@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "SQLParser.h"
+#include "config/config.h"
+#include "disk/tuple.h"
+
+namespace spdb {
+/**
+ * @return the index of the cloum called name in cols, or -1 if there is no
+ * such cloum. A qualified name "table.cloum" also matches a plain "cloum".
+ */
+auto GetIndexByName(std::string name, std::vector<Cloum> cols) -> int;
+
+/**
+ * The name of the output cloum computed for a select list item, aggregates
+ * are named like "COUNT(*)" or "SUM(val)".
+ */
+auto ExprName(const hsql::Expr *expr) -> std::string;
+
+/**
+ * @return the index of the cloum that a kExprColumnRef refers to, or -1.
+ * An aggregate kExprFunctionRef refers to the cloum named after it.
+ */
+auto ResolveColumn(const hsql::Expr *expr, const std::vector<Cloum> &cols)
+    -> int;
+
+/**
+ * Prefix the cloum names with the table name, names that are already
+ * qualified are kept.
+ */
+auto QualifyCols(const std::vector<Cloum> &cols, const std::string &table_name)
+    -> std::vector<Cloum>;
+
+/**
+ * Compare a raw cloum value with a literal expression.
+ * @return <0, 0 or >0 like strcmp
+ */
+auto CompareLiteral(const char *src, const Cloum &col,
+                    const hsql::Expr *literal) -> int;
+
+/**
+ * Compare two raw values of the same cloum type.
+ */
+auto CompareValue(const char *a, const char *b, const Cloum &col) -> int;
+
+/**
+ * Compare two raw values of the same cloum type, the sizes of char cloums may
+ * be different.
+ */
+auto CompareCloums(const char *a, const Cloum &col_a, const char *b,
+                   const Cloum &col_b) -> int;
+
+/**
+ * Encode the given cloums of a tuple into bytes that are equal exactly when
+ * the values are equal, char values are cut at their terminating '\0' so
+ * cloums of different sizes can be matched. Used as a hash key.
+ */
+auto EncodeKey(const Tuple &tuple, const std::vector<int> &indexes)
+    -> std::string;
+
+/**
+ * Write a literal expression into dst in the on-disk format of col.
+ */
+void WriteLiteral(char *dst, const Cloum &col, const hsql::Expr *literal);
+
+/**
+ * Check whether a literal expression can be stored in col.
+ */
+auto IsLiteralOf(const hsql::Expr *literal, const Cloum &col) -> bool;
+
+/**
+ * Evaluate a where clause against a tuple laid out as cols.
+ */
+auto EvaluatePredicate(const hsql::Expr *expr, const Tuple &tuple,
+                       const std::vector<Cloum> &cols) -> bool;
+}  // namespace spdb
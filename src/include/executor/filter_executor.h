@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "abstract_executor.h"
+namespace spdb {
+
+/**
+ * The FilterExecutor passes on the tuples of its child that satisfy a
+ * predicate, it is used where no scan can check the where clause itself.
+ */
+class FilterExecutor : public AbstractExecutor {
+ public:
+  FilterExecutor(Catalog *catalog, std::unique_ptr<AbstractExecutor> child,
+                 const hsql::Expr *predicate);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  std::vector<Cloum> cols_;
+  const hsql::Expr *predicate_;
+};
+}  // namespace spdb
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "disk/temp_file.h"
+namespace spdb {
+
+/**
+ * The HashJoinExecutor executes an equi-join. The build side is loaded into a
+ * hash table keyed on the join cloums and the other side probes it.
+ *
+ * If the build side grows over the memory budget, both sides are partitioned
+ * by the hash of their join key into temp files and the partitions are joined
+ * pair by pair, so only one build partition is held in memory at a time.
+ *
+ * The output tuple is always the left tuple followed by the right one, with
+ * cloum names qualified by their table.
+ */
+class HashJoinExecutor : public AbstractExecutor {
+ public:
+  HashJoinExecutor(Catalog *catalog, std::unique_ptr<AbstractExecutor> left,
+                   const std::string &left_name,
+                   std::unique_ptr<AbstractExecutor> right,
+                   const std::string &right_name, std::vector<int> left_keys,
+                   std::vector<int> right_keys, const hsql::Expr *predicate,
+                   bool build_left,
+                   size_t memory_budget = EXECUTOR_MEMORY_BUDGET);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  void Build();
+
+  // get the next tuple of the probe side, moving to the next partition pair
+  // if the current one is exhausted
+  auto NextProbe(Tuple *tuple) -> bool;
+
+  void LoadPartition(size_t partition);
+
+  auto Combine(const Tuple &left, const Tuple &right) -> Tuple;
+
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+  std::vector<Cloum> left_cols_;
+  std::vector<Cloum> right_cols_;
+  std::vector<Cloum> output_cols_;
+  std::vector<int> left_keys_;
+  std::vector<int> right_keys_;
+  const hsql::Expr *predicate_;
+  bool build_left_;
+  size_t memory_budget_;
+
+  bool is_built_{false};
+  std::unordered_multimap<std::string, Tuple> hash_table_;
+  std::deque<Tuple> results_;
+
+  // partitions of the build and the probe side once spilled
+  std::vector<std::unique_ptr<TempFile>> build_partitions_;
+  std::vector<std::unique_ptr<TempFile>> probe_partitions_;
+  size_t partition_{0};
+};
+}  // namespace spdb
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "concurrency/transaction_manager.h"
+namespace spdb {
+
+/**
+ * The range of keys an IndexScanExecutor has to visit. The first eq_.size()
+ * key cloums are fixed by equality predicates, the next key cloum may be
+ * bounded by lower_ and upper_. All bounds are literal expressions.
+ */
+struct KeyRange {
+  std::vector<const hsql::Expr *> eq_;
+  const hsql::Expr *lower_{nullptr};
+  bool lower_inclusive_{true};
+  const hsql::Expr *upper_{nullptr};
+  bool upper_inclusive_{true};
+
+  auto IsPoint(size_t key_nums) const -> bool { return eq_.size() == key_nums; }
+};
+
+/**
+ * The IndexScanExecutor answers a key range with a point lookup or a range
+ * probe on the B+ tree of the table, the rest of the where clause is checked
+ * on each tuple it visits. If a secondary index is given, the range is probed
+ * on the index and every hit is looked up in the table by its key. The rows
+ * deleted since the snapshot, or moved in the index, are taken from the
+ * versions: in key order on the table, after the hits on an index.
+ */
+class IndexScanExecutor : public AbstractExecutor {
+ public:
+  IndexScanExecutor(Catalog *catalog, const hsql::SQLStatement *,
+                    KeyRange range, const IndexInfo *index = nullptr);
+
+  IndexScanExecutor(Catalog *catalog, const std::string &table_name,
+                    const hsql::Expr *predicate, KeyRange range,
+                    const IndexInfo *index = nullptr);
+
+  ~IndexScanExecutor();
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  // check whether key is still inside range_, set is_end_ if it is past it
+  auto InRange(const Tuple &key) -> bool;
+
+  // the next row of the range on the table
+  auto NextInTable(Tuple *tuple, RID *rid) -> bool;
+
+  // the next row of the range on the index
+  auto NextInIndex(Tuple *tuple, RID *rid) -> bool;
+
+  TableInfo table_info_;
+  KeyRange range_;
+  // key type of the scanned tree, the table key or the index key
+  std::vector<Cloum> key_type_;
+  const hsql::Expr *predicate_;
+  StatementSnapshot snapshot_;
+  Iterator table_iterator_;
+  std::unique_ptr<Tuple> point_result_;
+  bool is_end_{false};
+  std::unique_ptr<BPlusTree> table_;
+  bool is_index_scan_{false};
+  // the smallest key inside the range
+  std::unique_ptr<Tuple> low_key_;
+  // the key of the last row returned from the table, low_key_ until then
+  std::unique_ptr<Tuple> last_key_;
+  bool has_last_key_{false};
+  std::unique_ptr<Tuple> displaced_key_;
+  // the table keys of the rows returned from the index
+  std::unordered_set<std::string> returned_;
+};
+}  // namespace spdb
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "abstract_executor.h"
+namespace spdb {
+
+/**
+ * The LimitExecutor passes on at most limit tuples of its child after
+ * skipping the first offset ones. The child isn't asked for a tuple more
+ * than it takes, so a scan below stops once the limit is reached, and the
+ * offset is skipped by the child itself, a scan passing over whole leaves.
+ */
+class LimitExecutor : public AbstractExecutor {
+ public:
+  LimitExecutor(Catalog *catalog, std::unique_ptr<AbstractExecutor> child,
+                size_t limit, size_t offset);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  std::vector<Cloum> cols_;
+  size_t limit_;
+  size_t offset_;
+  size_t count_{0};
+};
+}  // namespace spdb
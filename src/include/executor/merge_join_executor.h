@@ -0,0 +1,58 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "abstract_executor.h"
+namespace spdb {
+
+/**
+ * The MergeJoinExecutor executes an equi-join of two children that are
+ * already ordered on their join cloums, e.g. sequential scans of tables whose
+ * key starts with the join cloum. Both sides are read only once and only the
+ * right tuples sharing the current key are buffered.
+ *
+ * The output tuple is the left tuple followed by the right one, with cloum
+ * names qualified by their table.
+ */
+class MergeJoinExecutor : public AbstractExecutor {
+ public:
+  MergeJoinExecutor(Catalog *catalog, std::unique_ptr<AbstractExecutor> left,
+                    const std::string &left_name,
+                    std::unique_ptr<AbstractExecutor> right,
+                    const std::string &right_name, std::vector<int> left_keys,
+                    std::vector<int> right_keys, const hsql::Expr *predicate);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  // compare the join key of a left tuple with the one of a right tuple
+  auto CompareKeys(const Tuple &left, const Tuple &right) -> int;
+
+  void AdvanceLeft();
+
+  void AdvanceRight();
+
+  std::unique_ptr<AbstractExecutor> left_executor_;
+  std::unique_ptr<AbstractExecutor> right_executor_;
+  std::vector<Cloum> left_cols_;
+  std::vector<Cloum> right_cols_;
+  std::vector<Cloum> output_cols_;
+  std::vector<int> left_keys_;
+  std::vector<int> right_keys_;
+  const hsql::Expr *predicate_;
+
+  std::unique_ptr<Tuple> left_tuple_;
+  std::unique_ptr<Tuple> right_tuple_;
+  bool has_left_{false};
+  bool has_right_{false};
+  bool is_started_{false};
+  // right tuples with the same key
+  std::vector<Tuple> group_;
+  std::deque<Tuple> results_;
+};
+}  // namespace spdb
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "executor/seq_scan_executor.h"
+#include "executor/task_scheduler.h"
+namespace spdb {
+
+/**
+ * The ParallelSeqScanExecutor scans a table with the workers of the task
+ * scheduler. The key space is split at the separators of the upper levels of
+ * the tree into morsels, a few leaves each, many more than the workers. Each
+ * morsel is a task scanning it with a SeqScanExecutor of its own, all of
+ * them as of the snapshot of the statement, and the workers done early steal
+ * the morsels left.
+ *
+ * The tuples are gathered by an exchange: the tasks hand them over in
+ * batches through a bounded queue, and Next takes them out one by one. The
+ * tuples come in no particular order, and without their rids. The tasks are
+ * started by the first call to Next.
+ */
+class ParallelSeqScanExecutor : public AbstractExecutor {
+ public:
+  ParallelSeqScanExecutor(Catalog *catalog, const std::string &table_name,
+                          const hsql::Expr *predicate, size_t worker_nums,
+                          TaskScheduler *scheduler = TaskScheduler::Global());
+
+  ~ParallelSeqScanExecutor();
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+  auto GetMorselCount() const -> size_t { return morsels_.size(); }
+
+  auto GetScheduler() const -> TaskScheduler * { return scheduler_; }
+
+  /**
+   * Run task on the scan of every morsel, as tasks of the scheduler, instead
+   * of gathering the tuples with Next. The morsels run on the same worker
+   * one after another.
+   * @throws the first exception a task threw, once all of them finished
+   */
+  void ForEachMorsel(const std::function<void(AbstractExecutor *)> &task);
+
+ private:
+  void Scan(size_t morsel);
+
+  // @return false if the scan is stopped
+  auto Push(std::vector<char> batch) -> bool;
+
+  TableInfo table_info_;
+  size_t tuple_size_{0};
+  TaskScheduler *scheduler_;
+  StatementSnapshot snapshot_;
+  std::vector<std::unique_ptr<SeqScanExecutor>> morsels_;
+
+  std::mutex latch_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<std::vector<char>> batches_;
+  // the morsels not scanned yet
+  size_t running_{0};
+  std::atomic<bool> is_stopped_{false};
+  std::exception_ptr error_;
+  bool is_started_{false};
+  TaskGroup tasks_;
+
+  // the batch Next takes the tuples from
+  std::vector<char> batch_;
+  size_t batch_offset_{0};
+};
+}  // namespace spdb
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "abstract_executor.h"
+#include "index_scan_executor.h"
+
+namespace spdb {
+/**
+ * Find the range of a B+ tree key that a where clause restricts the table to.
+ * Only conjuncts comparing a key cloum with a literal are used: equality on a
+ * prefix of the key, optionally followed by a range on the next key cloum.
+ * @return std::nullopt if the where clause does not bound the key
+ */
+auto ExtractKeyRange(const hsql::Expr *where,
+                     const std::vector<Cloum> &key_type)
+    -> std::optional<KeyRange>;
+
+/**
+ * Pick the access path of the table a select statement reads from: an index
+ * scan on the table key if the where clause bounds it, then an index scan on
+ * a secondary index, preferring equality over range predicates, and a
+ * sequential scan otherwise. A large table is scanned in parallel by the
+ * task scheduler when the rows are grouped or sorted above the scan anyway.
+ */
+auto PlanScan(Catalog *catalog, const hsql::SelectStatement *select)
+    -> std::unique_ptr<AbstractExecutor>;
+
+/**
+ * Pick the access path of the rows of a table a where clause selects, as
+ * for a select statement, for the statements writing them.
+ */
+auto PlanScan(Catalog *catalog, const std::string &table_name,
+              const hsql::Expr *where) -> std::unique_ptr<AbstractExecutor>;
+
+/**
+ * Plan the from clause and the where clause of a select statement. A single
+ * table goes through PlanScan, inner joins are planned as a merge join when
+ * both sides are scans ordered on the join cloum, and as a hash join building
+ * on the smaller side otherwise, read by a parallel scan if it is large. The
+ * where clause of a join is checked by a filter on top of it.
+ */
+auto PlanFrom(Catalog *catalog, const hsql::SelectStatement *select)
+    -> std::unique_ptr<AbstractExecutor>;
+
+/**
+ * Put an aggregation on top of child if the select statement has aggregates
+ * or a group by clause, and a filter for its having clause. Plain cloums in
+ * the select list must appear in the group by clause.
+ * @return child itself if there is nothing to aggregate
+ */
+auto PlanAggregation(Catalog *catalog, const hsql::SelectStatement *select,
+                     std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor>;
+
+/**
+ * Put a sort on top of child for the order by clause. With a limit clause
+ * only the first limit + offset tuples are kept.
+ * @return child itself if there is no order by clause
+ */
+auto PlanSort(Catalog *catalog, const hsql::SelectStatement *select,
+              std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor>;
+
+/**
+ * Put a limit on top of child for the limit clause, so the executors below
+ * stop once it is reached, and skip the offset.
+ * @return child itself if there is no limit clause
+ */
+auto PlanLimit(Catalog *catalog, const hsql::SelectStatement *select,
+               std::unique_ptr<AbstractExecutor> child)
+    -> std::unique_ptr<AbstractExecutor>;
+}  // namespace spdb
@@ -23,6 +23,6 @@ class ProjectionExecutor : public AbstractExecutor {
   std::vector<Cloum> tuple_cloums_;
   size_t tuple_size_;
   std::deque<int> unname_var_;
-  TableInfo table_info_;
+  std::vector<Cloum> child_cols_;
 };
 }  // namespace spdb
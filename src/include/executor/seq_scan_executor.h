@@ -1,28 +1,67 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "abstract_executor.h"
+#include "concurrency/transaction_manager.h"
 namespace spdb {
 
 /**
- * The SeqScanExecutor executor executes a sequential table scan.
+ * The SeqScanExecutor executor executes a sequential table scan, tuples that
+ * don't satisfy the where clause are skipped. Rows are read as of the
+ * snapshot of the statement, the ones deleted since are merged in from the
+ * versions, so the tuples still come in key order.
  */
 class SeqScanExecutor : public AbstractExecutor {
  public:
   SeqScanExecutor(Catalog *catalog, const hsql::SQLStatement *);
 
+  SeqScanExecutor(Catalog *catalog, const std::string &table_name,
+                  const hsql::Expr *predicate = nullptr);
+
+  /**
+   * Scan the rows with keys in [low, high) as of the snapshot of another
+   * statement, for a partition of a parallel scan.
+   * @param low nullptr from the first key
+   * @param high nullptr until the last key
+   */
+  SeqScanExecutor(Catalog *catalog, const std::string &table_name,
+                  const hsql::Expr *predicate, const StatementSnapshot *outer,
+                  const Tuple *low, const Tuple *high);
+
   ~SeqScanExecutor();
 
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
   auto GetOutputCols() -> std::vector<Cloum> override;
 
+  /**
+   * Without a where clause, the rest of a leaf is skipped at once while the
+   * snapshot sees the tree as it is, the rows are read one by one otherwise.
+   */
+  auto Skip(size_t n) -> size_t override;
+
+  /**
+   * Read the values of a cloum of the rest of the current leaf at once, as
+   * Skip skips it, instead of the rows one by one.
+   * @param index the cloum in the output cloums
+   * @param[out] values the values, one after another
+   * @return the number of values, 0 if the rows should be read by Next
+   */
+  auto ReadCloum(size_t index, std::vector<char> *values) -> size_t;
+
  private:
   TableInfo table_info_;
+  const hsql::Expr *predicate_;
+  StatementSnapshot snapshot_;
   Iterator table_iterator_;
-  DiskManager *disk_;
-  BufferPoolManager *bpm_;
+  std::unique_ptr<Tuple> low_;
+  std::unique_ptr<Tuple> high_;
+  // the key of the last row returned, from the tree or the versions
+  std::unique_ptr<Tuple> last_key_;
+  bool has_last_key_{false};
+  std::unique_ptr<Tuple> displaced_key_;
 };
 }  // namespace spdb
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "disk/temp_file.h"
+namespace spdb {
+
+struct SortKey {
+  // the cloum of the child to sort on
+  int col_;
+  bool is_desc_{false};
+};
+
+/**
+ * LoserTree picks the smallest head among k sorted sources with log(k)
+ * comparisons per pick. less(a, b) tells whether the head of source a goes
+ * before the head of source b, it is never called on an exhausted source.
+ */
+class LoserTree {
+ public:
+  LoserTree(size_t k, std::function<bool(size_t, size_t)> less);
+
+  // @return the source with the smallest head, or -1 if all are exhausted
+  auto Winner() const -> int;
+
+  // Call after the head of the winner changed.
+  void Replay(bool is_exhausted);
+
+ private:
+  auto Beats(size_t a, size_t b) const -> bool;
+
+  void Adjust(size_t source);
+
+  size_t k_;
+  std::function<bool(size_t, size_t)> less_;
+  // tree_[0] is the winner, tree_[1..k) the losers of the inner nodes
+  std::vector<size_t> tree_;
+  std::vector<bool> is_exhausted_;
+};
+
+/**
+ * The SortExecutor returns the tuples of its child ordered by the sort keys.
+ *
+ * Tuples are sorted in memory on a normalized 8-byte prefix of the first key,
+ * falling back to a full comparison on ties. If they don't fit in the memory
+ * budget, sorted runs are written to temp files and merged with a loser tree.
+ *
+ * With a limit only the first limit tuples are returned, and as long as they
+ * fit in the budget they are kept in a heap instead of sorting everything.
+ */
+class SortExecutor : public AbstractExecutor {
+ public:
+  SortExecutor(Catalog *catalog, std::unique_ptr<AbstractExecutor> child,
+               std::vector<SortKey> keys,
+               size_t limit = std::numeric_limits<size_t>::max(),
+               size_t memory_budget = EXECUTOR_MEMORY_BUDGET);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  void Sort();
+
+  void SortTopN();
+
+  // sort the tuples in memory and write them out as a run
+  void SpillRun();
+
+  // the normalized key prefix, ordered like the tuples as an unsigned integer
+  auto Prefix(const char *tuple) const -> uint64_t;
+
+  auto EntryLess(const std::pair<uint64_t, size_t> &a,
+                 const std::pair<uint64_t, size_t> &b) const -> bool;
+
+  auto CompareTuples(const char *a, const char *b) const -> int;
+
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  std::vector<Cloum> cols_;
+  std::vector<size_t> offsets_;
+  size_t tuple_size_{0};
+  std::vector<SortKey> keys_;
+  size_t limit_;
+  size_t memory_budget_;
+
+  bool is_sorted_{false};
+  size_t emitted_{0};
+
+  // tuples in memory and their (prefix, index) in sorted order
+  std::vector<char> tuples_;
+  std::vector<std::pair<uint64_t, size_t>> entries_;
+  size_t cursor_{0};
+
+  // sorted runs on disk and the head tuple of each
+  std::vector<std::unique_ptr<TempFile>> runs_;
+  std::vector<std::unique_ptr<Tuple>> heads_;
+  std::unique_ptr<LoserTree> loser_tree_;
+};
+}  // namespace spdb
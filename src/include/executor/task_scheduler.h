@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace spdb {
+class TaskGroup;
+
+/**
+ * TaskScheduler runs the tasks of the executors on a fixed pool of workers,
+ * as morsels of work small enough that no worker waits long for the others.
+ *
+ * Every worker has a deque of its own. A task submitted by a worker goes to
+ * the back of its deque, one submitted from outside goes to the workers in
+ * turn. A worker takes its tasks from the back, and once it has none, steals
+ * from the front of the deques of the others, so a worker stuck with a
+ * skewed share is helped by the idle ones.
+ *
+ * If the machine has several NUMA nodes, as listed under
+ * /sys/devices/system/node, the workers are spread over the nodes and pinned
+ * to their cpus, and a worker steals from the workers of its own node before
+ * the others.
+ */
+class TaskScheduler {
+ public:
+  /** @param worker_nums 0 for a worker per core */
+  explicit TaskScheduler(size_t worker_nums);
+
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler &) = delete;
+  auto operator=(const TaskScheduler &) -> TaskScheduler & = delete;
+
+  /** The scheduler shared by the executors, with a worker per core. */
+  static auto Global() -> TaskScheduler *;
+
+  auto GetWorkerCount() const -> size_t { return workers_.size(); }
+
+  /** @return the index of the calling thread among the workers, or -1 */
+  auto GetWorkerIndex() const -> int;
+
+  auto GetNodeCount() const -> size_t { return node_nums_; }
+
+  /** The number of tasks taken from the deque of another worker. */
+  auto GetStealCount() const -> size_t { return steals_; }
+
+ private:
+  friend class TaskGroup;
+
+  struct Task {
+    std::function<void()> function_;
+    TaskGroup *group_{nullptr};
+  };
+
+  struct Worker {
+    std::mutex latch_;
+    std::deque<Task> tasks_;
+    int node_{0};
+    // the workers to steal from, those of the same node first
+    std::vector<size_t> victims_;
+    std::thread thread_;
+  };
+
+  void Submit(Task task);
+
+  // take a task for the worker, from its own deque or another one
+  auto Take(size_t index, Task *task) -> bool;
+
+  // run a task, for a worker or a thread waiting for its group
+  void Run(Task *task);
+
+  void Work(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  size_t node_nums_{1};
+  std::atomic<size_t> next_worker_{0};
+  std::atomic<size_t> steals_{0};
+
+  // the workers without a task sleep until one is queued
+  std::atomic<size_t> queued_{0};
+  std::mutex sleep_latch_;
+  std::condition_variable sleep_cv_;
+  bool is_stopped_{false};
+};
+
+/**
+ * TaskGroup is a set of tasks run by a scheduler, waited for together. A
+ * task may add more tasks to its group.
+ */
+class TaskGroup {
+ public:
+  explicit TaskGroup(TaskScheduler *scheduler) : scheduler_(scheduler) {}
+
+  /** Wait for the tasks left, their exceptions are dropped. */
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup &) = delete;
+  auto operator=(const TaskGroup &) -> TaskGroup & = delete;
+
+  void Run(std::function<void()> function);
+
+  /**
+   * Wait until every task of the group finished. A worker waiting runs
+   * tasks in the meantime.
+   * @throws the first exception a task threw
+   */
+  void Wait();
+
+ private:
+  friend class TaskScheduler;
+
+  void Finish(std::exception_ptr error);
+
+  TaskScheduler *scheduler_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  size_t pending_{0};
+  std::exception_ptr error_;
+};
+}  // namespace spdb
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "abstract_executor.h"
+#include "concurrency/transaction_manager.h"
+namespace spdb {
+
+/**
+ * The UpdateExecutor sets cloums of the rows its child returns to literals,
+ * in the transaction of the calling thread. A row keeping its key is
+ * overwritten in place in its leaf, see TransactionManager::UpdateRows. The
+ * child is drained before the first row is written, so a scan of the same
+ * table doesn't come across the writes. It returns one tuple, the number of
+ * rows updated.
+ */
+class UpdateExecutor : public AbstractExecutor {
+ public:
+  UpdateExecutor(Catalog *catalog, const std::string &table_name,
+                 std::unique_ptr<AbstractExecutor> child,
+                 const std::vector<hsql::UpdateClause *> &updates);
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+  auto GetOutputCols() -> std::vector<Cloum> override;
+
+ private:
+  TransactionManager *txn_manager_;
+  TableInfo table_info_;
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  // the cloums set, with their offsets in a row and their values
+  std::vector<int> cols_;
+  std::vector<size_t> offsets_;
+  std::vector<const hsql::Expr *> values_;
+  bool is_done_{false};
+};
+}  // namespace spdb
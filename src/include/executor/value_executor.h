@@ -10,6 +10,12 @@ class ValueExecutor : public AbstractExecutor {
 
   ~ValueExecutor();
 
+  /**
+   * Add the row of another insert statement into the same table, like a
+   * statement prepared for a row bound to the values of the next one.
+   */
+  void AddRow(const hsql::SQLStatement *);
+
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
   auto GetOutputCols() -> std::vector<Cloum> override;
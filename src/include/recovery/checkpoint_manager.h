@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+
+#include "buffer/buffer_pool.h"
+#include "config/config.h"
+#include "recovery/log_manager.h"
+
+namespace spdb {
+
+/**
+ * CheckpointManager takes fuzzy checkpoints, which bound both the length of
+ * the log and the time to recover. Pages stay in use meanwhile:
+ *
+ * - the pages dirty since before the last checkpoint are written back one at
+ *   a time, so no page stays dirty for more than two checkpoints;
+ * - the dirty page table is collected from the buffer pool and the written
+ *   pages are synced;
+ * - the checkpoint record is logged with the dirty page table, the running
+ *   transactions and the roots, and the log is truncated before the first
+ *   record the recovery may still need.
+ *
+ * A background thread checkpoints every interval, or sooner once the log
+ * appended since the last checkpoint would take longer than the recovery
+ * time objective to redo.
+ */
+class CheckpointManager {
+ public:
+  /**
+   * @param interval_ms the time between checkpoints
+   * @param rto_ms the recovery time objective
+   */
+  CheckpointManager(LogManager *log_manager, BufferPool *buffer_pool,
+                    size_t interval_ms = CHECKPOINT_INTERVAL_MS,
+                    size_t rto_ms = RECOVERY_TIME_OBJECTIVE_MS);
+
+  ~CheckpointManager();
+
+  /** Start checkpointing in the background, after the recovery. */
+  void Start();
+
+  void Stop();
+
+  /**
+   * Take a checkpoint now.
+   * @return the lsn of the checkpoint record
+   */
+  auto Checkpoint() -> lsn_t;
+
+  auto GetCheckpointCount() const -> size_t { return checkpoint_count_; }
+
+ private:
+  void CheckpointThread();
+
+  LogManager *log_manager_;
+  BufferPool *buffer_pool_;
+  size_t interval_ms_;
+  /** The log bytes the recovery time objective allows to redo. */
+  size_t redo_bytes_;
+
+  /** Where the last checkpoint began, and the log appended by then. */
+  lsn_t last_scan_lsn_{INVALID_LSN};
+  std::atomic<size_t> last_appended_bytes_{0};
+  std::atomic<size_t> checkpoint_count_{0};
+  /** One checkpoint at a time. */
+  std::mutex checkpoint_latch_;
+
+  bool is_running_{false};
+  /** Protects is_running_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+}  // namespace spdb
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <exception>
+#include <mutex>               // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "config/config.h"
+#include "recovery/log_record.h"
+
+namespace spdb {
+
+/**
+ * LogManager appends log records to a sequential log file. Records are
+ * buffered in memory and written by a background flusher, a transaction is
+ * only committed once its commit record is on disk.
+ *
+ * Commits are grouped: the flusher writes and syncs everything appended so
+ * far at once, so all the transactions committing during one fsync share the
+ * next one, instead of syncing one by one.
+ *
+ * Pages modified by a thread are logged under the transaction the thread
+ * began, or under no transaction outside of one.
+ *
+ * The log is truncated from the front as checkpoints make its head useless:
+ * once the truncation point passes the start of a flushed batch, the flusher
+ * copies the records from that batch on aside and renames the copy over the
+ * log. The records of the running transactions are always kept for undo.
+ *
+ * If the flusher fails to write, sync or truncate the log, it stops, and
+ * every flush of a record not on disk, so every commit, throws its error
+ * from then on.
+ */
+class LogManager {
+ public:
+  /**
+   * Open the log, records already in it are kept and the LSNs and
+   * transaction ids go on after the last of them.
+   */
+  explicit LogManager(const std::string &log_name);
+
+  /** Flush the remaining records and stop the flusher. */
+  ~LogManager();
+
+  /** Begin a transaction on the calling thread. */
+  auto Begin() -> txn_id_t;
+
+  /**
+   * Go on with a transaction on the calling thread, the pages it modifies
+   * from now on are logged under txn_id.
+   */
+  void Resume(txn_id_t txn_id);
+
+  /**
+   * Go on with a transaction the recovery found unfinished, on the calling
+   * thread, its records from now on follow last_lsn.
+   */
+  void Resume(txn_id_t txn_id, lsn_t last_lsn);
+
+  /**
+   * Commit the transaction, returns once the commit record is on disk.
+   * @throws std::runtime_error if the log can't be written
+   */
+  void Commit(txn_id_t txn_id);
+
+  /** Log that the transaction is rolled back, once its changes are undone. */
+  void Abort(txn_id_t txn_id);
+
+  /**
+   * Log the modification of a page by the transaction of the calling thread.
+   * The first sizeof(lsn_t) bytes are the page LSN and aren't compared.
+   * @param before the page before the modification
+   * @param after the page after the modification
+   * @return the lsn of the record, INVALID_LSN if the page isn't changed
+   */
+  auto AppendPageUpdate(const std::string &file_name, page_id_t page_id,
+                        const char *before, const char *after) -> lsn_t;
+
+  /**
+   * Log the move of the B+ tree root of a file by the transaction of the
+   * calling thread.
+   * @return the lsn of the record
+   */
+  auto AppendRootUpdate(const std::string &file_name, page_id_t old_root,
+                        page_id_t new_root) -> lsn_t;
+
+  /**
+   * Log that an update of the transaction is undone.
+   * @param record the undone page or root update
+   * @return the lsn of the CLR
+   */
+  auto AppendClr(const LogRecord &record) -> lsn_t;
+
+  /**
+   * Log the row of a key before the transaction of the calling thread first
+   * writes it, before the pages are modified.
+   * @param row the row, empty if there was none
+   * @param[out] prev_lsn the record of the transaction before it, the undo
+   * of the write goes on from there
+   * @return the lsn of the record
+   */
+  auto AppendRowUpdate(const std::string &file_name, const std::string &key,
+                       const std::string &row, lsn_t *prev_lsn) -> lsn_t;
+
+  /**
+   * Log that a row update of the transaction of the calling thread is undone.
+   * @param undo_next_lsn the prev_lsn of the undone row update
+   * @return the lsn of the row CLR
+   */
+  auto AppendRowClr(lsn_t undo_next_lsn) -> lsn_t;
+
+  /**
+   * Log the end of a statement of the transaction of the calling thread,
+   * once every page it modified is logged. From then on the recovery undoes
+   * the statement by its row updates instead of its page updates.
+   * @return the lsn of the record, INVALID_LSN outside of a transaction
+   */
+  auto AppendStatementEnd() -> lsn_t;
+
+  /**
+   * Log a fuzzy checkpoint. The running transactions and the roots are
+   * taken as of the checkpoint record.
+   * @param scan_lsn the next lsn when the dirty pages began to be collected
+   * @param dirty_pages the dirty page table
+   * @return the lsn of the checkpoint record
+   */
+  auto AppendCheckpoint(lsn_t scan_lsn,
+                        const std::vector<DirtyPage> &dirty_pages) -> lsn_t;
+
+  /**
+   * Allow the records before lsn to be dropped, the flusher truncates the
+   * log later. Records of running transactions are kept anyway.
+   */
+  void SetTruncationLSN(lsn_t lsn);
+
+  /**
+   * Block until all the records up to lsn are on disk. Flushes requested
+   * while the flusher is syncing are served together by its next sync.
+   * @throws std::runtime_error if the log can't be written
+   */
+  void Flush(lsn_t lsn);
+
+  /** Flush everything appended so far. */
+  void FlushAll();
+
+  /** @return the lsn of the last record on disk */
+  auto GetPersistentLSN() -> lsn_t;
+
+  /** @return the lsn the next record will get */
+  auto GetNextLSN() -> lsn_t;
+
+  /** @return the lsn of the first record in the log file */
+  auto GetFirstLSN() -> lsn_t;
+
+  /** @return the size of the log file and the records not written yet */
+  auto GetLogSize() -> size_t;
+
+  /** The number of bytes appended since the log was opened. */
+  auto GetAppendedBytes() const -> size_t { return appended_bytes_; }
+
+  /** The number of commits and of log syncs so far. */
+  auto GetCommitCount() const -> size_t { return commit_count_; }
+  auto GetSyncCount() const -> size_t { return sync_count_; }
+
+  auto GetLogName() -> const std::string & { return log_name_; }
+
+  /**
+   * Read the whole records of a log file, a torn record at the end is left
+   * out.
+   */
+  static auto ReadLog(const std::string &log_name) -> std::vector<LogRecord>;
+
+ private:
+  // Assign the next lsn to the record and buffer it, caller should acquire
+  // the latch.
+  auto AppendRecord(LogRecord *record) -> lsn_t;
+
+  void FlushThread();
+
+  // Write and sync the batches, truncating the log as it goes, until the
+  // log manager is closed, called by the flusher.
+  void FlushBatches();
+
+  // Drop the records before offset of the log file by writing the rest
+  // aside and renaming it over the log, called by the flusher.
+  void Truncate(size_t offset);
+
+  std::string log_name_;
+  int fd_{-1};
+
+  lsn_t next_lsn_{INVALID_LSN + 1};
+  lsn_t persistent_lsn_{INVALID_LSN};
+  txn_id_t next_txn_id_{0};
+  /** The first and the last record of every running transaction. */
+  std::unordered_map<txn_id_t, lsn_t> txn_first_lsn_;
+  std::unordered_map<txn_id_t, lsn_t> txn_last_lsn_;
+  /** The last root logged for every file since the log was opened. */
+  std::unordered_map<std::string, page_id_t> roots_;
+
+  /** The first lsn and the offset in the log file of every batch written. */
+  std::deque<std::pair<lsn_t, size_t>> batches_;
+  size_t file_size_{0};
+  /** The first lsn in log_buffer_. */
+  lsn_t buffer_first_lsn_{INVALID_LSN};
+  lsn_t truncation_lsn_{INVALID_LSN};
+
+  std::string log_buffer_;
+  std::string flush_buffer_;
+  bool is_running_{true};
+  bool flush_requested_{false};
+  /** The error the flusher stopped on. */
+  std::exception_ptr error_;
+
+  std::atomic<size_t> appended_bytes_{0};
+  std::atomic<size_t> commit_count_{0};
+  std::atomic<size_t> sync_count_{0};
+
+  /** Protects all the members above but flush_buffer_ and the counters. */
+  std::mutex latch_;
+  /** Wakes the flusher up. */
+  std::condition_variable flush_cv_;
+  /** Signals the records up to persistent_lsn_ are on disk. */
+  std::condition_variable persistent_cv_;
+  std::thread flush_thread_;
+};
+}  // namespace spdb
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "config/config.h"
+
+namespace spdb {
+
+enum class LogRecordType {
+  INVALID,
+  BEGIN,
+  COMMIT,
+  ABORT,
+  PAGE_UPDATE,
+  ROOT_UPDATE,
+  CLR,
+  CHECKPOINT,
+  ROW_UPDATE,
+  ROW_CLR,
+  STATEMENT_END
+};
+
+/** A page in the dirty page table of a checkpoint. */
+struct DirtyPage {
+  std::string file_name_;
+  page_id_t page_id_;
+  /** The first record which dirtied the page since it was written back. */
+  lsn_t rec_lsn_;
+};
+
+/**
+ * A record of the write-ahead log. Every record starts with a header:
+ *  ---------------------------------------------------------------------
+ * | Size (4) | LSN (8) | TxnId (4) | PrevLSN (8) | LogRecordType (4) |
+ *  ---------------------------------------------------------------------
+ * where PrevLSN is the previous record of the same transaction.
+ *
+ * A page update is logged physiologically: the page is named by its file and
+ * page id, and the changed bytes of the page are kept before and after the
+ * modification, so that it can be both redone and undone.
+ *  ---------------------------------------------------------------------
+ * | HEADER | FileNameLength (4) | FileName | PageId (4) | Offset (4) |
+ *  ---------------------------------------------------------------------
+ *  -------------------------------------------------------
+ * | Length (4) | BeforeImage (Length) | AfterImage (Length) |
+ *  -------------------------------------------------------
+ *
+ * A root update moves the root of the B+ tree in a file, it is laid out like
+ * a page update with an invalid page id, the images are the old and the new
+ * root page id.
+ *
+ * A compensation log record (CLR) is written when a page or root update is
+ * undone, the images are swapped and the record is followed by the lsn of the
+ * next record of the transaction to undo. CLRs are only redone, so undo isn't
+ * repeated if the recovery crashes.
+ *  -----------------------------------------------
+ * | PAGE UPDATE LAYOUT | UndoNextLSN (8) |
+ *  -----------------------------------------------
+ *
+ * A fuzzy checkpoint records the running transactions with their last
+ * record, the dirty pages and the roots moved since startup. The dirty pages
+ * are collected while other threads go on, starting at ScanLSN, so the
+ * records from ScanLSN on should be analysed as well.
+ *  ---------------------------------------------------------------------
+ * | HEADER | ScanLSN (8) | TxnNums (4) | TxnId (4) + LastLSN (8) | ...
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | PageNums (4) | FileNameLength (4) + FileName + PageId (4) + RecLSN (8)
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | ... | RootNums (4) | FileNameLength (4) + FileName + RootId (4) | ...
+ *  ---------------------------------------------------------------------
+ *
+ * A row update keeps the row of a key of a table before the transaction
+ * first wrote it, the row is empty if there was none. The statements of a
+ * transaction which have ended, by a statement end record, are undone
+ * logically from the row updates, as other transactions may have written
+ * their pages since.
+ *  ---------------------------------------------------------------------
+ * | HEADER | FileNameLength (4) | FileName | KeyLength (4) | Key |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------
+ * | RowLength (4) | Row (RowLength) |
+ *  ---------------------------------
+ *
+ * A row CLR is written when a row update is undone, it is followed by the
+ * lsn of the next record of the transaction to undo.
+ *  ---------------------------------
+ * | HEADER | UndoNextLSN (8) |
+ *  ---------------------------------
+ */
+class LogRecord {
+ public:
+  static constexpr size_t HEADER_SIZE = 28;
+
+  LogRecord() = default;
+
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, LogRecordType type)
+      : txn_id_(txn_id), prev_lsn_(prev_lsn), type_(type) {}
+
+  LogRecord(txn_id_t txn_id, lsn_t prev_lsn, std::string file_name,
+            page_id_t page_id, int offset, std::string before_image,
+            std::string after_image)
+      : txn_id_(txn_id),
+        prev_lsn_(prev_lsn),
+        type_(LogRecordType::PAGE_UPDATE),
+        file_name_(std::move(file_name)),
+        page_id_(page_id),
+        offset_(offset),
+        before_image_(std::move(before_image)),
+        after_image_(std::move(after_image)) {}
+
+  /** @return true if the record carries a file, page id and images */
+  auto HasPayload() const -> bool {
+    return type_ == LogRecordType::PAGE_UPDATE ||
+           type_ == LogRecordType::ROOT_UPDATE || type_ == LogRecordType::CLR;
+  }
+
+  /** @return the number of bytes the record takes in the log */
+  auto GetSize() const -> size_t;
+
+  /** Append the record to dst, with its lsn_ already assigned. */
+  void SerializeTo(std::string *dst) const;
+
+  /**
+   * Read a record from the start of src.
+   * @return false if src doesn't hold a whole record, e.g. the torn tail of
+   * the log
+   */
+  static auto Deserialize(const char *src, size_t size, LogRecord *record)
+      -> bool;
+
+  lsn_t lsn_{INVALID_LSN};
+  txn_id_t txn_id_{INVALID_TXN_ID};
+  lsn_t prev_lsn_{INVALID_LSN};
+  LogRecordType type_{LogRecordType::INVALID};
+
+  // only for page updates
+  std::string file_name_;
+  page_id_t page_id_{INVALID_PAGE_ID};
+  int offset_{0};
+  std::string before_image_;
+  std::string after_image_;
+
+  // only for CLRs and row CLRs
+  lsn_t undo_next_lsn_{INVALID_LSN};
+
+  // only for row updates, the table is file_name_
+  std::string key_;
+  std::string row_;
+
+  // only for checkpoints
+  lsn_t scan_lsn_{INVALID_LSN};
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<DirtyPage> dirty_pages_;
+  std::vector<std::pair<std::string, page_id_t>> roots_;
+};
+}  // namespace spdb
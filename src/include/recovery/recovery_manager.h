@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "config/catalog.h"
+#include "config/config.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_record.h"
+
+namespace spdb {
+
+/**
+ * RecoveryManager brings the table and index files back to the state of the
+ * log after a crash, in three passes over the log as in ARIES:
+ *
+ * - analysis finds the transactions that didn't finish and the first record
+ *   which dirtied every page;
+ * - redo repeats history, every update newer than its page is applied again.
+ *   The pages are partitioned by id among the redo threads, each of them
+ *   redoes the records of its pages in log order;
+ * - undo rolls back the unfinished transactions from their last record
+ *   backwards, writing a CLR for every undone update.
+ *
+ * The passes start from the last checkpoint in the log: its running
+ * transactions, dirty page table and roots are taken as they were, and only
+ * the records after it are analysed, or after the scan for the dirty pages.
+ * Redo skips the pages written back since their records.
+ *
+ * The statement a transaction was in the middle of is undone physically,
+ * by restoring the before images of its updates: no other transaction wrote
+ * the pages of its table meanwhile. The statements which ended are undone
+ * logically instead, as other transactions may have written the same pages
+ * since: every row update puts the row back through the trees, as a
+ * rollback does, and is followed by a row CLR.
+ *
+ * Should run at startup, after the catalog is loaded and before any
+ * statement, with the buffer pool logging to log_manager.
+ */
+class RecoveryManager {
+ public:
+  RecoveryManager(LogManager *log_manager, Catalog *catalog,
+                  size_t redo_thread_nums = REDO_THREAD_NUMS);
+
+  void Recover();
+
+  /** The number of records redone and undone by the last recovery. */
+  auto GetRedoCount() const -> size_t { return redo_count_; }
+  auto GetUndoCount() const -> size_t { return undo_count_; }
+
+ private:
+  void Analysis();
+
+  void Redo();
+
+  void Undo();
+
+  // Take the state of the last checkpoint, returns the index of its record
+  // or records_.size() if there is none.
+  auto LoadCheckpoint() -> size_t;
+
+  // Redo the page records of one partition in log order.
+  void RedoPartition(const std::vector<const LogRecord *> &records);
+
+  // Put back the row of a row update, with its index entries.
+  void UndoRow(const LogRecord &record);
+
+  // Write an image at the offset of a page and set the page LSN.
+  void ApplyToPage(const LogRecord &record, const std::string &image,
+                   lsn_t lsn);
+
+  // The manager of the file a record is about, nullptr if the file is
+  // dropped.
+  auto GetFile(const std::string &file_name) -> BufferPoolManager *;
+
+  LogManager *log_manager_;
+  Catalog *catalog_;
+  size_t redo_thread_nums_;
+
+  std::vector<LogRecord> records_;
+  /** lsn to the index of the record in records_ */
+  std::unordered_map<lsn_t, size_t> lsn_index_;
+  /** The unfinished transactions and their last record. */
+  std::unordered_map<txn_id_t, lsn_t> active_txns_;
+  /** The last checkpoint record, if any. */
+  const LogRecord *checkpoint_{nullptr};
+  /** (file, page) to the first record dirtying the page. */
+  std::unordered_map<std::string, lsn_t> dirty_pages_;
+  /** The files of the records, nullptr for the dropped files. */
+  std::unordered_map<std::string, BufferPoolManager *> files_;
+  /** The roots of the B+ trees moved by the log. */
+  std::unordered_map<std::string, page_id_t> roots_;
+
+  std::atomic<size_t> redo_count_{0};
+  size_t undo_count_{0};
+};
+}  // namespace spdb
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace spdb {
+/**
+ * Server serves clients over TCP in a line based text protocol. A client
+ * sends statements ending with ';', each over one or more lines, and may
+ * send the next ones before the replies come. The reply to a statement is
+ * the lines it printed followed by a line of a single '.', a line printed
+ * starting with '.' is sent with another '.' in front of it.
+ *
+ * One thread accepts the connections, reads the statements and writes the
+ * replies, never blocking on a socket. A fixed pool of workers runs the
+ * statements, so thousands of idle connections cost no thread. The
+ * statements of a connection run one at a time in the order they came; a
+ * connection having run one goes back to the end of the queue, so the
+ * busy connections take turns on the workers.
+ *
+ * A statement waiting for a row lock holds its worker until it is granted,
+ * with as many such statements as workers the other connections wait too.
+ */
+class Server {
+ public:
+  /** Handler runs the statements of one connection. */
+  class Handler {
+   public:
+    virtual ~Handler() = default;
+
+    /**
+     * Run a statement, on any of the workers.
+     * @param[out] output the lines printed by the statement
+     * @return false to close the connection once the reply is sent
+     */
+    virtual auto Execute(const std::string &statement, std::string *output)
+        -> bool = 0;
+  };
+
+  /** Makes the handler of every connection accepted. */
+  using HandlerFactory = std::function<std::unique_ptr<Handler>()>;
+
+  /**
+   * @param host the IPv4 address listened on
+   * @param port the port listened on, 0 for any free one
+   */
+  Server(std::string host, uint16_t port, size_t worker_nums,
+         HandlerFactory factory);
+
+  /** Stop the server if it runs. */
+  ~Server();
+
+  Server(const Server &) = delete;
+  auto operator=(const Server &) -> Server & = delete;
+
+  /**
+   * Listen and serve in the background.
+   * @throws std::runtime_error if the address can't be listened on
+   */
+  void Start();
+
+  /**
+   * Close every connection and wait for the statements running. The
+   * statements not started yet are dropped and the handlers destroyed.
+   */
+  void Stop();
+
+  /** @return the port listened on, once started */
+  auto GetPort() const -> uint16_t { return port_; }
+
+  /** @return the connections open */
+  auto GetConnectionCount() const -> size_t { return connection_count_; }
+
+  /** @return the statements run since the start */
+  auto GetStatementCount() const -> size_t { return statement_count_; }
+
+ private:
+  struct Connection;
+
+  // The loop of the thread doing the network.
+  void Loop();
+
+  void Accept();
+
+  // Read what arrived, queuing the statements completed.
+  void Read(const std::shared_ptr<Connection> &conn);
+
+  // Write the replies ready, closing the connection when it is done.
+  void Write(const std::shared_ptr<Connection> &conn);
+
+  void Close(const std::shared_ptr<Connection> &conn);
+
+  // Change the events of a connection watched.
+  void Watch(const std::shared_ptr<Connection> &conn, bool is_writing);
+
+  // Give a connection with statements waiting its turn on a worker.
+  void Submit(std::shared_ptr<Connection> conn);
+
+  // Run the next statement of a connection.
+  void Run(const std::shared_ptr<Connection> &conn);
+
+  // Hand a connection with a reply ready to the loop.
+  void Notify(std::shared_ptr<Connection> conn);
+
+  void WorkerLoop();
+
+  std::string host_;
+  uint16_t port_;
+  size_t worker_nums_;
+  HandlerFactory factory_;
+
+  int listen_fd_{-1};
+  int epoll_fd_{-1};
+  /** Wakes the loop when a reply is ready or the server stops. */
+  int wakeup_fd_{-1};
+  std::thread loop_thread_;
+  std::atomic<bool> is_stopping_{false};
+
+  /** The connections by id, only touched by the loop until it stops. */
+  std::unordered_map<uint64_t, std::shared_ptr<Connection>> connections_;
+  // ids 0 and 1 tell the listening socket and the wakeup apart
+  uint64_t next_connection_id_{2};
+
+  /** The connections with replies to write, handed over to the loop. */
+  std::vector<std::shared_ptr<Connection>> replied_;
+  std::mutex replied_latch_;
+
+  /** The connections waiting for a worker. */
+  std::deque<std::shared_ptr<Connection>> tasks_;
+  std::mutex tasks_latch_;
+  std::condition_variable tasks_cv_;
+  std::vector<std::thread> workers_;
+
+  std::atomic<size_t> connection_count_{0};
+  std::atomic<size_t> statement_count_{0};
+};
+}  // namespace spdb
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "SQLParser.h"
+
+namespace spdb {
+/** A value bound to a parameter of a statement, an int or a string. */
+struct Literal {
+  bool is_string_{false};
+  int64_t int_{0};
+  std::string string_;
+};
+
+/**
+ * Take the int and string literals out of a select, an insert or an execute
+ * statement, leaving a ? in their place and the whitespace between the
+ * tokens collapsed, or dropped next to commas and parentheses, so the
+ * statements differing in their literals only are the same text. A string
+ * with a quote doubled in it is taken out with a single one, as the parser
+ * reads it.
+ * @param[out] literals the literals taken out, in order
+ * @return the text, empty if the statement is of another kind, or has a
+ * literal which can't be a parameter
+ */
+auto ParameterizeStatement(const std::string &query,
+                           std::vector<Literal> *literals) -> std::string;
+
+/**
+ * PreparedStatement is a statement parsed once, its parameters are bound
+ * before every run. Binding writes the values into the parsed statement, so
+ * it is run by one session at a time.
+ */
+class PreparedStatement {
+ public:
+  /** @throws std::runtime_error if the text is no valid statement */
+  explicit PreparedStatement(const std::string &query);
+
+  PreparedStatement(const PreparedStatement &) = delete;
+  auto operator=(const PreparedStatement &) -> PreparedStatement & = delete;
+
+  auto GetStatement() const -> const hsql::SQLStatement * {
+    return result_.getStatement(0);
+  }
+
+  auto GetParameterCount() const -> size_t { return parameters_.size(); }
+
+  /**
+   * Bind the parameters, in the order they appear in the statement.
+   * @throws std::runtime_error if the number of values doesn't match
+   */
+  void Bind(const std::vector<Literal> &values);
+
+ private:
+  hsql::SQLParserResult result_;
+  std::vector<hsql::Expr *> parameters_;
+};
+
+/**
+ * PlanCache keeps the statements a session parsed last, by their text as
+ * ParameterizeStatement leaves it. The least recently used one is evicted
+ * once it is full.
+ */
+class PlanCache {
+ public:
+  explicit PlanCache(size_t capacity) : capacity_(capacity) {}
+
+  /** @return the statement cached for the text, nullptr if there is none */
+  auto Get(const std::string &text) -> std::shared_ptr<PreparedStatement>;
+
+  void Put(const std::string &text,
+           std::shared_ptr<PreparedStatement> statement);
+
+  auto GetSize() const -> size_t { return entries_.size(); }
+
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+  auto GetHitCount() const -> size_t { return hits_; }
+
+  auto GetMissCount() const -> size_t { return misses_; }
+
+ private:
+  using Entry = std::pair<std::string, std::shared_ptr<PreparedStatement>>;
+
+  size_t capacity_;
+  /** The entries, the most recently used first. */
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t hits_{0};
+  size_t misses_{0};
+};
+}  // namespace spdb
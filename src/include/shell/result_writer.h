@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/tuple.h"
+
+namespace spdb {
+/** The formats the rows of a select are written in. */
+enum class OutputMode { TABLE, CSV, TSV, JSON };
+
+/**
+ * @param name table, csv, tsv or json
+ * @return false if the name is of no mode
+ */
+auto ParseOutputMode(const std::string &name, OutputMode *mode) -> bool;
+
+/**
+ * ResultWriter writes the rows of a result as they come out of the executor,
+ * so a result of any size takes the same memory and its first rows show
+ * before the scan is done. The text goes through a buffer written to the
+ * stream once it is full, not line by line.
+ *
+ * A table is drawn with every cloum as wide as the widest value its type
+ * holds, known before the first row. csv quotes the values as RFC 4180
+ * does, tsv escapes tabs, newlines and backslashes, json writes an object
+ * per line.
+ */
+class ResultWriter {
+ public:
+  /** @param cols the cloums of the rows */
+  static auto Create(OutputMode mode, const std::vector<Cloum> &cols,
+                     std::ostream *out) -> std::unique_ptr<ResultWriter>;
+
+  virtual ~ResultWriter() = default;
+
+  ResultWriter(const ResultWriter &) = delete;
+  auto operator=(const ResultWriter &) -> ResultWriter & = delete;
+
+  virtual void WriteHeader() = 0;
+
+  virtual void WriteRow(const Tuple &row) = 0;
+
+  /** Write what ends the result, and flush the buffer to the stream. */
+  virtual void Finish();
+
+ protected:
+  ResultWriter(const std::vector<Cloum> &cols, std::ostream *out);
+
+  void Append(const char *data, size_t size) {
+    buffer_.append(data, size);
+    if (buffer_.size() >= RESULT_BUFFER_SIZE) {
+      Flush();
+    }
+  }
+
+  void Append(const std::string &text) { Append(text.data(), text.size()); }
+
+  void Append(char c) { Append(&c, 1); }
+
+  void Flush();
+
+  /**
+   * Write the value of a cloum as text, unquoted.
+   * @return the number of chars written
+   */
+  auto AppendValue(const Tuple &row, size_t index) -> size_t;
+
+  /**
+   * The chars of a CHAR value, up to its first '\0'.
+   * @param[out] size the number of chars
+   */
+  auto CharValue(const Tuple &row, size_t index, size_t *size) const
+      -> const char *;
+
+  std::vector<Cloum> cols_;
+  // the offset of every cloum in the data of a row
+  std::vector<size_t> offsets_;
+
+ private:
+  std::ostream *out_;
+  std::string buffer_;
+};
+}  // namespace spdb
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "config/catalog.h"
+#include "config/config.h"
+#include "executor/value_executor.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "shell/plan_cache.h"
+#include "shell/result_writer.h"
+
+namespace spdb {
+/**
+ * Engine opens the database in the working directory, bringing it back to
+ * the log in case the last process crashed, and holds what the sessions
+ * over it share: one buffer pool, catalog and transaction manager.
+ */
+class Engine {
+ public:
+  Engine(size_t pool_size, size_t checkpoint_interval_ms, size_t rto_ms);
+
+  Engine(const Engine &) = delete;
+  auto operator=(const Engine &) -> Engine & = delete;
+
+ private:
+  friend class Session;
+
+  // declared first so it outlives the pages written back at exit
+  LogManager log_manager_;
+  // one pool caches the pages of every table for the whole process
+  BufferPool buffer_pool_;
+  std::unique_ptr<Catalog> catalog_;
+  // stopped before the pages it writes back go away
+  CheckpointManager checkpoint_manager_;
+  // writers of the same row wait for each other, deadlocks are broken in
+  // the background
+  LockManager lock_manager_;
+  // statements read snapshots, inserts are versioned until they commit
+  std::unique_ptr<TransactionManager> txn_manager_;
+  /**
+   * Statements reading the tables hold it shared, the ones changing the
+   * schema or rewriting the files of a table exclusive.
+   */
+  std::shared_mutex schema_latch_;
+};
+
+/**
+ * Cut an insert of several rows into an insert of each row, the parser takes
+ * one row. The commas and parentheses in the strings and in the values are
+ * left alone.
+ * @return the inserts in order, none if the query is no insert of several
+ * rows
+ */
+auto SplitInsertRows(const std::string &query) -> std::vector<std::string>;
+
+/**
+ * Session runs the statements of one client, in order, the shell's or a
+ * connection of the server. A transaction opened by begin; spans the
+ * statements of the session until commit; or rollback;, each statement may
+ * run on another thread. Sessions of an engine run concurrently.
+ */
+class Session {
+ public:
+  /**
+   * @param out the results are written to
+   * @param err the errors are written to
+   */
+  Session(Engine *engine, std::ostream *out, std::ostream *err);
+
+  /** Roll back the transaction left open. */
+  ~Session();
+
+  Session(const Session &) = delete;
+  auto operator=(const Session &) -> Session & = delete;
+
+  /**
+   * Run a statement, ending with ';'.
+   * @return false once the session exits
+   */
+  auto Execute(const std::string &query) -> bool;
+
+  /** Set the format the rows of the selects are written in. */
+  void SetOutputMode(OutputMode mode) { output_mode_ = mode; }
+
+ private:
+  // Run a command of the shell, like vacuum;.
+  // @return false if the query is no command
+  auto ExecuteCommand(const std::string &query) -> bool;
+
+  // Run a statement of the parser.
+  void ExecuteStatement(const std::string &query);
+
+  // Parse a statement, or take it from the plan cache if it was parsed
+  // before and bind it to the literals of the query. The statement lives as
+  // long as result or prepared.
+  // @return nullptr if the query is no valid statement
+  auto ParseStatement(const std::string &query, hsql::SQLParserResult *result,
+                      std::shared_ptr<PreparedStatement> *prepared)
+      -> const hsql::SQLStatement *;
+
+  // Run a statement parsed, its parameters bound.
+  void RunStatement(const hsql::SQLStatement *statement);
+
+  // Run the inserts of the rows of one statement, as SplitInsertRows cuts
+  // it, all or none of the rows are inserted.
+  void RunInsert(const std::vector<std::string> &inserts);
+
+  // Insert the rows of value_executor, in the transaction of the session or
+  // in one of their own.
+  void InsertValues(const TableInfo &table_info,
+                    ValueExecutor *value_executor);
+
+  // Write the rows of a table the session sees to a column file, for copy
+  // <table> to '<file>';. @return the number of rows
+  auto ExportTable(const std::string &table_name, const std::string &file_name)
+      -> size_t;
+
+  // Insert the rows of a column file into a table, as InsertValues, for copy
+  // <table> from '<file>';. A row with a key the table has is left out.
+  // @return the number of rows inserted
+  auto ImportTable(const std::string &table_name, const std::string &file_name)
+      -> size_t;
+
+  // Run a delete or an update statement, as InsertValues.
+  void WriteRows(const hsql::SQLStatement *statement);
+
+  // Run the writes of a statement in the transaction of the session, or in
+  // one of their own committing with them. The transaction is rolled back if
+  // the writes abort it, or if it is their own and they fail.
+  // @return false if the transaction is rolled back
+  auto RunWrite(const std::function<void()> &write) -> bool;
+
+  Engine *engine_;
+  std::ostream *out_;
+  std::ostream *err_;
+  OutputMode output_mode_{OutputMode::TABLE};
+  /** The leaf layout of the tables the session creates, set by layout;. */
+  LeafLayout layout_{LeafLayout::Row};
+  /** The transaction opened by begin;, nullptr runs every statement alone. */
+  Transaction *txn_{nullptr};
+  /** The selects, inserts and executes run last, parsed. */
+  PlanCache plan_cache_{PLAN_CACHE_SIZE};
+  /** The statements prepared by name, until they are deallocated. */
+  std::unordered_map<std::string, std::shared_ptr<PreparedStatement>>
+      prepared_;
+};
+}  // namespace spdb
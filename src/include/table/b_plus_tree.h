@@ -1,7 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <mutex>
 #include <optional>
@@ -19,6 +21,12 @@
 #include "table/b_plus_tree_leaf_page.h"
 namespace spdb {
 
+/**
+ * Iterator walks the leaves in key order. It doesn't latch the leaf between
+ * steps, so writers go on meanwhile: every step looks for the first key
+ * after the last one returned, wherever inserts, splits or removes have moved
+ * the entries.
+ */
 class Iterator {
  public:
   Iterator() = default;
@@ -30,38 +38,85 @@ class Iterator {
         pid_(pid),
         index_(index),
         key_type_(key_type),
-        value_type_(value_type) {}
+        value_type_(value_type) {
+    if (pid_ != INVALID_PAGE_ID) {
+      Load(nullptr);
+    }
+  }
 
   auto IsEnd() -> bool { return pid_ == INVALID_PAGE_ID && index_ == -1; }
 
-  auto operator*() -> const std::pair<Tuple, Tuple> & {
+  auto operator*() -> const std::pair<Tuple, Tuple> & { return *pair_; }
+
+  auto operator++() -> Iterator & {
+    auto last = pair_->first;
+    Load(&last);
+    return *this;
+  }
+
+  /**
+   * Count the entries of the leaf from the current one on, for skipping the
+   * rest of the leaf with SkipPast.
+   * @param[out] last the key of the last entry of the leaf
+   * @return 0 at the end, or if the current entry left the leaf
+   */
+  auto CountLeafRest(Tuple *last) -> size_t {
+    if (IsEnd()) {
+      return 0;
+    }
     auto leaf_page_guard = bpm_->FetchPageRead(pid_);
     auto leaf_page = leaf_page_guard.As<BPlusTreeLeafPage>();
-    pair_ = std::make_shared<std::pair<Tuple, Tuple>>(
-        leaf_page->KeyAt(index_, key_type_),
-        leaf_page->ValueAt(index_, value_type_));
-    RID rid{pid_, index_};
-    pair_->second.SetRid(rid);
-    return *pair_;
+    int index = leaf_page->LowerBound(pair_->first, key_type_);
+    if (index >= leaf_page->GetSize()) {
+      return 0;
+    }
+    *last = leaf_page->KeyAt(leaf_page->GetSize() - 1, key_type_);
+    return leaf_page->GetSize() - index;
   }
 
-  auto operator++() -> Iterator & {
+  /**
+   * Copy the values of a cloum of the entries of the leaf from the current
+   * one on, for skipping them with SkipPast as CountLeafRest. A Pax leaf
+   * hands the values over at once from ValueCloumAt.
+   * @param index the cloum in value_type
+   * @param[out] values the values, one after another
+   * @param[out] last the key of the last entry of the leaf
+   * @return the number of values, 0 as CountLeafRest
+   */
+  auto ReadLeafCloum(size_t index, std::vector<char> *values, Tuple *last)
+      -> size_t {
+    if (IsEnd()) {
+      return 0;
+    }
     auto leaf_page_guard = bpm_->FetchPageRead(pid_);
     auto leaf_page = leaf_page_guard.As<BPlusTreeLeafPage>();
-    ++index_;
-    if (index_ >= leaf_page->GetSize()) {
-      page_id_t next_id = leaf_page->GetNextPageId();
-      pid_ = next_id;
-      if (next_id != INVALID_PAGE_ID) {
-        index_ = 0;
-      } else {
-        index_ = -1;
+    int start = leaf_page->LowerBound(pair_->first, key_type_);
+    if (start >= leaf_page->GetSize()) {
+      return 0;
+    }
+    size_t rest = leaf_page->GetSize() - start;
+    size_t size = value_type_[index].GetSize();
+    values->resize(rest * size);
+    auto cloum = leaf_page->ValueCloumAt(index, value_type_);
+    if (cloum != nullptr) {
+      memcpy(values->data(), cloum + start * size, rest * size);
+    } else {
+      size_t offset = 0;
+      for (size_t i = 0; i < index; ++i) {
+        offset += value_type_[i].GetSize();
+      }
+      for (size_t i = 0; i < rest; ++i) {
+        auto value = leaf_page->ValueAt(start + i, value_type_);
+        memcpy(values->data() + i * size, value.GetData() + offset, size);
       }
     }
-
-    return *this;
+    *last = leaf_page->KeyAt(leaf_page->GetSize() - 1, key_type_);
+    return rest;
   }
 
+  /** Move to the first entry after key. */
+  void SkipPast(const Tuple &key) { Load(&key); }
+
   auto operator==(const Iterator &itr) const -> bool {
     return (bpm_ == itr.bpm_ && pid_ == itr.pid_ && index_ == itr.index_);
   }
@@ -71,6 +126,46 @@ class Iterator {
   }
 
  private:
+  // Read the entry at index_ of leaf pid_, or with last the first entry
+  // after it from leaf pid_ on. Moves to the end if there is none.
+  void Load(const Tuple *last) {
+    while (pid_ != INVALID_PAGE_ID) {
+      auto leaf_page_guard = bpm_->FetchPageRead(pid_);
+      auto leaf_page = leaf_page_guard.As<BPlusTreeLeafPage>();
+      if (last != nullptr) {
+        index_ = NextIndex(leaf_page, *last);
+      }
+      if (index_ < leaf_page->GetSize()) {
+        pair_ = std::make_shared<std::pair<Tuple, Tuple>>(
+            leaf_page->KeyAt(index_, key_type_),
+            leaf_page->ValueAt(index_, value_type_));
+        RID rid{pid_, index_};
+        pair_->second.SetRid(rid);
+        return;
+      }
+      pid_ = leaf_page->GetNextPageId();
+      index_ = 0;
+    }
+    index_ = -1;
+    pair_.reset();
+  }
+
+  // The index of the first key after last in a leaf, the entry returned
+  // last is usually still at index_.
+  auto NextIndex(const BPlusTreeLeafPage *leaf_page, const Tuple &last)
+      -> int {
+    if (index_ < leaf_page->GetSize() &&
+        leaf_page->KeyAt(index_, key_type_) == last) {
+      return index_ + 1;
+    }
+    int index = leaf_page->LowerBound(last, key_type_);
+    if (index < leaf_page->GetSize() &&
+        leaf_page->KeyAt(index, key_type_) == last) {
+      ++index;
+    }
+    return index;
+  }
+
   BufferPoolManager *bpm_;
   page_id_t pid_;
   int index_;
@@ -101,7 +196,8 @@ class BPlusTree {
   explicit BPlusTree(BufferPoolManager *buffer_pool_manager,
                      std::vector<Cloum> key_type, std::vector<Cloum> value_type,
                      int leaf_max_size, int internal_max_size,
-                     page_id_t root_page_id = INVALID_PAGE_ID);
+                     page_id_t root_page_id = INVALID_PAGE_ID,
+                     LeafLayout layout = LeafLayout::Row);
 
   // Returns true if this B+ tree has no keys and values.
   auto IsEmpty() -> bool;
@@ -109,9 +205,32 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const Tuple &key, const Tuple &value) -> bool;
 
+  // Insert key-value pairs sorted by key. The pairs falling into the same
+  // leaf go in under one latch of it, the tree is only descended again for
+  // the next leaf or when the leaf is full. before_insert is called with the
+  // index of every pair whose key is not in the tree, right before it goes
+  // in. No one else should write to the tree meanwhile. Returns the number
+  // of pairs inserted.
+  auto InsertBatch(const std::vector<std::pair<Tuple, Tuple>> &pairs,
+                   const std::function<void(size_t)> &before_insert) -> size_t;
+
+  // Overwrite the values of keys sorted by key in place, so the tree keeps
+  // its shape. The pairs falling into the same leaf are written under one
+  // latch of it. before_update is called with the index of every pair whose
+  // key is in the tree and the value it replaces, right before it is
+  // overwritten. No one else should write to the tree meanwhile. Returns the
+  // number of pairs updated.
+  auto UpdateBatch(
+      const std::vector<std::pair<Tuple, Tuple>> &pairs,
+      const std::function<void(size_t, const Tuple &)> &before_update)
+      -> size_t;
+
   // Remove a key and its value from this B+ tree.
   void Remove(const Tuple &key);
 
+  // Build this (empty) B+ tree bottom-up from key-value pairs sorted by key
+  auto BulkLoad(const std::vector<std::pair<Tuple, Tuple>> &pairs) -> bool;
+
   // Return the value associated with a given key
   auto GetValue(const Tuple &key, Tuple &result) -> bool;
 
@@ -122,13 +241,50 @@ class BPlusTree {
 
   auto End() -> Iterator;
 
+  // Return an iterator positioned at the first key that is not less than key
   auto Begin(const Tuple &key) -> Iterator;
 
+  // Pick at most parts - 1 keys splitting the tree into key ranges of about
+  // as many leaves each, from the separators of the highest levels of
+  // internal pages having enough of them. The keys are taken page by page,
+  // the tree may change meanwhile.
+  auto SplitKeys(size_t parts) -> std::vector<Tuple>;
+
+  // Collect the ids of the pages reachable from the root, while no one
+  // writes to the tree
+  void CollectPageIds(std::vector<page_id_t> *page_ids);
+
+  // Rebuild the tree into new pages with dense leaves, allocated in key
+  // order, unless its leaves are dense and in page order already. The old
+  // pages are left as they are for the readers still on them, their ids are
+  // appended to old_page_ids to be freed later. No one should write to the
+  // tree meanwhile. Returns the number of pages of the new tree, or 0 if the
+  // tree is left alone.
+  auto Compact(std::vector<page_id_t> *old_page_ids) -> size_t;
+
  private:
+  // Build a tree bottom-up from count key-value pairs sorted by key, fill
+  // writes the next pair at an index of a leaf. The pages are allocated
+  // leaves first, so the leaves lie in key order in the file. Returns the
+  // root.
+  auto Build(size_t count,
+             const std::function<void(BPlusTreeLeafPage *, int)> &fill)
+      -> page_id_t;
+
+  // Collect the ids of the pages of the subtree of root.
+  void CollectPageIds(page_id_t root, std::vector<page_id_t> *page_ids);
+
+  // Whether key is after every key of a leaf which has a right sibling. A
+  // reader which started from a root that has split since reaches a leaf on
+  // the left of the key and moves right along the leaves.
+  auto IsLeftOf(const BPlusTreeLeafPage *leaf_page, const Tuple &key) -> bool;
+
   BufferPoolManager *bpm_;
   int leaf_max_size_;
   int internal_max_size_;
   page_id_t root_page_id_;
+  // the layout of the leaves this tree makes
+  LeafLayout layout_;
   std::mutex root_latch_;
   std::vector<Cloum> key_type_;
   std::vector<Cloum> value_type_;
@@ -11,7 +11,7 @@
 
 namespace spdb {
 
-#define INTERNAL_HEADER_SIZE 28
+#define INTERNAL_HEADER_SIZE 40
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
@@ -24,6 +24,14 @@ namespace spdb {
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ * Header format (size in byte, 40 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | LSN (8) | PageType (4) | CurrentSize (4) | MaxSize (4) | Checksum (4) |
+ *  ---------------------------------------------------------------------
+ *  -------------------------------
+ * | KeySize (8) | ValueSize (8) |
+ *  -------------------------------
  */
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
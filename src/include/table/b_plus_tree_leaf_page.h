@@ -19,14 +19,25 @@ namespace spdb {
  * | HEADER | KEY(1) + VAL(1) | KEY(2) + VAL(2) | ... | KEY(n) + VAL(n)
  *  ----------------------------------------------------------------------
  *
+ * A Pax leaf (PageType::PaxLeaf) holds as many entries, with the values of
+ * each cloum of the keys and then of the values stored together, every
+ * cloum taking room for MaxSize values:
+ *  ----------------------------------------------------------------------
+ * | HEADER | KEY CLOUM(1) | ... | KEY CLOUM(k) | VAL CLOUM(1) | ... |
+ *  ----------------------------------------------------------------------
+ *  KEY CLOUM(j):
+ *  ----------------------------------------------------------------------
+ * | KEY(1).j | KEY(2).j | ... | KEY(n).j | (free up to MaxSize)
+ *  ----------------------------------------------------------------------
+ *
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | KeySize (8) | ValueSize (8)
+ * | LSN (8) | PageType (4) | CurrentSize (4) | MaxSize (4) | Checksum (4) |
  *  ---------------------------------------------------------------------
  *  -----------------------------------------------
- * |  NextPageId (4) |
+ * | KeySize (8) | ValueSize (8) | NextPageId (4) |
  *  -----------------------------------------------
  */
-#define LEAF_HEADER_SIZE 32
+#define LEAF_HEADER_SIZE 44
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
   // Delete all constructor / destructor to ensure memory safety
@@ -37,8 +48,12 @@ class BPlusTreeLeafPage : public BPlusTreePage {
    * After creating a new leaf page from buffer pool, must call initialize
    * method to set default values
    * @param max_size Max size of the leaf node
+   * @param layout Pax makes a PageType::PaxLeaf page
    */
-  void Init(int max_size, size_t key_size, size_t value_size);
+  void Init(int max_size, size_t key_size, size_t value_size,
+            LeafLayout layout = LeafLayout::Row);
+
+  auto GetLayout() const -> LeafLayout;
 
   // helper methods
   auto GetNextPageId() const -> page_id_t;
@@ -48,9 +63,25 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void SetKeyAt(int index, const Tuple &key);
   void SetValueAt(int index, const Tuple &value);
 
+  /**
+   * The values of a cloum of the values in a Pax leaf, the one of entry i
+   * at i * its size, so a scan of the cloum reads only its own bytes.
+   * @param index the cloum in value_type
+   * @return nullptr if the leaf isn't a Pax one
+   */
+  auto ValueCloumAt(size_t index, const std::vector<Cloum> &value_type) const
+      -> const char *;
+
   auto BinarySearch(const Tuple &key, std::vector<Cloum> &key_type) const
       -> int;
 
+  /**
+   * @return index of the first key that is not less than key, or GetSize()
+   * if every key in this page is less than key
+   */
+  auto LowerBound(const Tuple &key, std::vector<Cloum> &key_type) const
+      -> int;
+
   auto Insert(const Tuple &key, const Tuple &value,
               std::vector<Cloum> &key_type, std::vector<Cloum> &value_type)
       -> int;
@@ -65,6 +96,17 @@ class BPlusTreeLeafPage : public BPlusTreePage {
               bool have_father) -> int;
 
  private:
+  // The offset of a cloum in a Pax leaf, base is where the cloums of the
+  // keys or of the values start.
+  auto CloumOffset(size_t base, const std::vector<Cloum> &cols,
+                   size_t index) const -> size_t;
+  // Copy the cloums of entry index out of their places in a Pax leaf.
+  void Gather(size_t base, int index, const std::vector<Cloum> &cols,
+              char *dst) const;
+  // Copy the cloums of a tuple into their places of entry index.
+  void Scatter(size_t base, int index, const std::vector<Cloum> &cols,
+               const char *src);
+
   page_id_t next_page_id_;
   // Flexible array member for page data.
   char data_[0];
@@ -1,7 +1,15 @@
 #pragma once
 #include <cstddef>
+
+#include "config/config.h"
 namespace spdb {
-enum class PageType { Leaf, Internal };
+enum class PageType { Leaf, Internal, PaxLeaf };
+
+/**
+ * How a leaf stores its entries: Row keeps every key next to its value,
+ * Pax keeps the values of each cloum together.
+ */
+enum class LeafLayout { Row, Pax };
 
 class BPlusTreePage {
  public:
@@ -11,6 +19,7 @@ class BPlusTreePage {
   ~BPlusTreePage() = delete;
 
   auto IsLeafPage() const -> bool;
+  auto GetPageType() const -> PageType;
   void SetPageType(PageType page_type);
 
   auto GetSize() const -> int;
@@ -28,9 +37,15 @@ class BPlusTreePage {
 
  private:
   // member variable, attributes that both internal and leaf page share
+  // the LSN should stay the first field, the buffer pool reads it as raw bytes
+  lsn_t lsn_;
+  // at PAGE_FLAGS_OFFSET, PAGE_CHECKSUM_FLAG is only set on the disk
   PageType page_type_;
   int size_;
   int max_size_;
+  // set by the buffer pool as the page is written back, at
+  // PAGE_CHECKSUM_OFFSET, if the file is registered with checksums
+  uint32_t checksum_;
   size_t key_size_;
   size_t value_size_;
 };
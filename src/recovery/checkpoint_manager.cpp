@@ -0,0 +1,92 @@
+#include "recovery/checkpoint_manager.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <stdexcept>
+
+namespace spdb {
+CheckpointManager::CheckpointManager(LogManager *log_manager,
+                                     BufferPool *buffer_pool,
+                                     size_t interval_ms, size_t rto_ms)
+    : log_manager_(log_manager),
+      buffer_pool_(buffer_pool),
+      interval_ms_(interval_ms),
+      redo_bytes_(rto_ms * (REDO_BYTES_PER_SECOND / 1000)) {}
+
+CheckpointManager::~CheckpointManager() { Stop(); }
+
+void CheckpointManager::Start() {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (is_running_) {
+    return;
+  }
+  is_running_ = true;
+  thread_ = std::thread([this] { CheckpointThread(); });
+}
+
+void CheckpointManager::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    is_running_ = false;
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+auto CheckpointManager::Checkpoint() -> lsn_t {
+  std::lock_guard<std::mutex> lock(checkpoint_latch_);
+  lsn_t scan_lsn = log_manager_->GetNextLSN();
+  size_t appended_bytes = log_manager_->GetAppendedBytes();
+
+  buffer_pool_->FlushOldPages(last_scan_lsn_);
+  auto dirty_pages = buffer_pool_->GetDirtyPages();
+  // the pages written back before the dirty page table was collected, here
+  // or by evictions, are on disk before their records are dropped
+  buffer_pool_->SyncFiles();
+
+  lsn_t lsn = log_manager_->AppendCheckpoint(scan_lsn, dirty_pages);
+  log_manager_->Flush(lsn);
+
+  // the recovery redoes from the first record dirtying a page in the table,
+  // or from the scan, whichever is first
+  lsn_t truncation_lsn = scan_lsn;
+  for (auto &page : dirty_pages) {
+    truncation_lsn = std::min(truncation_lsn, page.rec_lsn_);
+  }
+  log_manager_->SetTruncationLSN(truncation_lsn);
+
+  last_scan_lsn_ = scan_lsn;
+  last_appended_bytes_ = appended_bytes;
+  ++checkpoint_count_;
+  return lsn;
+}
+
+void CheckpointManager::CheckpointThread() {
+  auto last = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(latch_);
+  while (is_running_) {
+    cv_.wait_for(lock, std::chrono::milliseconds(LOG_TIMEOUT_MS));
+    if (!is_running_) {
+      break;
+    }
+    auto now = std::chrono::steady_clock::now();
+    bool is_due = now - last >= std::chrono::milliseconds(interval_ms_) ||
+                  log_manager_->GetAppendedBytes() - last_appended_bytes_ >=
+                      redo_bytes_;
+    if (!is_due) {
+      continue;
+    }
+    lock.unlock();
+    try {
+      Checkpoint();
+    } catch (std::runtime_error &e) {
+      // the log or the files can't be written, the commits fail with it
+      return;
+    }
+    lock.lock();
+    last = std::chrono::steady_clock::now();
+  }
+}
+}  // namespace spdb
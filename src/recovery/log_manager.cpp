@@ -0,0 +1,386 @@
+#include "recovery/log_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace spdb {
+// the transaction the calling thread is running
+static thread_local txn_id_t current_txn = INVALID_TXN_ID;
+
+static void WriteAll(int fd, const char *data, size_t size) {
+  size_t offset = 0;
+  while (offset < size) {
+    ssize_t n = write(fd, data + offset, size - offset);
+    if (n < 0) {
+      throw std::runtime_error("write log error.");
+    }
+    offset += n;
+  }
+}
+
+LogManager::LogManager(const std::string &log_name) : log_name_(log_name) {
+  fd_ = open(log_name_.data(), O_RDWR | O_CREAT, 0644);
+  if (fd_ == -1) {
+    throw std::runtime_error("can't open log file");
+  }
+
+  // go on after the records already in the log
+  size_t offset = 0;
+  for (auto &record : ReadLog(log_name_)) {
+    if (batches_.empty()) {
+      batches_.emplace_back(record.lsn_, 0);
+    }
+    next_lsn_ = record.lsn_ + 1;
+    if (record.txn_id_ >= next_txn_id_) {
+      next_txn_id_ = record.txn_id_ + 1;
+    }
+    offset += record.GetSize();
+  }
+  persistent_lsn_ = next_lsn_ - 1;
+  // drop the torn tail of a record which was being written
+  if (ftruncate(fd_, offset) != 0) {
+    throw std::runtime_error("can't truncate log file");
+  }
+  lseek(fd_, offset, SEEK_SET);
+  file_size_ = offset;
+
+  flush_thread_ = std::thread([this] { FlushThread(); });
+}
+
+auto LogManager::ReadLog(const std::string &log_name)
+    -> std::vector<LogRecord> {
+  std::ifstream file(log_name, std::ios::binary | std::ios::ate);
+  std::string log(file.is_open() ? static_cast<size_t>(file.tellg()) : 0, '\0');
+  file.seekg(0);
+  file.read(log.data(), log.size());
+  std::vector<LogRecord> records;
+  size_t offset = 0;
+  LogRecord record;
+  while (LogRecord::Deserialize(log.data() + offset, log.size() - offset,
+                                &record)) {
+    offset += record.GetSize();
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+LogManager::~LogManager() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    is_running_ = false;
+  }
+  flush_cv_.notify_one();
+  flush_thread_.join();
+  close(fd_);
+}
+
+auto LogManager::AppendRecord(LogRecord *record) -> lsn_t {
+  record->lsn_ = next_lsn_++;
+  if (log_buffer_.empty()) {
+    buffer_first_lsn_ = record->lsn_;
+  }
+  size_t size = log_buffer_.size();
+  record->SerializeTo(&log_buffer_);
+  appended_bytes_ += log_buffer_.size() - size;
+  if (record->txn_id_ != INVALID_TXN_ID) {
+    txn_last_lsn_[record->txn_id_] = record->lsn_;
+  }
+  if (log_buffer_.size() >= LOG_BUFFER_SIZE) {
+    flush_cv_.notify_one();
+  }
+  return record->lsn_;
+}
+
+auto LogManager::Begin() -> txn_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  txn_id_t txn_id = next_txn_id_++;
+  LogRecord record(txn_id, INVALID_LSN, LogRecordType::BEGIN);
+  txn_first_lsn_[txn_id] = AppendRecord(&record);
+  current_txn = txn_id;
+  return txn_id;
+}
+
+void LogManager::Resume(txn_id_t txn_id) { current_txn = txn_id; }
+
+void LogManager::Resume(txn_id_t txn_id, lsn_t last_lsn) {
+  std::lock_guard<std::mutex> lock(latch_);
+  txn_last_lsn_[txn_id] = last_lsn;
+  current_txn = txn_id;
+}
+
+void LogManager::Commit(txn_id_t txn_id) {
+  lsn_t lsn = INVALID_LSN;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    LogRecord record(txn_id, txn_last_lsn_[txn_id], LogRecordType::COMMIT);
+    lsn = AppendRecord(&record);
+    txn_first_lsn_.erase(txn_id);
+    txn_last_lsn_.erase(txn_id);
+  }
+  current_txn = INVALID_TXN_ID;
+  Flush(lsn);
+  ++commit_count_;
+}
+
+void LogManager::Abort(txn_id_t txn_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  LogRecord record(txn_id, txn_last_lsn_[txn_id], LogRecordType::ABORT);
+  AppendRecord(&record);
+  txn_first_lsn_.erase(txn_id);
+  txn_last_lsn_.erase(txn_id);
+  current_txn = INVALID_TXN_ID;
+}
+
+auto LogManager::AppendPageUpdate(const std::string &file_name,
+                                  page_id_t page_id, const char *before,
+                                  const char *after) -> lsn_t {
+  // only the changed range of the page is logged
+  int begin = sizeof(lsn_t);
+  while (begin < PAGE_SIZE && before[begin] == after[begin]) {
+    ++begin;
+  }
+  if (begin == PAGE_SIZE) {
+    return INVALID_LSN;
+  }
+  int end = PAGE_SIZE;
+  while (before[end - 1] == after[end - 1]) {
+    --end;
+  }
+
+  std::lock_guard<std::mutex> lock(latch_);
+  lsn_t prev_lsn = INVALID_LSN;
+  if (current_txn != INVALID_TXN_ID) {
+    prev_lsn = txn_last_lsn_[current_txn];
+  }
+  LogRecord record(current_txn, prev_lsn, file_name, page_id, begin,
+                   std::string(before + begin, end - begin),
+                   std::string(after + begin, end - begin));
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendRootUpdate(const std::string &file_name,
+                                  page_id_t old_root, page_id_t new_root)
+    -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  lsn_t prev_lsn = INVALID_LSN;
+  if (current_txn != INVALID_TXN_ID) {
+    prev_lsn = txn_last_lsn_[current_txn];
+  }
+  LogRecord record(current_txn, prev_lsn, file_name, INVALID_PAGE_ID, 0,
+                   std::string((char *)&old_root, sizeof(page_id_t)),
+                   std::string((char *)&new_root, sizeof(page_id_t)));
+  record.type_ = LogRecordType::ROOT_UPDATE;
+  roots_[file_name] = new_root;
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendClr(const LogRecord &undone) -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  LogRecord record(undone.txn_id_, txn_last_lsn_[undone.txn_id_],
+                   undone.file_name_, undone.page_id_, undone.offset_,
+                   undone.after_image_, undone.before_image_);
+  record.type_ = LogRecordType::CLR;
+  record.undo_next_lsn_ = undone.prev_lsn_;
+  if (undone.type_ == LogRecordType::ROOT_UPDATE) {
+    memcpy(&roots_[undone.file_name_], undone.before_image_.data(),
+           sizeof(page_id_t));
+  }
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendRowUpdate(const std::string &file_name,
+                                 const std::string &key,
+                                 const std::string &row, lsn_t *prev_lsn)
+    -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  LogRecord record(current_txn, txn_last_lsn_[current_txn],
+                   LogRecordType::ROW_UPDATE);
+  record.file_name_ = file_name;
+  record.key_ = key;
+  record.row_ = row;
+  *prev_lsn = record.prev_lsn_;
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendRowClr(lsn_t undo_next_lsn) -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  LogRecord record(current_txn, txn_last_lsn_[current_txn],
+                   LogRecordType::ROW_CLR);
+  record.undo_next_lsn_ = undo_next_lsn;
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendStatementEnd() -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (current_txn == INVALID_TXN_ID) {
+    return INVALID_LSN;
+  }
+  LogRecord record(current_txn, txn_last_lsn_[current_txn],
+                   LogRecordType::STATEMENT_END);
+  return AppendRecord(&record);
+}
+
+auto LogManager::AppendCheckpoint(lsn_t scan_lsn,
+                                  const std::vector<DirtyPage> &dirty_pages)
+    -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  LogRecord record(INVALID_TXN_ID, INVALID_LSN, LogRecordType::CHECKPOINT);
+  record.scan_lsn_ = scan_lsn;
+  record.active_txns_.assign(txn_last_lsn_.begin(), txn_last_lsn_.end());
+  record.dirty_pages_ = dirty_pages;
+  record.roots_.assign(roots_.begin(), roots_.end());
+  return AppendRecord(&record);
+}
+
+void LogManager::SetTruncationLSN(lsn_t lsn) {
+  std::lock_guard<std::mutex> lock(latch_);
+  // the flusher looks at it on its next round
+  truncation_lsn_ = std::max(truncation_lsn_, lsn);
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock<std::mutex> lock(latch_);
+  if (lsn >= next_lsn_) {
+    lsn = next_lsn_ - 1;
+  }
+  if (lsn <= persistent_lsn_) {
+    return;
+  }
+  flush_requested_ = true;
+  flush_cv_.notify_one();
+  persistent_cv_.wait(
+      lock, [&] { return persistent_lsn_ >= lsn || error_ != nullptr; });
+  if (persistent_lsn_ < lsn) {
+    std::rethrow_exception(error_);
+  }
+}
+
+void LogManager::FlushAll() { Flush(GetNextLSN() - 1); }
+
+auto LogManager::GetPersistentLSN() -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return persistent_lsn_;
+}
+
+auto LogManager::GetNextLSN() -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return next_lsn_;
+}
+
+auto LogManager::GetFirstLSN() -> lsn_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return batches_.empty() ? INVALID_LSN : batches_.front().first;
+}
+
+auto LogManager::GetLogSize() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return file_size_ + log_buffer_.size();
+}
+
+void LogManager::FlushThread() {
+  try {
+    FlushBatches();
+  } catch (std::exception &e) {
+    std::lock_guard<std::mutex> lock(latch_);
+    error_ = std::current_exception();
+    persistent_cv_.notify_all();
+  }
+}
+
+void LogManager::FlushBatches() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    flush_cv_.wait_for(lock, std::chrono::milliseconds(LOG_TIMEOUT_MS), [&] {
+      return !is_running_ || flush_requested_ ||
+             log_buffer_.size() >= LOG_BUFFER_SIZE;
+    });
+    if (!log_buffer_.empty()) {
+      // everything appended until now goes out with one sync, the records
+      // appended meanwhile wait for the next one
+      std::swap(log_buffer_, flush_buffer_);
+      lsn_t lsn = next_lsn_ - 1;
+      lsn_t first_lsn = buffer_first_lsn_;
+      flush_requested_ = false;
+      lock.unlock();
+
+      WriteAll(fd_, flush_buffer_.data(), flush_buffer_.size());
+      if (fdatasync(fd_) != 0) {
+        throw std::runtime_error("sync log error.");
+      }
+      ++sync_count_;
+
+      lock.lock();
+      batches_.emplace_back(first_lsn, file_size_);
+      file_size_ += flush_buffer_.size();
+      flush_buffer_.clear();
+      persistent_lsn_ = lsn;
+      persistent_cv_.notify_all();
+    } else {
+      flush_requested_ = false;
+      if (!is_running_) {
+        break;
+      }
+    }
+
+    // truncate to the last batch starting before the truncation point and
+    // the first record of every running transaction
+    lsn_t lsn = truncation_lsn_;
+    for (auto &[txn_id, first_lsn] : txn_first_lsn_) {
+      lsn = std::min(lsn, first_lsn);
+    }
+    size_t offset = 0;
+    for (auto &[first_lsn, batch_offset] : batches_) {
+      if (first_lsn > lsn) {
+        break;
+      }
+      offset = batch_offset;
+    }
+    if (offset > 0) {
+      lock.unlock();
+      Truncate(offset);
+      lock.lock();
+      while (batches_.front().second < offset) {
+        batches_.pop_front();
+      }
+      for (auto &batch : batches_) {
+        batch.second -= offset;
+      }
+      file_size_ -= offset;
+    }
+  }
+}
+
+void LogManager::Truncate(size_t offset) {
+  // only the flusher changes the file, so its size is stable here
+  std::string tail(file_size_ - offset, '\0');
+  size_t read_size = 0;
+  while (read_size < tail.size()) {
+    ssize_t n = pread(fd_, tail.data() + read_size, tail.size() - read_size,
+                      offset + read_size);
+    if (n <= 0) {
+      throw std::runtime_error("read log error.");
+    }
+    read_size += n;
+  }
+
+  // a crash leaves either the whole log or the truncated one
+  std::string tmp_name = log_name_ + ".tmp";
+  int fd = open(tmp_name.data(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1) {
+    throw std::runtime_error("can't open log file");
+  }
+  WriteAll(fd, tail.data(), tail.size());
+  if (fsync(fd) != 0 || std::rename(tmp_name.data(), log_name_.data()) != 0) {
+    throw std::runtime_error("truncate log error.");
+  }
+  close(fd_);
+  fd_ = fd;
+}
+}  // namespace spdb
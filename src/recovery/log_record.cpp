@@ -0,0 +1,240 @@
+#include "recovery/log_record.h"
+
+#include <cstring>
+
+namespace spdb {
+template <class T>
+static void Put(std::string *dst, const T &value) {
+  dst->append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <class T>
+static auto Get(const char *src, size_t *offset) -> T {
+  T value;
+  memcpy(&value, src + *offset, sizeof(T));
+  *offset += sizeof(T);
+  return value;
+}
+
+auto LogRecord::GetSize() const -> size_t {
+  if (type_ == LogRecordType::CHECKPOINT) {
+    size_t size = HEADER_SIZE + sizeof(lsn_t) + 3 * sizeof(int) +
+                  active_txns_.size() * (sizeof(txn_id_t) + sizeof(lsn_t));
+    for (auto &page : dirty_pages_) {
+      size += sizeof(int) + page.file_name_.size() + sizeof(page_id_t) +
+              sizeof(lsn_t);
+    }
+    for (auto &[file_name, root_id] : roots_) {
+      size += sizeof(int) + file_name.size() + sizeof(page_id_t);
+    }
+    return size;
+  }
+  if (type_ == LogRecordType::ROW_UPDATE) {
+    return HEADER_SIZE + 3 * sizeof(int) + file_name_.size() + key_.size() +
+           row_.size();
+  }
+  if (type_ == LogRecordType::ROW_CLR) {
+    return HEADER_SIZE + sizeof(lsn_t);
+  }
+  if (!HasPayload()) {
+    return HEADER_SIZE;
+  }
+  size_t size = HEADER_SIZE + sizeof(int) + file_name_.size() +
+                sizeof(page_id_t) + sizeof(int) + sizeof(int) +
+                before_image_.size() + after_image_.size();
+  return type_ == LogRecordType::CLR ? size + sizeof(lsn_t) : size;
+}
+
+void LogRecord::SerializeTo(std::string *dst) const {
+  Put(dst, static_cast<int>(GetSize()));
+  Put(dst, lsn_);
+  Put(dst, txn_id_);
+  Put(dst, prev_lsn_);
+  Put(dst, type_);
+  if (type_ == LogRecordType::CHECKPOINT) {
+    Put(dst, scan_lsn_);
+    Put(dst, static_cast<int>(active_txns_.size()));
+    for (auto &[txn_id, lsn] : active_txns_) {
+      Put(dst, txn_id);
+      Put(dst, lsn);
+    }
+    Put(dst, static_cast<int>(dirty_pages_.size()));
+    for (auto &page : dirty_pages_) {
+      Put(dst, static_cast<int>(page.file_name_.size()));
+      dst->append(page.file_name_);
+      Put(dst, page.page_id_);
+      Put(dst, page.rec_lsn_);
+    }
+    Put(dst, static_cast<int>(roots_.size()));
+    for (auto &[file_name, root_id] : roots_) {
+      Put(dst, static_cast<int>(file_name.size()));
+      dst->append(file_name);
+      Put(dst, root_id);
+    }
+    return;
+  }
+  if (type_ == LogRecordType::ROW_UPDATE) {
+    for (auto *field : {&file_name_, &key_, &row_}) {
+      Put(dst, static_cast<int>(field->size()));
+      dst->append(*field);
+    }
+    return;
+  }
+  if (type_ == LogRecordType::ROW_CLR) {
+    Put(dst, undo_next_lsn_);
+    return;
+  }
+  if (!HasPayload()) {
+    return;
+  }
+  Put(dst, static_cast<int>(file_name_.size()));
+  dst->append(file_name_);
+  Put(dst, page_id_);
+  Put(dst, offset_);
+  Put(dst, static_cast<int>(after_image_.size()));
+  dst->append(before_image_);
+  dst->append(after_image_);
+  if (type_ == LogRecordType::CLR) {
+    Put(dst, undo_next_lsn_);
+  }
+}
+
+// The checkpoint payload of a record of record_size bytes, from offset on.
+static auto DeserializeCheckpoint(const char *src, size_t record_size,
+                                  size_t offset, LogRecord *record) -> bool {
+  // every read is checked against the size of the record first
+  auto has = [&](size_t size) { return offset + size <= record_size; };
+  auto get_name = [&](std::string *name) {
+    if (!has(sizeof(int))) {
+      return false;
+    }
+    auto length = Get<int>(src, &offset);
+    if (length < 0 || !has(length)) {
+      return false;
+    }
+    name->assign(src + offset, length);
+    offset += length;
+    return true;
+  };
+
+  if (!has(sizeof(lsn_t) + sizeof(int))) {
+    return false;
+  }
+  record->scan_lsn_ = Get<lsn_t>(src, &offset);
+  auto txn_nums = Get<int>(src, &offset);
+  record->active_txns_.clear();
+  for (int i = 0; i < txn_nums; ++i) {
+    if (!has(sizeof(txn_id_t) + sizeof(lsn_t))) {
+      return false;
+    }
+    auto txn_id = Get<txn_id_t>(src, &offset);
+    record->active_txns_.emplace_back(txn_id, Get<lsn_t>(src, &offset));
+  }
+
+  if (!has(sizeof(int))) {
+    return false;
+  }
+  auto page_nums = Get<int>(src, &offset);
+  record->dirty_pages_.clear();
+  for (int i = 0; i < page_nums; ++i) {
+    DirtyPage page;
+    if (!get_name(&page.file_name_) ||
+        !has(sizeof(page_id_t) + sizeof(lsn_t))) {
+      return false;
+    }
+    page.page_id_ = Get<page_id_t>(src, &offset);
+    page.rec_lsn_ = Get<lsn_t>(src, &offset);
+    record->dirty_pages_.push_back(std::move(page));
+  }
+
+  if (!has(sizeof(int))) {
+    return false;
+  }
+  auto root_nums = Get<int>(src, &offset);
+  record->roots_.clear();
+  for (int i = 0; i < root_nums; ++i) {
+    std::string file_name;
+    if (!get_name(&file_name) || !has(sizeof(page_id_t))) {
+      return false;
+    }
+    record->roots_.emplace_back(file_name, Get<page_id_t>(src, &offset));
+  }
+  return offset == record_size;
+}
+
+// The row update payload of a record of record_size bytes, from offset on.
+static auto DeserializeRowUpdate(const char *src, size_t record_size,
+                                 size_t offset, LogRecord *record) -> bool {
+  for (auto *field : {&record->file_name_, &record->key_, &record->row_}) {
+    if (offset + sizeof(int) > record_size) {
+      return false;
+    }
+    auto length = Get<int>(src, &offset);
+    if (length < 0 || offset + length > record_size) {
+      return false;
+    }
+    field->assign(src + offset, length);
+    offset += length;
+  }
+  return offset == record_size;
+}
+
+auto LogRecord::Deserialize(const char *src, size_t size, LogRecord *record)
+    -> bool {
+  if (size < HEADER_SIZE) {
+    return false;
+  }
+  size_t offset = 0;
+  auto record_size = Get<int>(src, &offset);
+  if (record_size < static_cast<int>(HEADER_SIZE) ||
+      static_cast<size_t>(record_size) > size) {
+    return false;
+  }
+  record->lsn_ = Get<lsn_t>(src, &offset);
+  record->txn_id_ = Get<txn_id_t>(src, &offset);
+  record->prev_lsn_ = Get<lsn_t>(src, &offset);
+  record->type_ = Get<LogRecordType>(src, &offset);
+  if (record->type_ == LogRecordType::CHECKPOINT) {
+    return DeserializeCheckpoint(src, record_size, offset, record);
+  }
+  if (record->type_ == LogRecordType::ROW_UPDATE) {
+    return DeserializeRowUpdate(src, record_size, offset, record);
+  }
+  if (record->type_ == LogRecordType::ROW_CLR) {
+    if (record_size != static_cast<int>(HEADER_SIZE + sizeof(lsn_t))) {
+      return false;
+    }
+    record->undo_next_lsn_ = Get<lsn_t>(src, &offset);
+    return true;
+  }
+  if (!record->HasPayload()) {
+    return record->type_ != LogRecordType::INVALID &&
+           record_size == static_cast<int>(HEADER_SIZE);
+  }
+
+  auto name_length = Get<int>(src, &offset);
+  if (name_length < 0 || offset + name_length + 3 * sizeof(int) > size) {
+    return false;
+  }
+  record->file_name_.assign(src + offset, name_length);
+  offset += name_length;
+  record->page_id_ = Get<page_id_t>(src, &offset);
+  record->offset_ = Get<int>(src, &offset);
+  auto length = Get<int>(src, &offset);
+  size_t tail = record->type_ == LogRecordType::CLR ? sizeof(lsn_t) : 0;
+  if (length < 0 || record->offset_ < 0 ||
+      record->offset_ + length > PAGE_SIZE ||
+      offset + 2 * static_cast<size_t>(length) + tail !=
+          static_cast<size_t>(record_size)) {
+    return false;
+  }
+  record->before_image_.assign(src + offset, length);
+  record->after_image_.assign(src + offset + length, length);
+  offset += 2 * length;
+  record->undo_next_lsn_ = INVALID_LSN;
+  if (record->type_ == LogRecordType::CLR) {
+    record->undo_next_lsn_ = Get<lsn_t>(src, &offset);
+  }
+  return true;
+}
+}  // namespace spdb
@@ -0,0 +1,284 @@
+#include "recovery/recovery_manager.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <thread>  // NOLINT
+#include <unordered_set>
+
+namespace spdb {
+static auto PageKey(const LogRecord &record) -> std::string {
+  return record.file_name_ + ":" + std::to_string(record.page_id_);
+}
+
+static auto IsPageRecord(const LogRecord &record) -> bool {
+  return record.HasPayload() && record.page_id_ != INVALID_PAGE_ID;
+}
+
+static auto IsRootRecord(const LogRecord &record) -> bool {
+  return record.HasPayload() && record.page_id_ == INVALID_PAGE_ID;
+}
+
+RecoveryManager::RecoveryManager(LogManager *log_manager, Catalog *catalog,
+                                 size_t redo_thread_nums)
+    : log_manager_(log_manager),
+      catalog_(catalog),
+      redo_thread_nums_(redo_thread_nums == 0 ? 1 : redo_thread_nums) {}
+
+void RecoveryManager::Recover() {
+  records_ = LogManager::ReadLog(log_manager_->GetLogName());
+  lsn_index_.clear();
+  active_txns_.clear();
+  dirty_pages_.clear();
+  files_.clear();
+  roots_.clear();
+  checkpoint_ = nullptr;
+  redo_count_ = 0;
+  undo_count_ = 0;
+
+  Analysis();
+  Redo();
+  // the rows are undone through the trees from the roots as of the crash
+  for (auto &[file_name, root_id] : roots_) {
+    if (GetFile(file_name) != nullptr) {
+      catalog_->SetRoot(file_name, root_id);
+    }
+  }
+  Undo();
+
+  // the CLRs go to disk before the catalog refers to the rolled back roots
+  catalog_->Save();
+  records_.clear();
+}
+
+auto RecoveryManager::GetFile(const std::string &file_name)
+    -> BufferPoolManager * {
+  auto it = files_.find(file_name);
+  if (it != files_.end()) {
+    return it->second;
+  }
+  BufferPoolManager *bpm = nullptr;
+  if (catalog_->IsFileExisted(file_name)) {
+    bpm = catalog_->GetBufferPoolManager(file_name);
+  }
+  files_[file_name] = bpm;
+  return bpm;
+}
+
+auto RecoveryManager::LoadCheckpoint() -> size_t {
+  size_t index = records_.size();
+  for (size_t i = 0; i < records_.size(); ++i) {
+    if (records_[i].type_ == LogRecordType::CHECKPOINT) {
+      index = i;
+    }
+  }
+  if (index == records_.size()) {
+    return index;
+  }
+  checkpoint_ = &records_[index];
+  for (auto &[txn_id, lsn] : checkpoint_->active_txns_) {
+    active_txns_[txn_id] = lsn;
+  }
+  for (auto &page : checkpoint_->dirty_pages_) {
+    dirty_pages_[page.file_name_ + ":" + std::to_string(page.page_id_)] =
+        page.rec_lsn_;
+    GetFile(page.file_name_);
+  }
+  for (auto &[file_name, root_id] : checkpoint_->roots_) {
+    roots_[file_name] = root_id;
+    GetFile(file_name);
+  }
+  return index;
+}
+
+void RecoveryManager::Analysis() {
+  size_t checkpoint_index = LoadCheckpoint();
+  lsn_t scan_lsn =
+      checkpoint_ == nullptr ? INVALID_LSN : checkpoint_->scan_lsn_;
+  for (size_t i = 0; i < records_.size(); ++i) {
+    auto &record = records_[i];
+    lsn_index_[record.lsn_] = i;
+    // the pages dirtied after the scan may be missing from the checkpoint
+    if (IsPageRecord(record) && record.lsn_ >= scan_lsn) {
+      auto [it, is_new] = dirty_pages_.emplace(PageKey(record), record.lsn_);
+      it->second = std::min(it->second, record.lsn_);
+    }
+    // open the files here, so that the redo threads only look them up
+    if (record.HasPayload()) {
+      GetFile(record.file_name_);
+    }
+    if (checkpoint_ != nullptr && i <= checkpoint_index) {
+      continue;
+    }
+    switch (record.type_) {
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        active_txns_.erase(record.txn_id_);
+        break;
+      default:
+        if (record.txn_id_ != INVALID_TXN_ID) {
+          active_txns_[record.txn_id_] = record.lsn_;
+        }
+        break;
+    }
+  }
+}
+
+void RecoveryManager::Redo() {
+  std::vector<std::vector<const LogRecord *>> partitions(redo_thread_nums_);
+  std::hash<std::string> hash;
+  lsn_t checkpoint_lsn =
+      checkpoint_ == nullptr ? INVALID_LSN : checkpoint_->lsn_;
+  for (auto &record : records_) {
+    // the roots as of the checkpoint come with it
+    if (IsRootRecord(record) && record.lsn_ > checkpoint_lsn) {
+      page_id_t root_id = INVALID_PAGE_ID;
+      memcpy(&root_id, record.after_image_.data(), sizeof(page_id_t));
+      roots_[record.file_name_] = root_id;
+      continue;
+    }
+    if (!IsPageRecord(record) || files_[record.file_name_] == nullptr) {
+      continue;
+    }
+    // the page was written back after this record
+    auto key = PageKey(record);
+    auto it = dirty_pages_.find(key);
+    if (it == dirty_pages_.end() || record.lsn_ < it->second) {
+      continue;
+    }
+    partitions[hash(key) % redo_thread_nums_].push_back(&record);
+  }
+
+  std::vector<std::thread> threads;
+  for (auto &partition : partitions) {
+    threads.emplace_back([this, &partition] { RedoPartition(partition); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void RecoveryManager::RedoPartition(
+    const std::vector<const LogRecord *> &records) {
+  for (auto record : records) {
+    auto bpm = files_.at(record->file_name_);
+    bpm->ExtendTo(record->page_id_);
+    Page *page = bpm->FetchPage(record->page_id_);
+    if (page == nullptr) {
+      throw std::runtime_error("recovery: the buffer pool is full.");
+    }
+    bool is_redone = page->GetLSN() < record->lsn_;
+    if (is_redone) {
+      memcpy(page->GetData() + record->offset_, record->after_image_.data(),
+             record->after_image_.size());
+      page->SetLSN(record->lsn_);
+      ++redo_count_;
+    }
+    bpm->UnpinPage(record->page_id_, is_redone);
+  }
+}
+
+void RecoveryManager::ApplyToPage(const LogRecord &record,
+                                  const std::string &image, lsn_t lsn) {
+  auto bpm = files_[record.file_name_];
+  if (bpm == nullptr) {
+    return;
+  }
+  bpm->ExtendTo(record.page_id_);
+  Page *page = bpm->FetchPage(record.page_id_);
+  if (page == nullptr) {
+    throw std::runtime_error("recovery: the buffer pool is full.");
+  }
+  memcpy(page->GetData() + record.offset_, image.data(), image.size());
+  page->SetLSN(lsn);
+  bpm->UnpinPage(record.page_id_, true);
+}
+
+void RecoveryManager::UndoRow(const LogRecord &record) {
+  if (!catalog_->IsExisted(record.file_name_)) {
+    return;
+  }
+  auto table = catalog_->GetTable(record.file_name_);
+  std::string key_data = record.key_;
+  Tuple key{table.key_type_};
+  key.SetValues(key_data.data());
+  std::string row_data = record.row_;
+  Tuple row{table.value_type_};
+  if (!row_data.empty()) {
+    row.SetValues(row_data.data());
+  }
+  // the pages are logged under the transaction, so that an undo cut short
+  // by a crash is undone by its pages
+  log_manager_->Resume(record.txn_id_);
+  catalog_->RestoreRow(record.file_name_, key,
+                       row_data.empty() ? nullptr : &row);
+  log_manager_->AppendRowClr(record.prev_lsn_);
+  log_manager_->Resume(INVALID_TXN_ID);
+}
+
+void RecoveryManager::Undo() {
+  // undo the records of all the unfinished transactions, latest first
+  std::priority_queue<lsn_t> to_undo;
+  for (auto &[txn_id, lsn] : active_txns_) {
+    to_undo.push(lsn);
+    log_manager_->Resume(txn_id, lsn);
+  }
+  log_manager_->Resume(INVALID_TXN_ID);
+  // the transactions whose records left belong to ended statements
+  std::unordered_set<txn_id_t> ended;
+  while (!to_undo.empty()) {
+    auto &record = records_[lsn_index_.at(to_undo.top())];
+    to_undo.pop();
+
+    lsn_t next = record.prev_lsn_;
+    bool is_ended = ended.count(record.txn_id_) != 0;
+    switch (record.type_) {
+      case LogRecordType::PAGE_UPDATE:
+      case LogRecordType::ROOT_UPDATE: {
+        // other transactions may have written the pages of an ended
+        // statement since, it is undone by its rows
+        if (is_ended) {
+          break;
+        }
+        lsn_t clr_lsn = log_manager_->AppendClr(record);
+        if (record.type_ == LogRecordType::PAGE_UPDATE) {
+          ApplyToPage(record, record.before_image_, clr_lsn);
+        } else {
+          page_id_t root_id = INVALID_PAGE_ID;
+          memcpy(&root_id, record.before_image_.data(), sizeof(page_id_t));
+          catalog_->SetRoot(record.file_name_, root_id);
+        }
+        ++undo_count_;
+        break;
+      }
+      case LogRecordType::ROW_UPDATE:
+        // the row of the statement cut short is back with its pages
+        if (is_ended) {
+          UndoRow(record);
+          ++undo_count_;
+        }
+        break;
+      case LogRecordType::CLR:
+        // the records before it are undone already
+        next = record.undo_next_lsn_;
+        break;
+      case LogRecordType::ROW_CLR:
+        next = record.undo_next_lsn_;
+        ended.insert(record.txn_id_);
+        break;
+      case LogRecordType::STATEMENT_END:
+        ended.insert(record.txn_id_);
+        break;
+      default:
+        break;
+    }
+
+    if (next != INVALID_LSN) {
+      to_undo.push(next);
+    } else {
+      log_manager_->Abort(record.txn_id_);
+    }
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,176 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "config/config.h"
+
+// A connection to the server, sending a statement and waiting for its reply.
+class Client {
+ public:
+  Client(const std::string &host, uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+      throw std::runtime_error("invalid address " + host);
+    }
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0 ||
+        connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+      throw std::runtime_error(std::string("can't connect: ") +
+                               strerror(errno));
+    }
+    int on = 1;
+    setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+
+  ~Client() { close(fd_); }
+
+  /** @return the reply, without the line ending it */
+  auto Execute(const std::string &statement) -> std::string {
+    std::string request = statement + "\n";
+    size_t sent = 0;
+    while (sent < request.size()) {
+      ssize_t n = send(fd_, request.data() + sent, request.size() - sent,
+                       MSG_NOSIGNAL);
+      if (n <= 0) {
+        throw std::runtime_error("connection lost");
+      }
+      sent += n;
+    }
+    std::string reply;
+    while (true) {
+      size_t end = input_.find('\n');
+      if (end == std::string::npos) {
+        char buffer[4096];
+        ssize_t n = read(fd_, buffer, sizeof(buffer));
+        if (n <= 0) {
+          throw std::runtime_error("connection lost");
+        }
+        input_.append(buffer, n);
+        continue;
+      }
+      std::string line = input_.substr(0, end);
+      input_.erase(0, end + 1);
+      if (line == ".") {
+        return reply;
+      }
+      reply += (line[0] == '.' ? line.substr(1) : line) + "\n";
+    }
+  }
+
+ private:
+  int fd_;
+  std::string input_;
+};
+
+int main(int argc, char **argv) {
+  std::string host = "127.0.0.1";
+  size_t port = SERVER_PORT;
+  size_t client_nums = 64;
+  size_t ops = 1000;
+  size_t start_key = 0;
+  std::string mode = "insert";
+  std::string table = "bench";
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--host" && i + 1 < argc) {
+      host = argv[++i];
+    } else if (arg == "--port" && i + 1 < argc) {
+      port = std::stoul(argv[++i]);
+    } else if (arg == "--clients" && i + 1 < argc) {
+      client_nums = std::stoul(argv[++i]);
+    } else if (arg == "--ops" && i + 1 < argc) {
+      ops = std::stoul(argv[++i]);
+    } else if (arg == "--start-key" && i + 1 < argc) {
+      start_key = std::stoul(argv[++i]);
+    } else if (arg == "--mode" && i + 1 < argc &&
+               (std::string(argv[i + 1]) == "insert" ||
+                std::string(argv[i + 1]) == "select")) {
+      mode = argv[++i];
+    } else if (arg == "--table" && i + 1 < argc) {
+      table = argv[++i];
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--host address] [--port port] [--clients connections]"
+                   " [--ops statements per client] [--start-key key]"
+                   " [--mode insert|select] [--table name]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // every client inserts or looks up keys of its own, starting at the key
+  // given, so the runs inserting go on with --start-key
+  try {
+    Client client(host, port);
+    client.Execute("create table " + table + "(id INT, name CHAR(32));");
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::vector<std::vector<double>> latencies(client_nums);
+  std::atomic<size_t> failures{0};
+  std::vector<std::thread> threads;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t c = 0; c < client_nums; ++c) {
+    threads.emplace_back([&, c] {
+      try {
+        Client client(host, port);
+        latencies[c].reserve(ops);
+        for (size_t i = 0; i < ops; ++i) {
+          auto key = std::to_string(start_key + c * ops + i);
+          std::string statement =
+              mode == "insert"
+                  ? "insert into " + table + " values(" + key + ", 'client" +
+                        std::to_string(c) + "');"
+                  : "select * from " + table + " where id = " + key + ";";
+          auto sent = std::chrono::steady_clock::now();
+          client.Execute(statement);
+          std::chrono::duration<double, std::micro> latency =
+              std::chrono::steady_clock::now() - sent;
+          latencies[c].push_back(latency.count());
+        }
+        client.Execute("exit;");
+      } catch (std::runtime_error &e) {
+        ++failures;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+  std::vector<double> all;
+  for (auto &client_latencies : latencies) {
+    all.insert(all.end(), client_latencies.begin(), client_latencies.end());
+  }
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p) {
+    return all.empty() ? 0 : all[static_cast<size_t>(p * (all.size() - 1))];
+  };
+  std::cout << mode << ": " << all.size() << " statements by " << client_nums
+            << " clients in " << elapsed.count() << " s, "
+            << all.size() / elapsed.count() << " statements/s" << std::endl;
+  std::cout << "latency us: p50 " << percentile(0.5) << ", p99 "
+            << percentile(0.99) << ", max " << percentile(1) << std::endl;
+  if (failures > 0) {
+    std::cout << failures << " clients lost their connection" << std::endl;
+    return 1;
+  }
+  return 0;
+}
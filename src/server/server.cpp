@@ -0,0 +1,475 @@
+#include "server/server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "config/config.h"
+
+namespace spdb {
+static constexpr uint64_t LISTEN_ID = 0;
+static constexpr uint64_t WAKEUP_ID = 1;
+static constexpr int EPOLL_EVENT_NUMS = 64;
+static constexpr size_t READ_BUFFER_SIZE = 16 * 1024;
+
+struct Server::Connection {
+  uint64_t id_;
+  int fd_;
+  std::unique_ptr<Handler> handler_;
+
+  // touched by the loop only
+  /** The bytes read after the last full line. */
+  std::string input_;
+  /** The lines of the statement not ended yet. */
+  std::string statement_;
+  /** The bytes of the replies not written yet. */
+  std::string sending_;
+  /** True once the client sends nothing more. */
+  bool is_eof_{false};
+  /** True while the socket is watched for room to write. */
+  bool is_writing_{false};
+  /**
+   * True while the socket is in the epoll set. A socket with nothing to read
+   * or write is taken out, as EPOLLHUP is reported even for no events.
+   */
+  bool is_watched_{true};
+
+  std::mutex latch_;
+  // guarded by latch_
+  std::deque<std::string> statements_;
+  /** The replies the loop has not taken yet. */
+  std::string output_;
+  /** True while the connection waits for a worker or runs on one. */
+  bool is_queued_{false};
+  /** True while a worker runs a statement with the handler. */
+  bool is_executing_{false};
+  /** True once the handler asked to close, after the last reply. */
+  bool is_exiting_{false};
+  bool is_closed_{false};
+};
+
+// Turn the output of a statement into its reply.
+static auto Frame(const std::string &output) -> std::string {
+  std::string reply;
+  size_t begin = 0;
+  while (begin < output.size()) {
+    size_t end = output.find('\n', begin);
+    if (end == std::string::npos) {
+      end = output.size();
+    }
+    if (output[begin] == '.') {
+      reply.push_back('.');
+    }
+    reply.append(output, begin, end - begin);
+    reply.push_back('\n');
+    begin = end + 1;
+  }
+  reply.append(".\n");
+  return reply;
+}
+
+Server::Server(std::string host, uint16_t port, size_t worker_nums,
+               HandlerFactory factory)
+    : host_(std::move(host)),
+      port_(port),
+      worker_nums_(worker_nums),
+      factory_(std::move(factory)) {}
+
+Server::~Server() { Stop(); }
+
+void Server::Start() {
+  if (loop_thread_.joinable()) {
+    return;
+  }
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port_);
+  if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) != 1) {
+    throw std::runtime_error("invalid address " + host_);
+  }
+  listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error(std::string("socket: ") + strerror(errno));
+  }
+  int on = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) <
+          0 ||
+      listen(listen_fd_, SOMAXCONN) < 0) {
+    std::string error = strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    throw std::runtime_error("can't listen on " + host_ + ":" +
+                             std::to_string(port_) + ": " + error);
+  }
+  socklen_t len = sizeof(addr);
+  getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+  port_ = ntohs(addr.sin_port);
+
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = LISTEN_ID;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+  event.data.u64 = WAKEUP_ID;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wakeup_fd_, &event);
+
+  is_stopping_ = false;
+  for (size_t i = 0; i < worker_nums_; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+  loop_thread_ = std::thread([this] { Loop(); });
+}
+
+void Server::Stop() {
+  if (!loop_thread_.joinable()) {
+    return;
+  }
+  is_stopping_ = true;
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = write(wakeup_fd_, &one, sizeof(one));
+  loop_thread_.join();
+
+  {
+    std::lock_guard<std::mutex> lock(tasks_latch_);
+    tasks_.clear();
+  }
+  tasks_cv_.notify_all();
+  // the handlers idle are destroyed first, releasing the locks the
+  // statements running may wait for
+  for (auto &[id, conn] : connections_) {
+    close(conn->fd_);
+    std::unique_ptr<Handler> handler;
+    std::lock_guard<std::mutex> lock(conn->latch_);
+    conn->is_closed_ = true;
+    conn->statements_.clear();
+    if (!conn->is_executing_) {
+      handler = std::move(conn->handler_);
+    }
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  connections_.clear();
+  replied_.clear();
+  connection_count_ = 0;
+  close(listen_fd_);
+  close(epoll_fd_);
+  close(wakeup_fd_);
+  listen_fd_ = epoll_fd_ = wakeup_fd_ = -1;
+}
+
+void Server::Loop() {
+  epoll_event events[EPOLL_EVENT_NUMS];
+  while (!is_stopping_) {
+    int n = epoll_wait(epoll_fd_, events, EPOLL_EVENT_NUMS, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    for (int i = 0; i < n; ++i) {
+      uint64_t id = events[i].data.u64;
+      if (id == LISTEN_ID) {
+        Accept();
+      } else if (id == WAKEUP_ID) {
+        uint64_t count;
+        [[maybe_unused]] auto bytes = read(wakeup_fd_, &count, sizeof(count));
+        std::vector<std::shared_ptr<Connection>> replied;
+        {
+          std::lock_guard<std::mutex> lock(replied_latch_);
+          replied.swap(replied_);
+        }
+        for (auto &conn : replied) {
+          if (conn->fd_ >= 0) {
+            Write(conn);
+          }
+        }
+      } else {
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+          continue;
+        }
+        auto conn = it->second;
+        if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+          Read(conn);
+        }
+        if (conn->fd_ >= 0 && (events[i].events & EPOLLOUT) != 0) {
+          Write(conn);
+        }
+      }
+    }
+  }
+}
+
+void Server::Accept() {
+  while (true) {
+    int fd = accept4(listen_fd_, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    auto conn = std::make_shared<Connection>();
+    conn->id_ = next_connection_id_++;
+    conn->fd_ = fd;
+    conn->handler_ = factory_();
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = conn->id_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    connections_.emplace(conn->id_, std::move(conn));
+    ++connection_count_;
+  }
+}
+
+void Server::Read(const std::shared_ptr<Connection> &conn) {
+  char buffer[READ_BUFFER_SIZE];
+  while (true) {
+    ssize_t n = read(conn->fd_, buffer, sizeof(buffer));
+    if (n > 0) {
+      conn->input_.append(buffer, n);
+      if (static_cast<size_t>(n) < sizeof(buffer)) {
+        break;
+      }
+    } else if (n == 0) {
+      conn->is_eof_ = true;
+      break;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    } else {
+      Close(conn);
+      return;
+    }
+  }
+
+  std::vector<std::string> statements;
+  size_t begin = 0;
+  size_t end;
+  while ((end = conn->input_.find('\n', begin)) != std::string::npos) {
+    size_t line_end = end;
+    while (line_end > begin && isspace(conn->input_[line_end - 1]) != 0) {
+      --line_end;
+    }
+    if (line_end > begin) {
+      if (!conn->statement_.empty()) {
+        conn->statement_.push_back(' ');
+      }
+      conn->statement_.append(conn->input_, begin, line_end - begin);
+      if (conn->input_[line_end - 1] == ';') {
+        statements.push_back(std::move(conn->statement_));
+        conn->statement_.clear();
+      }
+    }
+    begin = end + 1;
+  }
+  conn->input_.erase(0, begin);
+  if (conn->input_.size() + conn->statement_.size() >
+      SERVER_MAX_STATEMENT_SIZE) {
+    Close(conn);
+    return;
+  }
+
+  if (!statements.empty()) {
+    bool is_submitting = false;
+    {
+      std::lock_guard<std::mutex> lock(conn->latch_);
+      if (!conn->is_exiting_) {
+        for (auto &statement : statements) {
+          conn->statements_.push_back(std::move(statement));
+        }
+        is_submitting = !conn->is_queued_;
+        conn->is_queued_ = true;
+      }
+    }
+    if (is_submitting) {
+      Submit(conn);
+    }
+  }
+  if (conn->is_eof_) {
+    // the replies of the statements sent are still written
+    Watch(conn, conn->is_writing_);
+    Write(conn);
+  }
+}
+
+void Server::Write(const std::shared_ptr<Connection> &conn) {
+  bool is_exiting;
+  bool is_idle;
+  {
+    std::lock_guard<std::mutex> lock(conn->latch_);
+    conn->sending_.append(conn->output_);
+    conn->output_.clear();
+    is_exiting = conn->is_exiting_;
+    is_idle = !conn->is_queued_ && conn->statements_.empty();
+  }
+  size_t sent = 0;
+  while (sent < conn->sending_.size()) {
+    ssize_t n = send(conn->fd_, conn->sending_.data() + sent,
+                     conn->sending_.size() - sent, MSG_NOSIGNAL);
+    if (n >= 0) {
+      sent += n;
+    } else if (errno == EINTR) {
+      continue;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    } else {
+      Close(conn);
+      return;
+    }
+  }
+  conn->sending_.erase(0, sent);
+  if (!conn->sending_.empty()) {
+    if (!conn->is_writing_) {
+      Watch(conn, true);
+    }
+    return;
+  }
+  if (conn->is_writing_) {
+    Watch(conn, false);
+  }
+  if (is_exiting || (conn->is_eof_ && is_idle)) {
+    Close(conn);
+  }
+}
+
+void Server::Close(const std::shared_ptr<Connection> &conn) {
+  if (conn->is_watched_) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd_, nullptr);
+  }
+  close(conn->fd_);
+  conn->fd_ = -1;
+  connections_.erase(conn->id_);
+  --connection_count_;
+  // destroyed out of the latch, rolling back what the client left open; a
+  // statement running keeps it until it is done
+  std::unique_ptr<Handler> handler;
+  std::lock_guard<std::mutex> lock(conn->latch_);
+  conn->is_closed_ = true;
+  conn->statements_.clear();
+  if (!conn->is_executing_) {
+    handler = std::move(conn->handler_);
+  }
+}
+
+void Server::Watch(const std::shared_ptr<Connection> &conn,
+                   bool is_writing) {
+  epoll_event event{};
+  event.events = (conn->is_eof_ ? 0 : EPOLLIN) | (is_writing ? EPOLLOUT : 0);
+  event.data.u64 = conn->id_;
+  conn->is_writing_ = is_writing;
+  // after the end of the input the socket waits out the statements running
+  // unwatched, Write closes it once the last reply is sent
+  if (event.events == 0) {
+    if (conn->is_watched_) {
+      epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn->fd_, nullptr);
+      conn->is_watched_ = false;
+    }
+    return;
+  }
+  epoll_ctl(epoll_fd_, conn->is_watched_ ? EPOLL_CTL_MOD : EPOLL_CTL_ADD,
+            conn->fd_, &event);
+  conn->is_watched_ = true;
+}
+
+void Server::Submit(std::shared_ptr<Connection> conn) {
+  {
+    std::lock_guard<std::mutex> lock(tasks_latch_);
+    tasks_.push_back(std::move(conn));
+  }
+  tasks_cv_.notify_one();
+}
+
+void Server::Notify(std::shared_ptr<Connection> conn) {
+  {
+    std::lock_guard<std::mutex> lock(replied_latch_);
+    replied_.push_back(std::move(conn));
+  }
+  uint64_t one = 1;
+  [[maybe_unused]] auto n = write(wakeup_fd_, &one, sizeof(one));
+}
+
+void Server::WorkerLoop() {
+  while (true) {
+    std::shared_ptr<Connection> conn;
+    {
+      std::unique_lock<std::mutex> lock(tasks_latch_);
+      tasks_cv_.wait(lock, [&] { return is_stopping_ || !tasks_.empty(); });
+      if (is_stopping_) {
+        return;
+      }
+      conn = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    Run(conn);
+  }
+}
+
+void Server::Run(const std::shared_ptr<Connection> &conn) {
+  std::string statement;
+  {
+    std::lock_guard<std::mutex> lock(conn->latch_);
+    if (conn->is_closed_ || conn->statements_.empty()) {
+      conn->is_queued_ = false;
+      return;
+    }
+    statement = std::move(conn->statements_.front());
+    conn->statements_.pop_front();
+    conn->is_executing_ = true;
+  }
+
+  std::string output;
+  bool is_open;
+  try {
+    is_open = conn->handler_->Execute(statement, &output);
+  } catch (std::exception &e) {
+    // a handler which failed is not trusted with the next statements
+    output = std::string(e.what()) + "\n";
+    is_open = false;
+  }
+  ++statement_count_;
+
+  std::unique_ptr<Handler> handler;
+  bool has_more;
+  {
+    std::lock_guard<std::mutex> lock(conn->latch_);
+    conn->is_executing_ = false;
+    if (conn->is_closed_) {
+      conn->is_queued_ = false;
+      handler = std::move(conn->handler_);
+      return;
+    }
+    conn->output_.append(Frame(output));
+    if (!is_open) {
+      conn->is_exiting_ = true;
+      conn->statements_.clear();
+    }
+    has_more = !conn->statements_.empty();
+    conn->is_queued_ = has_more;
+  }
+  // back to the end of the queue, so the other connections get their turn
+  if (has_more) {
+    Submit(conn);
+  }
+  Notify(conn);
+}
+}  // namespace spdb
@@ -0,0 +1,88 @@
+#include <signal.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "config/config.h"
+#include "server/server.h"
+#include "shell/session.h"
+
+// Runs the statements of a connection in a session of the engine.
+class SessionHandler : public spdb::Server::Handler {
+ public:
+  explicit SessionHandler(spdb::Engine *engine)
+      : session_(engine, &output_, &output_) {}
+
+  auto Execute(const std::string &statement, std::string *output)
+      -> bool override {
+    bool is_open = session_.Execute(statement);
+    *output = output_.str();
+    output_.str("");
+    return is_open;
+  }
+
+ private:
+  // the results and the errors are sent alike
+  std::ostringstream output_;
+  spdb::Session session_;
+};
+
+int main(int argc, char **argv) {
+  std::string host = "127.0.0.1";
+  size_t port = SERVER_PORT;
+  size_t worker_nums = SERVER_WORKER_NUMS;
+  size_t pool_size = DEFAULT_BUFFER_POOL_SIZE;
+  size_t checkpoint_interval_ms = CHECKPOINT_INTERVAL_MS;
+  size_t rto_ms = RECOVERY_TIME_OBJECTIVE_MS;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--host" && i + 1 < argc) {
+      host = argv[++i];
+    } else if (arg == "--port" && i + 1 < argc) {
+      port = std::stoul(argv[++i]);
+    } else if (arg == "--workers" && i + 1 < argc) {
+      worker_nums = std::stoul(argv[++i]);
+    } else if (arg == "--buffer-pool-size" && i + 1 < argc) {
+      pool_size = std::stoul(argv[++i]);
+    } else if (arg == "--checkpoint-interval" && i + 1 < argc) {
+      checkpoint_interval_ms = std::stoul(argv[++i]);
+    } else if (arg == "--rto" && i + 1 < argc) {
+      rto_ms = std::stoul(argv[++i]);
+    } else {
+      std::cerr << "usage: " << argv[0]
+                << " [--host address] [--port port] [--workers threads]"
+                   " [--buffer-pool-size frames] [--checkpoint-interval ms]"
+                   " [--rto ms]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // the signals stopping the server are waited for by the main thread only,
+  // blocked before any thread is started
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  spdb::Engine engine(pool_size, checkpoint_interval_ms, rto_ms);
+  spdb::Server server(host, port, worker_nums, [&engine] {
+    return std::make_unique<SessionHandler>(&engine);
+  });
+  try {
+    server.Start();
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << "listening on " << host << ":" << server.GetPort()
+            << std::endl;
+  int signal;
+  sigwait(&signals, &signal);
+  // the sessions are closed before the engine shuts down
+  server.Stop();
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include "shell/plan_cache.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace spdb {
+// the digits of the longest int literal taken out, a longer one may not fit
+static constexpr size_t MAX_INT_DIGITS = 18;
+
+static auto IsIdentifierChar(char c) -> bool {
+  return isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+}
+
+auto ParameterizeStatement(const std::string &query,
+                           std::vector<Literal> *literals) -> std::string {
+  literals->clear();
+  size_t n = query.size();
+  size_t i = 0;
+  while (i < n && isspace(static_cast<unsigned char>(query[i])) != 0) {
+    ++i;
+  }
+  std::string keyword;
+  for (size_t j = i; j < n && IsIdentifierChar(query[j]); ++j) {
+    keyword.push_back(static_cast<char>(tolower(query[j])));
+  }
+  if (keyword != "select" && keyword != "insert" && keyword != "execute") {
+    return "";
+  }
+
+  std::string text;
+  bool is_space = false;
+  while (i < n) {
+    char c = query[i];
+    if (isspace(static_cast<unsigned char>(c)) != 0) {
+      is_space = true;
+      ++i;
+      continue;
+    }
+    // none around the commas and inside the parentheses
+    if (is_space && !text.empty() && text.back() != '(' &&
+        text.back() != ',' && c != ')' && c != ',') {
+      text.push_back(' ');
+    }
+    is_space = false;
+    if (c == '\'') {
+      // a quote doubled is one quote of the string, as the parser reads it,
+      // a string over lines is left to the parser
+      Literal literal;
+      literal.is_string_ = true;
+      size_t begin = i + 1;
+      while (true) {
+        size_t end = query.find('\'', begin);
+        if (end == std::string::npos || query.find('\n', begin) < end) {
+          return "";
+        }
+        literal.string_.append(query, begin, end - begin);
+        if (end + 1 < n && query[end + 1] == '\'') {
+          literal.string_.push_back('\'');
+          begin = end + 2;
+          continue;
+        }
+        i = end + 1;
+        break;
+      }
+      literals->push_back(std::move(literal));
+      text.push_back('?');
+    } else if (c == '"') {
+      size_t end = query.find('"', i + 1);
+      if (end == std::string::npos) {
+        return "";
+      }
+      text.append(query, i, end + 1 - i);
+      i = end + 1;
+    } else if (isdigit(static_cast<unsigned char>(c)) != 0) {
+      size_t end = i;
+      while (end < n && isdigit(static_cast<unsigned char>(query[end])) != 0) {
+        ++end;
+      }
+      // floats stay literals
+      if (end - i > MAX_INT_DIGITS ||
+          (end < n && (query[end] == '.' || IsIdentifierChar(query[end])))) {
+        return "";
+      }
+      Literal literal;
+      literal.int_ = std::stoll(query.substr(i, end - i));
+      literals->push_back(std::move(literal));
+      text.push_back('?');
+      i = end;
+    } else if (IsIdentifierChar(c)) {
+      size_t end = i;
+      while (end < n && IsIdentifierChar(query[end])) {
+        ++end;
+      }
+      text.append(query, i, end - i);
+      i = end;
+    } else if ((c == '-' && i + 1 < n && query[i + 1] == '-') ||
+               (c == '.' && i + 1 < n &&
+                isdigit(static_cast<unsigned char>(query[i + 1])) != 0)) {
+      // a comment, or a float
+      return "";
+    } else {
+      text.push_back(c);
+      ++i;
+    }
+  }
+  return text;
+}
+
+PreparedStatement::PreparedStatement(const std::string &query) {
+  hsql::SQLParser::parse(query, &result_);
+  if (!result_.isValid() || result_.size() != 1) {
+    throw std::runtime_error("unrecongized syntax.");
+  }
+  // in the order they appear in the text
+  parameters_ = result_.parameters();
+}
+
+void PreparedStatement::Bind(const std::vector<Literal> &values) {
+  if (values.size() != parameters_.size()) {
+    throw std::runtime_error("expected " + std::to_string(parameters_.size()) +
+                             " parameters.");
+  }
+  // the parameters become literals, as if parsed with the values in place
+  for (size_t i = 0; i < values.size(); ++i) {
+    auto expr = parameters_[i];
+    free(expr->name);
+    expr->name = nullptr;
+    if (values[i].is_string_) {
+      expr->type = hsql::ExprType::kExprLiteralString;
+      expr->name = strdup(values[i].string_.c_str());
+    } else {
+      expr->type = hsql::ExprType::kExprLiteralInt;
+      expr->ival = values[i].int_;
+    }
+  }
+}
+
+auto PlanCache::Get(const std::string &text)
+    -> std::shared_ptr<PreparedStatement> {
+  auto it = index_.find(text);
+  if (it == index_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void PlanCache::Put(const std::string &text,
+                    std::shared_ptr<PreparedStatement> statement) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto it = index_.find(text);
+  if (it != index_.end()) {
+    it->second->second = std::move(statement);
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  if (entries_.size() == capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(text, std::move(statement));
+  index_[text] = entries_.begin();
+}
+}  // namespace spdb
@@ -0,0 +1,284 @@
+#include "shell/result_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+namespace spdb {
+// the chars of the widest INT, -2147483648
+static constexpr size_t INT_WIDTH = 11;
+
+auto ParseOutputMode(const std::string &name, OutputMode *mode) -> bool {
+  if (name == "table") {
+    *mode = OutputMode::TABLE;
+  } else if (name == "csv") {
+    *mode = OutputMode::CSV;
+  } else if (name == "tsv") {
+    *mode = OutputMode::TSV;
+  } else if (name == "json") {
+    *mode = OutputMode::JSON;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+ResultWriter::ResultWriter(const std::vector<Cloum> &cols, std::ostream *out)
+    : cols_(cols), out_(out) {
+  size_t offset = 0;
+  for (auto &col : cols_) {
+    offsets_.push_back(offset);
+    offset += col.GetSize();
+  }
+  buffer_.reserve(RESULT_BUFFER_SIZE);
+}
+
+void ResultWriter::Finish() {
+  Flush();
+  out_->flush();
+}
+
+void ResultWriter::Flush() {
+  out_->write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+}
+
+auto ResultWriter::CharValue(const Tuple &row, size_t index,
+                             size_t *size) const -> const char * {
+  const char *value = row.GetData() + offsets_[index];
+  *size = strnlen(value, cols_[index].GetSize());
+  return value;
+}
+
+auto ResultWriter::AppendValue(const Tuple &row, size_t index) -> size_t {
+  const char *value = row.GetData() + offsets_[index];
+  switch (cols_[index].GetType()) {
+    case CloumType::INT: {
+      int n;
+      memcpy(&n, value, sizeof(int));
+      char text[INT_WIDTH];
+      auto end = std::to_chars(text, text + INT_WIDTH, n).ptr;
+      Append(text, end - text);
+      return end - text;
+    }
+    case CloumType::BOOL:
+      Append(*value != 0 ? "true" : "false", *value != 0 ? 4 : 5);
+      return *value != 0 ? 4 : 5;
+    case CloumType::CHAR: {
+      size_t size;
+      CharValue(row, index, &size);
+      Append(value, size);
+      return size;
+    }
+    default:
+      throw std::runtime_error("only support bool&int&char now.");
+  }
+}
+
+/** Draws the rows in a table, the cloums sized by their types. */
+class TableResultWriter : public ResultWriter {
+ public:
+  TableResultWriter(const std::vector<Cloum> &cols, std::ostream *out)
+      : ResultWriter(cols, out) {
+    for (auto &col : cols_) {
+      size_t width = col.GetType() == CloumType::INT    ? INT_WIDTH
+                     : col.GetType() == CloumType::BOOL ? 5
+                                                        : col.GetSize();
+      widths_.push_back(std::max(width, col.cloum_name_.size()));
+    }
+    for (auto width : widths_) {
+      line_ += "+-" + std::string(width + 1, '-');
+      spaces_.resize(std::max(spaces_.size(), width + 1), ' ');
+    }
+    line_ += "+\n";
+  }
+
+  void WriteHeader() override {
+    Append(line_);
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      Append("| ", 2);
+      Append(cols_[i].cloum_name_);
+      Pad(widths_[i] - cols_[i].cloum_name_.size() + 1);
+    }
+    Append("|\n", 2);
+  }
+
+  void WriteRow(const Tuple &row) override {
+    // the header is parted from the rows, if there are any
+    if (!has_rows_) {
+      Append(line_);
+      has_rows_ = true;
+    }
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      Append("| ", 2);
+      Pad(widths_[i] - AppendValue(row, i) + 1);
+    }
+    Append("|\n", 2);
+  }
+
+  void Finish() override {
+    Append(line_);
+    ResultWriter::Finish();
+  }
+
+ private:
+  void Pad(size_t size) { Append(spaces_.data(), size); }
+
+  std::vector<size_t> widths_;
+  std::string line_;
+  std::string spaces_;
+  bool has_rows_{false};
+};
+
+/** Writes the rows as comma or tab separated values. */
+class SeparatedResultWriter : public ResultWriter {
+ public:
+  SeparatedResultWriter(const std::vector<Cloum> &cols, std::ostream *out,
+                        bool is_tab)
+      : ResultWriter(cols, out), is_tab_(is_tab) {}
+
+  void WriteHeader() override {
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      if (i > 0) {
+        Append(is_tab_ ? '\t' : ',');
+      }
+      AppendText(cols_[i].cloum_name_.data(), cols_[i].cloum_name_.size());
+    }
+    Append('\n');
+  }
+
+  void WriteRow(const Tuple &row) override {
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      if (i > 0) {
+        Append(is_tab_ ? '\t' : ',');
+      }
+      if (cols_[i].GetType() == CloumType::CHAR) {
+        size_t size;
+        const char *value = CharValue(row, i, &size);
+        AppendText(value, size);
+      } else {
+        AppendValue(row, i);
+      }
+    }
+    Append('\n');
+  }
+
+ private:
+  void AppendText(const char *text, size_t size) {
+    if (is_tab_) {
+      for (size_t i = 0; i < size; ++i) {
+        switch (text[i]) {
+          case '\t':
+            Append("\\t", 2);
+            break;
+          case '\n':
+            Append("\\n", 2);
+            break;
+          case '\r':
+            Append("\\r", 2);
+            break;
+          case '\\':
+            Append("\\\\", 2);
+            break;
+          default:
+            Append(text[i]);
+        }
+      }
+      return;
+    }
+    bool is_quoted = false;
+    for (size_t i = 0; i < size && !is_quoted; ++i) {
+      is_quoted = text[i] == ',' || text[i] == '"' || text[i] == '\r' ||
+                  text[i] == '\n';
+    }
+    if (!is_quoted) {
+      Append(text, size);
+      return;
+    }
+    Append('"');
+    for (size_t i = 0; i < size; ++i) {
+      if (text[i] == '"') {
+        Append('"');
+      }
+      Append(text[i]);
+    }
+    Append('"');
+  }
+
+  bool is_tab_;
+};
+
+/** Writes every row as a json object on a line of its own. */
+class JsonResultWriter : public ResultWriter {
+ public:
+  JsonResultWriter(const std::vector<Cloum> &cols, std::ostream *out)
+      : ResultWriter(cols, out) {
+    // the names are escaped once, each row only writes its values
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      std::string name = i == 0 ? "{" : ",";
+      AppendString(&name, cols_[i].cloum_name_.data(),
+                   cols_[i].cloum_name_.size());
+      names_.push_back(name + ":");
+    }
+  }
+
+  void WriteHeader() override {}
+
+  void WriteRow(const Tuple &row) override {
+    for (size_t i = 0; i < cols_.size(); ++i) {
+      Append(names_[i]);
+      if (cols_[i].GetType() == CloumType::CHAR) {
+        size_t size;
+        const char *value = CharValue(row, i, &size);
+        text_.clear();
+        AppendString(&text_, value, size);
+        Append(text_);
+      } else {
+        AppendValue(row, i);
+      }
+    }
+    Append(cols_.empty() ? "{}\n" : "}\n", cols_.empty() ? 3 : 2);
+  }
+
+ private:
+  static void AppendString(std::string *out, const char *text, size_t size) {
+    static const char *hex = "0123456789abcdef";
+    out->push_back('"');
+    for (size_t i = 0; i < size; ++i) {
+      unsigned char c = text[i];
+      if (c == '"' || c == '\\') {
+        out->push_back('\\');
+        out->push_back(c);
+      } else if (c < 0x20) {
+        *out += "\\u00";
+        out->push_back(hex[c >> 4]);
+        out->push_back(hex[c & 0xf]);
+      } else {
+        out->push_back(c);
+      }
+    }
+    out->push_back('"');
+  }
+
+  std::vector<std::string> names_;
+  // the escaped text of a value, kept to reuse its memory
+  std::string text_;
+};
+
+auto ResultWriter::Create(OutputMode mode, const std::vector<Cloum> &cols,
+                          std::ostream *out) -> std::unique_ptr<ResultWriter> {
+  switch (mode) {
+    case OutputMode::TABLE:
+      return std::make_unique<TableResultWriter>(cols, out);
+    case OutputMode::CSV:
+      return std::make_unique<SeparatedResultWriter>(cols, out, false);
+    case OutputMode::TSV:
+      return std::make_unique<SeparatedResultWriter>(cols, out, true);
+    case OutputMode::JSON:
+      return std::make_unique<JsonResultWriter>(cols, out);
+    default:
+      throw std::runtime_error("only support table&csv&tsv&json now.");
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,912 @@
+#include "shell/session.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "SQLParser.h"
+#include "config/config.h"
+#include "disk/column_file.h"
+#include "disk/tuple.h"
+#include "executor/delete_executor.h"
+#include "executor/planner.h"
+#include "executor/projection_executor.h"
+#include "executor/seq_scan_executor.h"
+#include "executor/update_executor.h"
+#include "executor/value_executor.h"
+#include "recovery/recovery_manager.h"
+
+namespace spdb {
+class TableWriter {
+ public:
+  TableWriter() = default;
+
+  void AddHeader(std::vector<std::string> headers) {
+    headers_.reserve(headers.size());
+    max_.reserve(headers.size());
+    for (auto &header : headers) {
+      headers_.emplace_back(header);
+      max_.emplace_back(header.length());
+    }
+  }
+
+  void AddRow(std::vector<std::string> &row) {
+    if (row.size() != headers_.size()) {
+      throw std::runtime_error(
+          "the row size of table should equal to headers size.");
+    }
+    for (size_t i = 0; i < row.size(); ++i) {
+      max_[i] = max_[i] >= row[i].length() ? max_[i] : row[i].length();
+    }
+    rows_.push_back(row);
+  }
+
+  void DrawLine(std::ostream &out) {
+    for (size_t i = 0; i < max_.size(); ++i) {
+      out << "+-";
+      for (size_t j = 0; j <= max_[i]; ++j) {
+        out << '-';
+      }
+    }
+    out << '+' << std::endl;
+  }
+
+  void DrawTable(std::ostream &out) {
+    DrawLine(out);
+    for (size_t i = 0; i < headers_.size(); ++i) {
+      out << "| " << std::setw(max_[i]) << setiosflags(std::ios::left)
+          << std::setfill(' ') << headers_[i] << ' ';
+    }
+    out << '|' << std::endl;
+    if (rows_.size() != 0) {
+      DrawLine(out);
+    }
+    for (size_t i = 0; i < rows_.size(); ++i) {
+      for (size_t j = 0; j < headers_.size(); ++j) {
+        out << "| " << std::setw(max_[j]) << setiosflags(std::ios::left)
+            << std::setfill(' ');
+        out << rows_[i][j] << ' ';
+      }
+      out << '|' << std::endl;
+    }
+    DrawLine(out);
+  }
+
+ private:
+  std::vector<std::string> headers_;
+  std::vector<std::vector<std::string>> rows_;
+  std::vector<int> max_;
+};
+
+// check every table a from clause reads from
+static auto IsTableRefExisted(Catalog &catalog, const hsql::TableRef *ref)
+    -> bool {
+  if (ref->type == hsql::kTableJoin) {
+    return IsTableRefExisted(catalog, ref->join->left) &&
+           IsTableRefExisted(catalog, ref->join->right);
+  }
+  return ref->name != nullptr && catalog.IsExisted(ref->name);
+}
+
+// The table named after a command, like vacuum <table>;, empty if none.
+static auto CommandArgument(const std::string &query, size_t length)
+    -> std::string {
+  std::string name = query.substr(length, query.size() - length - 1);
+  name.erase(0, name.find_first_not_of(' '));
+  name.erase(name.find_last_not_of(' ') + 1);
+  return name;
+}
+
+// Split copy <table> to|from '<file>'; into its parts, the keywords in any
+// case. @return false if the query is no copy command
+static auto ParseCopy(const std::string &query, std::string *table_name,
+                      bool *is_export, std::string *file_name) -> bool {
+  std::istringstream in(query);
+  std::string copy;
+  std::string direction;
+  in >> copy >> *table_name >> direction;
+  for (auto &c : copy) {
+    c = static_cast<char>(tolower(c));
+  }
+  for (auto &c : direction) {
+    c = static_cast<char>(tolower(c));
+  }
+  if (copy != "copy" || (direction != "to" && direction != "from")) {
+    return false;
+  }
+  *is_export = direction == "to";
+  std::string rest;
+  std::getline(in, rest);
+  size_t first = rest.find('\'');
+  size_t last = rest.rfind('\'');
+  if (first == std::string::npos || last == first ||
+      rest.find_first_not_of(' ', last + 1) != rest.size() - 1) {
+    return false;
+  }
+  *file_name = rest.substr(first + 1, last - first - 1);
+  return true;
+}
+
+Engine::Engine(size_t pool_size, size_t checkpoint_interval_ms,
+               size_t rto_ms)
+    : log_manager_(LOG_FILE_NAME),
+      buffer_pool_(pool_size),
+      checkpoint_manager_(&log_manager_, &buffer_pool_, checkpoint_interval_ms,
+                          rto_ms) {
+  buffer_pool_.SetLogManager(&log_manager_);
+  catalog_ = std::make_unique<Catalog>(CATALOG_NAME, &buffer_pool_);
+  // bring the tables back to the log in case the last process crashed
+  RecoveryManager(&log_manager_, catalog_.get()).Recover();
+  checkpoint_manager_.Start();
+  lock_manager_.Start();
+  txn_manager_ = std::make_unique<TransactionManager>(
+      catalog_.get(), &log_manager_, &lock_manager_);
+  catalog_->SetTransactionManager(txn_manager_.get());
+}
+
+Session::Session(Engine *engine, std::ostream *out, std::ostream *err)
+    : engine_(engine), out_(out), err_(err) {}
+
+Session::~Session() {
+  // the rows of an unfinished transaction are in the tables already
+  if (txn_ != nullptr) {
+    engine_->txn_manager_->Abort(txn_);
+  }
+}
+
+auto Session::Execute(const std::string &query) -> bool {
+  auto &txn_manager = *engine_->txn_manager_;
+  if (query == "exit;") {
+    if (txn_ != nullptr) {
+      txn_manager.Abort(txn_);
+      txn_ = nullptr;
+    }
+    return false;
+  }
+  // the transaction goes on on the thread running the statement
+  if (txn_ != nullptr) {
+    txn_manager.Resume(txn_);
+  }
+  try {
+    if (!ExecuteCommand(query)) {
+      ExecuteStatement(query);
+    }
+  } catch (std::runtime_error &e) {
+    *err_ << e.what() << std::endl;
+  }
+  // and the thread is left without it, for the statements of other sessions
+  txn_manager.Suspend();
+  return true;
+}
+
+auto Session::ExecuteCommand(const std::string &query) -> bool {
+  auto &catalog = *engine_->catalog_;
+  auto &txn_manager = *engine_->txn_manager_;
+  auto &out = *out_;
+  auto &err = *err_;
+  if (query == "show tables;") {
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    TableWriter writer;
+    writer.AddHeader({"name", "cols", "layout"});
+
+    for (auto &table : catalog.GetTables()) {
+      std::vector<std::string> row{};
+      row.push_back(table.disk_name_);
+      std::string str = "(";
+      for (auto &col : table.value_type_) {
+        str += col.cloum_name_;
+        str += ":";
+        switch (col.atr_.type_) {
+          case CloumType::INT:
+            str += "INT ";
+            break;
+          case CloumType::CHAR:
+            str += "CHAR ";
+            break;
+          case CloumType::BOOL:
+            str += "BOOL ";
+            break;
+          default:
+            throw std::runtime_error("only support bool&int&char now.");
+        }
+      }
+      str += ")";
+      row.push_back(str);
+      row.push_back(table.layout_ == LeafLayout::Pax ? "pax" : "row");
+      writer.AddRow(row);
+    }
+    writer.DrawTable(out);
+    return true;
+  }
+  if (query == "show buffer pool;") {
+    auto &buffer_pool = engine_->buffer_pool_;
+    TableWriter writer;
+    writer.AddHeader({"frames", "hits", "misses"});
+    std::vector<std::string> row{std::to_string(buffer_pool.GetPoolSize()),
+                                 std::to_string(buffer_pool.GetHitCount()),
+                                 std::to_string(buffer_pool.GetMissCount())};
+    writer.AddRow(row);
+    writer.DrawTable(out);
+    return true;
+  }
+  if (query == "show plan cache;") {
+    TableWriter writer;
+    writer.AddHeader({"statements", "capacity", "prepared", "hits", "misses"});
+    std::vector<std::string> row{std::to_string(plan_cache_.GetSize()),
+                                 std::to_string(plan_cache_.GetCapacity()),
+                                 std::to_string(prepared_.size()),
+                                 std::to_string(plan_cache_.GetHitCount()),
+                                 std::to_string(plan_cache_.GetMissCount())};
+    writer.AddRow(row);
+    writer.DrawTable(out);
+    return true;
+  }
+  std::string table_name;
+  bool is_export;
+  std::string file_name;
+  if (ParseCopy(query, &table_name, &is_export, &file_name)) {
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    if (!catalog.IsExisted(table_name)) {
+      err << "table is not existed." << std::endl;
+      return true;
+    }
+    size_t rows = is_export ? ExportTable(table_name, file_name)
+                            : ImportTable(table_name, file_name);
+    TableWriter writer;
+    writer.AddHeader({"table", is_export ? "rows exported" : "rows imported"});
+    std::vector<std::string> row{table_name, std::to_string(rows)};
+    writer.AddRow(row);
+    writer.DrawTable(out);
+    return true;
+  }
+  if (query.rfind("output ", 0) == 0) {
+    // output <table|csv|tsv|json>; sets the format of the results
+    if (!ParseOutputMode(CommandArgument(query, 6), &output_mode_)) {
+      err << "only support table&csv&tsv&json now." << std::endl;
+    }
+    return true;
+  }
+  if (query.rfind("layout ", 0) == 0) {
+    // layout <row|pax>; sets how the tables created from now on store their
+    // rows in the leaves, pax keeps the values of each cloum together
+    std::string name = CommandArgument(query, 6);
+    if (name == "row") {
+      layout_ = LeafLayout::Row;
+    } else if (name == "pax") {
+      layout_ = LeafLayout::Pax;
+    } else {
+      err << "only support row&pax now." << std::endl;
+    }
+    return true;
+  }
+  if (query == "begin;") {
+    if (txn_ != nullptr) {
+      err << "a transaction is already running." << std::endl;
+    } else {
+      txn_ = txn_manager.Begin();
+    }
+    return true;
+  }
+  if (query == "commit;" || query == "rollback;") {
+    if (txn_ == nullptr) {
+      err << "no transaction is running." << std::endl;
+    } else if (query == "commit;") {
+      txn_manager.Commit(txn_);
+    } else {
+      txn_manager.Abort(txn_);
+    }
+    txn_ = nullptr;
+    return true;
+  }
+  if (query == "checkpoint;") {
+    auto lsn = engine_->checkpoint_manager_.Checkpoint();
+    out << "checkpoint at lsn " << lsn << ", log "
+        << engine_->log_manager_.GetLogSize() << " bytes" << std::endl;
+    return true;
+  }
+  if (query.rfind("vacuum", 0) == 0) {
+    // vacuum; for every table, vacuum <table>; for one
+    std::unique_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    std::string name = CommandArgument(query, 6);
+    if (!name.empty() && !catalog.IsExisted(name)) {
+      err << "table is not existed." << std::endl;
+      return true;
+    }
+    TableWriter writer;
+    writer.AddHeader({"table", "truncated pages"});
+    for (auto &table : catalog.GetTables()) {
+      if (name.empty() || table.disk_name_ == name) {
+        std::vector<std::string> row{
+            table.disk_name_,
+            std::to_string(txn_manager.VacuumTable(table.disk_name_))};
+        writer.AddRow(row);
+      }
+    }
+    writer.DrawTable(out);
+    return true;
+  }
+  if (query.rfind("compact", 0) == 0) {
+    // compact; for every table, compact <table>; for one
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    std::string name = CommandArgument(query, 7);
+    if (!name.empty() && !catalog.IsExisted(name)) {
+      err << "table is not existed." << std::endl;
+      return true;
+    }
+    TableWriter writer;
+    writer.AddHeader({"table", "freed pages"});
+    for (auto &table : catalog.GetTables()) {
+      if (name.empty() || table.disk_name_ == name) {
+        std::vector<std::string> row{
+            table.disk_name_,
+            std::to_string(txn_manager.CompactTable(table.disk_name_))};
+        writer.AddRow(row);
+      }
+    }
+    writer.DrawTable(out);
+    return true;
+  }
+  if (query.rfind("compress ", 0) == 0 ||
+      query.rfind("uncompress ", 0) == 0) {
+    // compress <table>; stores a cold table compressed, uncompress
+    // <table>; in plain files again
+    bool is_compressed = query[0] == 'c';
+    std::unique_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    std::string name = CommandArgument(query, query.find(' '));
+    if (!catalog.IsExisted(name)) {
+      err << "table is not existed." << std::endl;
+      return true;
+    }
+    if (txn_ != nullptr) {
+      err << "cannot compress inside a transaction." << std::endl;
+      return true;
+    }
+    TableWriter writer;
+    writer.AddHeader({"table", "bytes on disk"});
+    std::vector<std::string> row{
+        name, std::to_string(catalog.SetCompressed(name, is_compressed))};
+    writer.AddRow(row);
+    writer.DrawTable(out);
+    return true;
+  }
+  return false;
+}
+
+// Whether the values of an insert statement are of the cloums of its table.
+static auto IsValuesMatched(const TableInfo &table_info,
+                            const hsql::InsertStatement *insert) -> bool {
+  if (table_info.value_type_.size() != insert->values->size()) {
+    return false;
+  }
+  for (size_t i = 0; i < insert->values->size(); ++i) {
+    switch (table_info.value_type_[i].GetType()) {
+      case CloumType::INT:
+        if (insert->values->at(i)->fval != 0 ||
+            insert->values->at(i)->getName() != nullptr) {
+          return false;
+        }
+        break;
+      case CloumType::CHAR:
+        if (insert->values->at(i)->getName() == nullptr) {
+          return false;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+// The end of the string or the quoted identifier starting at begin, the
+// quote doubled in it is a quote. @return std::string::npos if it is cut off
+static auto SkipQuoted(const std::string &query, size_t begin) -> size_t {
+  char quote = query[begin];
+  size_t end = begin + 1;
+  while ((end = query.find(quote, end)) != std::string::npos) {
+    if (end + 1 < query.size() && query[end + 1] == quote) {
+      end += 2;
+      continue;
+    }
+    return end + 1;
+  }
+  return std::string::npos;
+}
+
+static auto SkipSpaces(const std::string &query, size_t begin) -> size_t {
+  while (begin < query.size() &&
+         isspace(static_cast<unsigned char>(query[begin])) != 0) {
+    ++begin;
+  }
+  return begin;
+}
+
+auto SplitInsertRows(const std::string &query) -> std::vector<std::string> {
+  auto is_word = [](char c) {
+    return isalnum(static_cast<unsigned char>(c)) != 0 || c == '_';
+  };
+  // the words before the rows, up to values
+  size_t i = SkipSpaces(query, 0);
+  bool is_insert = false;
+  bool is_values = false;
+  while (i < query.size() && !is_values) {
+    if (query[i] == '\'' || query[i] == '"') {
+      i = SkipQuoted(query, i);
+      if (i == std::string::npos) {
+        return {};
+      }
+    } else if (is_word(query[i])) {
+      size_t end = i;
+      std::string word;
+      for (; end < query.size() && is_word(query[end]); ++end) {
+        word.push_back(static_cast<char>(tolower(query[end])));
+      }
+      if (!is_insert && word != "insert") {
+        return {};
+      }
+      is_insert = true;
+      is_values = word == "values";
+      i = end;
+    } else {
+      ++i;
+    }
+  }
+
+  // the rows, each in parentheses, separated by commas
+  std::vector<std::pair<size_t, size_t>> rows;
+  i = SkipSpaces(query, i);
+  while (i < query.size() && query[i] == '(') {
+    size_t begin = i;
+    int depth = 0;
+    do {
+      if (query[i] == '\'' || query[i] == '"') {
+        i = SkipQuoted(query, i);
+        if (i == std::string::npos) {
+          return {};
+        }
+        continue;
+      }
+      depth += query[i] == '(' ? 1 : (query[i] == ')' ? -1 : 0);
+      ++i;
+    } while (depth > 0 && i < query.size());
+    if (depth > 0) {
+      return {};
+    }
+    rows.emplace_back(begin, i);
+    size_t next = SkipSpaces(query, i);
+    if (next >= query.size() || query[next] != ',') {
+      break;
+    }
+    i = SkipSpaces(query, next + 1);
+  }
+  if (rows.size() < 2) {
+    return {};
+  }
+  auto head = query.substr(0, rows.front().first);
+  auto tail = query.substr(rows.back().second);
+  std::vector<std::string> inserts;
+  inserts.reserve(rows.size());
+  for (auto &[begin, end] : rows) {
+    inserts.push_back(head + query.substr(begin, end - begin) + tail);
+  }
+  return inserts;
+}
+
+void Session::ExecuteStatement(const std::string &query) {
+  auto inserts = SplitInsertRows(query);
+  if (!inserts.empty()) {
+    RunInsert(inserts);
+    return;
+  }
+  hsql::SQLParserResult result;
+  std::shared_ptr<PreparedStatement> prepared;
+  auto statement = ParseStatement(query, &result, &prepared);
+  if (statement == nullptr) {
+    *err_ << "unrecongized syntax." << std::endl;
+    return;
+  }
+  RunStatement(statement);
+}
+
+auto Session::ParseStatement(const std::string &query,
+                             hsql::SQLParserResult *result,
+                             std::shared_ptr<PreparedStatement> *prepared)
+    -> const hsql::SQLStatement * {
+  // a statement run before with other literals only is not parsed again
+  std::vector<Literal> literals;
+  auto text = ParameterizeStatement(query, &literals);
+  if (!text.empty()) {
+    *prepared = plan_cache_.Get(text);
+    if (*prepared == nullptr) {
+      try {
+        *prepared = std::make_shared<PreparedStatement>(text);
+        plan_cache_.Put(text, *prepared);
+      } catch (std::runtime_error &e) {
+        // a literal where the grammar takes no parameter, parsed as it is
+      }
+    }
+    if (*prepared != nullptr &&
+        (*prepared)->GetParameterCount() == literals.size()) {
+      (*prepared)->Bind(literals);
+      return (*prepared)->GetStatement();
+    }
+  }
+
+  hsql::SQLParser::parse(query, result);
+  if (!result->isValid() || result->size() == 0) {
+    return nullptr;
+  }
+  return result->getStatement(0);
+}
+
+void Session::RunInsert(const std::vector<std::string> &inserts) {
+  auto &catalog = *engine_->catalog_;
+  auto &err = *err_;
+  std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+  TableInfo table_info;
+  std::unique_ptr<ValueExecutor> value_executor;
+  // the rows of the same shape are parsed once, through the plan cache
+  for (auto &query : inserts) {
+    hsql::SQLParserResult result;
+    std::shared_ptr<PreparedStatement> prepared;
+    auto statement = ParseStatement(query, &result, &prepared);
+    if (statement == nullptr || !statement->isType(hsql::kStmtInsert)) {
+      err << "unrecongized syntax." << std::endl;
+      return;
+    }
+    auto insert = static_cast<const hsql::InsertStatement *>(statement);
+    if (value_executor == nullptr) {
+      if (!catalog.IsExisted(insert->tableName)) {
+        err << "table is not existed." << std::endl;
+        return;
+      }
+      table_info = catalog.GetTable(insert->tableName);
+    }
+    if (insert->values == nullptr || !IsValuesMatched(table_info, insert)) {
+      err << "values are not matched the values of table." << std::endl;
+      return;
+    }
+    if (value_executor == nullptr) {
+      value_executor = std::make_unique<ValueExecutor>(&catalog, insert);
+    } else {
+      value_executor->AddRow(insert);
+    }
+  }
+  InsertValues(table_info, value_executor.get());
+}
+
+void Session::InsertValues(const TableInfo &table_info,
+                           ValueExecutor *value_executor) {
+  std::vector<Tuple> rows;
+  auto value_type = value_executor->GetOutputCols();
+  Tuple tuple{value_type};
+  RID rid{};
+  while (value_executor->Next(&tuple, &rid)) {
+    rows.push_back(tuple);
+  }
+  auto &txn_manager = *engine_->txn_manager_;
+  RunWrite([&] {
+    txn_manager.InsertRows(TransactionManager::Current(),
+                           table_info.disk_name_, rows);
+  });
+}
+
+auto Session::ExportTable(const std::string &table_name,
+                          const std::string &file_name) -> size_t {
+  auto &catalog = *engine_->catalog_;
+  auto table = catalog.GetTable(table_name);
+  std::vector<std::string> key_names;
+  for (auto &col : table.key_type_) {
+    key_names.push_back(col.cloum_name_);
+  }
+  ColumnFileWriter writer(file_name, table.value_type_, key_names);
+  // the rows of the snapshot, in key order
+  SeqScanExecutor executor(&catalog, table_name);
+  Tuple row{table.value_type_};
+  RID rid{};
+  while (executor.Next(&row, &rid)) {
+    writer.Append(row);
+  }
+  return writer.Finish();
+}
+
+auto Session::ImportTable(const std::string &table_name,
+                          const std::string &file_name) -> size_t {
+  auto &catalog = *engine_->catalog_;
+  auto &txn_manager = *engine_->txn_manager_;
+  auto table = catalog.GetTable(table_name);
+  ColumnFileReader reader(file_name);
+  auto cols = reader.GetCloums();
+  bool is_matched = cols.size() == table.value_type_.size();
+  size_t row_size = 0;
+  for (size_t i = 0; is_matched && i < cols.size(); ++i) {
+    auto &col = table.value_type_[i];
+    is_matched = cols[i].cloum_name_ == col.cloum_name_ &&
+                 cols[i].GetType() == col.GetType() &&
+                 cols[i].GetSize() == col.GetSize();
+    row_size += col.GetSize();
+  }
+  if (!is_matched) {
+    throw std::runtime_error("the cloums of the file don't match the table.");
+  }
+
+  size_t imported = 0;
+  bool is_done = RunWrite([&] {
+    // a batch of rows sorted by key goes into the leaves a leaf at a time,
+    // an exported file is in key order already
+    size_t batch_rows = std::max<size_t>(COLUMN_BLOCK_SIZE / row_size, 1);
+    std::vector<Tuple> rows;
+    Tuple row{cols};
+    bool has_rows = true;
+    while (has_rows) {
+      has_rows = reader.Next(&row);
+      if (has_rows) {
+        rows.push_back(row);
+      }
+      if (rows.size() == batch_rows || (!has_rows && !rows.empty())) {
+        imported += txn_manager.InsertRows(TransactionManager::Current(),
+                                           table_name, rows);
+        rows.clear();
+      }
+    }
+  });
+  return is_done ? imported : 0;
+}
+
+void Session::WriteRows(const hsql::SQLStatement *statement) {
+  auto &catalog = *engine_->catalog_;
+  bool is_delete = statement->isType(hsql::kStmtDelete);
+  std::string table_name;
+  const hsql::Expr *where = nullptr;
+  const hsql::UpdateStatement *update = nullptr;
+  if (is_delete) {
+    auto remove = static_cast<const hsql::DeleteStatement *>(statement);
+    table_name = remove->tableName;
+    where = remove->expr;
+  } else {
+    update = static_cast<const hsql::UpdateStatement *>(statement);
+    if (update->table->type != hsql::kTableName) {
+      *err_ << "only support table in update clause now." << std::endl;
+      return;
+    }
+    table_name = update->table->name;
+    where = update->where;
+  }
+  if (!catalog.IsExisted(table_name)) {
+    *err_ << "table is not existed." << std::endl;
+    return;
+  }
+
+  int count = 0;
+  bool is_done = RunWrite([&] {
+    // planned in the transaction, so the scan reads its snapshot
+    auto executor = PlanScan(&catalog, table_name, where);
+    if (is_delete) {
+      executor = std::make_unique<DeleteExecutor>(&catalog, table_name,
+                                                  std::move(executor));
+    } else {
+      executor = std::make_unique<UpdateExecutor>(
+          &catalog, table_name, std::move(executor), *update->updates);
+    }
+    auto cols = executor->GetOutputCols();
+    Tuple tuple{cols};
+    RID rid{};
+    executor->Next(&tuple, &rid);
+    memcpy(&count, tuple.GetValuePtrAt(0), sizeof(int));
+  });
+  if (is_done) {
+    *out_ << count << (is_delete ? " rows deleted." : " rows updated.")
+          << std::endl;
+  }
+}
+
+auto Session::RunWrite(const std::function<void()> &write) -> bool {
+  auto &txn_manager = *engine_->txn_manager_;
+  // outside of a transaction the statement commits alone, once its
+  // log records are on disk, the pages are written back later
+  auto statement_txn = txn_ != nullptr ? txn_ : txn_manager.Begin();
+  try {
+    write();
+  } catch (TransactionAbortException &e) {
+    *err_ << e.what() << " the transaction is rolled back." << std::endl;
+    txn_manager.Abort(statement_txn);
+    txn_ = nullptr;
+    return false;
+  } catch (std::runtime_error &e) {
+    // a statement running alone leaves nothing behind
+    if (txn_ == nullptr) {
+      txn_manager.Abort(statement_txn);
+    }
+    throw;
+  }
+  if (txn_ == nullptr) {
+    txn_manager.Commit(statement_txn);
+  }
+  return true;
+}
+
+void Session::RunStatement(const hsql::SQLStatement *statement) {
+  auto &catalog = *engine_->catalog_;
+  auto &txn_manager = *engine_->txn_manager_;
+  auto &out = *out_;
+  auto &err = *err_;
+
+  if (statement->isType(hsql::kStmtPrepare)) {
+    const auto *prepare =
+        static_cast<const hsql::PrepareStatement *>(statement);
+    if (prepared_.count(prepare->name) != 0) {
+      err << "prepared statement " << prepare->name << " is already existed."
+          << std::endl;
+      return;
+    }
+    auto prepared = std::make_shared<PreparedStatement>(prepare->query);
+    if (!prepared->GetStatement()->isType(hsql::kStmtSelect) &&
+        !prepared->GetStatement()->isType(hsql::kStmtInsert)) {
+      err << "only support select&insert now." << std::endl;
+      return;
+    }
+    prepared_.emplace(prepare->name, std::move(prepared));
+
+  } else if (statement->isType(hsql::kStmtExecute)) {
+    const auto *execute =
+        static_cast<const hsql::ExecuteStatement *>(statement);
+    auto it = prepared_.find(execute->name);
+    if (it == prepared_.end()) {
+      err << "prepared statement is not existed." << std::endl;
+      return;
+    }
+    std::vector<Literal> values;
+    if (execute->parameters != nullptr) {
+      for (auto parameter : *execute->parameters) {
+        Literal value;
+        if (parameter->type == hsql::ExprType::kExprLiteralString) {
+          value.is_string_ = true;
+          value.string_ = parameter->name;
+        } else if (parameter->type == hsql::ExprType::kExprLiteralInt) {
+          value.int_ = parameter->ival;
+        } else {
+          throw std::runtime_error("only support int&char parameters now.");
+        }
+        values.push_back(std::move(value));
+      }
+    }
+    auto prepared = it->second;
+    prepared->Bind(values);
+    RunStatement(prepared->GetStatement());
+
+  } else if (statement->isType(hsql::kStmtSelect)) {
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    const auto *select = static_cast<const hsql::SelectStatement *>(statement);
+    if (!IsTableRefExisted(catalog, select->fromTable)) {
+      err << "table is not existed." << std::endl;
+      return;
+    }
+    auto executor = std::make_unique<ProjectionExecutor>(&catalog, statement);
+    auto &projection_executor = *executor;
+
+    auto value_type = projection_executor.GetOutputCols();
+    auto writer = ResultWriter::Create(output_mode_, value_type, &out);
+    writer->WriteHeader();
+    Tuple tuple{value_type};
+    RID rid{};
+    while (projection_executor.Next(&tuple, &rid)) {
+      writer->WriteRow(tuple);
+    }
+    writer->Finish();
+
+  } else if (statement->isType(hsql::kStmtInsert)) {
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    auto insert = static_cast<const hsql::InsertStatement *>(statement);
+    if (!catalog.IsExisted(insert->tableName)) {
+      err << "table is not existed." << std::endl;
+      return;
+    }
+    auto table_info = catalog.GetTable(insert->tableName);
+    if (!IsValuesMatched(table_info, insert)) {
+      err << "values are not matched the values of table." << std::endl;
+      return;
+    }
+    ValueExecutor value_executor(&catalog, statement);
+    InsertValues(table_info, &value_executor);
+
+  } else if (statement->isType(hsql::kStmtDelete) ||
+             statement->isType(hsql::kStmtUpdate)) {
+    std::shared_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    WriteRows(statement);
+
+  } else if (statement->isType(hsql::kStmtCreate)) {
+    std::unique_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    const auto *create = static_cast<const hsql::CreateStatement *>(statement);
+
+    if (create->type == hsql::CreateType::kCreateIndex) {
+      if (!catalog.IsExisted(create->tableName)) {
+        err << "table is not existed." << std::endl;
+        return;
+      }
+      if (catalog.IsIndexExisted(create->indexName)) {
+        err << "index " << create->indexName << " is already existed."
+            << std::endl;
+        return;
+      }
+      std::vector<std::string> index_cols;
+      for (auto col : *create->indexColumns) {
+        index_cols.emplace_back(col);
+      }
+      if (!catalog.CreateIndex(create->tableName, create->indexName,
+                               index_cols)) {
+        err << "fail to create index." << std::endl;
+      }
+      return;
+    }
+
+    if (catalog.IsExisted(create->tableName)) {
+      err << "table " << create->tableName << " is already existed."
+          << std::endl;
+      return;
+    }
+
+    auto cols = *create->columns;
+
+    // To make sure the key is unique, use value as key here.
+    std::vector<Cloum> value_type;
+    value_type.reserve(cols.size());
+    for (auto &col : cols) {
+      CloumAtr atr{};
+      switch (col->type.data_type) {
+        case hsql::DataType::INT:
+          atr.size_ = sizeof(int);
+          atr.type_ = CloumType::INT;
+          break;
+        case hsql::DataType::CHAR:
+          atr.size_ = col->type.length;
+          atr.type_ = CloumType::CHAR;
+          break;
+        default:
+          throw std::runtime_error("only support int&char type now.");
+      }
+      Cloum c{col->name, atr};
+      value_type.emplace_back(c);
+    }
+
+    catalog.CreateTable(create->tableName, value_type, value_type, layout_);
+  } else if (statement->isType(hsql::kStmtDrop)) {
+    const auto *drop = static_cast<const hsql::DropStatement *>(statement);
+    if (drop->type == hsql::DropType::kDropPreparedStatement) {
+      if (prepared_.erase(drop->name) == 0) {
+        err << "prepared statement is not existed." << std::endl;
+      }
+      return;
+    }
+    std::unique_lock<std::shared_mutex> schema_lock(engine_->schema_latch_);
+    if (drop->type == hsql::DropType::kDropTable) {
+      if (!catalog.IsExisted(drop->name)) {
+        err << "table is not existed." << std::endl;
+        return;
+      }
+      // their rollback would write to the table
+      if (txn_manager.HasUncommittedWrites(drop->name)) {
+        err << "the table has uncommitted writes." << std::endl;
+        return;
+      }
+      if (catalog.DropTable(drop->name)) {
+        out << "successfully drop." << std::endl;
+      } else {
+        err << "fail to drop." << std::endl;
+      }
+    } else if (drop->type == hsql::DropType::kDropIndex) {
+      if (!catalog.DropIndex(drop->indexName)) {
+        err << "index is not existed." << std::endl;
+        return;
+      }
+      out << "successfully drop." << std::endl;
+    } else {
+      err << "only support table&index now." << std::endl;
+    }
+  }
+}
+}  // namespace spdb
@@ -0,0 +1,52 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/checksum.h"
+#include "disk/disk_manager.h"
+
+// Check the checksums of the pages of table and index files, plain or
+// compressed, while no shell has them open. Exits with 1 if a page is
+// damaged.
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " file..." << std::endl;
+    return 2;
+  }
+  bool is_damaged = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string file_name = argv[i];
+    std::vector<page_id_t> damaged_pages;
+    size_t page_count = 0;
+    bool is_compressed = false;
+    try {
+      damaged_pages = spdb::VerifyFile(file_name);
+      is_compressed = spdb::DiskManager::IsCompressedFile(file_name);
+      if (is_compressed) {
+        page_count = spdb::DiskManager(file_name).GetFileSize() / PAGE_SIZE;
+      } else {
+        std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+        page_count = (static_cast<size_t>(file.tellg()) + PAGE_SIZE - 1) /
+                     PAGE_SIZE;
+      }
+    } catch (std::runtime_error& e) {
+      std::cerr << file_name << ": " << e.what() << std::endl;
+      is_damaged = true;
+      continue;
+    }
+    std::cout << file_name << ": " << page_count << " pages, "
+              << damaged_pages.size() << " damaged" << std::endl;
+    for (auto page_id : damaged_pages) {
+      // the pages of a compressed file are wherever its map puts them
+      std::cout << "  page " << page_id;
+      if (!is_compressed) {
+        std::cout << " at offset " << static_cast<size_t>(page_id) * PAGE_SIZE;
+      }
+      std::cout << std::endl;
+    }
+    is_damaged = is_damaged || !damaged_pages.empty();
+  }
+  return is_damaged ? 1 : 0;
+}
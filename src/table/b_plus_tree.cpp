@@ -12,11 +12,12 @@ auto GetTypeSize(std::vector<Cloum> &type) -> size_t {
 BPlusTree::BPlusTree(BufferPoolManager *buffer_pool_manager,
                      std::vector<Cloum> key_type, std::vector<Cloum> value_type,
                      int leaf_max_size, int internal_max_size,
-                     page_id_t root_page_id)
+                     page_id_t root_page_id, LeafLayout layout)
     : bpm_(buffer_pool_manager),
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size),
       root_page_id_(root_page_id),
+      layout_(layout),
       key_type_(key_type),
       value_type_(value_type) {}
 
@@ -35,7 +36,7 @@ auto BPlusTree::Insert(const Tuple &key, const Tuple &value) -> bool {
     auto root_page_guard = bpm_->NewPageGuarded(&root_id);
     auto root_page = root_page_guard.AsMut<BPlusTreeLeafPage>();
     root_page->Init(leaf_max_size_, GetTypeSize(key_type_),
-                    GetTypeSize(value_type_));
+                    GetTypeSize(value_type_), layout_);
     root_page->Insert(key, value, key_type_, value_type_);
     root_page_id_ = root_id;
     return true;
@@ -112,6 +113,113 @@ auto BPlusTree::Insert(const Tuple &key, const Tuple &value) -> bool {
   return true;
 }
 
+auto BPlusTree::InsertBatch(const std::vector<std::pair<Tuple, Tuple>> &pairs,
+                            const std::function<void(size_t)> &before_insert)
+    -> size_t {
+  size_t inserted = 0;
+  size_t i = 0;
+  while (i < pairs.size()) {
+    WritePageGuard leaf_page_guard;
+    // the keys from the first one of the next leaf on belong to other leaves
+    Tuple upper(key_type_);
+    bool has_upper = false;
+    bool is_empty;
+    {
+      std::lock_guard<std::mutex> l(root_latch_);
+      is_empty = root_page_id_ == INVALID_PAGE_ID;
+      if (!is_empty) {
+        leaf_page_guard = bpm_->FetchPageWrite(root_page_id_);
+        while (!leaf_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+          auto page = leaf_page_guard.As<BPlusTreeInternalPage>();
+          int index = page->BinarySearch(pairs[i].first, key_type_);
+          if (index + 1 < page->GetSize()) {
+            upper = page->KeyAt(index + 1, key_type_);
+            has_upper = true;
+          }
+          leaf_page_guard = bpm_->FetchPageWrite(page->ValueAt(index));
+        }
+      }
+    }
+    if (is_empty) {
+      before_insert(i);
+      Insert(pairs[i].first, pairs[i].second);
+      ++inserted;
+      ++i;
+      continue;
+    }
+
+    auto leaf_page = leaf_page_guard.AsMut<BPlusTreeLeafPage>();
+    bool is_full = false;
+    while (i < pairs.size() && (!has_upper || pairs[i].first < upper)) {
+      auto &[key, value] = pairs[i];
+      if (leaf_page->BinarySearch(key, key_type_) != -1) {
+        ++i;
+        continue;
+      }
+      if (leaf_page->GetSize() == leaf_page->GetMaxSize()) {
+        is_full = true;
+        break;
+      }
+      before_insert(i);
+      leaf_page->Insert(key, value, key_type_, value_type_);
+      ++inserted;
+      ++i;
+    }
+    // the leaf splits on the usual path, the next key descends again
+    if (is_full) {
+      leaf_page_guard.Drop();
+      before_insert(i);
+      Insert(pairs[i].first, pairs[i].second);
+      ++inserted;
+      ++i;
+    }
+  }
+  return inserted;
+}
+
+auto BPlusTree::UpdateBatch(
+    const std::vector<std::pair<Tuple, Tuple>> &pairs,
+    const std::function<void(size_t, const Tuple &)> &before_update)
+    -> size_t {
+  size_t updated = 0;
+  size_t i = 0;
+  while (i < pairs.size()) {
+    WritePageGuard leaf_page_guard;
+    // the keys from the first one of the next leaf on belong to other leaves
+    Tuple upper(key_type_);
+    bool has_upper = false;
+    {
+      std::lock_guard<std::mutex> l(root_latch_);
+      if (root_page_id_ == INVALID_PAGE_ID) {
+        return updated;
+      }
+      leaf_page_guard = bpm_->FetchPageWrite(root_page_id_);
+      while (!leaf_page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+        auto page = leaf_page_guard.As<BPlusTreeInternalPage>();
+        int index = page->BinarySearch(pairs[i].first, key_type_);
+        if (index + 1 < page->GetSize()) {
+          upper = page->KeyAt(index + 1, key_type_);
+          has_upper = true;
+        }
+        leaf_page_guard = bpm_->FetchPageWrite(page->ValueAt(index));
+      }
+    }
+
+    auto leaf_page = leaf_page_guard.AsMut<BPlusTreeLeafPage>();
+    do {
+      auto &[key, value] = pairs[i];
+      int index = leaf_page->BinarySearch(key, key_type_);
+      if (index != -1) {
+        before_update(i, leaf_page->ValueAt(index, value_type_));
+        leaf_page->SetValueAt(index, value);
+        ++updated;
+      }
+      ++i;
+    } while (i < pairs.size() && (!has_upper || pairs[i].first < upper));
+  }
+  return updated;
+}
+
 void BPlusTree::Remove(const Tuple &key) {
   Context ctx;
   std::lock_guard<std::mutex> l(root_latch_);
@@ -206,6 +314,8 @@ void BPlusTree::Remove(const Tuple &key) {
     }
 
   } else if (is_borrow == -1) {
+    // the page is only freed once it is unpinned
+    tmp_page_guard.Drop();
     bpm_->DeletePage(root_page_id_);
     root_page_id_ = INVALID_PAGE_ID;
 
@@ -220,11 +330,16 @@ void BPlusTree::Remove(const Tuple &key) {
       ctx.write_set_.pop_back();
     } else {
       auto child_page = tmp_page_guard.AsMut<BPlusTreeInternalPage>();
+      bpm_->DeletePage(child_page->ValueAt(index_to_delete));
       is_borrow =
           child_page->Delete(child_page->KeyAt(index_to_delete, key_type_),
                              bpm_, false, key_type_);
       if (is_borrow == -1) {
+        // the root is left with one child, which takes its place
+        page_id_t old_root_id = root_page_id_;
         root_page_id_ = child_page->ValueAt(0);
+        tmp_page_guard.Drop();
+        bpm_->DeletePage(old_root_id);
       }
       return;
     }
@@ -294,6 +409,140 @@ void BPlusTree::Remove(const Tuple &key) {
   }
 }
 
+auto BPlusTree::BulkLoad(const std::vector<std::pair<Tuple, Tuple>> &pairs)
+    -> bool {
+  std::lock_guard<std::mutex> l(root_latch_);
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    return false;
+  }
+  if (pairs.empty()) {
+    return true;
+  }
+
+  size_t pos = 0;
+  root_page_id_ =
+      Build(pairs.size(), [&](BPlusTreeLeafPage *leaf_page, int index) {
+        leaf_page->SetKeyAt(index, pairs[pos].first);
+        leaf_page->SetValueAt(index, pairs[pos].second);
+        ++pos;
+      });
+  return true;
+}
+
+auto BPlusTree::Build(size_t count,
+                      const std::function<void(BPlusTreeLeafPage *, int)> &fill)
+    -> page_id_t {
+  // spread the entries evenly so that every page stays above its min size
+  auto spread = [](size_t total, size_t max_size, size_t page_index) {
+    size_t pages = (total + max_size - 1) / max_size;
+    return total / pages + (page_index < total % pages ? 1 : 0);
+  };
+
+  // fill the leaves from left to right and chain them up
+  std::vector<std::pair<Tuple, page_id_t>> level;
+  size_t leaf_nums = (count + leaf_max_size_ - 1) / leaf_max_size_;
+  BasicPageGuard prev_guard;
+  for (size_t i = 0; i < leaf_nums; ++i) {
+    page_id_t pid;
+    auto leaf_guard = bpm_->NewPageGuarded(&pid);
+    auto leaf_page = leaf_guard.AsMut<BPlusTreeLeafPage>();
+    leaf_page->Init(leaf_max_size_, GetTypeSize(key_type_),
+                    GetTypeSize(value_type_), layout_);
+    size_t size = spread(count, leaf_max_size_, i);
+    for (size_t j = 0; j < size; ++j) {
+      fill(leaf_page, j);
+    }
+    leaf_page->SetSize(size);
+    level.emplace_back(leaf_page->KeyAt(0, key_type_), pid);
+    if (i > 0) {
+      prev_guard.AsMut<BPlusTreeLeafPage>()->SetNextPageId(pid);
+    }
+    prev_guard = std::move(leaf_guard);
+  }
+  prev_guard.Drop();
+
+  // build the internal levels until a single root is left
+  while (level.size() > 1) {
+    std::vector<std::pair<Tuple, page_id_t>> upper;
+    size_t page_nums = (level.size() + internal_max_size_ - 1) /
+                       internal_max_size_;
+    size_t pos = 0;
+    for (size_t i = 0; i < page_nums; ++i) {
+      page_id_t pid;
+      auto internal_guard = bpm_->NewPageGuarded(&pid);
+      auto internal_page = internal_guard.AsMut<BPlusTreeInternalPage>();
+      internal_page->Init(internal_max_size_, GetTypeSize(key_type_),
+                          sizeof(page_id_t));
+      size_t size = spread(level.size(), internal_max_size_, i);
+      upper.emplace_back(level[pos].first, pid);
+      for (size_t j = 0; j < size; ++j, ++pos) {
+        internal_page->SetKeyAt(j, level[pos].first);
+        internal_page->SetValueAt(j, level[pos].second);
+      }
+      internal_page->SetSize(size);
+    }
+    level = std::move(upper);
+  }
+  return level[0].second;
+}
+
+auto BPlusTree::Compact(std::vector<page_id_t> *old_page_ids) -> size_t {
+  std::lock_guard<std::mutex> l(root_latch_);
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    return 0;
+  }
+  auto page_guard = bpm_->FetchPageRead(root_page_id_);
+  while (!page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto internal_page = page_guard.As<BPlusTreeInternalPage>();
+    page_guard = bpm_->FetchPageRead(internal_page->ValueAt(0));
+  }
+  page_id_t first_leaf_id = page_guard.PageId();
+  page_guard.Drop();
+
+  // count the entries, and check whether the leaves are dense and follow
+  // each other in the file already
+  size_t count = 0;
+  size_t leaf_nums = 0;
+  bool is_in_order = true;
+  for (page_id_t pid = first_leaf_id; pid != INVALID_PAGE_ID;) {
+    auto leaf_guard = bpm_->FetchPageRead(pid);
+    auto leaf_page = leaf_guard.As<BPlusTreeLeafPage>();
+    count += leaf_page->GetSize();
+    ++leaf_nums;
+    page_id_t next_id = leaf_page->GetNextPageId();
+    is_in_order = is_in_order && (next_id == INVALID_PAGE_ID || next_id > pid);
+    pid = next_id;
+  }
+  if (count == 0 || (is_in_order && leaf_nums == (count + leaf_max_size_ - 1) /
+                                                     leaf_max_size_)) {
+    return 0;
+  }
+
+  // copy the entries leaf by leaf, the old tree stays as it is
+  auto leaf_guard = bpm_->FetchPageRead(first_leaf_id);
+  int index = 0;
+  page_id_t root_id =
+      Build(count, [&](BPlusTreeLeafPage *leaf_page, int leaf_index) {
+        auto old_page = leaf_guard.As<BPlusTreeLeafPage>();
+        while (index == old_page->GetSize()) {
+          leaf_guard = bpm_->FetchPageRead(old_page->GetNextPageId());
+          old_page = leaf_guard.As<BPlusTreeLeafPage>();
+          index = 0;
+        }
+        leaf_page->SetKeyAt(leaf_index, old_page->KeyAt(index, key_type_));
+        leaf_page->SetValueAt(leaf_index,
+                              old_page->ValueAt(index, value_type_));
+        ++index;
+      });
+  leaf_guard.Drop();
+
+  CollectPageIds(root_page_id_, old_page_ids);
+  root_page_id_ = root_id;
+  std::vector<page_id_t> page_ids;
+  CollectPageIds(root_id, &page_ids);
+  return page_ids.size();
+}
+
 auto BPlusTree::GetValue(const Tuple &key, Tuple &result) -> bool {
   Context ctx;
   std::lock_guard<std::mutex> l(root_latch_);
@@ -315,6 +564,11 @@ auto BPlusTree::GetValue(const Tuple &key, Tuple &result) -> bool {
 
   auto leaf_page = page_guard.As<BPlusTreeLeafPage>();
   int index = leaf_page->BinarySearch(key, key_type_);
+  while (index < 0 && IsLeftOf(leaf_page, key)) {
+    page_guard = bpm_->FetchPageRead(leaf_page->GetNextPageId());
+    leaf_page = page_guard.As<BPlusTreeLeafPage>();
+    index = leaf_page->BinarySearch(key, key_type_);
+  }
   if (index >= 0) {
     result = leaf_page->ValueAt(index, value_type_);
   } else {
@@ -324,6 +578,79 @@ auto BPlusTree::GetValue(const Tuple &key, Tuple &result) -> bool {
   return true;
 }
 
+void BPlusTree::CollectPageIds(std::vector<page_id_t> *page_ids) {
+  page_id_t root_id;
+  {
+    std::lock_guard<std::mutex> l(root_latch_);
+    root_id = root_page_id_;
+  }
+  CollectPageIds(root_id, page_ids);
+}
+
+void BPlusTree::CollectPageIds(page_id_t root,
+                               std::vector<page_id_t> *page_ids) {
+  std::vector<page_id_t> to_visit;
+  if (root != INVALID_PAGE_ID) {
+    to_visit.push_back(root);
+  }
+  while (!to_visit.empty()) {
+    page_id_t page_id = to_visit.back();
+    to_visit.pop_back();
+    page_ids->push_back(page_id);
+    auto page_guard = bpm_->FetchPageRead(page_id);
+    if (page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+      continue;
+    }
+    auto internal_page = page_guard.As<BPlusTreeInternalPage>();
+    for (int i = 0; i < internal_page->GetSize(); ++i) {
+      to_visit.push_back(internal_page->ValueAt(i));
+    }
+  }
+}
+
+auto BPlusTree::SplitKeys(size_t parts) -> std::vector<Tuple> {
+  std::vector<Tuple> keys;
+  std::vector<page_id_t> level{GetRootPageId()};
+  if (level.front() == INVALID_PAGE_ID || parts < 2) {
+    return keys;
+  }
+  // go down while the children are internal pages and too few
+  while (true) {
+    std::vector<page_id_t> children;
+    bool is_leaf_level = false;
+    for (auto page_id : level) {
+      auto page_guard = bpm_->FetchPageRead(page_id);
+      if (page_guard.As<BPlusTreePage>()->IsLeafPage()) {
+        is_leaf_level = true;
+        break;
+      }
+      auto internal_page = page_guard.As<BPlusTreeInternalPage>();
+      for (int i = 0; i < internal_page->GetSize(); ++i) {
+        if (i > 0) {
+          keys.push_back(internal_page->KeyAt(i, key_type_));
+        }
+        children.push_back(internal_page->ValueAt(i));
+      }
+    }
+    if (is_leaf_level || children.size() >= parts) {
+      break;
+    }
+    level = std::move(children);
+  }
+
+  // the keys of a level lie between the ones of the levels above
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  if (keys.size() < parts) {
+    return keys;
+  }
+  std::vector<Tuple> split_keys;
+  for (size_t i = 1; i < parts; ++i) {
+    split_keys.push_back(keys[i * (keys.size() + 1) / parts - 1]);
+  }
+  return split_keys;
+}
+
 auto BPlusTree::GetRootPageId() -> page_id_t {
   std::lock_guard<std::mutex> l(root_latch_);
   return root_page_id_;
@@ -370,9 +697,28 @@ auto BPlusTree::Begin(const Tuple &key) -> Iterator {
     tmp_page = tmp_page_guard.As<BPlusTreePage>();
   }
 
-  auto leaf_page_guard = bpm_->FetchPageRead(tmp_page_guard.PageId());
-  auto leaf_page = leaf_page_guard.As<BPlusTreeLeafPage>();
-  int index = leaf_page->BinarySearch(key, key_type_);
-  return Iterator(bpm_, tmp_page_guard.PageId(), index, key_type_, value_type_);
+  // every key in this leaf is smaller, the first candidate is on the next one
+  auto leaf_page = tmp_page_guard.As<BPlusTreeLeafPage>();
+  while (IsLeftOf(leaf_page, key)) {
+    tmp_page_guard = bpm_->FetchPageRead(leaf_page->GetNextPageId());
+    leaf_page = tmp_page_guard.As<BPlusTreeLeafPage>();
+  }
+  int index = leaf_page->LowerBound(key, key_type_);
+  if (index < leaf_page->GetSize()) {
+    return Iterator(bpm_, tmp_page_guard.PageId(), index, key_type_,
+                    value_type_);
+  }
+  page_id_t next_id = leaf_page->GetNextPageId();
+  if (next_id == INVALID_PAGE_ID) {
+    return Iterator(bpm_, INVALID_PAGE_ID, -1, key_type_, value_type_);
+  }
+  return Iterator(bpm_, next_id, 0, key_type_, value_type_);
+}
+
+auto BPlusTree::IsLeftOf(const BPlusTreeLeafPage *leaf_page, const Tuple &key)
+    -> bool {
+  int size = leaf_page->GetSize();
+  return size > 0 && leaf_page->GetNextPageId() != INVALID_PAGE_ID &&
+         leaf_page->KeyAt(size - 1, key_type_) < key;
 }
 }  // namespace spdb
@@ -2,15 +2,21 @@
 
 namespace spdb {
 
-void BPlusTreeLeafPage::Init(int max_size, size_t key_size, size_t value_size) {
+void BPlusTreeLeafPage::Init(int max_size, size_t key_size, size_t value_size,
+                             LeafLayout layout) {
   SetSize(0);
   SetMaxSize(max_size);
-  SetPageType(PageType::Leaf);
+  SetPageType(layout == LeafLayout::Pax ? PageType::PaxLeaf : PageType::Leaf);
   next_page_id_ = INVALID_PAGE_ID;
   SetKeySize(key_size);
   SetValueSize(value_size);
 };
 
+auto BPlusTreeLeafPage::GetLayout() const -> LeafLayout {
+  return GetPageType() == PageType::PaxLeaf ? LeafLayout::Pax
+                                            : LeafLayout::Row;
+}
+
 auto BPlusTreeLeafPage::GetNextPageId() const -> page_id_t {
   return next_page_id_;
 }
@@ -19,11 +25,47 @@ void BPlusTreeLeafPage::SetNextPageId(page_id_t next_page_id) {
   next_page_id_ = next_page_id;
 }
 
+auto BPlusTreeLeafPage::CloumOffset(size_t base,
+                                    const std::vector<Cloum> &cols,
+                                    size_t index) const -> size_t {
+  size_t offset = base;
+  for (size_t i = 0; i < index; ++i) {
+    offset += GetMaxSize() * cols[i].GetSize();
+  }
+  return offset;
+}
+
+void BPlusTreeLeafPage::Gather(size_t base, int index,
+                               const std::vector<Cloum> &cols,
+                               char *dst) const {
+  size_t offset = base;
+  for (auto &col : cols) {
+    memcpy(dst, data_ + offset + index * col.GetSize(), col.GetSize());
+    dst += col.GetSize();
+    offset += GetMaxSize() * col.GetSize();
+  }
+}
+
+void BPlusTreeLeafPage::Scatter(size_t base, int index,
+                                const std::vector<Cloum> &cols,
+                                const char *src) {
+  size_t offset = base;
+  for (auto &col : cols) {
+    memcpy(data_ + offset + index * col.GetSize(), src, col.GetSize());
+    src += col.GetSize();
+    offset += GetMaxSize() * col.GetSize();
+  }
+}
+
 auto BPlusTreeLeafPage::KeyAt(int index, std::vector<Cloum> &key_type) const
     -> Tuple {
-  size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
   auto src = (char *)malloc(GetKeySize());
-  memcpy(src, data_ + tuple_offset, GetKeySize());
+  if (GetLayout() == LeafLayout::Pax) {
+    Gather(0, index, key_type, src);
+  } else {
+    size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
+    memcpy(src, data_ + tuple_offset, GetKeySize());
+  }
   Tuple ret(key_type);
   ret.SetValues(src);
   free(src);
@@ -32,9 +74,13 @@ auto BPlusTreeLeafPage::KeyAt(int index, std::vector<Cloum> &key_type) const
 
 auto BPlusTreeLeafPage::ValueAt(int index, std::vector<Cloum> &value_type) const
     -> Tuple {
-  size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
-  auto src = (char *)malloc(GetKeySize());
-  memcpy(src, data_ + GetKeySize() + tuple_offset, GetValueSize());
+  auto src = (char *)malloc(GetValueSize());
+  if (GetLayout() == LeafLayout::Pax) {
+    Gather(GetMaxSize() * GetKeySize(), index, value_type, src);
+  } else {
+    size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
+    memcpy(src, data_ + GetKeySize() + tuple_offset, GetValueSize());
+  }
   Tuple ret(value_type);
   ret.SetValues(src);
   free(src);
@@ -42,14 +88,32 @@ auto BPlusTreeLeafPage::ValueAt(int index, std::vector<Cloum> &value_type) const
 }
 
 void BPlusTreeLeafPage::SetKeyAt(int index, const Tuple &key) {
+  if (GetLayout() == LeafLayout::Pax) {
+    Scatter(0, index, key.GetCloums(), key.GetData());
+    return;
+  }
   size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
   memcpy(data_ + tuple_offset, key.GetData(), GetKeySize());
 }
 void BPlusTreeLeafPage::SetValueAt(int index, const Tuple &value) {
+  if (GetLayout() == LeafLayout::Pax) {
+    Scatter(GetMaxSize() * GetKeySize(), index, value.GetCloums(),
+            value.GetData());
+    return;
+  }
   size_t tuple_offset = (GetKeySize() + GetValueSize()) * index;
   memcpy(data_ + tuple_offset + GetKeySize(), value.GetData(), GetValueSize());
 }
 
+auto BPlusTreeLeafPage::ValueCloumAt(size_t index,
+                                     const std::vector<Cloum> &value_type) const
+    -> const char * {
+  if (GetLayout() != LeafLayout::Pax) {
+    return nullptr;
+  }
+  return data_ + CloumOffset(GetMaxSize() * GetKeySize(), value_type, index);
+}
+
 auto BPlusTreeLeafPage::BinarySearch(const Tuple &key,
                                      std::vector<Cloum> &key_type) const
     -> int {
@@ -71,6 +135,21 @@ auto BPlusTreeLeafPage::BinarySearch(const Tuple &key,
   return ret;
 }
 
+auto BPlusTreeLeafPage::LowerBound(const Tuple &key,
+                                   std::vector<Cloum> &key_type) const -> int {
+  int l = 0;
+  int r = GetSize();
+  while (l < r) {
+    int m = (l + r) / 2;
+    if (KeyAt(m, key_type) < key) {
+      l = m + 1;
+    } else {
+      r = m;
+    }
+  }
+  return l;
+}
+
 auto BPlusTreeLeafPage::Insert(const Tuple &key, const Tuple &value,
                                std::vector<Cloum> &key_type,
                                std::vector<Cloum> &value_type) -> int {
@@ -115,7 +194,7 @@ auto BPlusTreeLeafPage::Split(const Tuple &key, const Tuple &value,
     -> BasicPageGuard {
   auto split_page_guard = bpm->NewPageGuarded(&pid_to_insert);
   auto split_page = split_page_guard.AsMut<BPlusTreeLeafPage>();
-  split_page->Init(GetMaxSize(), GetKeySize(), GetValueSize());
+  split_page->Init(GetMaxSize(), GetKeySize(), GetValueSize(), GetLayout());
   split_page->SetNextPageId(next_page_id_);
   next_page_id_ = pid_to_insert;
 
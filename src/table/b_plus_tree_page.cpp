@@ -5,8 +5,9 @@ namespace spdb {
  * Page type enum class is defined in b_plus_tree_page.h
  */
 auto BPlusTreePage::IsLeafPage() const -> bool {
-  return page_type_ == PageType::Leaf;
+  return page_type_ == PageType::Leaf || page_type_ == PageType::PaxLeaf;
 }
+auto BPlusTreePage::GetPageType() const -> PageType { return page_type_; }
 void BPlusTreePage::SetPageType(PageType page_type) { page_type_ = page_type; }
 
 /*
@@ -1,5 +1,10 @@
 #include "table/b_plus_tree.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
 #include <thread>
 
 #include "gtest/gtest.h"
@@ -168,6 +173,201 @@ TEST(BPlusTreeConcurrentTest, InsertTest2) {
   delete bpm;
 }
 
+TEST(BPlusTreeConcurrentTest, BeginLowerBoundTest) {
+  auto disk = DiskManager("b_plus_tree_test_disk");
+  auto *bpm = new BufferPoolManager(50, &disk);
+  // create b+ tree
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  Tuple index_key(type);
+  BPlusTree tree(bpm, type, type, 4, 5);
+  // only even keys are inserted
+  std::vector<int32_t> keys;
+  for (int32_t key = 2; key <= 200; key += 2) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  // a missing key starts from the next larger one, even across leaves
+  for (int32_t start_key = 1; start_key < 200; start_key += 2) {
+    index_key.SetValues((char *)&start_key);
+    auto iterator = tree.Begin(index_key);
+    ASSERT_FALSE(iterator.IsEnd());
+    EXPECT_EQ(*(*iterator).first.GetValueAtAs<int32_t>(0), start_key + 1);
+  }
+
+  int32_t past_key = 201;
+  index_key.SetValues((char *)&past_key);
+  EXPECT_TRUE(tree.Begin(index_key).IsEnd());
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, BulkLoadTest) {
+  auto disk = DiskManager("b_plus_tree_test_disk");
+  auto *bpm = new BufferPoolManager(50, &disk);
+  // create b+ tree
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  Tuple index_key(type);
+  BPlusTree tree(bpm, type, type, 3, 4);
+  // sorted pairs to load
+  std::vector<std::pair<Tuple, Tuple>> pairs;
+  int32_t scale_factor = 1000;
+  for (int32_t key = 1; key <= scale_factor; key++) {
+    index_key.SetValues((char *)&key);
+    pairs.emplace_back(index_key, index_key);
+  }
+  ASSERT_TRUE(tree.BulkLoad(pairs));
+  ASSERT_FALSE(tree.BulkLoad(pairs));
+
+  int32_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(*(*iterator).second.GetValueAtAs<int32_t>(0), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale_factor + 1);
+
+  // the loaded tree keeps working with inserts and deletes
+  std::vector<int32_t> remove_keys;
+  for (int32_t key = 1; key <= scale_factor; key += 2) {
+    remove_keys.push_back(key);
+  }
+  DeleteHelper(&tree, remove_keys);
+  InsertHelper(&tree, {scale_factor + 1});
+  for (int32_t key = 1; key <= scale_factor + 1; key++) {
+    Tuple result(type);
+    index_key.SetValues((char *)&key);
+    EXPECT_EQ(tree.GetValue(index_key, result), key % 2 == 0 ||
+                                                    key == scale_factor + 1);
+  }
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, InsertBatchTest) {
+  auto disk = DiskManager("b_plus_tree_test_disk");
+  auto *bpm = new BufferPoolManager(50, &disk);
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  Tuple index_key(type);
+  BPlusTree tree(bpm, type, type, 3, 4);
+  // every third key is in the tree already
+  int32_t scale_factor = 1000;
+  std::vector<int32_t> keys;
+  for (int32_t key = 0; key < scale_factor; key += 3) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  // batches of sorted keys, a few of them twice
+  std::vector<int32_t> batch_keys;
+  for (int32_t key = 0; key < scale_factor; ++key) {
+    batch_keys.push_back(key);
+  }
+  std::shuffle(batch_keys.begin(), batch_keys.end(), std::mt19937(0));
+  size_t inserted = 0;
+  size_t called = 0;
+  for (size_t begin = 0; begin < batch_keys.size(); begin += 100) {
+    std::vector<int32_t> batch(batch_keys.begin() + begin,
+                               batch_keys.begin() + begin + 100);
+    batch.push_back(batch.front());
+    std::sort(batch.begin(), batch.end());
+    std::vector<std::pair<Tuple, Tuple>> pairs;
+    for (auto key : batch) {
+      index_key.SetValues((char *)&key);
+      pairs.emplace_back(index_key, index_key);
+    }
+    inserted += tree.InsertBatch(pairs, [&](size_t i) {
+      // only the keys not in the tree yet go in
+      EXPECT_NE(*pairs[i].first.GetValueAtAs<int32_t>(0) % 3, 0);
+      ++called;
+    });
+  }
+  EXPECT_EQ(inserted, scale_factor - keys.size());
+  EXPECT_EQ(called, inserted);
+
+  int32_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(*(*iterator).first.GetValueAtAs<int32_t>(0), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale_factor);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, UpdateBatchTest) {
+  auto disk = DiskManager("b_plus_tree_test_disk");
+  auto *bpm = new BufferPoolManager(50, &disk);
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  Tuple index_key(type);
+  Tuple value(type);
+  BPlusTree tree(bpm, type, type, 3, 4);
+  // the even keys are in the tree
+  int32_t scale_factor = 1000;
+  std::vector<int32_t> keys;
+  for (int32_t key = 0; key < scale_factor; key += 2) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+  auto root_page_id = tree.GetRootPageId();
+
+  // every key is negated, the odd ones are not in the tree
+  std::vector<std::pair<Tuple, Tuple>> pairs;
+  for (int32_t key = 0; key < scale_factor; ++key) {
+    int32_t negated = -key;
+    index_key.SetValues((char *)&key);
+    value.SetValues((char *)&negated);
+    pairs.emplace_back(index_key, value);
+  }
+  size_t called = 0;
+  size_t updated = tree.UpdateBatch(pairs, [&](size_t i, const Tuple &old) {
+    // the value replaced is the one inserted
+    EXPECT_EQ(*old.GetValueAtAs<int32_t>(0), static_cast<int32_t>(i));
+    EXPECT_EQ(i % 2, 0);
+    ++called;
+  });
+  EXPECT_EQ(updated, keys.size());
+  EXPECT_EQ(called, updated);
+  EXPECT_EQ(tree.GetRootPageId(), root_page_id);
+
+  int32_t current_key = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(*(*iterator).first.GetValueAtAs<int32_t>(0), current_key);
+    EXPECT_EQ(*(*iterator).second.GetValueAtAs<int32_t>(0), -current_key);
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(current_key, scale_factor);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, SplitKeysTest) {
+  auto disk = DiskManager("b_plus_tree_test_disk");
+  auto *bpm = new BufferPoolManager(50, &disk);
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  BPlusTree tree(bpm, type, type, 3, 4);
+  EXPECT_TRUE(tree.SplitKeys(8).empty());
+  std::vector<int32_t> keys;
+  for (int32_t key = 0; key < 1000; ++key) {
+    keys.push_back(key);
+  }
+  InsertHelper(&tree, keys);
+
+  // the keys are increasing, and the ranges between them hold some keys
+  // each
+  auto split_keys = tree.SplitKeys(8);
+  ASSERT_EQ(split_keys.size(), 7);
+  int32_t last = 0;
+  for (auto &key : split_keys) {
+    int32_t split_key = *key.GetValueAtAs<int32_t>(0);
+    EXPECT_GT(split_key, last);
+    last = split_key;
+  }
+  EXPECT_LT(last, 1000);
+  EXPECT_TRUE(tree.SplitKeys(1).empty());
+  delete bpm;
+}
+
 TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto disk = DiskManager("b_plus_tree_test_disk");
@@ -343,4 +543,246 @@ TEST(BPlusTreeConcurrentTest, MixTest2) {
   delete bpm;
 }
 
+TEST(BPlusTreeTest, VacuumTest) {
+  const std::string db_name = "b_plus_tree_vacuum_test_disk";
+  std::remove(db_name.data());
+  std::remove(FreePageMap::FileName(db_name).data());
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  int leaf_max_size = (PAGE_SIZE - LEAF_HEADER_SIZE) / (type[0].GetSize() * 2);
+  int internal_max_size =
+      (PAGE_SIZE - INTERNAL_HEADER_SIZE) / (type[0].GetSize() * 2);
+  std::vector<int32_t> keys;
+  for (int32_t key = 0; key < 20000; ++key) {
+    keys.push_back(key);
+  }
+  std::vector<int32_t> remove_keys(keys.begin() + 1000, keys.end());
+
+  page_id_t root_id = INVALID_PAGE_ID;
+  page_id_t page_count = 0;
+  {
+    DiskManager disk(db_name);
+    BufferPoolManager bpm(50, &disk);
+    BPlusTree tree(&bpm, type, type, leaf_max_size, internal_max_size);
+    InsertHelper(&tree, keys);
+    page_count = bpm.GetPageCount();
+    DeleteHelper(&tree, remove_keys);
+    EXPECT_GT(bpm.GetFreePageCount(), 0);
+    bpm.FlushAllPages();
+    root_id = tree.GetRootPageId();
+  }
+
+  {
+    // the free pages survive the restart and are reused first
+    DiskManager disk(db_name);
+    BufferPoolManager bpm(50, &disk);
+    EXPECT_EQ(bpm.GetPageCount(), page_count);
+    size_t free_page_count = bpm.GetFreePageCount();
+    EXPECT_GT(free_page_count, 0);
+    BPlusTree tree(&bpm, type, type, leaf_max_size, internal_max_size,
+                   root_id);
+    InsertHelper(&tree, std::vector<int32_t>(remove_keys.begin(),
+                                             remove_keys.begin() + 1000));
+    EXPECT_LT(bpm.GetFreePageCount(), free_page_count);
+    EXPECT_EQ(bpm.GetPageCount(), page_count);
+
+    // the vacuum cuts the tail of the file off
+    std::vector<page_id_t> used_pages;
+    tree.CollectPageIds(&used_pages);
+    EXPECT_GT(bpm.Vacuum(used_pages), 0);
+    EXPECT_LT(bpm.GetPageCount(), page_count);
+    EXPECT_EQ(disk.GetFileSize(), bpm.GetPageCount() * PAGE_SIZE);
+    EXPECT_EQ(bpm.GetPageCount(), used_pages.size() + bpm.GetFreePageCount());
+    int32_t size = 0;
+    for (auto it = tree.Begin(); it != tree.End(); ++it) {
+      EXPECT_EQ(*(*it).second.GetValueAtAs<int32_t>(0), size);
+      ++size;
+    }
+    EXPECT_EQ(size, 2000);
+  }
+  std::remove(db_name.data());
+  std::remove(FreePageMap::FileName(db_name).data());
+}
+
+TEST(BPlusTreeTest, CompactTest) {
+  const std::string db_name = "b_plus_tree_compact_test_disk";
+  std::remove(db_name.data());
+  std::remove(FreePageMap::FileName(db_name).data());
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  int leaf_max_size = (PAGE_SIZE - LEAF_HEADER_SIZE) / (type[0].GetSize() * 2);
+  int internal_max_size =
+      (PAGE_SIZE - INTERNAL_HEADER_SIZE) / (type[0].GetSize() * 2);
+  {
+    DiskManager disk(db_name);
+    BufferPoolManager bpm(50, &disk);
+    BPlusTree tree(&bpm, type, type, leaf_max_size, internal_max_size);
+    std::vector<int32_t> keys;
+    for (int32_t key = 0; key < 20000; ++key) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+    InsertHelper(&tree, keys);
+    std::vector<int32_t> remove_keys;
+    for (int32_t key = 0; key < 20000; key += 2) {
+      remove_keys.push_back(key);
+    }
+    DeleteHelper(&tree, remove_keys);
+
+    // the leaves in key order, as page ids
+    auto leaves = [&]() {
+      std::vector<page_id_t> page_ids;
+      auto guard = bpm.FetchPageRead(tree.GetRootPageId());
+      while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+        auto internal_page = guard.As<BPlusTreeInternalPage>();
+        guard = bpm.FetchPageRead(internal_page->ValueAt(0));
+      }
+      while (true) {
+        page_ids.push_back(guard.PageId());
+        page_id_t next_id = guard.As<BPlusTreeLeafPage>()->GetNextPageId();
+        if (next_id == INVALID_PAGE_ID) {
+          break;
+        }
+        guard = bpm.FetchPageRead(next_id);
+      }
+      return page_ids;
+    };
+    size_t dense_leaf_nums = (10000 + leaf_max_size - 1) / leaf_max_size;
+    EXPECT_GT(leaves().size(), dense_leaf_nums);
+
+    // a reader in the middle of the old leaves goes on reading them
+    auto it = tree.Begin();
+    for (int i = 0; i < 100; ++i) {
+      ++it;
+    }
+    std::vector<page_id_t> old_page_ids;
+    size_t page_nums = tree.Compact(&old_page_ids);
+    EXPECT_GT(page_nums, 0);
+    EXPECT_LT(page_nums, old_page_ids.size());
+    int32_t key = 201;
+    for (; it != tree.End(); ++it, key += 2) {
+      EXPECT_EQ(*(*it).first.GetValueAtAs<int32_t>(0), key);
+    }
+    EXPECT_EQ(key, 20001);
+
+    // the new leaves are dense and follow each other in the file
+    auto leaf_ids = leaves();
+    EXPECT_EQ(leaf_ids.size(), dense_leaf_nums);
+    EXPECT_TRUE(std::is_sorted(leaf_ids.begin(), leaf_ids.end()));
+    for (auto page_id : old_page_ids) {
+      EXPECT_TRUE(bpm.DeletePage(page_id));
+    }
+    std::vector<page_id_t> used_pages;
+    tree.CollectPageIds(&used_pages);
+    EXPECT_EQ(used_pages.size(), page_nums);
+    std::vector<page_id_t> none;
+    EXPECT_EQ(tree.Compact(&none), 0);
+    EXPECT_TRUE(none.empty());
+
+    LookupHelper(&tree, std::vector<int32_t>{1, 3, 9999, 19999}, 0);
+    InsertHelper(&tree, remove_keys);
+    key = 0;
+    for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++key) {
+      EXPECT_EQ(*(*iter).first.GetValueAtAs<int32_t>(0), key);
+    }
+    EXPECT_EQ(key, 20000);
+  }
+  std::remove(db_name.data());
+  std::remove(FreePageMap::FileName(db_name).data());
+}
+
+TEST(BPlusTreeTest, PaxLeafTest) {
+  const std::string row_db_name = "b_plus_tree_row_leaf_test_disk";
+  const std::string pax_db_name = "b_plus_tree_pax_leaf_test_disk";
+  for (auto &name : {row_db_name, pax_db_name}) {
+    std::remove(name.data());
+    std::remove(FreePageMap::FileName(name).data());
+  }
+  std::vector<Cloum> key_type{Cloum{"id", {CloumType::INT, 4}}};
+  std::vector<Cloum> value_type{Cloum{"id", {CloumType::INT, 4}},
+                                Cloum{"name", {CloumType::CHAR, 12}}};
+  int leaf_max_size = (PAGE_SIZE - LEAF_HEADER_SIZE) / 20;
+  int internal_max_size = (PAGE_SIZE - INTERNAL_HEADER_SIZE) / 20;
+  {
+    DiskManager row_disk(row_db_name);
+    DiskManager pax_disk(pax_db_name);
+    BufferPoolManager row_bpm(50, &row_disk);
+    BufferPoolManager pax_bpm(50, &pax_disk);
+    BPlusTree row_tree(&row_bpm, key_type, value_type, leaf_max_size,
+                       internal_max_size);
+    BPlusTree pax_tree(&pax_bpm, key_type, value_type, leaf_max_size,
+                       internal_max_size, INVALID_PAGE_ID, LeafLayout::Pax);
+
+    // the same entries in both, split and merged on the way
+    std::vector<int32_t> keys;
+    for (int32_t key = 0; key < 10000; ++key) {
+      keys.push_back(key);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+    Tuple key(key_type);
+    Tuple value(value_type);
+    for (auto k : keys) {
+      char data[16] = {0};
+      memcpy(data, &k, sizeof(int32_t));
+      snprintf(data + 4, 12, "name%d", k);
+      key.SetValues(data);
+      value.SetValues(data);
+      ASSERT_TRUE(row_tree.Insert(key, value));
+      ASSERT_TRUE(pax_tree.Insert(key, value));
+    }
+    for (int32_t k = 0; k < 10000; k += 3) {
+      key.SetValues((char *)&k);
+      row_tree.Remove(key);
+      pax_tree.Remove(key);
+    }
+    std::vector<page_id_t> old_page_ids;
+    EXPECT_GT(pax_tree.Compact(&old_page_ids), 0);
+
+    auto row_it = row_tree.Begin();
+    auto pax_it = pax_tree.Begin();
+    size_t entries = 0;
+    for (; pax_it != pax_tree.End(); ++row_it, ++pax_it, ++entries) {
+      ASSERT_TRUE(row_it != row_tree.End());
+      EXPECT_EQ(memcmp((*pax_it).first.GetData(), (*row_it).first.GetData(),
+                       4),
+                0);
+      EXPECT_EQ(memcmp((*pax_it).second.GetData(),
+                       (*row_it).second.GetData(), 16),
+                0);
+    }
+    EXPECT_TRUE(row_it == row_tree.End());
+    EXPECT_EQ(entries, 6666);
+
+    // the values of a cloum follow each other in a pax leaf
+    auto first_leaf = [](BufferPoolManager *bpm, page_id_t root_id) {
+      auto guard = bpm->FetchPageRead(root_id);
+      while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+        auto internal_page = guard.As<BPlusTreeInternalPage>();
+        guard = bpm->FetchPageRead(internal_page->ValueAt(0));
+      }
+      return guard;
+    };
+    auto row_guard = first_leaf(&row_bpm, row_tree.GetRootPageId());
+    auto row_leaf = row_guard.As<BPlusTreeLeafPage>();
+    EXPECT_EQ(row_leaf->GetLayout(), LeafLayout::Row);
+    EXPECT_EQ(row_leaf->ValueCloumAt(0, value_type), nullptr);
+    auto pax_guard = first_leaf(&pax_bpm, pax_tree.GetRootPageId());
+    auto pax_leaf = pax_guard.As<BPlusTreeLeafPage>();
+    EXPECT_EQ(pax_leaf->GetLayout(), LeafLayout::Pax);
+    const char *ids = pax_leaf->ValueCloumAt(0, value_type);
+    const char *names = pax_leaf->ValueCloumAt(1, value_type);
+    ASSERT_GT(pax_leaf->GetSize(), 0);
+    for (int i = 0; i < pax_leaf->GetSize(); ++i) {
+      int32_t id;
+      memcpy(&id, ids + i * 4, sizeof(int32_t));
+      EXPECT_EQ(id, i + i / 2 + 1);
+      EXPECT_EQ(std::string(names + i * 12), "name" + std::to_string(id));
+    }
+  }
+  for (auto &name : {row_db_name, pax_db_name}) {
+    std::remove(name.data());
+    std::remove(FreePageMap::FileName(name).data());
+  }
+}
+
 }  // namespace spdb
@@ -1,12 +1,21 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <cstring>
 #include <random>
+#include <set>
+#include <stdexcept>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "config/config.h"
+#include "disk/checksum.h"
 #include "disk/disk_manager.h"
+#include "disk/free_page_map.h"
+#include "disk/lz4.h"
 #include "gtest/gtest.h"
 
 namespace spdb {
@@ -223,4 +232,469 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, SharedPoolTest) {
+  const size_t buffer_pool_size = 10;
+  remove("test_a.db");
+  remove("test_b.db");
+
+  BufferPool pool(buffer_pool_size);
+  auto *disk_a = new DiskManager("test_a.db");
+  auto *disk_b = new DiskManager("test_b.db");
+  auto *bpm_a = new BufferPoolManager(&pool, disk_a);
+  auto *bpm_b = new BufferPoolManager(&pool, disk_b);
+
+  // Scenario: page ids of different files are independent.
+  page_id_t pid_a;
+  page_id_t pid_b;
+  auto *page_a = bpm_a->NewPage(&pid_a);
+  auto *page_b = bpm_b->NewPage(&pid_b);
+  ASSERT_NE(nullptr, page_a);
+  ASSERT_NE(nullptr, page_b);
+  EXPECT_EQ(0, pid_a);
+  EXPECT_EQ(0, pid_b);
+  snprintf(page_a->GetData(), PAGE_SIZE, "file a");
+  snprintf(page_b->GetData(), PAGE_SIZE, "file b");
+  EXPECT_TRUE(bpm_a->UnpinPage(pid_a, true));
+  EXPECT_TRUE(bpm_b->UnpinPage(pid_b, true));
+
+  // Scenario: both files share the frames of the pool, the pages of file a
+  // evict the ones of file b.
+  for (size_t i = 1; i <= buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm_a->NewPage(&pid_a));
+  }
+  EXPECT_EQ(nullptr, bpm_b->NewPage(&pid_b));
+  for (page_id_t i = 1; i <= static_cast<page_id_t>(buffer_pool_size); ++i) {
+    EXPECT_TRUE(bpm_a->UnpinPage(i, false));
+  }
+
+  // Scenario: a cached page is fetched without reading the file.
+  size_t misses = pool.GetMissCount();
+  page_a = bpm_a->FetchPage(buffer_pool_size);
+  EXPECT_EQ(misses, pool.GetMissCount());
+  EXPECT_TRUE(bpm_a->UnpinPage(buffer_pool_size, false));
+
+  // Scenario: dirty pages are written back when evicted.
+  page_b = bpm_b->FetchPage(0);
+  ASSERT_NE(nullptr, page_b);
+  EXPECT_EQ(0, strcmp(page_b->GetData(), "file b"));
+  EXPECT_TRUE(bpm_b->UnpinPage(0, false));
+  page_a = bpm_a->FetchPage(0);
+  ASSERT_NE(nullptr, page_a);
+  EXPECT_EQ(0, strcmp(page_a->GetData(), "file a"));
+  EXPECT_TRUE(bpm_a->UnpinPage(0, false));
+
+  // Scenario: a reopened file allocates pages after the existing ones.
+  delete bpm_b;
+  bpm_b = new BufferPoolManager(&pool, disk_b);
+  EXPECT_NE(nullptr, bpm_b->NewPage(&pid_b));
+  EXPECT_EQ(1, pid_b);
+  EXPECT_TRUE(bpm_b->UnpinPage(pid_b, false));
+
+  delete bpm_a;
+  delete bpm_b;
+  disk_a->ShutDown();
+  disk_b->ShutDown();
+  delete disk_a;
+  delete disk_b;
+  remove("test_a.db");
+  remove("test_b.db");
+}
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, EvictionTest) {
+  const std::string db_name = "test_eviction.db";
+  const std::string map_name = FreePageMap::FileName(db_name);
+  remove(db_name.data());
+  remove(map_name.data());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(4, disk_manager);
+  const int thread_nums = 4;
+  const int pages_per_thread = 8;
+  for (int i = 0; i < thread_nums * pages_per_thread; ++i) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Scenario: dirty pages are written back as they are evicted by the
+  // fetches of other threads, none of them loses a write or is cached
+  // twice.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_nums; ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 1; round <= 50; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          page_id_t page_id = t * pages_per_thread + i;
+          Page *page = nullptr;
+          while (page == nullptr) {
+            page = bpm->FetchPage(page_id);
+          }
+          int value;
+          memcpy(&value, page->GetData() + 100, sizeof(int));
+          EXPECT_EQ(round - 1, value);
+          value = round;
+          memcpy(page->GetData() + 100, &value, sizeof(int));
+          EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  bpm->FlushAllPages();
+  for (page_id_t page_id = 0; page_id < thread_nums * pages_per_thread;
+       ++page_id) {
+    char data[PAGE_SIZE];
+    disk_manager->ReadPage(page_id, data);
+    int value;
+    memcpy(&value, data + 100, sizeof(int));
+    EXPECT_EQ(50, value);
+  }
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.data());
+  remove(map_name.data());
+}
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FreePageMapTest) {
+  const std::string db_name = "test_free.db";
+  const std::string map_name = FreePageMap::FileName(db_name);
+  remove(db_name.data());
+  remove(map_name.data());
+
+  // Scenario: the deleted pages are saved as free when the file is closed.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_TRUE(bpm->DeletePage(5));
+  EXPECT_TRUE(bpm->DeletePage(2));
+  delete bpm;
+
+  // Scenario: a reopened file reuses them, the lowest first.
+  bpm = new BufferPoolManager(10, disk_manager);
+  EXPECT_EQ(2, bpm->GetFreePageCount());
+  for (page_id_t expected : {2, 5, 8}) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_EQ(expected, page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_TRUE(bpm->DeletePage(3));
+  delete bpm;
+
+  // Scenario: a map is stale once the free pages change, until it is saved
+  // again, so a crash leaks the free pages instead of reusing live ones.
+  FreePageMap map(db_name);
+  std::set<page_id_t> free_pages;
+  EXPECT_TRUE(map.Load(9, &free_pages));
+  EXPECT_EQ(std::set<page_id_t>{3}, free_pages);
+  map.Invalidate();
+  EXPECT_FALSE(FreePageMap(db_name).Load(9, &free_pages));
+  map.Save(9, {1, 4});
+  EXPECT_TRUE(FreePageMap(db_name).Load(9, &free_pages));
+  EXPECT_EQ((std::set<page_id_t>{1, 4}), free_pages);
+  // and it belongs to a file of as many pages
+  EXPECT_FALSE(FreePageMap(db_name).Load(10, &free_pages));
+
+  // Scenario: a map of several pages.
+  std::set<page_id_t> many;
+  for (page_id_t i = 0; i < 3 * FREE_PAGE_MAP_BITS; i += 7) {
+    many.insert(i);
+  }
+  map.Save(3 * FREE_PAGE_MAP_BITS, many);
+  EXPECT_TRUE(FreePageMap(db_name).Load(3 * FREE_PAGE_MAP_BITS, &free_pages));
+  EXPECT_EQ(many, free_pages);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.data());
+  remove(map_name.data());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ChecksumTest) {
+  const std::string db_name = "test_checksum.db";
+  const std::string map_name = FreePageMap::FileName(db_name);
+  remove(db_name.data());
+  remove(map_name.data());
+
+  // Scenario: the CRC32C check value.
+  EXPECT_EQ(0xE3069283, Crc32c("123456789", 9));
+  EXPECT_EQ(0xE3069283, Crc32c("6789", 4, Crc32c("12345", 5)));
+
+  // Scenario: the pages written back carry their checksum.
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager, LRUK_REPLACER_K, true);
+  page_id_t page_id_temp;
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData() + PAGE_CHECKSUM_OFFSET + 4, 'a' + i, 100);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  EXPECT_TRUE(VerifyFile(db_name).empty());
+
+  // Scenario: a byte flipped on the disk is found.
+  FILE *file = fopen(db_name.data(), "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, 2 * PAGE_SIZE + 50, SEEK_SET);
+  fputc('z', file);
+  fclose(file);
+  EXPECT_EQ(std::vector<page_id_t>{2}, VerifyFile(db_name));
+
+  // Scenario: the damaged page is never handed out, the others still are.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(10, disk_manager, LRUK_REPLACER_K, true);
+  EXPECT_THROW(bpm->FetchPage(2), std::runtime_error);
+  for (page_id_t page_id : {0, 1, 3}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ('a' + page_id, page->GetData()[PAGE_CHECKSUM_OFFSET + 4]);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_THROW(bpm->FetchPage(2), std::runtime_error);
+
+  // Scenario: the threads fetching a page read meanwhile share the frame.
+  std::vector<std::thread> threads;
+  std::vector<Page *> fetched(4, nullptr);
+  for (size_t i = 0; i < fetched.size(); ++i) {
+    threads.emplace_back([&, i] { fetched[i] = bpm->FetchPage(3); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto *page : fetched) {
+    EXPECT_EQ(fetched[0], page);
+    EXPECT_TRUE(bpm->UnpinPage(3, false));
+  }
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: the pages of a file without checksums are written and read as
+  // they are, the bytes of the checksum included.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(10, disk_manager);
+  auto *page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  memset(page->GetData(), 'c', PAGE_SIZE);
+  EXPECT_TRUE(bpm->UnpinPage(2, true));
+  bpm->FlushAllPages();
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(2, data);
+  EXPECT_EQ(std::string(PAGE_SIZE, 'c'), std::string(data, PAGE_SIZE));
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.data());
+  remove(map_name.data());
+
+  // Scenario: a file written before the checksums were kept is read as it
+  // is, its pages get a checksum as they are written back.
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    memset(page->GetData() + PAGE_CHECKSUM_OFFSET, 'a' + i, 100);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  EXPECT_TRUE(VerifyFile(db_name).empty());
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(10, disk_manager, LRUK_REPLACER_K, true);
+  for (page_id_t page_id = 0; page_id < 4; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ('a' + page_id, page->GetData()[PAGE_CHECKSUM_OFFSET]);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, page_id == 1));
+  }
+  EXPECT_TRUE(bpm->FlushPage(1));
+  disk_manager->ReadPage(0, data);
+  EXPECT_FALSE(HasPageChecksum(data));
+  disk_manager->ReadPage(1, data);
+  EXPECT_TRUE(HasPageChecksum(data));
+  EXPECT_TRUE(IsPageChecksumValid(data));
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  file = fopen(db_name.data(), "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, PAGE_SIZE + 50, SEEK_SET);
+  fputc('z', file);
+  fclose(file);
+  EXPECT_EQ(std::vector<page_id_t>{1}, VerifyFile(db_name));
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManager(10, disk_manager, LRUK_REPLACER_K, true);
+  EXPECT_THROW(bpm->FetchPage(1), std::runtime_error);
+  // the mark isn't in the page handed out
+  auto *old_page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, old_page);
+  EXPECT_FALSE(HasPageChecksum(old_page->GetData()));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.data());
+  remove(map_name.data());
+}
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, FlushLatchTest) {
+  const std::string db_name = "test_flush_latch.db";
+  const std::string map_name = FreePageMap::FileName(db_name);
+  remove(db_name.data());
+  remove(map_name.data());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(10, disk_manager, LRUK_REPLACER_K, true);
+  page_id_t page_id;
+  { auto guard = bpm->NewPageGuarded(&page_id); }
+
+  // Scenario: a flush waits for the writer of the page, the writer writes
+  // the page back itself as it is done.
+  std::atomic<bool> is_flushed{false};
+  std::thread flusher;
+  {
+    auto guard = bpm->FetchPageWrite(page_id);
+    memset(guard.GetDataMut() + PAGE_CHECKSUM_OFFSET + 4, 'x', 100);
+    flusher = std::thread([&] {
+      EXPECT_TRUE(bpm->FlushPage(page_id));
+      is_flushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(is_flushed);
+    memset(guard.GetDataMut() + PAGE_CHECKSUM_OFFSET + 104, 'y', 100);
+  }
+  flusher.join();
+  EXPECT_TRUE(is_flushed);
+  bpm->FlushAllPages();
+  char data[PAGE_SIZE];
+  disk_manager->ReadPage(page_id, data);
+  EXPECT_TRUE(IsPageChecksumValid(data));
+  EXPECT_EQ('x', data[PAGE_CHECKSUM_OFFSET + 4]);
+  EXPECT_EQ('y', data[PAGE_CHECKSUM_OFFSET + 104]);
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.data());
+  remove(map_name.data());
+}
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, CompressionTest) {
+  const std::string db_name = "test_compressed.db";
+  const std::string map_name = DiskManager::MapFileName(db_name);
+  remove(db_name.data());
+  remove(map_name.data());
+  remove(FreePageMap::FileName(db_name).data());
+  std::mt19937 rng(2024);
+  // rows of a CHAR(32) and a CHAR(64) padded with zeros, or random bytes
+  auto make_page = [&](char *data, bool is_random) {
+    memset(data, 0, PAGE_SIZE);
+    for (size_t i = 0; i < PAGE_SIZE; ++i) {
+      if (is_random) {
+        data[i] = static_cast<char>(rng());
+      } else if (i % 96 < 8 || (i % 96 >= 32 && i % 96 < 36)) {
+        data[i] = static_cast<char>('a' + rng() % 26);
+      }
+    }
+    SetPageChecksum(data);
+  };
+
+  // Scenario: LZ4 blocks round trip, and text pages shrink several-fold.
+  char page[PAGE_SIZE];
+  char block[PAGE_SIZE];
+  char data[PAGE_SIZE];
+  make_page(page, false);
+  size_t size = Lz4Compress(page, PAGE_SIZE, block, PAGE_SIZE);
+  ASSERT_GT(size, 0);
+  EXPECT_LT(size * 3, PAGE_SIZE);
+  ASSERT_TRUE(Lz4Decompress(block, size, data, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page, data, PAGE_SIZE));
+  EXPECT_FALSE(Lz4Decompress(block, size / 2, data, PAGE_SIZE));
+  make_page(page, true);
+  EXPECT_EQ(0, Lz4Compress(page, PAGE_SIZE, block, PAGE_SIZE));
+
+  // Scenario: the pages of a compressed file read back as written, moved
+  // when they grow.
+  std::vector<std::string> pages(32, std::string(PAGE_SIZE, '\0'));
+  auto *disk_manager = new DiskManager(db_name, true);
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  for (page_id_t id = 0; id < 32; ++id) {
+    make_page(pages[id].data(), id == 7);
+    disk_manager->WritePage(id, pages[id].data());
+  }
+  make_page(pages[3].data(), true);
+  disk_manager->WritePage(3, pages[3].data());
+  make_page(pages[7].data(), false);
+  disk_manager->WritePage(7, pages[7].data());
+  EXPECT_THROW(disk_manager->WritePage(40, data), std::runtime_error);
+  EXPECT_EQ(32 * PAGE_SIZE, disk_manager->GetFileSize());
+  disk_manager->Sync();
+  EXPECT_LT(DiskManager::GetDiskSize(db_name) * 2, 32 * PAGE_SIZE);
+  for (page_id_t id = 0; id < 32; ++id) {
+    disk_manager->ReadPage(id, data);
+    EXPECT_EQ(0, memcmp(pages[id].data(), data, PAGE_SIZE));
+  }
+  EXPECT_THROW(disk_manager->ReadPage(32, data), std::runtime_error);
+  disk_manager->ShutDown();
+  delete disk_manager;
+
+  // Scenario: a reopened file keeps its mode, a buffer pool reads through it
+  // and the truncated pages are cut off.
+  disk_manager = new DiskManager(db_name);
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  auto *bpm = new BufferPoolManager(10, disk_manager);
+  for (page_id_t id = 0; id < 32; ++id) {
+    auto *fetched = bpm->FetchPage(id);
+    ASSERT_NE(nullptr, fetched);
+    EXPECT_EQ(0, memcmp(pages[id].data(), fetched->GetData(), PAGE_SIZE));
+    EXPECT_TRUE(bpm->UnpinPage(id, false));
+  }
+  delete bpm;
+  size_t disk_size = DiskManager::GetDiskSize(db_name);
+  disk_manager->Truncate(16);
+  disk_manager->Sync();
+  EXPECT_EQ(16 * PAGE_SIZE, disk_manager->GetFileSize());
+  EXPECT_LT(DiskManager::GetDiskSize(db_name), disk_size);
+  disk_manager->ShutDown();
+  delete disk_manager;
+  EXPECT_TRUE(VerifyFile(db_name).empty());
+
+  // Scenario: a file is converted to a plain one and back.
+  DiskManager::Convert(db_name, false);
+  EXPECT_FALSE(DiskManager::IsCompressedFile(db_name));
+  EXPECT_EQ(16 * PAGE_SIZE, DiskManager::GetDiskSize(db_name));
+  DiskManager::Convert(db_name, true);
+  EXPECT_TRUE(DiskManager::IsCompressedFile(db_name));
+  disk_manager = new DiskManager(db_name);
+  for (page_id_t id = 0; id < 16; ++id) {
+    disk_manager->ReadPage(id, data);
+    EXPECT_EQ(0, memcmp(pages[id].data(), data, PAGE_SIZE));
+  }
+  delete disk_manager;
+
+  // Scenario: a damaged extent is found, the first page is in the first one
+  // after the header.
+  FILE *file = fopen(db_name.data(), "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, COMPRESSED_EXTENT_SIZE + 20, SEEK_SET);
+  fputc(fgetc(file) ^ 0x55, file);
+  fclose(file);
+  EXPECT_EQ(std::vector<page_id_t>{0}, VerifyFile(db_name));
+  remove(db_name.data());
+  remove(map_name.data());
+}
 }  // namespace spdb
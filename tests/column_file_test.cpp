@@ -0,0 +1,129 @@
+#include "disk/column_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace spdb {
+static const char *file_name = "column_file_test.col";
+
+static auto TableType() -> std::vector<Cloum> {
+  return {Cloum("id", {CloumType::INT, 4}),
+          Cloum("name", {CloumType::CHAR, 16}),
+          Cloum("val", {CloumType::INT, 4})};
+}
+
+static auto Row(int id) -> Tuple {
+  auto type = TableType();
+  Tuple row(type);
+  char data[24] = {0};
+  int val = id % 7 - 3;
+  memcpy(data, &id, sizeof(int));
+  snprintf(data + 4, 16, "name%d", id % 100);
+  memcpy(data + 20, &val, sizeof(int));
+  row.SetValues(data);
+  return row;
+}
+
+// write the rows 0, ..., n - 1
+static void WriteRows(int n) {
+  ColumnFileWriter writer(file_name, TableType(), {"id"});
+  for (int id = 0; id < n; ++id) {
+    writer.Append(Row(id));
+  }
+  EXPECT_EQ(writer.Finish(), n);
+}
+
+TEST(ColumnFileTest, RoundTripTest) {
+  // several blocks, the last one partly filled
+  int n = 3 * COLUMN_BLOCK_SIZE / 24 + 100;
+  WriteRows(n);
+  {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    EXPECT_LT(static_cast<size_t>(file.tellg()), n * 24 / 2);
+  }
+
+  ColumnFileReader reader(file_name);
+  auto cols = reader.GetCloums();
+  ASSERT_EQ(cols.size(), 3);
+  EXPECT_EQ(cols[1].cloum_name_, "name");
+  EXPECT_EQ(cols[1].GetType(), CloumType::CHAR);
+  EXPECT_EQ(cols[1].GetSize(), 16);
+  EXPECT_EQ(reader.GetKeyNames(), std::vector<std::string>{"id"});
+  Tuple row(cols);
+  int id = 0;
+  while (reader.Next(&row)) {
+    ASSERT_EQ(memcmp(row.GetData(), Row(id).GetData(), 24), 0);
+    ++id;
+  }
+  EXPECT_EQ(id, n);
+  EXPECT_FALSE(reader.Next(&row));
+  remove(file_name);
+}
+
+TEST(ColumnFileTest, BlockStatsTest) {
+  int n = 3 * COLUMN_BLOCK_SIZE / 24 + 100;
+  WriteRows(n);
+
+  // every other block is passed over without reading its values
+  ColumnFileReader reader(file_name);
+  auto cols = reader.GetCloums();
+  Tuple row(cols);
+  int first = 0;
+  size_t blocks = 0;
+  while (reader.NextBlock()) {
+    int rows = reader.GetBlockRowCount();
+    int min;
+    int max;
+    memcpy(&min, reader.GetBlockMin(0), sizeof(int));
+    memcpy(&max, reader.GetBlockMax(0), sizeof(int));
+    EXPECT_EQ(min, first);
+    EXPECT_EQ(max, first + rows - 1);
+    memcpy(&min, reader.GetBlockMin(2), sizeof(int));
+    memcpy(&max, reader.GetBlockMax(2), sizeof(int));
+    EXPECT_EQ(min, -3);
+    EXPECT_EQ(max, 3);
+    EXPECT_STREQ(reader.GetBlockMin(1), "name0");
+    EXPECT_STREQ(reader.GetBlockMax(1), "name99");
+    if (blocks++ % 2 == 1) {
+      ASSERT_TRUE(reader.Next(&row));
+      EXPECT_EQ(*row.GetValueAtAs<int>(0), first);
+    }
+    first += rows;
+  }
+  EXPECT_EQ(first, n);
+  EXPECT_EQ(blocks, 4);
+  remove(file_name);
+}
+
+TEST(ColumnFileTest, DamagedTest) {
+  WriteRows(1000);
+  {
+    std::fstream file(file_name,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(-20, std::ios::end);
+    file.put('x');
+  }
+  ColumnFileReader reader(file_name);
+  auto cols = reader.GetCloums();
+  Tuple row(cols);
+  EXPECT_THROW(
+      {
+        while (reader.Next(&row)) {
+        }
+      },
+      std::runtime_error);
+
+  {
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    file << "not a column file";
+  }
+  EXPECT_THROW(ColumnFileReader{file_name}, std::runtime_error);
+  remove(file_name);
+}
+}  // namespace spdb
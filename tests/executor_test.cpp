@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "concurrency/transaction_manager.h"
+#include "config/catalog.h"
+#include "config/config.h"
+#include "disk/tuple.h"
+#include "executor/abstract_executor.h"
+#include "executor/aggregation_executor.h"
+#include "executor/hash_join_executor.h"
+#include "executor/index_scan_executor.h"
+#include "executor/limit_executor.h"
+#include "executor/merge_join_executor.h"
+#include "executor/planner.h"
+#include "executor/seq_scan_executor.h"
+#include "executor/sort_executor.h"
+#include "gtest/gtest.h"
+using namespace std;
+
+namespace spdb {
+// an executor returning (id, val) tuples from a vector
+class VectorExecutor : public AbstractExecutor {
+ public:
+  explicit VectorExecutor(vector<pair<int, int>> rows)
+      : AbstractExecutor(nullptr), rows_(std::move(rows)) {
+    CloumAtr atr{CloumType::INT, 4};
+    cols_.emplace_back("id", atr);
+    cols_.emplace_back("val", atr);
+  }
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override {
+    if (cursor_ == rows_.size()) {
+      return false;
+    }
+    int src[2] = {rows_[cursor_].first, rows_[cursor_].second};
+    tuple->SetValues(reinterpret_cast<char *>(src));
+    ++cursor_;
+    return true;
+  }
+
+  auto GetOutputCols() -> vector<Cloum> override { return cols_; }
+
+  // the number of rows returned or skipped
+  auto GetCursor() const -> size_t { return cursor_; }
+
+ private:
+  vector<pair<int, int>> rows_;
+  vector<Cloum> cols_;
+  size_t cursor_{0};
+};
+
+// run an executor of 4 int cloums to the end
+static auto Collect(AbstractExecutor *executor) -> vector<vector<int>> {
+  auto cols = executor->GetOutputCols();
+  EXPECT_EQ(cols.size(), 4);
+  Tuple tuple{cols};
+  RID rid{};
+  vector<vector<int>> ret;
+  while (executor->Next(&tuple, &rid)) {
+    vector<int> row(4);
+    memcpy(row.data(), tuple.GetData(), 4 * sizeof(int));
+    ret.push_back(row);
+  }
+  sort(ret.begin(), ret.end());
+  return ret;
+}
+
+// the expected result of joining left.id = right.id
+static auto NestedLoopJoin(const vector<pair<int, int>> &left,
+                           const vector<pair<int, int>> &right)
+    -> vector<vector<int>> {
+  vector<vector<int>> ret;
+  for (auto &l : left) {
+    for (auto &r : right) {
+      if (l.first == r.first) {
+        ret.push_back({l.first, l.second, r.first, r.second});
+      }
+    }
+  }
+  sort(ret.begin(), ret.end());
+  return ret;
+}
+
+TEST(ExecutorTest, HashJoinTest) {
+  vector<pair<int, int>> left, right;
+  for (int i = 0; i < 1000; ++i) {
+    left.emplace_back(i % 300, i);
+    right.emplace_back((i * 7) % 500, -i);
+  }
+  auto expected = NestedLoopJoin(left, right);
+  ASSERT_FALSE(expected.empty());
+
+  for (bool build_left : {true, false}) {
+    HashJoinExecutor join(
+        nullptr, make_unique<VectorExecutor>(left), "l",
+        make_unique<VectorExecutor>(right), "r", {0}, {0}, nullptr, build_left);
+    EXPECT_EQ(join.GetOutputCols()[0].cloum_name_, "l.id");
+    EXPECT_EQ(join.GetOutputCols()[3].cloum_name_, "r.val");
+    EXPECT_EQ(Collect(&join), expected);
+  }
+}
+
+TEST(ExecutorTest, HashJoinSpillTest) {
+  vector<pair<int, int>> left, right;
+  for (int i = 0; i < 5000; ++i) {
+    left.emplace_back(i, i);
+    right.emplace_back(i % 2500, i);
+  }
+  // a budget of a few entries forces both sides into partitions
+  HashJoinExecutor join(nullptr, make_unique<VectorExecutor>(left), "l",
+                        make_unique<VectorExecutor>(right), "r", {0}, {0},
+                        nullptr, true, 1024);
+  EXPECT_EQ(Collect(&join), NestedLoopJoin(left, right));
+}
+
+TEST(ExecutorTest, MergeJoinTest) {
+  vector<pair<int, int>> left, right;
+  for (int i = 0; i < 1000; ++i) {
+    left.emplace_back(i / 3, i);
+    right.emplace_back(i / 2 + 100, i);
+  }
+  MergeJoinExecutor join(nullptr, make_unique<VectorExecutor>(left), "l",
+                         make_unique<VectorExecutor>(right), "r", {0}, {0},
+                         nullptr);
+  auto expected = NestedLoopJoin(left, right);
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(Collect(&join), expected);
+}
+
+TEST(ExecutorTest, AggregationTest) {
+  vector<pair<int, int>> rows;
+  map<int, vector<int>> groups;
+  for (int i = 0; i < 20000; ++i) {
+    int id = (i * 31) % 7000;
+    int val = i % 1000 - 500;
+    rows.emplace_back(id, val);
+    groups[id].push_back(val);
+  }
+  vector<AggregateSpec> aggregates{{AggregationType::COUNT, -1, "COUNT(*)"},
+                                   {AggregationType::SUM, 1, "SUM(val)"},
+                                   {AggregationType::MIN, 1, "MIN(val)"},
+                                   {AggregationType::MAX, 1, "MAX(val)"},
+                                   {AggregationType::AVG, 1, "AVG(val)"}};
+
+  // the small budget spills most of the groups
+  for (size_t budget : {size_t{EXECUTOR_MEMORY_BUDGET}, size_t{4096}}) {
+    AggregationExecutor agg(nullptr, make_unique<VectorExecutor>(rows), {0},
+                            aggregates, budget);
+    auto cols = agg.GetOutputCols();
+    ASSERT_EQ(cols.size(), 6);
+    EXPECT_EQ(cols[1].cloum_name_, "COUNT(*)");
+    Tuple tuple{cols};
+    RID rid{};
+    map<int, vector<int>> result;
+    while (agg.Next(&tuple, &rid)) {
+      vector<int> row(6);
+      memcpy(row.data(), tuple.GetData(), 6 * sizeof(int));
+      EXPECT_EQ(result.count(row[0]), 0);
+      result[row[0]] = vector<int>(row.begin() + 1, row.end());
+    }
+    ASSERT_EQ(result.size(), groups.size());
+    for (auto &[id, vals] : groups) {
+      int sum = 0;
+      for (auto v : vals) {
+        sum += v;
+      }
+      vector<int> expected{static_cast<int>(vals.size()), sum,
+                           *min_element(vals.begin(), vals.end()),
+                           *max_element(vals.begin(), vals.end()),
+                           sum / static_cast<int>(vals.size())};
+      EXPECT_EQ(result[id], expected);
+    }
+  }
+}
+
+TEST(ExecutorTest, AggregationWithoutGroupByTest) {
+  vector<AggregateSpec> aggregates{{AggregationType::COUNT, -1, "COUNT(*)"},
+                                   {AggregationType::SUM, 1, "SUM(val)"}};
+  for (int n : {0, 5000}) {
+    vector<pair<int, int>> rows;
+    for (int i = 0; i < n; ++i) {
+      rows.emplace_back(i, 2);
+    }
+    AggregationExecutor agg(nullptr, make_unique<VectorExecutor>(rows), {},
+                            aggregates);
+    auto cols = agg.GetOutputCols();
+    Tuple tuple{cols};
+    RID rid{};
+    ASSERT_TRUE(agg.Next(&tuple, &rid));
+    int row[2];
+    memcpy(row, tuple.GetData(), sizeof(row));
+    EXPECT_EQ(row[0], n);
+    EXPECT_EQ(row[1], 2 * n);
+    EXPECT_FALSE(agg.Next(&tuple, &rid));
+  }
+
+  // MIN and MAX start from the first value, not from 0
+  vector<AggregateSpec> bounds{{AggregationType::MIN, 1, "MIN(val)"},
+                               {AggregationType::MAX, 1, "MAX(val)"}};
+  for (auto &[vals, expected] :
+       vector<pair<vector<int>, pair<int, int>>>{{{5, 7, 9}, {5, 9}},
+                                                 {{-5, -7}, {-7, -5}}}) {
+    vector<pair<int, int>> rows;
+    for (auto v : vals) {
+      rows.emplace_back(rows.size(), v);
+    }
+    AggregationExecutor agg(nullptr, make_unique<VectorExecutor>(rows), {},
+                            bounds);
+    auto cols = agg.GetOutputCols();
+    Tuple tuple{cols};
+    RID rid{};
+    ASSERT_TRUE(agg.Next(&tuple, &rid));
+    int row[2];
+    memcpy(row, tuple.GetData(), sizeof(row));
+    EXPECT_EQ(row[0], expected.first);
+    EXPECT_EQ(row[1], expected.second);
+  }
+}
+
+TEST(ExecutorTest, LoserTreeTest) {
+  for (size_t k = 1; k < 10; ++k) {
+    vector<vector<int>> sources(k);
+    vector<int> expected;
+    for (size_t i = 0; i < k; ++i) {
+      for (size_t j = 0; j <= i * 3; ++j) {
+        sources[i].push_back(random() % 100);
+      }
+      sort(sources[i].begin(), sources[i].end());
+      expected.insert(expected.end(), sources[i].begin(), sources[i].end());
+    }
+    sort(expected.begin(), expected.end());
+
+    vector<size_t> cursors(k, 0);
+    LoserTree tree(k, [&](size_t a, size_t b) {
+      return sources[a][cursors[a]] < sources[b][cursors[b]];
+    });
+    vector<int> result;
+    for (int w = tree.Winner(); w != -1; w = tree.Winner()) {
+      result.push_back(sources[w][cursors[w]++]);
+      tree.Replay(cursors[w] == sources[w].size());
+    }
+    EXPECT_EQ(result, expected);
+  }
+}
+
+TEST(ExecutorTest, SortTest) {
+  vector<pair<int, int>> rows;
+  for (int i = 0; i < 20000; ++i) {
+    rows.emplace_back(random() % 1000 - 500, i);
+  }
+  auto expected = rows;
+  sort(expected.begin(), expected.end(), [](auto &a, auto &b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  });
+
+  // the small budgets write sorted runs, the limits use the heap
+  vector<pair<size_t, size_t>> cases{
+      {numeric_limits<size_t>::max(), EXECUTOR_MEMORY_BUDGET},
+      {numeric_limits<size_t>::max(), 4096},
+      {100, EXECUTOR_MEMORY_BUDGET},
+      {1000, 4096}};
+  for (auto [limit, budget] : cases) {
+    SortExecutor sort_executor(nullptr, make_unique<VectorExecutor>(rows),
+                               {{0, true}, {1, false}}, limit, budget);
+    auto cols = sort_executor.GetOutputCols();
+    Tuple tuple{cols};
+    RID rid{};
+    vector<pair<int, int>> result;
+    while (sort_executor.Next(&tuple, &rid)) {
+      int row[2];
+      memcpy(row, tuple.GetData(), sizeof(row));
+      result.emplace_back(row[0], row[1]);
+    }
+    size_t size = min(limit, expected.size());
+    EXPECT_EQ(result, decltype(expected)(expected.begin(),
+                                         expected.begin() + size));
+  }
+}
+
+TEST(ExecutorTest, LimitTest) {
+  vector<pair<int, int>> rows;
+  for (int i = 0; i < 100; ++i) {
+    rows.emplace_back(i, -i);
+  }
+  // limit, offset, then the ids expected
+  vector<tuple<size_t, size_t, int, int>> cases{
+      {10, 0, 0, 10},
+      {10, 5, 5, 15},
+      {10, 95, 95, 100},
+      {0, 0, 0, 0},
+      {10, 200, 0, 0},
+      {numeric_limits<size_t>::max(), 90, 90, 100}};
+  for (auto [limit, offset, first, last] : cases) {
+    auto child = make_unique<VectorExecutor>(rows);
+    auto &vector_executor = *child;
+    LimitExecutor limit_executor(nullptr, std::move(child), limit, offset);
+    auto cols = limit_executor.GetOutputCols();
+    Tuple tuple{cols};
+    RID rid{};
+    vector<int> result;
+    while (limit_executor.Next(&tuple, &rid)) {
+      result.push_back(*tuple.GetValueAtAs<int>(0));
+    }
+    EXPECT_FALSE(limit_executor.Next(&tuple, &rid));
+    vector<int> expected;
+    for (int i = first; i < last; ++i) {
+      expected.push_back(i);
+    }
+    EXPECT_EQ(result, expected);
+    // the child is asked for no row past the limit
+    EXPECT_EQ(vector_executor.GetCursor(),
+              min(rows.size(), limit == 0 ? 0 : offset + expected.size()));
+  }
+}
+
+// The where clause of a select on table_name.
+static auto ParseWhere(hsql::SQLParserResult *result, const string &table_name,
+                       const string &where) -> const hsql::SelectStatement * {
+  hsql::SQLParser::parse("select * from " + table_name + " where " + where +
+                             ";",
+                         result);
+  if (!result->isValid()) {
+    return nullptr;
+  }
+  return static_cast<const hsql::SelectStatement *>(result->getStatement(0));
+}
+
+TEST(ExecutorTest, ExtractKeyRangeTest) {
+  CloumAtr atr{CloumType::INT, 4};
+  vector<Cloum> key_type{Cloum{"id", atr}, Cloum{"val", atr}};
+  hsql::SQLParserResult result;
+  auto range = [&](const string &where) {
+    auto select = ParseWhere(&result, "t", where);
+    EXPECT_NE(select, nullptr) << where;
+    return select == nullptr ? nullopt
+                             : ExtractKeyRange(select->whereClause, key_type);
+  };
+
+  // equality on the whole key is a point
+  auto point = range("id = 5 and val = 7");
+  ASSERT_TRUE(point.has_value());
+  EXPECT_TRUE(point->IsPoint(key_type.size()));
+  EXPECT_EQ(point->eq_[1]->ival, 7);
+
+  // a range on the cloum after the equalities, with the literal on either
+  // side
+  auto prefix = range("id = 5 and 3 < val and val <= 9");
+  ASSERT_TRUE(prefix.has_value());
+  EXPECT_EQ(prefix->eq_.size(), 1);
+  ASSERT_NE(prefix->lower_, nullptr);
+  EXPECT_EQ(prefix->lower_->ival, 3);
+  EXPECT_FALSE(prefix->lower_inclusive_);
+  ASSERT_NE(prefix->upper_, nullptr);
+  EXPECT_EQ(prefix->upper_->ival, 9);
+  EXPECT_TRUE(prefix->upper_inclusive_);
+
+  auto bounds = range("id >= 3 and id < 9");
+  ASSERT_TRUE(bounds.has_value());
+  EXPECT_TRUE(bounds->eq_.empty());
+  EXPECT_TRUE(bounds->lower_inclusive_);
+  EXPECT_FALSE(bounds->upper_inclusive_);
+
+  auto between = range("id between 3 and 9 and val = 1");
+  ASSERT_TRUE(between.has_value());
+  EXPECT_TRUE(between->eq_.empty());
+  EXPECT_EQ(between->lower_->ival, 3);
+  EXPECT_EQ(between->upper_->ival, 9);
+  EXPECT_TRUE(between->lower_inclusive_ && between->upper_inclusive_);
+
+  // an equality wins over a range on the same cloum
+  auto eq = range("id > 3 and id = 5");
+  ASSERT_TRUE(eq.has_value());
+  EXPECT_EQ(eq->eq_.size(), 1);
+  EXPECT_EQ(eq->lower_, nullptr);
+
+  // nothing bounds the first key cloum
+  EXPECT_FALSE(range("val = 5").has_value());
+  EXPECT_FALSE(range("id = 5 or id = 6").has_value());
+  EXPECT_FALSE(range("val > 1 and val < 5").has_value());
+}
+
+TEST(ExecutorTest, IndexScanTest) {
+  const char *catalog_name = "executor_test_catalog.db";
+  const char *table_name = "executor_test_table";
+  auto remove_files = [&] {
+    std::remove(catalog_name);
+    std::remove(table_name);
+    std::remove(FreePageMap::FileName(table_name).data());
+  };
+  remove_files();
+  {
+    BufferPool pool(256);
+    Catalog catalog(catalog_name, &pool);
+    CloumAtr atr{CloumType::INT, 4};
+    vector<Cloum> cols{Cloum{"id", atr}, Cloum{"val", atr}};
+    ASSERT_TRUE(catalog.CreateTable(table_name, {cols[0]}, cols));
+    TransactionManager txn_manager(&catalog);
+    catalog.SetTransactionManager(&txn_manager);
+    vector<Tuple> rows;
+    for (int id = 0; id < 1000; ++id) {
+      int values[2] = {id, id % 7};
+      rows.emplace_back(cols);
+      rows.back().SetValues(reinterpret_cast<char *>(values));
+    }
+    auto txn = txn_manager.Begin();
+    ASSERT_EQ(txn_manager.InsertRows(txn, table_name, rows), 1000);
+    txn_manager.Commit(txn);
+
+    // where clause, whether the key bounds it, the ids expected
+    vector<tuple<string, bool, function<bool(int, int)>>> cases{
+        {"id = 500", true, [](int id, int) { return id == 500; }},
+        {"id = 5000", true, [](int, int) { return false; }},
+        {"id >= 100 and id < 110", true,
+         [](int id, int) { return id >= 100 && id < 110; }},
+        {"id > 100 and id <= 110", true,
+         [](int id, int) { return id > 100 && id <= 110; }},
+        {"110 > id and 100 < id", true,
+         [](int id, int) { return id > 100 && id < 110; }},
+        {"id between 100 and 110", true,
+         [](int id, int) { return id >= 100 && id <= 110; }},
+        {"id > 990", true, [](int id, int) { return id > 990; }},
+        {"id <= 5", true, [](int id, int) { return id <= 5; }},
+        {"id > 10 and id < 5", true, [](int, int) { return false; }},
+        // the rest of the where clause is checked on the rows in range
+        {"id >= 100 and id < 200 and val = 3", true,
+         [](int id, int val) { return id >= 100 && id < 200 && val == 3; }},
+        {"id = 500 and val = 1", true, [](int, int) { return false; }},
+        {"id = 500 and val = 3", true, [](int id, int) { return id == 500; }},
+        // without a bound on the key the table is scanned
+        {"val = 3", false, [](int, int val) { return val == 3; }},
+        {"id = 5 or id = 6", false,
+         [](int id, int) { return id == 5 || id == 6; }}};
+    for (auto &[where, is_index_scan, is_expected] : cases) {
+      hsql::SQLParserResult result;
+      auto select = ParseWhere(&result, table_name, where);
+      ASSERT_NE(select, nullptr) << where;
+      auto scan = PlanScan(&catalog, select);
+      EXPECT_EQ(dynamic_cast<IndexScanExecutor *>(scan.get()) != nullptr,
+                is_index_scan)
+          << where;
+      EXPECT_EQ(dynamic_cast<SeqScanExecutor *>(scan.get()) != nullptr,
+                !is_index_scan)
+          << where;
+      auto out_cols = scan->GetOutputCols();
+      Tuple tuple{out_cols};
+      RID rid{};
+      vector<int> ids;
+      while (scan->Next(&tuple, &rid)) {
+        ids.push_back(*tuple.GetValueAtAs<int>(0));
+      }
+      vector<int> expected;
+      for (int id = 0; id < 1000; ++id) {
+        if (is_expected(id, id % 7)) {
+          expected.push_back(id);
+        }
+      }
+      EXPECT_EQ(ids, expected) << where;
+    }
+  }
+  remove_files();
+}
+}  // namespace spdb
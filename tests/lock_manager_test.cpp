@@ -0,0 +1,248 @@
+#include "concurrency/lock_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "concurrency/transaction_manager.h"
+#include "config/catalog.h"
+#include "gtest/gtest.h"
+
+namespace spdb {
+static void Sleep() {
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+TEST(LockManagerTest, SharedExclusiveTest) {
+  LockManager lock_manager;
+  Transaction t0(0, 0);
+  Transaction t1(1, 0);
+  Transaction t2(2, 0);
+  lock_manager.LockShared(&t0, "row");
+  lock_manager.LockShared(&t1, "row");
+  EXPECT_EQ(t0.GetLockSet().at("row"), LockMode::SHARED);
+
+  // the writer waits for both readers
+  std::atomic<bool> is_locked{false};
+  std::thread writer([&] {
+    lock_manager.LockExclusive(&t2, "row");
+    is_locked = true;
+  });
+  Sleep();
+  EXPECT_FALSE(is_locked);
+  lock_manager.UnlockAll(&t0);
+  Sleep();
+  EXPECT_FALSE(is_locked);
+  lock_manager.Unlock(&t1, "row");
+  writer.join();
+  EXPECT_TRUE(is_locked);
+  EXPECT_TRUE(t1.GetLockSet().empty());
+
+  // and a reader coming later waits for the writer
+  std::thread reader([&] { lock_manager.LockShared(&t0, "row"); });
+  Sleep();
+  EXPECT_TRUE(t0.GetLockSet().empty());
+  lock_manager.UnlockAll(&t2);
+  reader.join();
+  EXPECT_EQ(t0.GetLockSet().size(), 1);
+  lock_manager.UnlockAll(&t0);
+}
+
+TEST(LockManagerTest, UpgradeTest) {
+  LockManager lock_manager;
+  Transaction t0(0, 0);
+  Transaction t1(1, 0);
+  Transaction t2(2, 0);
+  lock_manager.LockShared(&t0, "row");
+  lock_manager.LockShared(&t1, "row");
+
+  // the upgrade goes ahead of the writer waiting already
+  std::thread writer([&] { lock_manager.LockExclusive(&t2, "row"); });
+  Sleep();
+  std::thread upgrade([&] { lock_manager.LockExclusive(&t0, "row"); });
+  Sleep();
+  // a second upgrade would deadlock with the first one
+  EXPECT_THROW(lock_manager.LockExclusive(&t1, "row"),
+               TransactionAbortException);
+  EXPECT_EQ(t1.GetState(), TransactionState::ABORTED);
+  lock_manager.UnlockAll(&t1);
+  upgrade.join();
+  EXPECT_EQ(t0.GetLockSet().at("row"), LockMode::EXCLUSIVE);
+  EXPECT_TRUE(t2.GetLockSet().empty());
+  lock_manager.UnlockAll(&t0);
+  writer.join();
+  EXPECT_EQ(t2.GetLockSet().at("row"), LockMode::EXCLUSIVE);
+  lock_manager.UnlockAll(&t2);
+}
+
+TEST(LockManagerTest, DeadlockTest) {
+  LockManager lock_manager(10);
+  lock_manager.Start();
+  Transaction t0(0, 0);
+  Transaction t1(1, 0);
+  lock_manager.LockExclusive(&t0, "a");
+  lock_manager.LockExclusive(&t1, "b");
+
+  std::thread older([&] {
+    lock_manager.LockExclusive(&t0, "b");
+    lock_manager.UnlockAll(&t0);
+  });
+  Sleep();
+  // the younger transaction is aborted, the older one goes on
+  EXPECT_THROW(lock_manager.LockExclusive(&t1, "a"),
+               TransactionAbortException);
+  EXPECT_EQ(t1.GetState(), TransactionState::ABORTED);
+  lock_manager.UnlockAll(&t1);
+  older.join();
+  EXPECT_EQ(t0.GetState(), TransactionState::RUNNING);
+  EXPECT_EQ(lock_manager.GetDeadlockCount(), 1);
+}
+
+TEST(LockManagerTest, DeadlockCycleTest) {
+  // a cycle through readers and an upgrade: t0 waits to upgrade a, which
+  // t1 reads, t1 waits for b, which t2 writes, t2 waits for a
+  LockManager lock_manager;
+  Transaction t0(0, 0);
+  Transaction t1(1, 0);
+  Transaction t2(2, 0);
+  lock_manager.LockShared(&t0, "a");
+  lock_manager.LockShared(&t1, "a");
+  lock_manager.LockExclusive(&t2, "b");
+  std::thread upgrade([&] { lock_manager.LockExclusive(&t0, "a"); });
+  Sleep();
+  std::atomic<bool> is_aborted{false};
+  std::thread reader([&] {
+    try {
+      lock_manager.LockShared(&t1, "b");
+    } catch (TransactionAbortException &e) {
+      is_aborted = true;
+    }
+  });
+  Sleep();
+  std::thread writer([&] {
+    try {
+      lock_manager.LockShared(&t2, "a");
+    } catch (TransactionAbortException &e) {
+      is_aborted = true;
+      lock_manager.UnlockAll(&t2);
+    }
+  });
+  Sleep();
+  lock_manager.DetectDeadlocks();
+  writer.join();
+  EXPECT_TRUE(is_aborted);
+  EXPECT_EQ(t2.GetState(), TransactionState::ABORTED);
+  // nothing is left to break
+  lock_manager.DetectDeadlocks();
+  EXPECT_EQ(lock_manager.GetDeadlockCount(), 1);
+  reader.join();
+  lock_manager.UnlockAll(&t1);
+  upgrade.join();
+  lock_manager.UnlockAll(&t0);
+}
+
+TEST(LockManagerTest, WaitForWriterTest) {
+  const char *catalog_name = "lock_manager_test_catalog.db";
+  const char *table_name = "lock_manager_test_table";
+  std::vector<Cloum> key_type{Cloum{"id", {CloumType::INT, 4}}};
+  std::remove(catalog_name);
+  std::remove(table_name);
+  std::remove(FreePageMap::FileName(table_name).data());
+  BufferPool pool(64);
+  LockManager lock_manager;
+  {
+    Catalog catalog(catalog_name, &pool);
+    catalog.CreateTable(table_name, key_type, key_type);
+    TransactionManager txn_manager(&catalog, nullptr, &lock_manager);
+    Tuple row(key_type);
+    int key = 1;
+    row.SetValues((char *)&key);
+
+    // the second writer waits for the first, and writes once it aborts
+    auto first = txn_manager.Begin();
+    ASSERT_TRUE(txn_manager.InsertRow(first, table_name, row));
+    std::atomic<bool> is_inserted{false};
+    std::thread second_thread([&] {
+      auto second = txn_manager.Begin();
+      is_inserted = txn_manager.InsertRow(second, table_name, row);
+      txn_manager.Commit(second);
+    });
+    Sleep();
+    EXPECT_FALSE(is_inserted);
+    txn_manager.Abort(first);
+    second_thread.join();
+    EXPECT_TRUE(is_inserted);
+
+    // a third one waits too, but aborts as the row is committed meanwhile
+    auto third = txn_manager.Begin();
+    auto fourth = txn_manager.Begin();
+    key = 2;
+    row.SetValues((char *)&key);
+    ASSERT_TRUE(txn_manager.InsertRow(third, table_name, row));
+    std::thread fourth_thread([&] {
+      txn_manager.Resume(fourth);
+      EXPECT_THROW(txn_manager.InsertRow(fourth, table_name, row),
+                   TransactionAbortException);
+      txn_manager.Abort(fourth);
+    });
+    Sleep();
+    txn_manager.Commit(third);
+    fourth_thread.join();
+  }
+  std::remove(catalog_name);
+  std::remove(table_name);
+  std::remove(FreePageMap::FileName(table_name).data());
+}
+
+/**
+ * Threads lock random rows, mostly shared, in key order so they never
+ * deadlock; the partitions keep them from contending on one latch.
+ */
+TEST(LockManagerTest, ContentionBenchmark) {
+  LockManager lock_manager;
+  const int thread_num = 8;
+  const int txn_num = 5000;
+  const int row_num = 10000;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      std::mt19937 rng(t);
+      for (int i = 0; i < txn_num; ++i) {
+        Transaction txn(t * txn_num + i, 0);
+        std::vector<int> rows;
+        for (int j = 0; j < 4; ++j) {
+          rows.push_back(rng() % row_num);
+        }
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+        for (auto row : rows) {
+          if (rng() % 4 == 0) {
+            lock_manager.LockExclusive(&txn, std::to_string(row));
+          } else {
+            lock_manager.LockShared(&txn, std::to_string(row));
+          }
+        }
+        lock_manager.UnlockAll(&txn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  std::cout << "transactions/s: " << thread_num * txn_num / seconds
+            << std::endl;
+  EXPECT_EQ(lock_manager.GetDeadlockCount(), 0);
+}
+}  // namespace spdb
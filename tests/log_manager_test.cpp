@@ -0,0 +1,287 @@
+#include "recovery/log_manager.h"
+
+#include <sys/resource.h>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "buffer/buffer_pool_manager.h"
+#include "disk/checksum.h"
+#include "gtest/gtest.h"
+#include "table/b_plus_tree.h"
+
+namespace spdb {
+TEST(LogManagerTest, LogRecordTest) {
+  LogRecord update(3, 7, "table", 2, 100, "abc", "xyz");
+  update.lsn_ = 8;
+  LogRecord commit(3, 8, LogRecordType::COMMIT);
+  commit.lsn_ = 9;
+  std::string log;
+  update.SerializeTo(&log);
+  commit.SerializeTo(&log);
+  EXPECT_EQ(log.size(), update.GetSize() + commit.GetSize());
+
+  LogRecord record;
+  ASSERT_TRUE(LogRecord::Deserialize(log.data(), log.size(), &record));
+  EXPECT_EQ(record.type_, LogRecordType::PAGE_UPDATE);
+  EXPECT_EQ(record.lsn_, 8);
+  EXPECT_EQ(record.txn_id_, 3);
+  EXPECT_EQ(record.prev_lsn_, 7);
+  EXPECT_EQ(record.file_name_, "table");
+  EXPECT_EQ(record.page_id_, 2);
+  EXPECT_EQ(record.offset_, 100);
+  EXPECT_EQ(record.before_image_, "abc");
+  EXPECT_EQ(record.after_image_, "xyz");
+
+  size_t offset = update.GetSize();
+  ASSERT_TRUE(LogRecord::Deserialize(log.data() + offset, log.size() - offset,
+                                     &record));
+  EXPECT_EQ(record.type_, LogRecordType::COMMIT);
+  EXPECT_EQ(record.prev_lsn_, 8);
+
+  // the torn tail of the log isn't a record
+  EXPECT_FALSE(LogRecord::Deserialize(log.data(), update.GetSize() - 1,
+                                      &record));
+}
+
+TEST(LogManagerTest, CheckpointRecordTest) {
+  LogRecord checkpoint(INVALID_TXN_ID, INVALID_LSN, LogRecordType::CHECKPOINT);
+  checkpoint.lsn_ = 20;
+  checkpoint.scan_lsn_ = 15;
+  checkpoint.active_txns_ = {{3, 12}, {4, 18}};
+  checkpoint.dirty_pages_ = {DirtyPage{"table", 2, 11},
+                             DirtyPage{"idx", 0, 16}};
+  checkpoint.roots_ = {{"table", 5}, {"idx", INVALID_PAGE_ID}};
+  std::string log;
+  checkpoint.SerializeTo(&log);
+  EXPECT_EQ(log.size(), checkpoint.GetSize());
+
+  LogRecord record;
+  ASSERT_TRUE(LogRecord::Deserialize(log.data(), log.size(), &record));
+  EXPECT_EQ(record.type_, LogRecordType::CHECKPOINT);
+  EXPECT_EQ(record.lsn_, 20);
+  EXPECT_EQ(record.scan_lsn_, 15);
+  EXPECT_EQ(record.active_txns_, checkpoint.active_txns_);
+  ASSERT_EQ(record.dirty_pages_.size(), 2);
+  EXPECT_EQ(record.dirty_pages_[1].file_name_, "idx");
+  EXPECT_EQ(record.dirty_pages_[1].page_id_, 0);
+  EXPECT_EQ(record.dirty_pages_[1].rec_lsn_, 16);
+  EXPECT_EQ(record.roots_, checkpoint.roots_);
+  EXPECT_FALSE(LogRecord::Deserialize(log.data(), log.size() - 1, &record));
+}
+
+TEST(LogManagerTest, RowRecordTest) {
+  // an insert keeps no row
+  LogRecord insert(3, 7, LogRecordType::ROW_UPDATE);
+  insert.file_name_ = "table";
+  insert.key_ = "key";
+  LogRecord update = insert;
+  update.row_ = "row";
+  LogRecord clr(3, 9, LogRecordType::ROW_CLR);
+  clr.undo_next_lsn_ = 7;
+  LogRecord end(3, 10, LogRecordType::STATEMENT_END);
+  std::string log;
+  for (auto *record : {&insert, &update, &clr, &end}) {
+    record->SerializeTo(&log);
+  }
+
+  size_t offset = 0;
+  LogRecord record;
+  for (auto *expected : {&insert, &update, &clr, &end}) {
+    ASSERT_TRUE(LogRecord::Deserialize(log.data() + offset,
+                                       log.size() - offset, &record));
+    EXPECT_EQ(record.type_, expected->type_);
+    EXPECT_EQ(record.prev_lsn_, expected->prev_lsn_);
+    EXPECT_EQ(record.GetSize(), expected->GetSize());
+    EXPECT_FALSE(LogRecord::Deserialize(log.data() + offset,
+                                        expected->GetSize() - 1, &record));
+    offset += expected->GetSize();
+  }
+  EXPECT_EQ(offset, log.size());
+
+  ASSERT_TRUE(LogRecord::Deserialize(log.data() + insert.GetSize(),
+                                     update.GetSize(), &record));
+  EXPECT_EQ(record.file_name_, "table");
+  EXPECT_EQ(record.key_, "key");
+  EXPECT_EQ(record.row_, "row");
+  ASSERT_TRUE(LogRecord::Deserialize(log.data(), insert.GetSize(), &record));
+  EXPECT_TRUE(record.row_.empty());
+  ASSERT_TRUE(LogRecord::Deserialize(
+      log.data() + insert.GetSize() + update.GetSize(), clr.GetSize(),
+      &record));
+  EXPECT_EQ(record.undo_next_lsn_, 7);
+}
+
+TEST(LogManagerTest, GroupCommitTest) {
+  std::remove("log_manager_test.log");
+  const int thread_nums = 8;
+  const int txn_nums = 50;
+  {
+    LogManager log_manager("log_manager_test.log");
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_nums; ++i) {
+      threads.emplace_back([&log_manager, i] {
+        char before[PAGE_SIZE] = {};
+        char after[PAGE_SIZE] = {};
+        for (int j = 0; j < txn_nums; ++j) {
+          auto txn_id = log_manager.Begin();
+          after[sizeof(lsn_t) + j] = static_cast<char>(i + 1);
+          auto lsn = log_manager.AppendPageUpdate("table", i, before, after);
+          log_manager.Commit(txn_id);
+          // the commit record after the update is on disk
+          EXPECT_GT(log_manager.GetPersistentLSN(), lsn);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(log_manager.GetCommitCount(), thread_nums * txn_nums);
+    // concurrent commits share their syncs
+    EXPECT_LT(log_manager.GetSyncCount(), thread_nums * txn_nums);
+  }
+
+  auto records = LogManager::ReadLog("log_manager_test.log");
+  ASSERT_EQ(records.size(), 3 * thread_nums * txn_nums);
+  std::map<txn_id_t, lsn_t> last_lsn;
+  int commits = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    auto &record = records[i];
+    EXPECT_EQ(record.lsn_, static_cast<lsn_t>(i + 1));
+    // every record points to the previous record of its transaction
+    EXPECT_EQ(record.prev_lsn_, last_lsn[record.txn_id_]);
+    last_lsn[record.txn_id_] = record.lsn_;
+    commits += record.type_ == LogRecordType::COMMIT ? 1 : 0;
+  }
+  EXPECT_EQ(commits, thread_nums * txn_nums);
+
+  // a reopened log goes on after its records
+  {
+    LogManager log_manager("log_manager_test.log");
+    EXPECT_EQ(log_manager.GetNextLSN(), records.size() + 1);
+    auto txn_id = log_manager.Begin();
+    EXPECT_EQ(txn_id, thread_nums * txn_nums);
+    log_manager.Commit(txn_id);
+  }
+  EXPECT_EQ(LogManager::ReadLog("log_manager_test.log").size(),
+            records.size() + 2);
+  std::remove("log_manager_test.log");
+}
+
+TEST(LogManagerTest, FlushErrorTest) {
+  std::remove("log_manager_test.log");
+  LogManager log_manager("log_manager_test.log");
+  char before[PAGE_SIZE] = {};
+  char after[PAGE_SIZE];
+  memset(after, 1, PAGE_SIZE);
+  auto txn_id = log_manager.Begin();
+  log_manager.AppendPageUpdate("table", 0, before, after);
+  log_manager.Commit(txn_id);
+
+  // a log file which can't grow fails the write of the flusher, every
+  // commit waiting for it and coming after it throws
+  rlimit old_limit{};
+  getrlimit(RLIMIT_FSIZE, &old_limit);
+  auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+  rlimit limit = old_limit;
+  limit.rlim_cur = log_manager.GetLogSize() + PAGE_SIZE;
+  setrlimit(RLIMIT_FSIZE, &limit);
+  std::vector<std::thread> threads;
+  std::atomic<int> failed{0};
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      auto txn_id = log_manager.Begin();
+      for (int j = 0; j < 4; ++j) {
+        log_manager.AppendPageUpdate("table", j, before, after);
+      }
+      try {
+        log_manager.Commit(txn_id);
+      } catch (std::runtime_error &e) {
+        ++failed;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failed, 4);
+  EXPECT_THROW(log_manager.FlushAll(), std::runtime_error);
+  txn_id = log_manager.Begin();
+  EXPECT_THROW(log_manager.Commit(txn_id), std::runtime_error);
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  std::signal(SIGXFSZ, old_handler);
+
+  // the records flushed before are kept
+  EXPECT_GE(LogManager::ReadLog("log_manager_test.log").size(), 3);
+  std::remove("log_manager_test.log");
+}
+
+TEST(LogManagerTest, WriteAheadTest) {
+  std::remove("log_manager_test.log");
+  std::remove("log_manager_test.db");
+  LogManager log_manager("log_manager_test.log");
+  BufferPool pool(200);
+  pool.SetLogManager(&log_manager);
+  auto disk = DiskManager("log_manager_test.db");
+  auto bpm = std::make_unique<BufferPoolManager>(&pool, &disk, true);
+
+  Cloum c{"value", {CloumType::INT, 4}};
+  std::vector<Cloum> type{c};
+  BPlusTree tree(bpm.get(), type, type, 8, 8);
+  auto txn_id = log_manager.Begin();
+  Tuple key(type);
+  for (int i = 0; i < 200; ++i) {
+    key.SetValues((char *)&i);
+    tree.Insert(key, key);
+  }
+  log_manager.Commit(txn_id);
+
+  // the modified pages are only in the pool and the log
+  auto page_nums = disk.GetFileSize() / PAGE_SIZE;
+  ASSERT_GT(page_nums, 1);
+  char data[PAGE_SIZE];
+  for (page_id_t pid = 0; pid < static_cast<page_id_t>(page_nums); ++pid) {
+    disk.ReadPage(pid, data);
+    lsn_t lsn = INVALID_LSN;
+    memcpy(&lsn, data, sizeof(lsn_t));
+    EXPECT_EQ(lsn, INVALID_LSN);
+  }
+
+  // replaying the log over empty pages gives the pages written back
+  bpm->FlushAllPages();
+  std::map<page_id_t, std::string> pages;
+  for (auto &record : LogManager::ReadLog("log_manager_test.log")) {
+    if (record.type_ != LogRecordType::PAGE_UPDATE) {
+      continue;
+    }
+    EXPECT_EQ(record.file_name_, "log_manager_test.db");
+    auto &page = pages[record.page_id_];
+    page.resize(PAGE_SIZE, '\0');
+    page.replace(record.offset_, record.after_image_.size(),
+                 record.after_image_);
+    page.replace(0, sizeof(lsn_t), (char *)&record.lsn_, sizeof(lsn_t));
+  }
+  ASSERT_EQ(pages.size(), page_nums);
+  for (auto &[pid, page] : pages) {
+    // the pages are written back with their checksum
+    SetPageChecksum(page.data());
+    disk.ReadPage(pid, data);
+    lsn_t lsn = INVALID_LSN;
+    memcpy(&lsn, data, sizeof(lsn_t));
+    EXPECT_LE(lsn, log_manager.GetPersistentLSN());
+    EXPECT_EQ(memcmp(data, page.data(), PAGE_SIZE), 0);
+  }
+
+  bpm.reset();
+  disk.ShutDown();
+  std::remove("log_manager_test.log");
+  std::remove("log_manager_test.db");
+}
+}  // namespace spdb
@@ -0,0 +1,201 @@
+#include "shell/plan_cache.h"
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "gtest/gtest.h"
+
+namespace spdb {
+// true if two expressions read the same, as the executors see them
+static auto IsSameExpr(const hsql::Expr *a, const hsql::Expr *b) -> bool {
+  if (a == nullptr || b == nullptr) {
+    return a == b;
+  }
+  if (a->type != b->type || a->opType != b->opType || a->ival != b->ival ||
+      (a->name == nullptr) != (b->name == nullptr) ||
+      (a->name != nullptr && strcmp(a->name, b->name) != 0) ||
+      !IsSameExpr(a->expr, b->expr) || !IsSameExpr(a->expr2, b->expr2) ||
+      (a->exprList == nullptr) != (b->exprList == nullptr)) {
+    return false;
+  }
+  if (a->exprList != nullptr) {
+    if (a->exprList->size() != b->exprList->size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a->exprList->size(); ++i) {
+      if (!IsSameExpr(a->exprList->at(i), b->exprList->at(i))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The where clause of a select, or the first value of an insert.
+static auto GetExpr(const hsql::SQLStatement *statement)
+    -> const hsql::Expr * {
+  if (statement->isType(hsql::kStmtSelect)) {
+    return static_cast<const hsql::SelectStatement *>(statement)->whereClause;
+  }
+  return static_cast<const hsql::InsertStatement *>(statement)
+      ->values->front();
+}
+
+// NOLINTNEXTLINE
+TEST(PlanCacheTest, ParameterizeTest) {
+  std::vector<Literal> literals;
+
+  // Scenario: int, string and quoted quote literals leave the same text.
+  const std::string text = "select * from t where a = ?;";
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 5;", &literals),
+            text);
+  ASSERT_EQ(literals.size(), 1);
+  EXPECT_FALSE(literals[0].is_string_);
+  EXPECT_EQ(literals[0].int_, 5);
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 'x';", &literals),
+            text);
+  ASSERT_EQ(literals.size(), 1);
+  EXPECT_TRUE(literals[0].is_string_);
+  EXPECT_EQ(literals[0].string_, "x");
+  EXPECT_EQ(
+      ParameterizeStatement("select * from t where a = 'it''s';", &literals),
+      text);
+  ASSERT_EQ(literals.size(), 1);
+  EXPECT_EQ(literals[0].string_, "it's");
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = '''';", &literals),
+            text);
+  EXPECT_EQ(literals[0].string_, "'");
+  EXPECT_EQ(
+      ParameterizeStatement("SELECT *\n  FROM t   WHERE a = 7;", &literals),
+      "SELECT * FROM t WHERE a = ?;");
+
+  // Scenario: the digits of identifiers are left alone.
+  EXPECT_EQ(ParameterizeStatement(
+                "select c1, t2.c3 from t2 where c1 = 10 and c_2 = 'a1';",
+                &literals),
+            "select c1,t2.c3 from t2 where c1 = ? and c_2 = ?;");
+  ASSERT_EQ(literals.size(), 2);
+  EXPECT_EQ(literals[0].int_, 10);
+  EXPECT_EQ(literals[1].string_, "a1");
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 1b;", &literals),
+            "");
+
+  // Scenario: the minus sign of a negative literal stays in the text.
+  EXPECT_EQ(ParameterizeStatement("insert into t values (-5, 'a');",
+                                  &literals),
+            "insert into t values (-?,?);");
+  ASSERT_EQ(literals.size(), 2);
+  EXPECT_EQ(literals[0].int_, 5);
+
+  // Scenario: the statements which can't be cached.
+  EXPECT_EQ(ParameterizeStatement("delete from t where a = 1;", &literals),
+            "");
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 1.5;", &literals),
+            "");
+  EXPECT_EQ(ParameterizeStatement("select * from t -- all\n;", &literals), "");
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 'x\ny';",
+                                  &literals),
+            "");
+  EXPECT_EQ(ParameterizeStatement("select * from t where a = 'x;", &literals),
+            "");
+}
+
+// NOLINTNEXTLINE
+TEST(PlanCacheTest, BindTest) {
+  PreparedStatement prepared("select * from t where a = ?;");
+  ASSERT_EQ(prepared.GetParameterCount(), 1);
+  auto where = GetExpr(prepared.GetStatement());
+
+  // Scenario: a statement is bound to literals of another type in turn.
+  Literal int_literal;
+  int_literal.int_ = 5;
+  Literal string_literal;
+  string_literal.is_string_ = true;
+  string_literal.string_ = "it's";
+  prepared.Bind({int_literal});
+  EXPECT_EQ(where->expr2->type, hsql::ExprType::kExprLiteralInt);
+  EXPECT_EQ(where->expr2->ival, 5);
+  EXPECT_EQ(where->expr2->name, nullptr);
+  prepared.Bind({string_literal});
+  EXPECT_EQ(where->expr2->type, hsql::ExprType::kExprLiteralString);
+  EXPECT_STREQ(where->expr2->name, "it's");
+  int_literal.int_ = 7;
+  prepared.Bind({int_literal});
+  EXPECT_EQ(where->expr2->type, hsql::ExprType::kExprLiteralInt);
+  EXPECT_EQ(where->expr2->ival, 7);
+  EXPECT_EQ(where->expr2->name, nullptr);
+
+  // Scenario: the number of values should match.
+  EXPECT_THROW(prepared.Bind({}), std::runtime_error);
+  EXPECT_THROW(prepared.Bind({int_literal, int_literal}), std::runtime_error);
+  EXPECT_THROW(PreparedStatement("select from;"), std::runtime_error);
+
+  // Scenario: a statement taken from the cache reads as parsed directly. One
+  // the grammar takes no parameter for is parsed directly by the session.
+  for (const char *query :
+       {"select * from t where a = -5;", "select * from t where a = 3 - 5;",
+        "select * from t where a = 'it''s';", "insert into t values (-5);",
+        "insert into t values ('a''b');"}) {
+    std::vector<Literal> literals;
+    auto text = ParameterizeStatement(query, &literals);
+    ASSERT_NE(text, "") << query;
+    std::unique_ptr<PreparedStatement> cached;
+    try {
+      cached = std::make_unique<PreparedStatement>(text);
+    } catch (std::runtime_error &e) {
+      continue;
+    }
+    cached->Bind(literals);
+    hsql::SQLParserResult result;
+    hsql::SQLParser::parse(query, &result);
+    ASSERT_TRUE(result.isValid()) << query;
+    EXPECT_TRUE(IsSameExpr(GetExpr(result.getStatement(0)),
+                           GetExpr(cached->GetStatement())))
+        << query;
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PlanCacheTest, EvictionTest) {
+  PlanCache cache(PLAN_CACHE_SIZE);
+  auto text = [](size_t i) {
+    return "select * from t" + std::to_string(i) + ";";
+  };
+  for (size_t i = 0; i < PLAN_CACHE_SIZE; ++i) {
+    EXPECT_EQ(cache.Get(text(i)), nullptr);
+    cache.Put(text(i), std::make_shared<PreparedStatement>(text(i)));
+  }
+  EXPECT_EQ(cache.GetSize(), PLAN_CACHE_SIZE);
+  EXPECT_EQ(cache.GetMissCount(), PLAN_CACHE_SIZE);
+
+  // Scenario: the least recently used statement is evicted, a statement
+  // used lately stays.
+  auto first = cache.Get(text(0));
+  ASSERT_NE(first, nullptr);
+  cache.Put(text(PLAN_CACHE_SIZE),
+            std::make_shared<PreparedStatement>(text(PLAN_CACHE_SIZE)));
+  EXPECT_EQ(cache.GetSize(), PLAN_CACHE_SIZE);
+  EXPECT_EQ(cache.Get(text(0)), first);
+  EXPECT_EQ(cache.Get(text(1)), nullptr);
+  EXPECT_NE(cache.Get(text(2)), nullptr);
+  EXPECT_NE(cache.Get(text(PLAN_CACHE_SIZE)), nullptr);
+  EXPECT_EQ(cache.GetHitCount(), 4);
+  EXPECT_EQ(cache.GetMissCount(), PLAN_CACHE_SIZE + 1);
+
+  // Scenario: a statement put again replaces the one cached.
+  auto again = std::make_shared<PreparedStatement>(text(2));
+  cache.Put(text(2), again);
+  EXPECT_EQ(cache.GetSize(), PLAN_CACHE_SIZE);
+  EXPECT_EQ(cache.Get(text(2)), again);
+
+  // Scenario: a cache of no capacity keeps nothing.
+  PlanCache empty(0);
+  empty.Put(text(0), first);
+  EXPECT_EQ(empty.GetSize(), 0);
+  EXPECT_EQ(empty.Get(text(0)), nullptr);
+}
+}  // namespace spdb
@@ -0,0 +1,413 @@
+#include "recovery/recovery_manager.h"
+
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "concurrency/transaction_manager.h"
+#include "config/catalog.h"
+#include "gtest/gtest.h"
+#include "recovery/checkpoint_manager.h"
+#include "recovery/log_manager.h"
+#include "table/b_plus_tree.h"
+
+namespace spdb {
+static const char *log_name = "recovery_test.log";
+static const char *catalog_name = "recovery_test_catalog.db";
+static const char *table_name = "recovery_test_table";
+// every transaction inserts this many keys
+static const int batch_size = 5;
+
+static void RemoveFiles() {
+  std::remove(log_name);
+  std::remove(catalog_name);
+  std::remove(table_name);
+  std::remove(FreePageMap::FileName(table_name).data());
+  std::remove(DiskManager::MapFileName(table_name).data());
+}
+
+static auto TableType() -> std::vector<Cloum> {
+  return {Cloum{"id", {CloumType::INT, 4}}, Cloum{"val", {CloumType::INT, 4}}};
+}
+
+/**
+ * A database of one table, which is recovered when opened. Destroying it
+ * shuts it down cleanly, a crash is simulated by exiting the process
+ * without destroying it.
+ */
+struct Database {
+  explicit Database(size_t pool_size = 64)
+      : log_manager_(log_name),
+        pool_(pool_size),
+        checkpoint_manager_(&log_manager_, &pool_) {
+    pool_.SetLogManager(&log_manager_);
+    catalog_ = std::make_unique<Catalog>(catalog_name, &pool_);
+    if (!catalog_->IsExisted(table_name)) {
+      catalog_->CreateTable(table_name, TableType(), TableType());
+    }
+    RecoveryManager recovery(&log_manager_, catalog_.get());
+    recovery.Recover();
+    redo_count_ = recovery.GetRedoCount();
+    undo_count_ = recovery.GetUndoCount();
+  }
+
+  auto Tree() -> BPlusTree {
+    auto table = catalog_->GetTable(table_name);
+    return BPlusTree(catalog_->GetBufferPoolManager(table_name),
+                     table.key_type_, table.value_type_, table.leaf_max_size_,
+                     table.internal_max_size_, table.root_id_);
+  }
+
+  // Insert keys [begin, end) in one transaction.
+  void Commit(BPlusTree *tree, int begin, int end) {
+    auto txn_id = log_manager_.Begin();
+    for (int key = begin; key < end; ++key) {
+      Insert(tree, key);
+    }
+    log_manager_.Commit(txn_id);
+  }
+
+  void Insert(BPlusTree *tree, int key) {
+    auto type = TableType();
+    Tuple row(type);
+    int values[2] = {key, key * 2};
+    row.SetValues((char *)values);
+    tree->Insert(row, row);
+    catalog_->ModifyTableRoot(table_name, tree->GetRootPageId());
+  }
+
+  auto Keys() -> std::vector<int> {
+    std::vector<int> keys;
+    auto tree = Tree();
+    for (auto it = tree.Begin(); it != tree.End(); ++it) {
+      auto &[key, value] = *it;
+      keys.push_back(*value.GetValueAtAs<int>(0));
+      EXPECT_EQ(*value.GetValueAtAs<int>(1), keys.back() * 2);
+    }
+    return keys;
+  }
+
+  LogManager log_manager_;
+  BufferPool pool_;
+  std::unique_ptr<Catalog> catalog_;
+  // stopped before the pool and the log go away
+  CheckpointManager checkpoint_manager_;
+  size_t redo_count_{0};
+  size_t undo_count_{0};
+};
+
+TEST(RecoveryTest, RedoUndoTest) {
+  RemoveFiles();
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    auto db = new Database();
+    auto tree = db->Tree();
+    // committed and written back
+    auto txn_id = db->log_manager_.Begin();
+    for (int key = 0; key < 100; ++key) {
+      db->Insert(&tree, key);
+    }
+    db->log_manager_.Commit(txn_id);
+    db->catalog_->GetBufferPoolManager(table_name)->FlushAllPages();
+    // committed, but only in the log
+    txn_id = db->log_manager_.Begin();
+    for (int key = 100; key < 200; ++key) {
+      db->Insert(&tree, key);
+    }
+    db->log_manager_.Commit(txn_id);
+    // not committed
+    db->log_manager_.Begin();
+    for (int key = 200; key < 300; ++key) {
+      db->Insert(&tree, key);
+    }
+    db->log_manager_.FlushAll();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+
+  {
+    Database db;
+    EXPECT_GT(db.redo_count_, 0);
+    EXPECT_GT(db.undo_count_, 0);
+    auto keys = db.Keys();
+    ASSERT_EQ(keys.size(), 200);
+    for (int key = 0; key < 200; ++key) {
+      EXPECT_EQ(keys[key], key);
+    }
+  }
+  // the rolled back transaction isn't undone again
+  {
+    Database db;
+    EXPECT_EQ(db.undo_count_, 0);
+    EXPECT_EQ(db.Keys().size(), 200);
+  }
+  RemoveFiles();
+}
+
+TEST(RecoveryTest, InterleavedUndoTest) {
+  RemoveFiles();
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    auto db = new Database();
+    auto txn_manager =
+        new TransactionManager(db->catalog_.get(), &db->log_manager_);
+    auto rows = [](int begin, int end) {
+      auto type = TableType();
+      std::vector<Tuple> ret;
+      for (int key = begin; key < end; ++key) {
+        int values[2] = {key, key * 2};
+        ret.emplace_back(type);
+        ret.back().SetValues((char *)values);
+      }
+      return ret;
+    };
+    auto txn = txn_manager->Begin();
+    txn_manager->InsertRows(txn, table_name, rows(0, 10));
+    txn_manager->Commit(txn);
+
+    // both write the same leaf, one statement after the other
+    auto loser = txn_manager->Begin();
+    txn_manager->InsertRows(loser, table_name, rows(10, 15));
+    txn_manager->DeleteRows(loser, table_name, rows(3, 4));
+    auto winner = txn_manager->Begin();
+    txn_manager->InsertRows(winner, table_name, rows(15, 20));
+    txn_manager->DeleteRows(winner, table_name, rows(5, 6));
+    txn_manager->Commit(winner);
+    txn_manager->InsertRows(loser, table_name, rows(20, 21));
+    // rolled back before the crash
+    auto aborted = txn_manager->Begin();
+    txn_manager->InsertRows(aborted, table_name, rows(21, 25));
+    txn_manager->Abort(aborted);
+    db->log_manager_.FlushAll();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+
+  std::vector<int> expected;
+  for (int key = 0; key < 20; ++key) {
+    if (key != 5 && (key < 10 || key >= 15)) {
+      expected.push_back(key);
+    }
+  }
+  {
+    Database db;
+    EXPECT_GT(db.undo_count_, 0);
+    EXPECT_EQ(db.Keys(), expected);
+  }
+  // the rows put back aren't undone again
+  {
+    Database db;
+    EXPECT_EQ(db.undo_count_, 0);
+    EXPECT_EQ(db.Keys(), expected);
+  }
+  RemoveFiles();
+}
+
+TEST(RecoveryTest, FaultInjectionTest) {
+  RemoveFiles();
+  std::mt19937 rng(2024);
+  std::set<int> committed;
+  for (int round = 0; round < 8; ++round) {
+    int pipe_fd[2];
+    ASSERT_EQ(pipe(pipe_fd), 0);
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      // insert batches of keys after the recovered ones until killed, and
+      // report every committed batch
+      close(pipe_fd[0]);
+      auto db = new Database(16);
+      // and truncate the log meanwhile
+      auto checkpoint_manager =
+          new CheckpointManager(&db->log_manager_, &db->pool_, 20);
+      checkpoint_manager->Start();
+      auto tree = db->Tree();
+      int key = db->Keys().size();
+      while (true) {
+        auto txn_id = db->log_manager_.Begin();
+        for (int i = 0; i < batch_size; ++i, ++key) {
+          db->Insert(&tree, key);
+        }
+        db->log_manager_.Commit(txn_id);
+        if (write(pipe_fd[1], &key, sizeof(int)) != sizeof(int)) {
+          _exit(1);
+        }
+      }
+    }
+    close(pipe_fd[1]);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50 + rng() % 150));
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    int end = 0;
+    while (read(pipe_fd[0], &end, sizeof(int)) == sizeof(int)) {
+      for (int key = end - batch_size; key < end; ++key) {
+        committed.insert(key);
+      }
+    }
+    close(pipe_fd[0]);
+
+    // the committed batches survive, the one in flight is all or nothing
+    Database db;
+    auto keys = db.Keys();
+    ASSERT_EQ(keys.size() % batch_size, 0);
+    ASSERT_GE(keys.size(), committed.size());
+    ASSERT_LE(keys.size(), committed.size() + batch_size);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_EQ(keys[i], i);
+    }
+    for (size_t key = committed.size(); key < keys.size(); ++key) {
+      committed.insert(key);
+    }
+  }
+  EXPECT_GT(committed.size(), 0);
+  RemoveFiles();
+}
+TEST(RecoveryTest, LogTruncationTest) {
+  RemoveFiles();
+  {
+    Database db;
+    auto tree = db.Tree();
+    for (int key = 0; key < 500; key += 50) {
+      db.Commit(&tree, key, key + 50);
+    }
+    db.log_manager_.FlushAll();
+    lsn_t first_lsn = db.log_manager_.GetFirstLSN();
+    size_t log_size = db.log_manager_.GetLogSize();
+
+    // the second checkpoint writes back the pages dirty since before the
+    // first one, then the head of the log is useless
+    db.checkpoint_manager_.Checkpoint();
+    db.checkpoint_manager_.Checkpoint();
+    for (int i = 0; i < 50 && db.log_manager_.GetFirstLSN() == first_lsn;
+         ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(LOG_TIMEOUT_MS));
+    }
+    EXPECT_GT(db.log_manager_.GetFirstLSN(), first_lsn);
+    EXPECT_LT(db.log_manager_.GetLogSize(), log_size);
+    EXPECT_EQ(db.Keys().size(), 500);
+  }
+  {
+    Database db;
+    EXPECT_EQ(db.Keys().size(), 500);
+  }
+
+  // the background checkpoints are taken every interval
+  {
+    Database db;
+    CheckpointManager checkpoint_manager(&db.log_manager_, &db.pool_, 10);
+    checkpoint_manager.Start();
+    auto tree = db.Tree();
+    db.Commit(&tree, 500, 600);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3 * LOG_TIMEOUT_MS));
+    checkpoint_manager.Stop();
+    EXPECT_GT(checkpoint_manager.GetCheckpointCount(), 0);
+  }
+  RemoveFiles();
+}
+
+TEST(RecoveryTest, CheckpointRecoveryTest) {
+  RemoveFiles();
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    auto db = new Database();
+    auto tree = db->Tree();
+    // truncated away, the roots come from the checkpoint
+    db->Commit(&tree, 0, 100);
+    db->checkpoint_manager_.Checkpoint();
+    db->checkpoint_manager_.Checkpoint();
+    // committed across a checkpoint
+    auto txn_id = db->log_manager_.Begin();
+    for (int key = 100; key < 200; ++key) {
+      db->Insert(&tree, key);
+      if (key == 150) {
+        db->checkpoint_manager_.Checkpoint();
+      }
+    }
+    db->log_manager_.Commit(txn_id);
+    // running across a checkpoint
+    db->log_manager_.Begin();
+    for (int key = 200; key < 300; ++key) {
+      db->Insert(&tree, key);
+      if (key == 250) {
+        db->checkpoint_manager_.Checkpoint();
+      }
+    }
+    db->log_manager_.FlushAll();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+
+  Database db;
+  EXPECT_GT(db.undo_count_, 0);
+  auto keys = db.Keys();
+  ASSERT_EQ(keys.size(), 200);
+  for (int key = 0; key < 200; ++key) {
+    EXPECT_EQ(keys[key], key);
+  }
+  RemoveFiles();
+}
+TEST(RecoveryTest, CompressedRecoveryTest) {
+  RemoveFiles();
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    auto db = new Database();
+    {
+      auto tree = db->Tree();
+      db->Commit(&tree, 0, 100);
+    }
+    db->catalog_->SetCompressed(table_name, true);
+    // the pages moved since the last checkpoint are lost with the map, and
+    // redone from the log
+    auto tree = db->Tree();
+    db->Commit(&tree, 100, 200);
+    db->checkpoint_manager_.Checkpoint();
+    for (int key = 200; key < 400; key += 50) {
+      db->Commit(&tree, key, key + 50);
+      db->pool_.FlushOldPages(db->log_manager_.GetNextLSN());
+    }
+    db->log_manager_.Begin();
+    for (int key = 400; key < 450; ++key) {
+      db->Insert(&tree, key);
+    }
+    db->log_manager_.FlushAll();
+    _exit(0);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status));
+
+  {
+    Database db;
+    EXPECT_TRUE(DiskManager::IsCompressedFile(table_name));
+    EXPECT_GT(db.redo_count_, 0);
+    auto keys = db.Keys();
+    ASSERT_EQ(keys.size(), 400);
+    for (int key = 0; key < 400; ++key) {
+      EXPECT_EQ(keys[key], key);
+    }
+    // and back in a plain file
+    db.catalog_->SetCompressed(table_name, false);
+    EXPECT_EQ(db.Keys().size(), 400);
+  }
+  EXPECT_FALSE(DiskManager::IsCompressedFile(table_name));
+  RemoveFiles();
+}
+}  // namespace spdb
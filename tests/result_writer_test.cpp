@@ -0,0 +1,117 @@
+#include "shell/result_writer.h"
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/tuple.h"
+#include "gtest/gtest.h"
+
+namespace spdb {
+static auto ResultType() -> std::vector<Cloum> {
+  return {Cloum("id", {CloumType::INT, 4}), Cloum("ok", {CloumType::BOOL, 1}),
+          Cloum("name", {CloumType::CHAR, 12})};
+}
+
+static auto Row(int id, bool ok, const std::string &name) -> Tuple {
+  auto type = ResultType();
+  Tuple row(type);
+  char data[17] = {0};
+  memcpy(data, &id, sizeof(int));
+  data[4] = ok ? 1 : 0;
+  memcpy(data + 5, name.data(), name.size());
+  row.SetValues(data);
+  return row;
+}
+
+// The text of a result of the rows, written in mode.
+static auto Write(OutputMode mode, const std::vector<Tuple> &rows)
+    -> std::string {
+  std::ostringstream out;
+  auto writer = ResultWriter::Create(mode, ResultType(), &out);
+  writer->WriteHeader();
+  for (auto &row : rows) {
+    writer->WriteRow(row);
+  }
+  writer->Finish();
+  return out.str();
+}
+
+// NOLINTNEXTLINE
+TEST(ResultWriterTest, FormatTest) {
+  // a CHAR as long as its cloum has no '\0'
+  std::vector<Tuple> rows{
+      Row(1, true, "plain"),
+      Row(std::numeric_limits<int>::min(), false, "a,\"b\"\n"),
+      Row(42, true, "tab\tback\\"), Row(0, false, "123456789012")};
+
+  // Scenario: csv quotes the values with commas, quotes or newlines.
+  EXPECT_EQ(Write(OutputMode::CSV, rows),
+            "id,ok,name\n"
+            "1,true,plain\n"
+            "-2147483648,false,\"a,\"\"b\"\"\n\"\n"
+            "42,true,tab\tback\\\n"
+            "0,false,123456789012\n");
+
+  // Scenario: tsv escapes tabs, newlines and backslashes.
+  EXPECT_EQ(Write(OutputMode::TSV, rows),
+            "id\tok\tname\n"
+            "1\ttrue\tplain\n"
+            "-2147483648\tfalse\ta,\"b\"\\n\n"
+            "42\ttrue\ttab\\tback\\\\\n"
+            "0\tfalse\t123456789012\n");
+
+  // Scenario: json writes an object a line, with the strings escaped.
+  EXPECT_EQ(Write(OutputMode::JSON, rows),
+            "{\"id\":1,\"ok\":true,\"name\":\"plain\"}\n"
+            "{\"id\":-2147483648,\"ok\":false,"
+            "\"name\":\"a,\\\"b\\\"\\u000a\"}\n"
+            "{\"id\":42,\"ok\":true,\"name\":\"tab\\u0009back\\\\\"}\n"
+            "{\"id\":0,\"ok\":false,\"name\":\"123456789012\"}\n");
+
+  // Scenario: a table is as wide as the types, with or without rows.
+  EXPECT_EQ(Write(OutputMode::TABLE, {rows[0], rows[3]}),
+            "+-------------+-------+--------------+\n"
+            "| id          | ok    | name         |\n"
+            "+-------------+-------+--------------+\n"
+            "| 1           | true  | plain        |\n"
+            "| 0           | false | 123456789012 |\n"
+            "+-------------+-------+--------------+\n");
+  EXPECT_EQ(Write(OutputMode::TABLE, {}),
+            "+-------------+-------+--------------+\n"
+            "| id          | ok    | name         |\n"
+            "+-------------+-------+--------------+\n");
+}
+
+// NOLINTNEXTLINE
+TEST(ResultWriterTest, FlushTest) {
+  std::ostringstream out;
+  auto writer = ResultWriter::Create(OutputMode::CSV, ResultType(), &out);
+  writer->WriteHeader();
+  std::string expected = "id,ok,name\n";
+
+  // Scenario: nothing reaches the stream until the buffer is full, then the
+  // buffer is written at once, even in the middle of a row.
+  int id = 0;
+  while (expected.size() < RESULT_BUFFER_SIZE - 64) {
+    writer->WriteRow(Row(id, true, "abcdefghijkl"));
+    expected += std::to_string(id++) + ",true,abcdefghijkl\n";
+  }
+  EXPECT_EQ(out.str(), "");
+  while (expected.size() < RESULT_BUFFER_SIZE + 64) {
+    writer->WriteRow(Row(id, true, "abcdefghijkl"));
+    expected += std::to_string(id++) + ",true,abcdefghijkl\n";
+  }
+  auto flushed = out.str();
+  EXPECT_GE(flushed.size(), RESULT_BUFFER_SIZE);
+  EXPECT_LT(flushed.size(), RESULT_BUFFER_SIZE + 16);
+  EXPECT_EQ(flushed, expected.substr(0, flushed.size()));
+
+  // Scenario: the rest is written as the result is done.
+  writer->Finish();
+  EXPECT_EQ(out.str(), expected);
+}
+}  // namespace spdb
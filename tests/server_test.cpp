@@ -0,0 +1,272 @@
+#include "server/server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace spdb {
+// Replies with the statement, numbered by its connection. block; waits until
+// the test releases it, dots; prints lines starting with dots, exit; closes
+// the connection.
+class EchoHandler : public Server::Handler {
+ public:
+  EchoHandler(std::atomic<int> *handler_count, std::mutex *latch,
+              std::condition_variable *cv, bool *is_released)
+      : handler_count_(handler_count),
+        latch_(latch),
+        cv_(cv),
+        is_released_(is_released) {
+    ++*handler_count_;
+  }
+
+  ~EchoHandler() override { --*handler_count_; }
+
+  auto Execute(const std::string &statement, std::string *output)
+      -> bool override {
+    if (statement == "exit;") {
+      *output = "bye";
+      return false;
+    }
+    if (statement == "dots;") {
+      *output = ".\n..a\n";
+      return true;
+    }
+    if (statement == "block;") {
+      std::unique_lock<std::mutex> lock(*latch_);
+      cv_->wait(lock, [&] { return *is_released_; });
+    }
+    *output = std::to_string(count_++) + " " + statement + "\n";
+    return true;
+  }
+
+ private:
+  std::atomic<int> *handler_count_;
+  std::mutex *latch_;
+  std::condition_variable *cv_;
+  bool *is_released_;
+  int count_{0};
+};
+
+class ServerTest : public ::testing::Test {
+ protected:
+  void StartServer(size_t worker_nums) {
+    server_ = std::make_unique<Server>("127.0.0.1", 0, worker_nums, [this] {
+      return std::make_unique<EchoHandler>(&handler_count_, &latch_, &cv_,
+                                           &is_released_);
+    });
+    server_->Start();
+  }
+
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      is_released_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  auto Connect() -> int {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(server_->GetPort());
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT_EQ(
+        connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    return fd;
+  }
+
+  static void Send(int fd, const std::string &data) {
+    ASSERT_EQ(send(fd, data.data(), data.size(), MSG_NOSIGNAL),
+              static_cast<ssize_t>(data.size()));
+  }
+
+  // Read a reply, with the line ending it.
+  static auto Receive(int fd) -> std::string {
+    std::string reply;
+    char c;
+    while (read(fd, &c, 1) == 1) {
+      reply.push_back(c);
+      if (reply == ".\n" || (reply.size() >= 3 &&
+                             reply.compare(reply.size() - 3, 3, "\n.\n") ==
+                                 0)) {
+        break;
+      }
+    }
+    return reply;
+  }
+
+  std::atomic<int> handler_count_{0};
+  std::mutex latch_;
+  std::condition_variable cv_;
+  bool is_released_{false};
+  std::unique_ptr<Server> server_;
+};
+
+TEST_F(ServerTest, ProtocolTest) {
+  StartServer(2);
+  int fd = Connect();
+  Send(fd, "select *\n  from t;\n");
+  EXPECT_EQ(Receive(fd), "0 select *   from t;\n.\n");
+
+  // the statements sent at once are replied in order
+  Send(fd, "a;\nb;\r\n\nc");
+  EXPECT_EQ(Receive(fd), "1 a;\n.\n");
+  EXPECT_EQ(Receive(fd), "2 b;\n.\n");
+  Send(fd, ";\n");
+  EXPECT_EQ(Receive(fd), "3 c;\n.\n");
+
+  // a line starting with a dot is escaped
+  Send(fd, "dots;\n");
+  EXPECT_EQ(Receive(fd), "..\n...a\n.\n");
+
+  // the connection is closed after the reply to exit;
+  Send(fd, "exit;\nd;\n");
+  EXPECT_EQ(Receive(fd), "bye\n.\n");
+  char c;
+  EXPECT_EQ(read(fd, &c, 1), 0);
+  close(fd);
+  while (handler_count_ > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(server_->GetConnectionCount(), 0);
+}
+
+TEST_F(ServerTest, HalfCloseTest) {
+  StartServer(1);
+  int fd = Connect();
+  // the statements sent before the client stops sending are still replied
+  Send(fd, "a;\nb;\n");
+  shutdown(fd, SHUT_WR);
+  EXPECT_EQ(Receive(fd), "0 a;\n.\n");
+  EXPECT_EQ(Receive(fd), "1 b;\n.\n");
+  char c;
+  EXPECT_EQ(read(fd, &c, 1), 0);
+  close(fd);
+}
+
+TEST_F(ServerTest, HalfCloseWhileRunningTest) {
+  StartServer(1);
+  int fd = Connect();
+  // the client stops sending while its statement runs, the server waits for
+  // the statement without spinning on the socket
+  Send(fd, "block;\n");
+  shutdown(fd, SHUT_WR);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  std::clock_t begin = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_LT(std::clock() - begin, CLOCKS_PER_SEC / 20);
+  Release();
+  EXPECT_EQ(Receive(fd), "0 block;\n.\n");
+  char c;
+  EXPECT_EQ(read(fd, &c, 1), 0);
+  close(fd);
+  while (handler_count_ > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(server_->GetConnectionCount(), 0);
+
+  // a client resetting the connection while its statement runs is closed
+  // once the statement is done
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    is_released_ = false;
+  }
+  fd = Connect();
+  Send(fd, "block;\n");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  linger reset{1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+  close(fd);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  begin = std::clock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_LT(std::clock() - begin, CLOCKS_PER_SEC / 20);
+  Release();
+  while (handler_count_ > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(server_->GetConnectionCount(), 0);
+}
+
+TEST_F(ServerTest, ConcurrentClientsTest) {
+  const int client_nums = 200;
+  const int statement_nums = 50;
+  StartServer(4);
+  std::vector<int> fds;
+  for (int i = 0; i < client_nums; ++i) {
+    fds.push_back(Connect());
+  }
+  while (server_->GetConnectionCount() < client_nums) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(handler_count_, client_nums);
+
+  // every client pipelines its statements, the replies of each come in the
+  // order it sent them
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int i = 0; i < client_nums; ++i) {
+    threads.emplace_back([&, i] {
+      std::string batch;
+      for (int j = 0; j < statement_nums; ++j) {
+        batch += "c" + std::to_string(i) + "s" + std::to_string(j) + ";\n";
+      }
+      Send(fds[i], batch);
+      for (int j = 0; j < statement_nums; ++j) {
+        auto expected = std::to_string(j) + " c" + std::to_string(i) + "s" +
+                        std::to_string(j) + ";\n.\n";
+        if (Receive(fds[i]) != expected) {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches, 0);
+  EXPECT_EQ(server_->GetStatementCount(), client_nums * statement_nums);
+  for (int fd : fds) {
+    close(fd);
+  }
+}
+
+TEST_F(ServerTest, BlockedStatementTest) {
+  StartServer(2);
+  int blocked = Connect();
+  int other = Connect();
+  Send(blocked, "block;\nafter;\n");
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // a statement holding a worker doesn't stop the other connections
+  for (int i = 0; i < 10; ++i) {
+    Send(other, "x;\n");
+    EXPECT_EQ(Receive(other), std::to_string(i) + " x;\n.\n");
+  }
+  Release();
+  EXPECT_EQ(Receive(blocked), "0 block;\n.\n");
+  EXPECT_EQ(Receive(blocked), "1 after;\n.\n");
+
+  // stopping closes the connections and destroys their handlers
+  server_->Stop();
+  EXPECT_EQ(handler_count_, 0);
+  char c;
+  EXPECT_EQ(read(other, &c, 1), 0);
+  close(blocked);
+  close(other);
+}
+}  // namespace spdb
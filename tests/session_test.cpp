@@ -0,0 +1,93 @@
+#include "shell/session.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "disk/free_page_map.h"
+#include "gtest/gtest.h"
+
+namespace spdb {
+static const char *table_name = "session_test_table";
+
+static void RemoveFiles() {
+  std::remove(LOG_FILE_NAME);
+  std::remove(CATALOG_NAME);
+  std::remove(table_name);
+  std::remove(FreePageMap::FileName(CATALOG_NAME).data());
+  std::remove(FreePageMap::FileName(table_name).data());
+}
+
+// NOLINTNEXTLINE
+TEST(SessionTest, SplitInsertRowsTest) {
+  // Scenario: the commas and parentheses in strings and values are left in
+  // their rows, the text around the rows is kept in every insert.
+  EXPECT_EQ(SplitInsertRows("insert into t values (1, 'a,b'), (2, '(c)');"),
+            (std::vector<std::string>{"insert into t values (1, 'a,b');",
+                                      "insert into t values (2, '(c)');"}));
+  EXPECT_EQ(SplitInsertRows("INSERT INTO t VALUES(1,'it''s), (x'),\n"
+                            "  (abs(2), \"v,)\")  ;"),
+            (std::vector<std::string>{
+                "INSERT INTO t VALUES(1,'it''s), (x')  ;",
+                "INSERT INTO t VALUES(abs(2), \"v,)\")  ;"}));
+  EXPECT_EQ(SplitInsertRows("insert into t (a, b) values (1), (2, 3);"),
+            (std::vector<std::string>{"insert into t (a, b) values (1);",
+                                      "insert into t (a, b) values (2, 3);"}));
+
+  // Scenario: an insert of one row, another statement or a row cut off is
+  // left alone.
+  EXPECT_TRUE(SplitInsertRows("insert into t values (1, 'a), (b');").empty());
+  EXPECT_TRUE(SplitInsertRows("select * from t where a in (1), (2);").empty());
+  EXPECT_TRUE(SplitInsertRows("insert into t values (1, 'a), (2);").empty());
+  EXPECT_TRUE(SplitInsertRows("insert into t values (1, (2), (3);").empty());
+}
+
+// NOLINTNEXTLINE
+TEST(SessionTest, InsertRowsTest) {
+  RemoveFiles();
+  std::ostringstream out;
+  std::ostringstream err;
+  {
+    Engine engine(64, CHECKPOINT_INTERVAL_MS, RECOVERY_TIME_OBJECTIVE_MS);
+    Session session(&engine, &out, &err);
+    session.SetOutputMode(OutputMode::CSV);
+    const std::string table(table_name);
+    session.Execute("create table " + table + " (id INT, name CHAR(16));");
+    ASSERT_EQ(err.str(), "");
+    auto select = [&] {
+      out.str("");
+      session.Execute("select * from " + table + ";");
+      return out.str();
+    };
+
+    // Scenario: the rows with quoted commas and parentheses are inserted.
+    session.Execute("insert into " + table +
+                    " values (1, 'a,b'), (2, '(c)'), (3, 'it''s, (x)');");
+    EXPECT_EQ(err.str(), "");
+    EXPECT_EQ(select(), "id,name\n1,\"a,b\"\n2,(c)\n3,\"it's, (x)\"\n");
+
+    // Scenario: a row of another arity inserts none of the rows.
+    session.Execute("insert into " + table + " values (4, 'd'), (5);");
+    EXPECT_EQ(err.str(), "values are not matched the values of table.\n");
+    err.str("");
+    session.Execute("insert into " + table + " values (4, 'd'), (5, 'e', 6);");
+    EXPECT_EQ(err.str(), "values are not matched the values of table.\n");
+    err.str("");
+    EXPECT_EQ(select(), "id,name\n1,\"a,b\"\n2,(c)\n3,\"it's, (x)\"\n");
+
+    // Scenario: a statement the plan cache can't take, for the comment in
+    // it, inserts its rows all the same.
+    session.Execute("insert into " + table +
+                    " values (6, 'f'), (7, 'g') -- two rows\n;");
+    EXPECT_EQ(err.str(), "");
+    EXPECT_EQ(select(),
+              "id,name\n1,\"a,b\"\n2,(c)\n3,\"it's, (x)\"\n6,f\n7,g\n");
+
+    session.Execute("drop table " + table + ";");
+    session.Execute("exit;");
+  }
+  RemoveFiles();
+}
+}  // namespace spdb
@@ -0,0 +1,105 @@
+#include "executor/task_scheduler.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <set>
+#include <stdexcept>
+#include <thread>  // NOLINT
+
+#include "gtest/gtest.h"
+
+namespace spdb {
+TEST(TaskSchedulerTest, RunTest) {
+  TaskScheduler scheduler(4);
+  EXPECT_EQ(scheduler.GetWorkerCount(), 4);
+  EXPECT_EQ(scheduler.GetWorkerIndex(), -1);
+  std::atomic<int> count{0};
+  std::atomic<int> outside{0};
+  TaskGroup group(&scheduler);
+  for (int i = 0; i < 1000; ++i) {
+    group.Run([&] {
+      ++count;
+      if (scheduler.GetWorkerIndex() == -1) {
+        ++outside;
+      }
+    });
+  }
+  group.Wait();
+  EXPECT_EQ(count, 1000);
+  EXPECT_EQ(outside, 0);
+
+  // a group is waited for again after more tasks
+  group.Run([&] { ++count; });
+  group.Wait();
+  EXPECT_EQ(count, 1001);
+}
+
+TEST(TaskSchedulerTest, NestedTest) {
+  TaskScheduler scheduler(4);
+  std::atomic<int> count{0};
+  TaskGroup group(&scheduler);
+  // every task adds two more, down to a depth of ten
+  std::function<void(int)> spawn = [&](int depth) {
+    ++count;
+    if (depth < 10) {
+      group.Run([&, depth] { spawn(depth + 1); });
+      group.Run([&, depth] { spawn(depth + 1); });
+    }
+  };
+  group.Run([&] { spawn(0); });
+  group.Wait();
+  EXPECT_EQ(count, (1 << 11) - 1);
+
+  // a task waiting for a group of its own runs tasks meanwhile
+  TaskScheduler single(1);
+  TaskGroup outer(&single);
+  outer.Run([&] {
+    TaskGroup inner(&single);
+    for (int i = 0; i < 10; ++i) {
+      inner.Run([&] { ++count; });
+    }
+    inner.Wait();
+  });
+  outer.Wait();
+  EXPECT_EQ(count, (1 << 11) + 9);
+}
+
+TEST(TaskSchedulerTest, StealTest) {
+  TaskScheduler scheduler(4);
+  std::mutex latch;
+  std::set<int> workers;
+  TaskGroup group(&scheduler);
+  // all the tasks are queued on the deque of one worker, the others steal
+  group.Run([&] {
+    for (int i = 0; i < 100; ++i) {
+      group.Run([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::lock_guard<std::mutex> lock(latch);
+        workers.insert(scheduler.GetWorkerIndex());
+      });
+    }
+  });
+  group.Wait();
+  EXPECT_GT(scheduler.GetStealCount(), 0);
+  EXPECT_GT(workers.size(), 1);
+}
+
+TEST(TaskSchedulerTest, ExceptionTest) {
+  TaskScheduler scheduler(2);
+  std::atomic<int> count{0};
+  TaskGroup group(&scheduler);
+  for (int i = 0; i < 100; ++i) {
+    group.Run([&, i] {
+      if (i == 50) {
+        throw std::runtime_error("task failed.");
+      }
+      ++count;
+    });
+  }
+  EXPECT_THROW(group.Wait(), std::runtime_error);
+  // the other tasks still ran
+  EXPECT_EQ(count, 99);
+  group.Wait();
+}
+}  // namespace spdb
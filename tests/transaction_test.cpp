@@ -0,0 +1,902 @@
+#include "concurrency/transaction_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <random>
+#include <set>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool.h"
+#include "config/catalog.h"
+#include "executor/aggregation_executor.h"
+#include "executor/parallel_seq_scan_executor.h"
+#include "executor/seq_scan_executor.h"
+#include "gtest/gtest.h"
+#include "table/b_plus_tree.h"
+
+namespace spdb {
+static const char *catalog_name = "transaction_test_catalog.db";
+static const char *table_name = "transaction_test_table";
+static const char *index_name = "transaction_test_index";
+static const char *index_file_name =
+    "transaction_test_table.transaction_test_index.idx";
+
+static void RemoveFiles() {
+  std::remove(catalog_name);
+  std::remove(table_name);
+  std::remove(index_file_name);
+  std::remove(FreePageMap::FileName(table_name).data());
+  std::remove(FreePageMap::FileName(index_file_name).data());
+}
+
+static auto TableType() -> std::vector<Cloum> {
+  return {Cloum{"id", {CloumType::INT, 4}}, Cloum{"val", {CloumType::INT, 4}}};
+}
+
+static auto KeyType() -> std::vector<Cloum> {
+  return {Cloum{"id", {CloumType::INT, 4}}};
+}
+
+static auto Row(int key, int val) -> Tuple {
+  auto type = TableType();
+  Tuple row(type);
+  int values[2] = {key, val};
+  row.SetValues((char *)values);
+  return row;
+}
+
+/** A database of one (id, val) table, run by a transaction manager. */
+struct Database {
+  explicit Database(LeafLayout layout = LeafLayout::Row) : pool_(256) {
+    RemoveFiles();
+    catalog_ = std::make_unique<Catalog>(catalog_name, &pool_);
+    catalog_->CreateTable(table_name, KeyType(), TableType(), layout);
+    txn_manager_ = std::make_unique<TransactionManager>(catalog_.get());
+    catalog_->SetTransactionManager(txn_manager_.get());
+  }
+
+  ~Database() {
+    txn_manager_.reset();
+    catalog_.reset();
+    RemoveFiles();
+  }
+
+  // The value of the key txn sees, or -1 without a row.
+  auto Read(const Transaction *txn, int key) -> int {
+    auto table = catalog_->GetTable(table_name);
+    BPlusTree tree(catalog_->GetBufferPoolManager(table_name), table.key_type_,
+                   table.value_type_, table.leaf_max_size_,
+                   table.internal_max_size_, table.root_id_);
+    auto row = Row(key, 0);
+    auto row_key = row.Project(table.key_type_);
+    if (!tree.GetValue(row_key, row) ||
+        !txn_manager_->ReadRow(txn, table_name, row_key, &row)) {
+      return -1;
+    }
+    return *row.GetValueAtAs<int>(1);
+  }
+
+  // The keys a full scan of the calling thread sees.
+  auto Scan() -> std::vector<int> {
+    SeqScanExecutor executor(catalog_.get(), table_name);
+    auto type = TableType();
+    Tuple row(type);
+    RID rid{};
+    std::vector<int> keys;
+    while (executor.Next(&row, &rid)) {
+      keys.push_back(*row.GetValueAtAs<int>(0));
+    }
+    return keys;
+  }
+
+  BufferPool pool_;
+  std::unique_ptr<Catalog> catalog_;
+  std::unique_ptr<TransactionManager> txn_manager_;
+};
+
+TEST(TransactionTest, DirtyReadTest) {
+  Database db;
+  auto writer = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(writer, table_name, Row(1, 10)));
+  // the writer reads its own writes, nobody else does
+  EXPECT_EQ(db.Read(writer, 1), 10);
+  auto reader = db.txn_manager_->BeginSnapshot();
+  EXPECT_EQ(db.Read(reader, 1), -1);
+  EXPECT_EQ(db.Read(nullptr, 1), -1);
+
+  db.txn_manager_->Commit(writer);
+  EXPECT_EQ(db.Read(reader, 1), -1);
+  EXPECT_EQ(db.Read(nullptr, 1), 10);
+  db.txn_manager_->Commit(reader);
+}
+
+TEST(TransactionTest, SnapshotReadTest) {
+  Database db;
+  auto first = db.txn_manager_->Begin();
+  for (int key = 0; key < 100; ++key) {
+    db.txn_manager_->InsertRow(first, table_name, Row(key, key));
+  }
+  db.txn_manager_->Commit(first);
+
+  // a snapshot taken before the second batch sees none of it, however many
+  // times it scans
+  auto reader = db.txn_manager_->Begin();
+  EXPECT_EQ(db.Scan().size(), 100);
+  std::thread writer([&] {
+    auto second = db.txn_manager_->Begin();
+    for (int key = 100; key < 1000; ++key) {
+      db.txn_manager_->InsertRow(second, table_name, Row(key, key));
+    }
+    // the writer scans its own rows
+    EXPECT_EQ(db.Scan().size(), 1000);
+    db.txn_manager_->Commit(second);
+  });
+  for (int i = 0; i < 20; ++i) {
+    auto keys = db.Scan();
+    ASSERT_EQ(keys.size(), 100);
+    EXPECT_EQ(keys.back(), 99);
+  }
+  writer.join();
+  EXPECT_EQ(db.Scan().size(), 100);
+  EXPECT_EQ(db.Read(reader, 500), -1);
+  db.txn_manager_->Commit(reader);
+
+  // a new snapshot sees every row
+  EXPECT_EQ(db.Scan().size(), 1000);
+}
+
+TEST(TransactionTest, RollbackTest) {
+  Database db;
+  ASSERT_TRUE(db.catalog_->CreateIndex(table_name, index_name, {"val"}));
+
+  auto txn = db.txn_manager_->Begin();
+  for (int key = 0; key < 300; ++key) {
+    db.txn_manager_->InsertRow(txn, table_name, Row(key, key * 2));
+  }
+  db.txn_manager_->Abort(txn);
+  EXPECT_TRUE(db.Scan().empty());
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+  // the index entries are gone with the rows
+  auto table = db.catalog_->GetTable(table_name);
+  auto &index = table.indexes_.front();
+  BPlusTree index_tree(db.catalog_->GetBufferPoolManager(index.disk_name_),
+                       index.key_type_, table.key_type_,
+                       index.leaf_max_size_, index.internal_max_size_,
+                       index.root_id_);
+  EXPECT_TRUE(index_tree.Begin() == index_tree.End());
+
+  // and the keys can be written again
+  txn = db.txn_manager_->Begin();
+  for (int key = 0; key < 300; ++key) {
+    EXPECT_TRUE(db.txn_manager_->InsertRow(txn, table_name, Row(key, key)));
+  }
+  db.txn_manager_->Commit(txn);
+  EXPECT_EQ(db.Scan().size(), 300);
+  EXPECT_EQ(db.Read(nullptr, 7), 7);
+}
+
+TEST(TransactionTest, WriteConflictTest) {
+  Database db;
+  // a key written by a running transaction
+  auto first = db.txn_manager_->Begin();
+  auto second = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(first, table_name, Row(1, 1)));
+  EXPECT_THROW(db.txn_manager_->InsertRow(second, table_name, Row(1, 2)),
+               TransactionAbortException);
+  db.txn_manager_->Abort(second);
+
+  // a key committed after the snapshot
+  auto third = db.txn_manager_->Begin();
+  db.txn_manager_->Commit(first);
+  EXPECT_THROW(db.txn_manager_->InsertRow(third, table_name, Row(1, 3)),
+               TransactionAbortException);
+  db.txn_manager_->Abort(third);
+  EXPECT_EQ(db.Read(nullptr, 1), 1);
+
+  // a key committed before the snapshot is a plain duplicate
+  auto fourth = db.txn_manager_->Begin();
+  EXPECT_FALSE(db.txn_manager_->InsertRow(fourth, table_name, Row(1, 4)));
+  EXPECT_TRUE(db.txn_manager_->InsertRow(fourth, table_name, Row(2, 4)));
+  EXPECT_FALSE(db.txn_manager_->InsertRow(fourth, table_name, Row(2, 5)));
+  db.txn_manager_->Commit(fourth);
+  EXPECT_EQ(db.Read(nullptr, 2), 4);
+}
+
+TEST(TransactionTest, InsertRowsTest) {
+  Database db;
+  ASSERT_TRUE(db.catalog_->CreateIndex(table_name, index_name, {"val"}));
+  auto txn = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(txn, table_name, Row(10, 10)));
+  db.txn_manager_->Commit(txn);
+
+  // one batch, unsorted, with a key already in the table and one repeated
+  std::vector<Tuple> rows;
+  for (int key = 0; key < 500; ++key) {
+    rows.push_back(Row(key, key * 2));
+  }
+  std::shuffle(rows.begin(), rows.end(), std::mt19937(0));
+  rows.push_back(Row(7, -1));
+  txn = db.txn_manager_->Begin();
+  EXPECT_EQ(db.txn_manager_->InsertRows(txn, table_name, rows), 499);
+  EXPECT_EQ(db.Read(nullptr, 7), -1);
+  db.txn_manager_->Commit(txn);
+  EXPECT_EQ(db.Read(nullptr, 7), 14);
+  EXPECT_EQ(db.Read(nullptr, 10), 10);
+  EXPECT_EQ(db.Scan().size(), 500);
+
+  // every row inserted has its index entry
+  auto table = db.catalog_->GetTable(table_name);
+  auto &index = table.indexes_.front();
+  BPlusTree index_tree(db.catalog_->GetBufferPoolManager(index.disk_name_),
+                       index.key_type_, table.key_type_,
+                       index.leaf_max_size_, index.internal_max_size_,
+                       index.root_id_);
+  size_t entries = 0;
+  for (auto it = index_tree.Begin(); it != index_tree.End(); ++it) {
+    ++entries;
+  }
+  EXPECT_EQ(entries, 500);
+
+  // a batch with a key another transaction writes inserts nothing
+  auto other = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(other, table_name, Row(600, 0)));
+  txn = db.txn_manager_->Begin();
+  EXPECT_THROW(db.txn_manager_->InsertRows(
+                   txn, table_name, {Row(599, 0), Row(600, 1), Row(601, 0)}),
+               TransactionAbortException);
+  db.txn_manager_->Abort(txn);
+  db.txn_manager_->Commit(other);
+  EXPECT_EQ(db.Read(nullptr, 599), -1);
+  EXPECT_EQ(db.Read(nullptr, 601), -1);
+  EXPECT_EQ(db.Scan().size(), 501);
+}
+
+TEST(TransactionTest, DeleteRowsTest) {
+  Database db;
+  ASSERT_TRUE(db.catalog_->CreateIndex(table_name, index_name, {"val"}));
+  std::vector<Tuple> rows;
+  for (int key = 0; key < 100; ++key) {
+    rows.push_back(Row(key, key));
+  }
+  auto txn = db.txn_manager_->Begin();
+  db.txn_manager_->InsertRows(txn, table_name, rows);
+  db.txn_manager_->Commit(txn);
+
+  // the even keys are deleted, the reader started before still sees them in
+  // key order
+  auto reader = db.txn_manager_->Begin();
+  std::thread([&] {
+    auto deleter = db.txn_manager_->Begin();
+    std::vector<Tuple> keys;
+    for (int key = 0; key < 100; key += 2) {
+      keys.push_back(Row(key, 0).Project(KeyType()));
+    }
+    keys.push_back(Row(500, 0).Project(KeyType()));
+    EXPECT_EQ(db.txn_manager_->DeleteRows(deleter, table_name, keys), 50);
+    EXPECT_EQ(db.Scan().size(), 50);
+    db.txn_manager_->Commit(deleter);
+  }).join();
+  auto keys = db.Scan();
+  ASSERT_EQ(keys.size(), 100);
+  for (int key = 0; key < 100; ++key) {
+    EXPECT_EQ(keys[key], key);
+  }
+  db.txn_manager_->Commit(reader);
+  EXPECT_EQ(db.Scan().size(), 50);
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+
+  // a delete rolled back leaves the rows
+  txn = db.txn_manager_->Begin();
+  std::vector<Tuple> odd_keys;
+  for (int key = 1; key < 100; key += 2) {
+    odd_keys.push_back(Row(key, 0).Project(KeyType()));
+  }
+  EXPECT_EQ(db.txn_manager_->DeleteRows(txn, table_name, odd_keys), 50);
+  EXPECT_TRUE(db.Scan().empty());
+  db.txn_manager_->Abort(txn);
+  EXPECT_EQ(db.Scan().size(), 50);
+  EXPECT_EQ(db.Read(nullptr, 51), 51);
+  // the versions of the rows a scan may have passed by go with the next
+  // commit
+  txn = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(txn, table_name, Row(100, 100)));
+  db.txn_manager_->Commit(txn);
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+}
+
+TEST(TransactionTest, UpdateRowsTest) {
+  Database db;
+  ASSERT_TRUE(db.catalog_->CreateIndex(table_name, index_name, {"val"}));
+  std::vector<Tuple> rows;
+  for (int key = 0; key < 100; ++key) {
+    rows.push_back(Row(key, key));
+  }
+  auto txn = db.txn_manager_->Begin();
+  db.txn_manager_->InsertRows(txn, table_name, rows);
+  db.txn_manager_->Commit(txn);
+
+  // the values change in place, the reader started before sees the old ones
+  auto reader = db.txn_manager_->Begin();
+  std::thread([&] {
+    auto updater = db.txn_manager_->Begin();
+    std::vector<std::pair<Tuple, Tuple>> updates;
+    for (int key = 0; key < 50; ++key) {
+      updates.emplace_back(Row(key, key), Row(key, key + 1000));
+    }
+    EXPECT_EQ(db.txn_manager_->UpdateRows(updater, table_name, updates), 50);
+    EXPECT_EQ(db.Read(updater, 3), 1003);
+    db.txn_manager_->Commit(updater);
+  }).join();
+  EXPECT_EQ(db.Read(reader, 3), 3);
+  EXPECT_EQ(db.Scan().size(), 100);
+  db.txn_manager_->Commit(reader);
+  EXPECT_EQ(db.Read(nullptr, 3), 1003);
+  EXPECT_EQ(db.Read(nullptr, 60), 60);
+
+  // a row getting a new key moves
+  txn = db.txn_manager_->Begin();
+  EXPECT_EQ(db.txn_manager_->UpdateRows(txn, table_name,
+                                        {{Row(99, 99), Row(200, 99)}}),
+            1);
+  db.txn_manager_->Commit(txn);
+  EXPECT_EQ(db.Read(nullptr, 99), -1);
+  EXPECT_EQ(db.Read(nullptr, 200), 99);
+  EXPECT_EQ(db.Scan().size(), 100);
+
+  // but not onto the key of another row
+  txn = db.txn_manager_->Begin();
+  EXPECT_THROW(db.txn_manager_->UpdateRows(txn, table_name,
+                                           {{Row(98, 98), Row(0, 98)}}),
+               std::runtime_error);
+  db.txn_manager_->Abort(txn);
+  EXPECT_EQ(db.Read(nullptr, 0), 1000);
+  EXPECT_EQ(db.Read(nullptr, 98), 98);
+
+  // an update rolled back restores the old value
+  txn = db.txn_manager_->Begin();
+  EXPECT_EQ(db.txn_manager_->UpdateRows(txn, table_name,
+                                        {{Row(5, 1005), Row(5, -5)}}),
+            1);
+  db.txn_manager_->Abort(txn);
+  EXPECT_EQ(db.Read(nullptr, 5), 1005);
+  txn = db.txn_manager_->Begin();
+  ASSERT_TRUE(db.txn_manager_->InsertRow(txn, table_name, Row(300, 300)));
+  db.txn_manager_->Commit(txn);
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+}
+
+TEST(TransactionTest, ParallelScanTest) {
+  Database db;
+  std::vector<Tuple> rows;
+  for (int key = 0; key < 20000; ++key) {
+    rows.push_back(Row(key, key));
+  }
+  auto txn = db.txn_manager_->Begin();
+  db.txn_manager_->InsertRows(txn, table_name, rows);
+  db.txn_manager_->Commit(txn);
+  auto parallel_scan = [&] {
+    ParallelSeqScanExecutor executor(db.catalog_.get(), table_name, nullptr,
+                                     4);
+    EXPECT_GT(executor.GetMorselCount(), 4);
+    auto type = TableType();
+    Tuple row(type);
+    RID rid{};
+    std::vector<int> keys;
+    while (executor.Next(&row, &rid)) {
+      EXPECT_EQ(*row.GetValueAtAs<int>(1), *row.GetValueAtAs<int>(0));
+      keys.push_back(*row.GetValueAtAs<int>(0));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+  };
+
+  // every partition reads as of the snapshot of the reader
+  auto reader = db.txn_manager_->Begin();
+  std::thread([&] {
+    auto deleter = db.txn_manager_->Begin();
+    std::vector<Tuple> keys;
+    for (int key = 0; key < 20000; key += 3) {
+      keys.push_back(Row(key, 0).Project(KeyType()));
+    }
+    db.txn_manager_->DeleteRows(deleter, table_name, keys);
+    db.txn_manager_->Commit(deleter);
+  }).join();
+  auto keys = parallel_scan();
+  ASSERT_EQ(keys.size(), 20000);
+  for (int key = 0; key < 20000; ++key) {
+    EXPECT_EQ(keys[key], key);
+  }
+  db.txn_manager_->Commit(reader);
+  EXPECT_EQ(parallel_scan().size(), 20000 - 6667);
+
+  // a scan given up early stops its threads
+  {
+    ParallelSeqScanExecutor executor(db.catalog_.get(), table_name, nullptr,
+                                     4);
+    auto type = TableType();
+    Tuple row(type);
+    RID rid{};
+    EXPECT_TRUE(executor.Next(&row, &rid));
+  }
+}
+
+TEST(TransactionTest, SkipTest) {
+  Database db;
+  std::vector<Tuple> rows;
+  for (int key = 0; key < 5000; ++key) {
+    rows.push_back(Row(key, key));
+  }
+  auto txn = db.txn_manager_->Begin();
+  db.txn_manager_->InsertRows(txn, table_name, rows);
+  db.txn_manager_->Commit(txn);
+  // the keys after skipping n rows, read by a fresh scan
+  auto skip = [&](size_t n, size_t *skipped) {
+    SeqScanExecutor executor(db.catalog_.get(), table_name);
+    *skipped = executor.Skip(n);
+    auto type = TableType();
+    Tuple row(type);
+    RID rid{};
+    std::vector<int> keys;
+    while (executor.Next(&row, &rid)) {
+      keys.push_back(*row.GetValueAtAs<int>(0));
+    }
+    return keys;
+  };
+
+  // whole leaves are skipped while no versions are kept
+  size_t skipped;
+  auto keys = skip(1234, &skipped);
+  EXPECT_EQ(skipped, 1234);
+  ASSERT_EQ(keys.size(), 5000 - 1234);
+  EXPECT_EQ(keys.front(), 1234);
+  EXPECT_TRUE(skip(6000, &skipped).empty());
+  EXPECT_EQ(skipped, 5000);
+
+  // a reader older than a delete skips the rows it still sees
+  auto reader = db.txn_manager_->Begin();
+  std::thread([&] {
+    auto deleter = db.txn_manager_->Begin();
+    std::vector<Tuple> keys;
+    for (int key = 0; key < 5000; key += 2) {
+      keys.push_back(Row(key, 0).Project(KeyType()));
+    }
+    db.txn_manager_->DeleteRows(deleter, table_name, keys);
+    db.txn_manager_->Commit(deleter);
+  }).join();
+  keys = skip(1234, &skipped);
+  EXPECT_EQ(skipped, 1234);
+  ASSERT_EQ(keys.size(), 5000 - 1234);
+  EXPECT_EQ(keys.front(), 1234);
+  db.txn_manager_->Commit(reader);
+
+  // and a later one the rows left
+  keys = skip(1234, &skipped);
+  ASSERT_EQ(keys.size(), 2500 - 1234);
+  EXPECT_EQ(keys.front(), 2 * 1234 + 1);
+}
+
+TEST(TransactionTest, ParallelAggregationTest) {
+  Database db;
+  std::vector<Tuple> rows;
+  // no 0 among the ids or the values, so MIN and MAX don't start from it
+  for (int key = 1; key <= 20000; ++key) {
+    rows.push_back(Row(key, -(key % 10) - 1));
+  }
+  auto txn = db.txn_manager_->Begin();
+  db.txn_manager_->InsertRows(txn, table_name, rows);
+  db.txn_manager_->Commit(txn);
+
+  // the groups of the workers, spilled or not, add up to those of one scan
+  TaskScheduler scheduler(4);
+  std::vector<AggregateSpec> aggregates{
+      {AggregationType::COUNT, -1, "COUNT(*)"},
+      {AggregationType::SUM, 0, "SUM(id)"},
+      {AggregationType::MIN, 0, "MIN(id)"},
+      {AggregationType::MAX, 1, "MAX(val)"}};
+  auto aggregate = [&](std::unique_ptr<AbstractExecutor> child,
+                       std::vector<int> group_by, size_t memory_budget) {
+    AggregationExecutor executor(db.catalog_.get(), std::move(child),
+                                 group_by, aggregates, memory_budget);
+    auto cols = executor.GetOutputCols();
+    Tuple tuple(cols);
+    RID rid{};
+    std::set<std::vector<int>> groups;
+    while (executor.Next(&tuple, &rid)) {
+      std::vector<int> values;
+      for (size_t i = 0; i < cols.size(); ++i) {
+        values.push_back(*tuple.GetValueAtAs<int>(i));
+      }
+      groups.insert(values);
+    }
+    return groups;
+  };
+  for (size_t memory_budget : {EXECUTOR_MEMORY_BUDGET, 1}) {
+    for (auto group_by : {std::vector<int>{1}, std::vector<int>{}}) {
+      auto expected = aggregate(
+          std::make_unique<SeqScanExecutor>(db.catalog_.get(), table_name),
+          group_by, memory_budget);
+      auto groups = aggregate(
+          std::make_unique<ParallelSeqScanExecutor>(
+              db.catalog_.get(), table_name, nullptr, 4, &scheduler),
+          group_by, memory_budget);
+      EXPECT_EQ(groups.size(), group_by.empty() ? 1 : 10);
+      EXPECT_EQ(groups, expected);
+      if (group_by.empty()) {
+        EXPECT_EQ(*groups.begin(),
+                  (std::vector<int>{20000, 20000 * 20001 / 2, 1, -1}));
+      }
+    }
+  }
+}
+
+TEST(TransactionTest, GarbageCollectionTest) {
+  Database db;
+  auto reader = db.txn_manager_->BeginSnapshot();
+  auto txn = db.txn_manager_->Begin();
+  for (int key = 0; key < 100; ++key) {
+    db.txn_manager_->InsertRow(txn, table_name, Row(key, key));
+  }
+  db.txn_manager_->Commit(txn);
+  // the reader still needs to know the rows didn't exist
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 100);
+  EXPECT_EQ(db.Read(reader, 50), -1);
+  db.txn_manager_->Commit(reader);
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+  EXPECT_EQ(db.Read(nullptr, 50), 50);
+}
+
+TEST(TransactionTest, CompactTest) {
+  Database db;
+  std::vector<int> keys;
+  for (int key = 0; key < 5000; ++key) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+  auto txn = db.txn_manager_->Begin();
+  for (auto key : keys) {
+    db.txn_manager_->InsertRow(txn, table_name, Row(key, key));
+  }
+
+  // the rows written aren't committed yet
+  std::thread([&] {
+    EXPECT_THROW(db.txn_manager_->CompactTable(table_name),
+                 std::runtime_error);
+  }).join();
+  EXPECT_THROW(db.txn_manager_->CompactTable(table_name), std::runtime_error);
+  db.txn_manager_->Commit(txn);
+
+  auto bpm = db.catalog_->GetBufferPoolManager(table_name);
+  size_t free_page_count = bpm->GetFreePageCount();
+  {
+    // a scan started before the compaction reads the old pages to its end
+    SeqScanExecutor executor(db.catalog_.get(), table_name);
+    auto type = TableType();
+    Tuple row(type);
+    RID rid{};
+    int key = 0;
+    for (; key < 100; ++key) {
+      ASSERT_TRUE(executor.Next(&row, &rid));
+    }
+    EXPECT_GT(db.txn_manager_->CompactTable(table_name), 0);
+    EXPECT_GT(db.txn_manager_->GetRetiredPageCount(), 0);
+    EXPECT_EQ(db.Read(nullptr, 4999), 4999);
+    while (executor.Next(&row, &rid)) {
+      EXPECT_EQ(*row.GetValueAtAs<int>(0), key);
+      ++key;
+    }
+    EXPECT_EQ(key, 5000);
+  }
+  // and the old pages are freed once it finishes
+  EXPECT_EQ(db.txn_manager_->GetRetiredPageCount(), 0);
+  EXPECT_GT(bpm->GetFreePageCount(), free_page_count);
+  EXPECT_EQ(db.txn_manager_->CompactTable(table_name), 0);
+  EXPECT_EQ(db.Scan().size(), 5000);
+}
+
+TEST(TransactionTest, VacuumAfterCompactTest) {
+  Database db;
+  auto insert = [&](int begin, int end) {
+    std::vector<Tuple> rows;
+    for (int key = begin; key < end; ++key) {
+      rows.push_back(Row(key, key));
+    }
+    std::shuffle(rows.begin(), rows.end(), std::mt19937(begin));
+    auto txn = db.txn_manager_->Begin();
+    EXPECT_EQ(db.txn_manager_->InsertRows(txn, table_name, rows), end - begin);
+    db.txn_manager_->Commit(txn);
+  };
+  insert(0, 5000);
+
+  // the pages the compaction retires stay with the old snapshot, a vacuum
+  // meanwhile keeps them
+  auto reader = db.txn_manager_->Begin();
+  db.txn_manager_->Suspend();
+  EXPECT_GT(db.txn_manager_->CompactTable(table_name), 0);
+  size_t retired = db.txn_manager_->GetRetiredPageCount();
+  EXPECT_GT(retired, 0);
+  db.txn_manager_->VacuumTable(table_name);
+  EXPECT_EQ(db.txn_manager_->GetRetiredPageCount(), retired);
+  insert(5000, 10000);
+  db.txn_manager_->Commit(reader);
+  EXPECT_EQ(db.txn_manager_->GetRetiredPageCount(), 0);
+
+  // the pages freed after the snapshot are reused by the rows to come, and
+  // none of them is in use twice
+  insert(10000, 15000);
+  auto keys = db.Scan();
+  ASSERT_EQ(keys.size(), 15000);
+  for (int key = 0; key < 15000; ++key) {
+    ASSERT_EQ(keys[key], key);
+  }
+  for (int key = 0; key < 15000; key += 997) {
+    EXPECT_EQ(db.Read(nullptr, key), key);
+  }
+}
+
+TEST(TransactionTest, PaxLayoutTest) {
+  Database db(LeafLayout::Pax);
+  std::vector<Tuple> rows;
+  for (int key = 1; key <= 3000; ++key) {
+    rows.push_back(Row(key, key));
+  }
+  std::shuffle(rows.begin(), rows.end(), std::mt19937(0));
+  auto txn = db.txn_manager_->Begin();
+  EXPECT_EQ(db.txn_manager_->InsertRows(txn, table_name, rows), 3000);
+  db.txn_manager_->Commit(txn);
+
+  // written through every path, the rows read as in a row table
+  txn = db.txn_manager_->Begin();
+  std::vector<std::pair<Tuple, Tuple>> updates;
+  std::vector<Tuple> keys;
+  for (int key = 1; key <= 3000; key += 2) {
+    updates.emplace_back(Row(key, key), Row(key, -key));
+    keys.push_back(Row(key + 1, 0).Project(KeyType()));
+  }
+  EXPECT_EQ(db.txn_manager_->UpdateRows(txn, table_name, updates), 1500);
+  EXPECT_EQ(db.txn_manager_->DeleteRows(txn, table_name, keys), 1500);
+  db.txn_manager_->Commit(txn);
+  EXPECT_GT(db.txn_manager_->CompactTable(table_name), 0);
+  auto scanned = db.Scan();
+  ASSERT_EQ(scanned.size(), 1500);
+  for (int i = 0; i < 1500; ++i) {
+    EXPECT_EQ(scanned[i], i * 2 + 1);
+  }
+  EXPECT_EQ(db.Read(nullptr, 2999), -2999);
+
+  // the layout is kept with the catalog
+  db.txn_manager_.reset();
+  db.catalog_.reset();
+  db.catalog_ = std::make_unique<Catalog>(catalog_name, &db.pool_);
+  db.txn_manager_ = std::make_unique<TransactionManager>(db.catalog_.get());
+  db.catalog_->SetTransactionManager(db.txn_manager_.get());
+  auto table = db.catalog_->GetTable(table_name);
+  EXPECT_EQ(table.layout_, LeafLayout::Pax);
+  auto bpm = db.catalog_->GetBufferPoolManager(table_name);
+  auto guard = bpm->FetchPageRead(table.root_id_);
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    guard = bpm->FetchPageRead(guard.As<BPlusTreeInternalPage>()->ValueAt(0));
+  }
+  EXPECT_EQ(guard.As<BPlusTreeLeafPage>()->GetLayout(), LeafLayout::Pax);
+  guard.Drop();
+  EXPECT_EQ(db.Read(nullptr, 11), -11);
+
+  // a cloum is read from its place in each leaf, so is an aggregate of it,
+  // the ids are all positive and the values all negative
+  SeqScanExecutor scan(db.catalog_.get(), table_name);
+  std::vector<char> values;
+  size_t n = scan.ReadCloum(1, &values);
+  ASSERT_GT(n, 0);
+  ASSERT_EQ(values.size(), n * sizeof(int));
+  for (size_t i = 0; i < n; ++i) {
+    int val = 0;
+    memcpy(&val, values.data() + i * sizeof(int), sizeof(int));
+    EXPECT_EQ(val, -2 * static_cast<int>(i) - 1);
+  }
+  auto aggregate = [&](std::vector<AggregateSpec> aggregates) {
+    AggregationExecutor aggregation(
+        db.catalog_.get(),
+        std::make_unique<SeqScanExecutor>(db.catalog_.get(), table_name), {},
+        aggregates);
+    auto cols = aggregation.GetOutputCols();
+    Tuple tuple(cols);
+    RID rid{};
+    EXPECT_TRUE(aggregation.Next(&tuple, &rid));
+    std::vector<int> result(cols.size());
+    memcpy(result.data(), tuple.GetData(), result.size() * sizeof(int));
+    EXPECT_FALSE(aggregation.Next(&tuple, &rid));
+    return result;
+  };
+  EXPECT_EQ(aggregate({{AggregationType::COUNT, -1, "COUNT(*)"},
+                       {AggregationType::SUM, 1, "SUM(val)"},
+                       {AggregationType::MIN, 1, "MIN(val)"},
+                       {AggregationType::MAX, 1, "MAX(val)"}}),
+            (std::vector<int>{1500, -1500 * 1500, -2999, -1}));
+  EXPECT_EQ(aggregate({{AggregationType::MIN, 0, "MIN(id)"},
+                       {AggregationType::MAX, 0, "MAX(id)"}}),
+            (std::vector<int>{1, 2999}));
+}
+
+TEST(TransactionTest, CatalogFormatTest) {
+  const std::string other_name = "transaction_test_other";
+  auto check = [&](const TableInfo &table, const std::string &name) {
+    EXPECT_EQ(table.disk_name_, name);
+    ASSERT_EQ(table.key_type_.size(), 1);
+    EXPECT_EQ(table.key_type_[0].cloum_name_, "id");
+    ASSERT_EQ(table.value_type_.size(), 2);
+    EXPECT_EQ(table.value_type_[1].cloum_name_, "val");
+  };
+
+  // a catalog of two tables written before the layouts and indexes were
+  // kept reads as Row tables without indexes
+  RemoveFiles();
+  {
+    std::fstream file(catalog_name, std::ios::out | std::ios::binary);
+    auto write_cloums = [&](const std::vector<Cloum> &cols) {
+      size_t nums = cols.size();
+      file.write((char *)&nums, sizeof(size_t));
+      for (auto &col : cols) {
+        size_t length = col.cloum_name_.length() + 1;
+        file.write((char *)&length, sizeof(size_t));
+        file.write(col.cloum_name_.data(), length);
+        file.write((char *)&col.atr_, sizeof(CloumAtr));
+      }
+    };
+    size_t tsize = 2;
+    file.write((char *)&tsize, sizeof(size_t));
+    for (const std::string &name : {std::string(table_name), other_name}) {
+      size_t length = name.length() + 1;
+      file.write((char *)&length, sizeof(size_t));
+      file.write(name.data(), length);
+      write_cloums(KeyType());
+      write_cloums(TableType());
+      page_id_t root_id = INVALID_PAGE_ID;
+      int max_sizes[2] = {100, 200};
+      file.write((char *)&root_id, sizeof(page_id_t));
+      file.write((char *)max_sizes, sizeof(max_sizes));
+    }
+  }
+  {
+    BufferPool pool(64);
+    Catalog catalog(catalog_name, &pool);
+    for (const std::string &name : {std::string(table_name), other_name}) {
+      auto table = catalog.GetTable(name);
+      check(table, name);
+      EXPECT_EQ(table.leaf_max_size_, 100);
+      EXPECT_EQ(table.internal_max_size_, 200);
+      EXPECT_TRUE(table.indexes_.empty());
+      EXPECT_EQ(table.layout_, LeafLayout::Row);
+    }
+  }
+  RemoveFiles();
+
+  // the indexes and layouts of every table are kept with the catalog
+  {
+    Database db;
+    ASSERT_TRUE(db.catalog_->CreateIndex(table_name, index_name, {"val"}));
+    ASSERT_TRUE(db.catalog_->CreateTable(other_name, KeyType(), TableType(),
+                                         LeafLayout::Pax));
+    db.txn_manager_.reset();
+    db.catalog_.reset();
+    db.catalog_ = std::make_unique<Catalog>(catalog_name, &db.pool_);
+    db.txn_manager_ = std::make_unique<TransactionManager>(db.catalog_.get());
+    db.catalog_->SetTransactionManager(db.txn_manager_.get());
+    auto table = db.catalog_->GetTable(table_name);
+    check(table, table_name);
+    EXPECT_EQ(table.layout_, LeafLayout::Row);
+    ASSERT_EQ(table.indexes_.size(), 1);
+    EXPECT_EQ(table.indexes_[0].index_name_, index_name);
+    EXPECT_EQ(table.indexes_[0].disk_name_, index_file_name);
+    auto other = db.catalog_->GetTable(other_name);
+    check(other, other_name);
+    EXPECT_EQ(other.layout_, LeafLayout::Pax);
+    EXPECT_TRUE(other.indexes_.empty());
+  }
+  std::remove(other_name.data());
+  std::remove(FreePageMap::FileName(other_name).data());
+}
+
+/**
+ * Writers commit batches of keys, each with one of a few hot keys every
+ * writer competes for, while readers check every batch is seen all or
+ * nothing.
+ */
+TEST(TransactionTest, ContentionBenchmark) {
+  Database db;
+  const int writer_num = 4;
+  const int reader_num = 4;
+  const int batch_num = 200;
+  const int batch_size = 10;
+  const int hot_key_num = 20;
+
+  std::atomic<int> committed{0};
+  std::atomic<int> aborted{0};
+  std::atomic<bool> is_running{true};
+  std::atomic<size_t> reads{0};
+  std::mutex latch;
+  std::set<int> committed_keys;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int w = 0; w < writer_num; ++w) {
+    threads.emplace_back([&, w] {
+      std::mt19937 rng(w);
+      for (int b = 0; b < batch_num; ++b) {
+        // a batch is one hot key and private keys, tagged with its first
+        int first = (w * batch_num + b) * batch_size + hot_key_num;
+        int hot = rng() % hot_key_num;
+        auto txn = db.txn_manager_->Begin();
+        try {
+          for (int i = 0; i + 1 < batch_size; ++i) {
+            db.txn_manager_->InsertRow(txn, table_name, Row(first + i, first));
+          }
+          // the first writer of a hot key wins, later ones see a duplicate
+          bool is_hot_inserted =
+              db.txn_manager_->InsertRow(txn, table_name, Row(hot, first));
+          db.txn_manager_->Commit(txn);
+          std::lock_guard<std::mutex> lock(latch);
+          for (int i = 0; i + 1 < batch_size; ++i) {
+            committed_keys.insert(first + i);
+          }
+          if (is_hot_inserted) {
+            EXPECT_TRUE(committed_keys.insert(hot).second);
+          }
+          ++committed;
+        } catch (TransactionAbortException &e) {
+          db.txn_manager_->Abort(txn);
+          ++aborted;
+        }
+      }
+    });
+  }
+  for (int r = 0; r < reader_num; ++r) {
+    threads.emplace_back([&, r] {
+      std::mt19937 rng(writer_num + r);
+      const int batch_total = writer_num * batch_num;
+      while (is_running) {
+        auto txn = db.txn_manager_->BeginSnapshot();
+        int first = (rng() % batch_total) * batch_size + hot_key_num;
+        int visible = 0;
+        for (int i = 0; i + 1 < batch_size; ++i) {
+          int val = db.Read(txn, first + i);
+          if (val != -1) {
+            EXPECT_EQ(val, first);
+            ++visible;
+          }
+        }
+        EXPECT_TRUE(visible == 0 || visible == batch_size - 1);
+        reads += batch_size - 1;
+        db.txn_manager_->Commit(txn);
+      }
+    });
+  }
+  for (int w = 0; w < writer_num; ++w) {
+    threads[w].join();
+  }
+  is_running = false;
+  for (int r = 0; r < reader_num; ++r) {
+    threads[writer_num + r].join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+
+  std::cout << "commits: " << committed << ", aborts: " << aborted
+            << ", commits/s: " << committed / seconds
+            << ", reads/s: " << reads / seconds << ", conflict rate: "
+            << 1.0 * aborted / (committed + aborted) << std::endl;
+  EXPECT_EQ(committed + aborted, writer_num * batch_num);
+  // every key is written once, and only by the committed batches
+  auto keys = db.Scan();
+  EXPECT_EQ(std::set<int>(keys.begin(), keys.end()).size(), keys.size());
+  EXPECT_EQ(std::set<int>(keys.begin(), keys.end()), committed_keys);
+  EXPECT_EQ(db.txn_manager_->GetVersionCount(), 0);
+}
+}  // namespace spdb